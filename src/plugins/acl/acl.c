@@ -28,6 +28,7 @@
 #include <vnet/ip/format.h>
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/ip/ip_types_api.h>
+#include <vnet/ip/ip_flow_cache.h>
 
 #include <vlibapi/api.h>
 #include <vlibmemory/api.h>
@@ -40,6 +41,7 @@
 
 #include "fa_node.h"
 #include "public_inlines.h"
+#include "dtree_lookup.h"
 
 acl_main_t acl_main;
 
@@ -415,6 +417,8 @@ acl_add_list (u32 count, vl_api_acl_rule_t rules[],
     }
   validate_and_reset_acl_counters (am, *acl_list_index);
   acl_plugin_lookup_context_notify_acl_change (*acl_list_index);
+  /* the cached flows were permitted by the old rules */
+  ip_flow_cache_feature_update ();
   return 0;
 }
 
@@ -598,6 +602,8 @@ acl_stats_intf_counters_enable_disable (acl_main_t * am, int enable_disable)
   int rv = 0;
 
   am->interface_acl_counters_enabled = enable_disable;
+  /* the cached flows would not be counted */
+  ip_flow_cache_feature_update ();
 
   return rv;
 }
@@ -612,6 +618,47 @@ acl_interface_inout_enable_disable (acl_main_t * am, u32 sw_if_index,
     return acl_interface_out_enable_disable (am, sw_if_index, enable_disable);
 }
 
+static int
+acl_vec_is_stateless (acl_main_t * am, u32 * acl_vec)
+{
+  acl_rule_t *r;
+  u32 *pacln;
+
+  vec_foreach (pacln, acl_vec)
+  {
+    vec_foreach (r, am->acls[*pacln].rules)
+    {
+      /* reflexive ACEs create sessions */
+      if (r->is_permit > 1)
+	return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * The flow cache may bypass the ACLs on an interface if they give the same
+ * verdict to every packet of a flow, i.e. there are no sessions, and the
+ * packets need not be counted.
+ */
+static int
+acl_interface_is_flow_cacheable (u32 sw_if_index)
+{
+  acl_main_t *am = &acl_main;
+
+  if (am->interface_acl_counters_enabled)
+    return 0;
+  if (sw_if_index < vec_len (am->input_acl_vec_by_sw_if_index) &&
+      !acl_vec_is_stateless (am, am->input_acl_vec_by_sw_if_index
+			     [sw_if_index]))
+    return 0;
+  if (sw_if_index < vec_len (am->output_acl_vec_by_sw_if_index) &&
+      !acl_vec_is_stateless (am, am->output_acl_vec_by_sw_if_index
+			     [sw_if_index]))
+    return 0;
+  return 1;
+}
+
 static int
 acl_is_not_defined (acl_main_t * am, u32 acl_list_index)
 {
@@ -751,6 +798,8 @@ acl_interface_set_inout_acl_list (acl_main_t * am, u32 sw_if_index,
   acl_interface_inout_enable_disable (am, sw_if_index, is_input,
 				      vec_len (vec_acl_list_index) > 0);
 
+  ip_flow_cache_feature_update ();
+
 done:
   clib_bitmap_free (change_acl_bitmap);
   clib_bitmap_free (seen_acl_bitmap);
@@ -2523,6 +2572,7 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
   u32 val = 0;
   u32 eh_val = 0;
   uword memory_size = 0;
+  acl_lookup_engine_t engine;
   acl_main_t *am = &acl_main;
 
   if (unformat (input, "skip-ipv6-extension-header %u %u", &eh_val, &val))
@@ -2538,6 +2588,22 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
       am->use_hash_acl_matching = (val != 0);
       goto done;
     }
+  if (unformat (input, "lookup-engine %U", unformat_acl_lookup_engine,
+		&engine))
+    {
+      int rv;
+
+      if (!unformat (input, "lc_index %u", &val))
+	{
+	  /* the default for the lookup contexts created from now on */
+	  am->default_lookup_engine = engine;
+	  goto done;
+	}
+      rv = acl_plugin_set_lookup_engine (val, engine);
+      if (rv)
+	error = clib_error_return (0, "lookup context %u: error %d", val, rv);
+      goto done;
+    }
   if (unformat (input, "l4-match-nonfirst-fragment %u", &val))
     {
       am->l4_match_nonfirst_fragment = (val != 0);
@@ -2633,6 +2699,21 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
 		  goto done;
 		}
 	    }
+	  if (unformat (input, "lookup-cache-sets"))
+	    {
+	      if (!unformat (input, "%u", &val))
+		{
+		  error = clib_error_return (0,
+					     "expecting number of lookup cache sets, got `%U`",
+					     format_unformat_error, input);
+		  goto done;
+		}
+	      else
+		{
+		  am->fa_conn_table_lookup_cache_sets = val;
+		  goto done;
+		}
+	    }
 	  if (unformat (input, "event-trace"))
 	    {
 	      if (!unformat (input, "%u", &val))
@@ -3455,6 +3536,317 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
   return error;
 }
 
+/*
+ * A synthetic rule set with many distinct masks: prefixes of assorted
+ * lengths, and ports that are any, one or a range.
+ */
+static void
+acl_lookup_test_make_rule (acl_rule_t * r, int is_ip6, u32 * seed)
+{
+  static u8 ip4_lens[] = { 0, 8, 16, 20, 24, 28, 32 };
+  static u8 ip6_lens[] = { 0, 32, 48, 56, 64, 96, 128 };
+  u8 *lens = is_ip6 ? ip6_lens : ip4_lens;
+  u32 max_len = is_ip6 ? 128 : 32;
+  ip46_address_t *addrs[2] = { &r->src, &r->dst };
+  u8 *plens[2] = { &r->src_prefixlen, &r->dst_prefixlen };
+  u16 *ports[2][2] = {
+    {&r->src_port_or_type_first, &r->src_port_or_type_last},
+    {&r->dst_port_or_code_first, &r->dst_port_or_code_last},
+  };
+  int i, j;
+
+  clib_memset (r, 0, sizeof (*r));
+  r->is_permit = random_u32 (seed) & 1;
+  r->is_ipv6 = is_ip6;
+
+  for (i = 0; i < 2; i++)
+    {
+      u32 len = (random_u32 (seed) & 3) ?
+	lens[random_u32 (seed) % ARRAY_LEN (ip4_lens)] :
+	(random_u32 (seed) % (max_len / 8 + 1)) * 8;
+
+      *plens[i] = len;
+      for (j = 0; j < 4; j++)
+	addrs[i]->ip6.as_u32[j] = random_u32 (seed);
+      /* keep the addresses close, so that rules overlap */
+      addrs[i]->as_u8[is_ip6 ? 0 : 12] = 10;
+      for (j = 0; j < (is_ip6 ? 16 : 4); j++)
+	{
+	  int bits = clib_max (0, clib_min ((int) len - 8 * j, 8));
+	  addrs[i]->as_u8[(is_ip6 ? 0 : 12) + j] &= (0xff00 >> bits) & 0xff;
+	}
+      if (!is_ip6)
+	clib_memset (addrs[i]->pad, 0, sizeof (addrs[i]->pad));
+    }
+
+  switch (random_u32 (seed) & 7)
+    {
+    case 0:
+      return;
+    case 1:
+      r->proto = is_ip6 ? IP_PROTOCOL_ICMP6 : IP_PROTOCOL_ICMP;
+      break;
+    case 2:
+    case 3:
+    case 4:
+      r->proto = IP_PROTOCOL_TCP;
+      break;
+    default:
+      r->proto = IP_PROTOCOL_UDP;
+      break;
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      u32 v = random_u32 (seed);
+
+      switch (v & 3)
+	{
+	case 0:
+	case 1:
+	  *ports[i][0] = 0;
+	  *ports[i][1] = 0xffff;
+	  break;
+	case 2:
+	  *ports[i][0] = *ports[i][1] = v >> 16;
+	  break;
+	default:
+	  *ports[i][0] = v >> 16;
+	  *ports[i][1] = clib_min (0xffff, (v >> 16) + (v & 0x3ff0));
+	  break;
+	}
+    }
+  if (r->proto == IP_PROTOCOL_TCP && !(random_u32 (seed) & 15))
+    {
+      /* SYN without ACK */
+      r->tcp_flags_mask = 0x12;
+      r->tcp_flags_value = 0x02;
+    }
+}
+
+/* A packet mostly falling within a given rule, sometimes anywhere */
+static void
+acl_lookup_test_make_packet (fa_5tuple_t * pkt, acl_rule_t * r, u32 lc_index,
+			     u32 * seed)
+{
+  int is_ip6 = r->is_ipv6;
+  int in_rule = (random_u32 (seed) & 3) != 0;
+  ip46_address_t *addrs[2] = { &r->src, &r->dst };
+  u8 plens[2] = { r->src_prefixlen, r->dst_prefixlen };
+  fa_packet_info_t info = {.lc_index = lc_index,.is_ip6 = is_ip6,
+    .mask_type_index_lsb = ~0,.l4_valid = 1
+  };
+  int i, j;
+
+  clib_memset (pkt, 0, sizeof (*pkt));
+  for (i = 0; i < 2; i++)
+    {
+      u8 *a = is_ip6 ? pkt->ip6_addr[i].as_u8 : pkt->ip4_addr[i].as_u8;
+      u8 *ra = is_ip6 ? addrs[i]->ip6.as_u8 : addrs[i]->ip4.as_u8;
+
+      for (j = 0; j < (is_ip6 ? 16 : 4); j++)
+	{
+	  int bits = in_rule ? clib_max (0, clib_min (plens[i] - 8 * j, 8)) : 0;
+	  u8 mask = (0xff00 >> bits) & 0xff;
+
+	  a[j] = (ra[j] & mask) | (random_u32 (seed) & ~mask);
+	}
+    }
+
+  pkt->l4.proto = (in_rule && r->proto) ? r->proto :
+    ((random_u32 (seed) & 1) ? IP_PROTOCOL_TCP : IP_PROTOCOL_UDP);
+  if (in_rule && r->proto)
+    {
+      pkt->l4.port[0] = r->src_port_or_type_first +
+	random_u32 (seed) % (r->src_port_or_type_last -
+			     r->src_port_or_type_first + 1);
+      pkt->l4.port[1] = r->dst_port_or_code_first +
+	random_u32 (seed) % (r->dst_port_or_code_last -
+			     r->dst_port_or_code_first + 1);
+    }
+  else
+    {
+      pkt->l4.port[0] = random_u32 (seed);
+      pkt->l4.port[1] = random_u32 (seed);
+    }
+  if (pkt->l4.proto == IP_PROTOCOL_TCP)
+    {
+      info.tcp_flags = random_u32 (seed);
+      info.tcp_flags_valid = 1;
+    }
+  if (!(random_u32 (seed) & 31))
+    {
+      /* truncated */
+      info.l4_valid = 0;
+      info.tcp_flags_valid = 0;
+      pkt->l4.port[0] = pkt->l4.port[1] = 0;
+    }
+  pkt->pkt = info;
+}
+
+/*
+ * Compare the lookup engines on a synthetic rule set: the time to build
+ * their structures, the clocks per lookup, and that they agree. The
+ * linear engine, the reference, is only run on a sample of the packets.
+ */
+static clib_error_t *
+acl_test_aclplugin_lookup_engines_fn (vlib_main_t * vm,
+				      unformat_input_t * input,
+				      vlib_cli_command_t * cmd)
+{
+  acl_main_t *am = &acl_main;
+  u32 n_rules = 20000, n_packets = 100000, n_check = 1000;
+  u32 seed = 0xdeadbeef;
+  int is_ip6 = 0;
+  clib_error_t *error = 0;
+  acl_rule_t *rules = 0;
+  vl_api_acl_rule_t *api_rules = 0;
+  fa_5tuple_t *pkts = 0;
+  u32 acl_index = ~0, *acl_vec = 0;
+  u32 user_id, lc_index, i;
+  u32 *hash_results = 0, n_hash_matched = 0, n_dtree_matched = 0;
+  u32 n_dtree_mismatch = 0, n_hash_mismatch = 0;
+  u64 hash_clocks, dtree_clocks, linear_clocks, t0;
+  f64 apply_time;
+  unformat_input_t _line_input, *line_input = &_line_input;
+  int rv;
+
+  if (unformat_user (input, unformat_line_input, line_input))
+    {
+      while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+	{
+	  if (unformat (line_input, "rules %u", &n_rules))
+	    ;
+	  else if (unformat (line_input, "packets %u", &n_packets))
+	    ;
+	  else if (unformat (line_input, "check %u", &n_check))
+	    ;
+	  else if (unformat (line_input, "seed %u", &seed))
+	    ;
+	  else if (unformat (line_input, "ip6"))
+	    is_ip6 = 1;
+	  else
+	    {
+	      error = clib_error_return (0, "unknown input '%U'",
+					 format_unformat_error, line_input);
+	      unformat_free (line_input);
+	      return error;
+	    }
+	}
+      unformat_free (line_input);
+    }
+  if (0 == n_rules || 0 == n_packets)
+    return clib_error_return (0, "rules and packets must be non-zero");
+  n_check = clib_min (n_check, n_packets);
+
+  vec_validate (rules, n_rules - 1);
+  vec_validate (api_rules, n_rules - 1);
+  for (i = 0; i < n_rules; i++)
+    {
+      acl_lookup_test_make_rule (&rules[i], is_ip6, &seed);
+      copy_acl_rule_to_api_rule (&api_rules[i], &rules[i]);
+    }
+  rv = acl_add_list (n_rules, api_rules, &acl_index,
+		     (u8 *) "lookup-engines-test");
+  if (rv)
+    {
+      error = clib_error_return (0, "adding the ACL failed: %d", rv);
+      goto done;
+    }
+
+  user_id = acl_plugin.register_user_module ("lookup engines test", "rules",
+					     "seed");
+  lc_index = acl_plugin.get_lookup_context_index (user_id, n_rules, seed);
+  acl_plugin.set_lookup_engine (lc_index, ACL_LOOKUP_ENGINE_HASH);
+
+  vec_add1 (acl_vec, acl_index);
+  apply_time = vlib_time_now (vm);
+  acl_plugin.set_acl_vec_for_context (lc_index, acl_vec);
+  apply_time = vlib_time_now (vm) - apply_time;
+  acl_plugin.set_lookup_engine (lc_index, ACL_LOOKUP_ENGINE_DTREE);
+
+  vec_validate (pkts, n_packets - 1);
+  vec_validate (hash_results, n_packets - 1);
+  for (i = 0; i < n_packets; i++)
+    acl_lookup_test_make_packet (&pkts[i],
+				 &rules[random_u32 (&seed) % n_rules],
+				 lc_index, &seed);
+
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_packets; i++)
+    {
+      u8 action;
+      u32 acl_pos, acl_match, rule_match, trace_bitmap = 0;
+
+      hash_results[i] = ~0;
+      if (hash_multi_acl_match_5tuple (am, lc_index, &pkts[i], is_ip6,
+				       &action, &acl_pos, &acl_match,
+				       &rule_match, &trace_bitmap))
+	{
+	  hash_results[i] = rule_match;
+	  n_hash_matched++;
+	}
+    }
+  hash_clocks = clib_cpu_time_now () - t0;
+
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_packets; i++)
+    {
+      u8 action;
+      u32 acl_pos, acl_match, rule_match = ~0, trace_bitmap = 0;
+
+      if (dtree_multi_acl_match_5tuple (am, lc_index, &pkts[i], is_ip6,
+					&action, &acl_pos, &acl_match,
+					&rule_match, &trace_bitmap))
+	n_dtree_matched++;
+      else
+	rule_match = ~0;
+      n_dtree_mismatch += (rule_match != hash_results[i]);
+    }
+  dtree_clocks = clib_cpu_time_now () - t0;
+
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_check; i++)
+    {
+      u8 action;
+      u32 acl_pos, acl_match, rule_match = ~0, trace_bitmap = 0;
+
+      if (!linear_multi_acl_match_5tuple (am, lc_index, &pkts[i], is_ip6,
+					  &action, &acl_pos, &acl_match,
+					  &rule_match, &trace_bitmap))
+	rule_match = ~0;
+      n_hash_mismatch += (rule_match != hash_results[i]);
+    }
+  linear_clocks = clib_cpu_time_now () - t0;
+
+  vlib_cli_output (vm, "%u %s rules, %u packets, %u matched by hash, "
+		   "%u by dtree", n_rules, is_ip6 ? "ip6" : "ip4", n_packets,
+		   n_hash_matched, n_dtree_matched);
+  vlib_cli_output (vm, "  linear: %.0f clocks/lookup, %u of %u differ "
+		   "from hash", n_check ? (f64) linear_clocks / n_check : 0,
+		   n_hash_mismatch, n_check);
+  vlib_cli_output (vm, "  hash: applied in %.3fs, %.0f clocks/lookup",
+		   apply_time, (f64) hash_clocks / n_packets);
+  vlib_cli_output (vm, "  dtree: %.0f clocks/lookup, %u differ from hash",
+		   (f64) dtree_clocks / n_packets, n_dtree_mismatch);
+  vlib_cli_output (vm, "  %U", format_acl_dtree,
+		   am->dtree_by_lc_index[lc_index]);
+
+  if (n_dtree_mismatch || n_hash_mismatch)
+    error = clib_error_return (0, "lookup engines disagree");
+
+  acl_plugin.put_lookup_context_index (lc_index);
+  acl_del_list (acl_index);
+
+done:
+  vec_free (rules);
+  vec_free (api_rules);
+  vec_free (pkts);
+  vec_free (acl_vec);
+  vec_free (hash_results);
+  return error;
+}
+
 static clib_error_t *
 acl_clear_aclplugin_fn (vlib_main_t * vm,
 			unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -3539,6 +3931,21 @@ VLIB_CLI_COMMAND (aclplugin_clear_command, static) = {
     .function = acl_clear_aclplugin_fn,
 };
 
+/*?
+ * Compare the ACL lookup engines on a synthetic set of rules with many
+ * distinct masks: the time to build, the clocks per lookup, and whether
+ * they agree on the rule matched.
+ *
+ * @cliexpar
+ * <b><em> test acl-plugin lookup-engines rules 20000 packets 100000 </b></em>
+ * @cliexend
+ ?*/
+VLIB_CLI_COMMAND (aclplugin_test_lookup_engines_command, static) = {
+    .path = "test acl-plugin lookup-engines",
+    .short_help = "test acl-plugin lookup-engines [rules N] [packets N] [check N] [seed N] [ip6]",
+    .function = acl_test_aclplugin_lookup_engines_fn,
+};
+
 /*?
  * [un]Apply an ACL to an interface.
  *  The ACL is applied in a given direction, either input or output.
@@ -3584,6 +3991,7 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
   u32 conn_table_hash_buckets;
   uword conn_table_hash_memory_size;
   u32 conn_table_max_entries;
+  u32 conn_table_lookup_cache_sets;
   uword main_heap_size;
   uword hash_heap_size;
   u32 hash_lookup_hash_buckets;
@@ -3605,6 +4013,9 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "connection count max %d",
 			 &conn_table_max_entries))
 	am->fa_conn_table_max_entries = conn_table_max_entries;
+      else if (unformat (input, "connection lookup cache sets %d",
+			 &conn_table_lookup_cache_sets))
+	am->fa_conn_table_lookup_cache_sets = conn_table_lookup_cache_sets;
       else
 	if (unformat
 	    (input, "main heap size %U", unformat_memory_size,
@@ -3637,6 +4048,10 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "reclassify sessions %d",
 			 &reclassify_sessions))
 	am->reclassify_sessions = reclassify_sessions;
+      else if (unformat (input, "lookup engine %U",
+			 unformat_acl_lookup_engine,
+			 &am->default_lookup_engine))
+	;
 
       else
 	return clib_error_return (0, "unknown input '%U'",
@@ -3744,6 +4159,11 @@ acl_init (vlib_main_t * vm)
 						 CLIB_CACHE_LINE_BYTES);
   am->acl_counter_lock[0] = 0;	/* should be no need */
 
+  ip_flow_cache_feature_register ("acl-plugin-in-ip4-fa",
+				  acl_interface_is_flow_cacheable);
+  ip_flow_cache_feature_register ("acl-plugin-in-ip6-fa",
+				  acl_interface_is_flow_cacheable);
+
   return error;
 }
 
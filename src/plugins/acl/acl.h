@@ -32,6 +32,7 @@
 #include "types.h"
 #include "fa_node.h"
 #include "hash_lookup_types.h"
+#include "dtree_lookup_types.h"
 #include "lookup_context.h"
 
 #define  ACL_PLUGIN_VERSION_MAJOR 1
@@ -189,6 +190,12 @@ typedef struct {
   /* vec of vectors of all info of all mask types present in ACEs contained in each lc_index */
   hash_applied_mask_info_t **hash_applied_mask_info_vec_by_lc_index;
 
+  /* decision tree of each lc_index using that engine, NULL for the others */
+  acl_dtree_t **dtree_by_lc_index;
+
+  /* the lookup engine of newly allocated lookup contexts */
+  acl_lookup_engine_t default_lookup_engine;
+
   /*
    * Classify tables used to grab the packets for the ACL check,
    * and serving as the 5-tuple session tables at the same time
@@ -242,6 +249,8 @@ typedef struct {
   u32 fa_conn_table_hash_num_buckets;
   uword fa_conn_table_hash_memory_size;
   u64 fa_conn_table_max_entries;
+  /* per-thread session lookup cache sets, 0 disables the caches */
+  u32 fa_conn_table_lookup_cache_sets;
 
   int trace_sessions;
   int trace_acl;
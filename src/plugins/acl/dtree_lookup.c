@@ -0,0 +1,452 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <stddef.h>
+#include <netinet/in.h>
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vppinfra/error.h>
+#include <acl/acl.h>
+
+#include "dtree_lookup.h"
+
+/*
+ * The tree is built the HyperSplit way: each node splits the region of
+ * the packet header space it covers in two on the one dimension and value
+ * that best divide the rules overlapping it, and a node with few enough
+ * rules left becomes a leaf, whose rules are then checked all at once.
+ * As in EffiCuts, the rules are first partitioned by how wide they are,
+ * and a packet is looked up in the tree of each partition.
+ */
+
+/* the deepest the tree is allowed to grow */
+#define ACL_DTREE_MAX_DEPTH 64
+
+/* the rules are copied at most this many times over into the leaves */
+#define ACL_DTREE_MAX_COPIES_PER_RULE 32
+
+typedef struct {
+  u32 lo[ACL_DTREE_MAX_N_DIMS];
+  u32 hi[ACL_DTREE_MAX_N_DIMS];
+} acl_dtree_box_t;
+
+typedef struct {
+  acl_dtree_table_t *table;
+  /* the values each rule matches, by index of the rule */
+  acl_dtree_box_t *boxes;
+  acl_dtree_rule_t *rules;
+  /* the rule copies made by splitting so far and the limit on them */
+  u32 n_copies;
+  u32 max_copies;
+  /* scratch for choosing the splits */
+  u32 *los;
+  u32 *his;
+  u32 *cuts;
+} acl_dtree_build_ctx_t;
+
+static void
+acl_dtree_prefix_range(u32 addr, int prefixlen, u32 *lo, u32 *hi)
+{
+  u32 mask;
+
+  prefixlen = clib_max(0, clib_min(prefixlen, 32));
+  mask = prefixlen ? ~0 << (32 - prefixlen) : 0;
+  *lo = addr & mask;
+  *hi = addr | ~mask;
+}
+
+static void
+acl_dtree_rule_box(acl_rule_t *r, acl_dtree_box_t *box)
+{
+  u32 *lo = box->lo;
+  u32 *hi = box->hi;
+  int i;
+
+  if (r->is_ipv6) {
+    for (i = 0; i < 4; i++) {
+      acl_dtree_prefix_range(clib_net_to_host_u32(r->src.ip6.as_u32[i]),
+                             r->src_prefixlen - 32 * i, &lo[i], &hi[i]);
+      acl_dtree_prefix_range(clib_net_to_host_u32(r->dst.ip6.as_u32[i]),
+                             r->dst_prefixlen - 32 * i, &lo[4 + i], &hi[4 + i]);
+    }
+    lo += 8;
+    hi += 8;
+  } else {
+    acl_dtree_prefix_range(clib_net_to_host_u32(r->src.ip4.as_u32),
+                           r->src_prefixlen, &lo[0], &hi[0]);
+    acl_dtree_prefix_range(clib_net_to_host_u32(r->dst.ip4.as_u32),
+                           r->dst_prefixlen, &lo[1], &hi[1]);
+    lo += 2;
+    hi += 2;
+  }
+
+  if (r->proto) {
+    /* the ports are only matched, and the L4 information needed, with a protocol */
+    lo[0] = hi[0] = ACL_DTREE_L4_VALID | r->proto;
+    lo[1] = r->src_port_or_type_first;
+    hi[1] = r->src_port_or_type_last;
+    lo[2] = r->dst_port_or_code_first;
+    hi[2] = r->dst_port_or_code_last;
+  } else {
+    lo[0] = 0;
+    hi[0] = ACL_DTREE_L4_VALID | 0xff;
+    lo[1] = lo[2] = 0;
+    hi[1] = hi[2] = 0xffff;
+  }
+}
+
+/* the partition of a rule: whether its source and destination are short prefixes */
+static u32
+acl_dtree_rule_partition(acl_rule_t *r)
+{
+  int short_len = r->is_ipv6 ? 64 : 16;
+
+  return (r->src_prefixlen < short_len) | ((r->dst_prefixlen < short_len) << 1);
+}
+
+/* the region of the header space of the whole tree */
+static void
+acl_dtree_full_box(u32 n_dims, acl_dtree_box_t *box)
+{
+  u32 d;
+
+  for (d = 0; d < n_dims; d++) {
+    box->lo[d] = 0;
+    box->hi[d] = ~0;
+  }
+  box->hi[n_dims - 3] = ACL_DTREE_L4_VALID | 0xff;
+  box->hi[n_dims - 2] = 0xffff;
+  box->hi[n_dims - 1] = 0xffff;
+}
+
+static int
+acl_dtree_box_covers(u32 n_dims, acl_dtree_box_t *box, acl_dtree_box_t *region)
+{
+  u32 d;
+
+  for (d = 0; d < n_dims; d++)
+    if (box->lo[d] > region->lo[d] || box->hi[d] < region->hi[d])
+      return 0;
+  return 1;
+}
+
+static int
+acl_dtree_u32_cmp(void *a1, void *a2)
+{
+  u32 *v1 = a1;
+  u32 *v2 = a2;
+
+  return (*v1 > *v2) - (*v1 < *v2);
+}
+
+static void
+acl_dtree_make_leaf(acl_dtree_build_ctx_t *ctx, u32 node_index, u32 *rules)
+{
+  acl_dtree_table_t *t = ctx->table;
+  u32 n_dims = t->n_dims;
+  u32 block_size = (2 * n_dims + 1) * ACL_DTREE_BLOCK_SIZE;
+  u32 n_blocks = (vec_len(rules) + ACL_DTREE_BLOCK_SIZE - 1) / ACL_DTREE_BLOCK_SIZE;
+  acl_dtree_node_t *node = vec_elt_at_index(t->nodes, node_index);
+  u32 *block, b, d, lane, i;
+
+  node->dim = ACL_DTREE_LEAF;
+  node->index = vec_len(t->blocks) / block_size;
+  node->n_blocks = n_blocks;
+
+  if (0 == n_blocks)
+    goto done;
+
+  vec_add2(t->blocks, block, n_blocks * block_size);
+
+  for (b = 0; b < n_blocks; b++, block += block_size) {
+    u32 *lo = block;
+    u32 *hi = block + n_dims * ACL_DTREE_BLOCK_SIZE;
+    u32 *ri = hi + n_dims * ACL_DTREE_BLOCK_SIZE;
+
+    for (lane = 0; lane < ACL_DTREE_BLOCK_SIZE; lane++) {
+      i = b * ACL_DTREE_BLOCK_SIZE + lane;
+      for (d = 0; d < n_dims; d++) {
+        lo[d * ACL_DTREE_BLOCK_SIZE + lane] =
+          i < vec_len(rules) ? ctx->boxes[rules[i]].lo[d] : ~0;
+        hi[d * ACL_DTREE_BLOCK_SIZE + lane] =
+          i < vec_len(rules) ? ctx->boxes[rules[i]].hi[d] : 0;
+      }
+      ri[lane] = i < vec_len(rules) ? rules[i] : ~0;
+    }
+  }
+
+done:
+  t->n_leaves++;
+  t->n_rule_copies += vec_len(rules);
+}
+
+/*
+ * Find the dimension and the value the region is best split at: the one
+ * leaving the fewest rules on the side with the more of them, then the
+ * fewest copied to both sides. Returns the number on the bigger side.
+ */
+static u32
+acl_dtree_choose_split(acl_dtree_build_ctx_t *ctx, u32 *rules,
+                       acl_dtree_box_t *region, u32 *split_dim, u32 *split_at)
+{
+  u32 n_dims = ctx->table->n_dims;
+  u32 n = vec_len(rules);
+  u32 best = n, best_sum = ~0;
+  u32 d, i, j, k;
+
+  for (d = 0; d < n_dims; d++) {
+    vec_reset_length(ctx->los);
+    vec_reset_length(ctx->his);
+    vec_reset_length(ctx->cuts);
+
+    for (i = 0; i < n; i++) {
+      acl_dtree_box_t *box = &ctx->boxes[rules[i]];
+      u32 lo = clib_max(box->lo[d], region->lo[d]);
+      u32 hi = clib_min(box->hi[d], region->hi[d]);
+
+      vec_add1(ctx->los, lo);
+      vec_add1(ctx->his, hi);
+      /* a split is worth making only where a rule starts or ends */
+      if (lo > region->lo[d])
+        vec_add1(ctx->cuts, lo);
+      if (hi < region->hi[d])
+        vec_add1(ctx->cuts, hi + 1);
+    }
+    if (0 == vec_len(ctx->cuts))
+      continue;
+
+    vec_sort_with_function(ctx->los, acl_dtree_u32_cmp);
+    vec_sort_with_function(ctx->his, acl_dtree_u32_cmp);
+    vec_sort_with_function(ctx->cuts, acl_dtree_u32_cmp);
+
+    /* the rules starting before a cut go left, those ending at or after it right */
+    for (i = j = k = 0; k < vec_len(ctx->cuts); k++) {
+      u32 cut = ctx->cuts[k];
+      u32 n_left, n_right, worst;
+
+      if (k && cut == ctx->cuts[k - 1])
+        continue;
+      while (i < n && ctx->los[i] < cut)
+        i++;
+      while (j < n && ctx->his[j] < cut)
+        j++;
+      n_left = i;
+      n_right = n - j;
+      worst = clib_max(n_left, n_right);
+      if (worst < best || (worst == best && n_left + n_right < best_sum)) {
+        best = worst;
+        best_sum = n_left + n_right;
+        *split_dim = d;
+        *split_at = cut;
+      }
+    }
+  }
+  return best;
+}
+
+static void
+acl_dtree_build_node(acl_dtree_build_ctx_t *ctx, u32 node_index, u32 *rules,
+                     acl_dtree_box_t *region, u32 depth)
+{
+  acl_dtree_table_t *t = ctx->table;
+  u32 *left = 0, *right = 0;
+  acl_dtree_box_t sub_region;
+  acl_dtree_node_t *children;
+  u32 split_dim = 0, split_at = 0;
+  u32 i, n;
+
+  t->max_depth = clib_max(t->max_depth, depth);
+
+  /* the rules after one always matching in this region can never match */
+  for (i = 0; i < vec_len(rules); i++) {
+    if (0 == ctx->rules[rules[i]].tcp_flags_mask &&
+        acl_dtree_box_covers(t->n_dims, &ctx->boxes[rules[i]], region)) {
+      vec_set_len(rules, i + 1);
+      break;
+    }
+  }
+  n = vec_len(rules);
+
+  if (n <= ACL_DTREE_BLOCK_SIZE || depth >= ACL_DTREE_MAX_DEPTH ||
+      ctx->n_copies >= ctx->max_copies ||
+      acl_dtree_choose_split(ctx, rules, region, &split_dim, &split_at) >= n) {
+    acl_dtree_make_leaf(ctx, node_index, rules);
+    return;
+  }
+
+  for (i = 0; i < n; i++) {
+    acl_dtree_box_t *box = &ctx->boxes[rules[i]];
+    if (box->lo[split_dim] < split_at)
+      vec_add1(left, rules[i]);
+    if (box->hi[split_dim] >= split_at)
+      vec_add1(right, rules[i]);
+  }
+  ctx->n_copies += vec_len(left) + vec_len(right) - n;
+
+  vec_add2(t->nodes, children, 2);
+  t->nodes[node_index].dim = split_dim;
+  t->nodes[node_index].threshold = split_at - 1;
+  t->nodes[node_index].index = children - t->nodes;
+
+  sub_region = *region;
+  sub_region.hi[split_dim] = split_at - 1;
+  acl_dtree_build_node(ctx, t->nodes[node_index].index, left, &sub_region, depth + 1);
+  vec_free(left);
+
+  sub_region = *region;
+  sub_region.lo[split_dim] = split_at;
+  acl_dtree_build_node(ctx, t->nodes[node_index].index + 1, right, &sub_region, depth + 1);
+  vec_free(right);
+}
+
+acl_dtree_t *
+acl_dtree_build(acl_main_t *am, u32 lc_index)
+{
+  acl_lookup_context_t *acontext = pool_elt_at_index(am->acl_lookup_contexts, lc_index);
+  acl_dtree_build_ctx_t ctx = { 0 };
+  f64 start = vlib_time_now(am->vlib_main);
+  u32 *rules_by_part[2][ACL_DTREE_N_PARTITIONS] = { { 0 } };
+  acl_dtree_box_t region;
+  acl_dtree_t *dt;
+  u32 pos, ace, af, part;
+
+  dt = clib_mem_alloc(sizeof(*dt));
+  clib_memset(dt, 0, sizeof(*dt));
+
+  vec_foreach_index(pos, acontext->acl_indices) {
+    u32 acl_index = acontext->acl_indices[pos];
+    acl_rule_t *acl_rules;
+
+    if (pool_is_free_index(am->acls, acl_index))
+      continue;
+
+    acl_rules = am->acls[acl_index].rules;
+    vec_foreach_index(ace, acl_rules) {
+      acl_rule_t *r = &acl_rules[ace];
+      acl_dtree_rule_t *dr;
+      acl_dtree_box_t *box;
+
+      vec_add1(rules_by_part[r->is_ipv6 != 0][acl_dtree_rule_partition(r)],
+               vec_len(dt->rules));
+      vec_add2(dt->rules, dr, 1);
+      dr->acl_index = acl_index;
+      dr->ace_index = ace;
+      dr->acl_position = pos;
+      dr->action = r->is_permit;
+      /* like the hash matching, TCP flags are only matched by TCP rules */
+      dr->tcp_flags_mask = (r->proto == IPPROTO_TCP) ? r->tcp_flags_mask : 0;
+      dr->tcp_flags_value = r->tcp_flags_value & dr->tcp_flags_mask;
+      vec_add2(ctx.boxes, box, 1);
+      acl_dtree_rule_box(r, box);
+    }
+  }
+  ctx.rules = dt->rules;
+
+  for (af = 0; af < 2; af++) {
+    for (part = 0; part < ACL_DTREE_N_PARTITIONS; part++) {
+      u32 *rules = rules_by_part[af][part];
+
+      ctx.table = &dt->tables[af][part];
+      ctx.table->n_dims = af ? ACL_DTREE_IP6_N_DIMS : ACL_DTREE_IP4_N_DIMS;
+      ctx.table->n_rules = vec_len(rules);
+      if (0 == vec_len(rules))
+        continue;
+      ctx.n_copies = 0;
+      ctx.max_copies = ACL_DTREE_MAX_COPIES_PER_RULE * vec_len(rules);
+      vec_validate(ctx.table->nodes, 0);
+      acl_dtree_full_box(ctx.table->n_dims, &region);
+      acl_dtree_build_node(&ctx, 0, rules, &region, 0);
+      vec_free(rules);
+    }
+  }
+
+  vec_free(ctx.boxes);
+  vec_free(ctx.los);
+  vec_free(ctx.his);
+  vec_free(ctx.cuts);
+
+  dt->build_time = vlib_time_now(am->vlib_main) - start;
+  return dt;
+}
+
+void
+acl_dtree_free(acl_dtree_t *dt)
+{
+  int af, part;
+
+  if (!dt)
+    return;
+
+  for (af = 0; af < 2; af++) {
+    for (part = 0; part < ACL_DTREE_N_PARTITIONS; part++) {
+      vec_free(dt->tables[af][part].nodes);
+      vec_free(dt->tables[af][part].blocks);
+    }
+  }
+  vec_free(dt->rules);
+  clib_mem_free(dt);
+}
+
+void
+acl_dtree_update(acl_main_t *am, u32 lc_index)
+{
+  acl_lookup_context_t *acontext = pool_elt_at_index(am->acl_lookup_contexts, lc_index);
+  acl_dtree_t *old_dt;
+
+  vec_validate(am->dtree_by_lc_index, lc_index);
+  old_dt = am->dtree_by_lc_index[lc_index];
+
+  /*
+   * Configuration changes are made with the workers held at the barrier,
+   * so the old tree can be freed at once.
+   */
+  if (acontext->engine == ACL_LOOKUP_ENGINE_DTREE)
+    am->dtree_by_lc_index[lc_index] = acl_dtree_build(am, lc_index);
+  else
+    am->dtree_by_lc_index[lc_index] = 0;
+
+  acl_dtree_free(old_dt);
+}
+
+u8 *
+format_acl_dtree(u8 *s, va_list *args)
+{
+  acl_dtree_t *dt = va_arg(*args, acl_dtree_t *);
+  u32 indent = format_get_indent(s);
+  uword bytes = vec_bytes(dt->rules);
+  int af, part;
+
+  s = format(s, "dtree: %u rules, built in %.3fs", vec_len(dt->rules), dt->build_time);
+  for (af = 0; af < 2; af++) {
+    for (part = 0; part < ACL_DTREE_N_PARTITIONS; part++) {
+      acl_dtree_table_t *t = &dt->tables[af][part];
+
+      if (0 == t->n_rules)
+        continue;
+      s = format(s, "\n%U%s partition %u: %u rules, %u nodes, %u leaves, "
+                 "%u rule copies, depth %u",
+                 format_white_space, indent + 2, af ? "ip6" : "ip4", part,
+                 t->n_rules, vec_len(t->nodes), t->n_leaves,
+                 t->n_rule_copies, t->max_depth);
+      bytes += vec_bytes(t->nodes) + vec_bytes(t->blocks);
+    }
+  }
+  s = format(s, "\n%Umemory: %U", format_white_space, indent + 2,
+             format_memory_size, bytes);
+  return s;
+}
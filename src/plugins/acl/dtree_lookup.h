@@ -0,0 +1,41 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#ifndef _ACL_DTREE_LOOKUP_H_
+#define _ACL_DTREE_LOOKUP_H_
+
+#include "lookup_context.h"
+#include "acl.h"
+
+/*
+ * Build the decision tree of the rules of the ACLs in a lookup context,
+ * in the order the ACLs are applied.
+ */
+
+acl_dtree_t *acl_dtree_build(acl_main_t *am, u32 lc_index);
+void acl_dtree_free(acl_dtree_t *dt);
+
+/*
+ * Rebuild the decision tree of a lookup context after a change of its ACLs
+ * or of its engine, or free it if the context no longer uses one.
+ */
+
+void acl_dtree_update(acl_main_t *am, u32 lc_index);
+
+format_function_t format_acl_dtree;
+
+#endif
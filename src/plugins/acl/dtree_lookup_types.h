@@ -0,0 +1,111 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#ifndef _ACL_DTREE_LOOKUP_TYPES_H_
+#define _ACL_DTREE_LOOKUP_TYPES_H_
+
+#include "types.h"
+
+/*
+ * The fields a rule is matched on, each as a range of u32 values:
+ * the source and destination addresses, the protocol (with the bit
+ * above it set when the L4 information is valid), and the two ports.
+ *
+ * An IPv6 address is split into its four 32 bit words. A prefix is
+ * an exact value of the words it covers, a range in the word it ends
+ * in and any value in the others.
+ */
+#define ACL_DTREE_IP4_N_DIMS 5
+#define ACL_DTREE_IP6_N_DIMS 11
+#define ACL_DTREE_MAX_N_DIMS ACL_DTREE_IP6_N_DIMS
+
+/* the proto dimension value when the L4 information is valid */
+#define ACL_DTREE_L4_VALID (1 << 8)
+
+/* rules in a block of a leaf, one per vector lane */
+#define ACL_DTREE_BLOCK_SIZE 8
+
+/* the dimension of a leaf node */
+#define ACL_DTREE_LEAF 0xff
+
+/*
+ * The rules of a family are partitioned by whether their source and
+ * destination prefixes are short, with a tree for each partition, so that
+ * the rules wide in one address are not copied into every leaf of the
+ * trees splitting on it.
+ */
+#define ACL_DTREE_N_PARTITIONS 4
+
+/*
+ * A node of the tree. An internal node sends the values of its dimension
+ * up to and including the threshold to its left child, the others to the
+ * right. The children of a node are adjacent.
+ */
+typedef struct {
+  u8 dim;
+  u8 pad[3];
+  u32 threshold;
+  /* the left child, or the first block of a leaf */
+  u32 index;
+  /* the number of blocks of a leaf */
+  u32 n_blocks;
+} acl_dtree_node_t;
+
+/*
+ * The tree for one partition of an address family. The leaves' rules are held in
+ * blocks, each laid out as the ACL_DTREE_BLOCK_SIZE low bounds of each
+ * dimension, then the high bounds of each, then the index of each rule.
+ * The rules of a leaf are in the order they are matched; unused lanes
+ * match nothing.
+ */
+typedef struct {
+  acl_dtree_node_t *nodes;
+  u32 *blocks;
+  u32 n_dims;
+  /* the number of rules in the partition, none meaning no lookup */
+  u32 n_rules;
+  /* for show */
+  u32 n_leaves;
+  u32 n_rule_copies;
+  u32 max_depth;
+} acl_dtree_table_t;
+
+/* An applied rule: what the tree does not match on, and the result */
+typedef struct {
+  u32 acl_index;
+  u32 ace_index;
+  u32 acl_position;
+  u8 action;
+  /* the TCP flags of a TCP rule */
+  u8 tcp_flags_mask;
+  u8 tcp_flags_value;
+} acl_dtree_rule_t;
+
+/*
+ * The decision tree of a lookup context, rebuilt whenever its ACLs change
+ * and swapped in whole.
+ */
+typedef struct {
+  /* the applied rules, in the order they are matched */
+  acl_dtree_rule_t *rules;
+  /* the IPv4 and IPv6 trees, one per partition */
+  acl_dtree_table_t tables[2][ACL_DTREE_N_PARTITIONS];
+  /* the time it took to build, for show */
+  f64 build_time;
+} acl_dtree_t;
+
+#endif
@@ -74,6 +74,30 @@ typedef int (*acl_plugin_match_5tuple_fn_t) (u32 lc_index,
                                            u32 * r_rule_match_p,
                                            u32 * trace_bitmap);
 
+/*
+ * The engines a lookup context can match packets with. The hash engine
+ * is the default, the decision tree one trades a longer build for lookups
+ * whose cost does not grow with the number of distinct masks in the rules.
+ */
+
+#define foreach_acl_lookup_engine \
+_(HASH, "hash")                    \
+_(DTREE, "dtree")
+
+typedef enum {
+#define _(sym, str) ACL_LOOKUP_ENGINE_##sym,
+  foreach_acl_lookup_engine
+#undef _
+  ACL_N_LOOKUP_ENGINES,
+} acl_lookup_engine_t;
+
+/*
+ * Select the engine used for the lookups within a given context.
+ * If >= 0 - success. If < 0 - error code.
+ */
+
+typedef int (*acl_plugin_set_lookup_engine_fn_t) (u32 lc_index, acl_lookup_engine_t engine);
+
 
 #define foreach_acl_plugin_exported_method_name \
 _(acl_exists)                          \
@@ -82,7 +106,8 @@ _(get_lookup_context_index)            \
 _(put_lookup_context_index)            \
 _(set_acl_vec_for_context)             \
 _(fill_5tuple)                         \
-_(match_5tuple)                        
+_(match_5tuple)                        \
+_(set_lookup_engine)
 
 #define _(name) acl_plugin_ ## name ## _fn_t name;
 typedef struct {
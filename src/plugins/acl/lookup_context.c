@@ -18,6 +18,7 @@
 #include <vlib/unix/plugin.h>
 #include <plugins/acl/public_inlines.h>
 #include "hash_lookup.h"
+#include "dtree_lookup.h"
 #include "elog_acl_trace.h"
 
 /* check if a given ACL exists */
@@ -114,9 +115,11 @@ static int acl_plugin_get_lookup_context_index (u32 acl_user_id, u32 val1, u32 v
   acontext->context_user_id = acl_user_id;
   acontext->user_val1 = val1;
   acontext->user_val2 = val2;
+  acontext->engine = am->default_lookup_engine;
 
   u32 new_context_id = acontext - am->acl_lookup_contexts;
   vec_add1(am->acl_users[acl_user_id].lookup_contexts, new_context_id);
+  acl_dtree_update(am, new_context_id);
 
   return new_context_id;
 }
@@ -206,6 +209,8 @@ static void acl_plugin_put_lookup_context_index (u32 lc_index)
   unapply_acl_vec(lc_index, acontext->acl_indices);
   unlock_acl_vec(lc_index, acontext->acl_indices);
   vec_free(acontext->acl_indices);
+  acontext->engine = ACL_LOOKUP_ENGINE_HASH;
+  acl_dtree_update(am, lc_index);
   pool_put(am->acl_lookup_contexts, acontext);
 }
 
@@ -258,6 +263,7 @@ static int acl_plugin_set_acl_vec_for_context (u32 lc_index, u32 *acl_list)
   unlock_acl_vec(lc_index, old_acl_vector);
   lock_acl_vec(lc_index, acontext->acl_indices);
   apply_acl_vec(lc_index, acontext->acl_indices);
+  acl_dtree_update(am, lc_index);
 
   vec_free(old_acl_vector);
 
@@ -280,6 +286,65 @@ void acl_plugin_lookup_context_notify_acl_change(u32 acl_num)
     /* this is a deletion notification */
     hash_acl_delete(am, acl_num);
   }
+  if (acl_num < vec_len(am->lc_index_vec_by_acl)) {
+    u32 *lc_index;
+    vec_foreach(lc_index, am->lc_index_vec_by_acl[acl_num]) {
+      acl_dtree_update(am, *lc_index);
+    }
+  }
+}
+
+/*
+ * Select the engine used for the lookups within a given context,
+ * building or freeing the structures only it uses.
+ */
+int acl_plugin_set_lookup_engine (u32 lc_index, acl_lookup_engine_t engine)
+{
+  acl_main_t *am = &acl_main;
+  acl_lookup_context_t *acontext;
+
+  if (!acl_lc_index_valid(am, lc_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+  if (engine >= ACL_N_LOOKUP_ENGINES)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  elog_acl_cond_trace_X2(am, (am->trace_acl), "LOOKUP-CONTEXT: set-engine lc_index %d engine %d", "i4i4", lc_index, engine);
+  acontext = pool_elt_at_index(am->acl_lookup_contexts, lc_index);
+  acontext->engine = engine;
+  acl_dtree_update(am, lc_index);
+  return 0;
+}
+
+static char *acl_lookup_engine_names[] = {
+#define _(sym, str) str,
+  foreach_acl_lookup_engine
+#undef _
+};
+
+u8 *
+format_acl_lookup_engine (u8 * s, va_list * args)
+{
+  acl_lookup_engine_t engine = va_arg (*args, int);
+
+  if (engine >= ACL_N_LOOKUP_ENGINES)
+    return format (s, "unknown-engine-%d", engine);
+  return format (s, "%s", acl_lookup_engine_names[engine]);
+}
+
+uword
+unformat_acl_lookup_engine (unformat_input_t * input, va_list * args)
+{
+  acl_lookup_engine_t *engine = va_arg (*args, acl_lookup_engine_t *);
+
+#define _(sym, str)                             \
+  if (unformat (input, str))                    \
+    {                                           \
+      *engine = ACL_LOOKUP_ENGINE_##sym;        \
+      return 1;                                 \
+    }
+  foreach_acl_lookup_engine
+#undef _
+  return 0;
 }
 
 
@@ -339,16 +404,20 @@ acl_plugin_show_lookup_context (u32 lc_index)
     if ((lc_index == ~0) || (curr_lc_index == lc_index)) {
       if (acl_user_id_valid(am, acontext->context_user_id)) {
         acl_lookup_context_user_t *auser = pool_elt_at_index(am->acl_users, acontext->context_user_id);
-        vlib_cli_output (vm, "index %d:%s %s: %d %s: %d, acl_indices: %U",
+        vlib_cli_output (vm, "index %d:%s %s: %d %s: %d, acl_indices: %U, engine: %U",
                        curr_lc_index, auser->user_module_name, auser->val1_label,
                        acontext->user_val1, auser->val2_label, acontext->user_val2,
-                       format_vec32, acontext->acl_indices, "%d");
+                       format_vec32, acontext->acl_indices, "%d",
+                       format_acl_lookup_engine, acontext->engine);
       } else {
-        vlib_cli_output (vm, "index %d: user_id: %d user_val1: %d user_val2: %d, acl_indices: %U",
+        vlib_cli_output (vm, "index %d: user_id: %d user_val1: %d user_val2: %d, acl_indices: %U, engine: %U",
                        curr_lc_index, acontext->context_user_id,
                        acontext->user_val1, acontext->user_val2,
-                       format_vec32, acontext->acl_indices, "%d");
+                       format_vec32, acontext->acl_indices, "%d",
+                       format_acl_lookup_engine, acontext->engine);
       }
+      if (am->dtree_by_lc_index[curr_lc_index])
+        vlib_cli_output (vm, "  %U", format_acl_dtree, am->dtree_by_lc_index[curr_lc_index]);
     }
   }
 }
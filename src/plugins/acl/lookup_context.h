@@ -16,6 +16,8 @@
 #ifndef included_acl_lookup_context_h
 #define included_acl_lookup_context_h
 
+#include "exported_types.h"
+
 typedef struct {
   /* A name of the portion of the code using the ACL infra */
   char *user_module_name;
@@ -36,6 +38,8 @@ typedef struct {
   u32 user_val1;
   /* per-instance user value 2 */
   u32 user_val2;
+  /* the engine matching packets within this context */
+  acl_lookup_engine_t engine;
 } acl_lookup_context_t;
 
 void acl_plugin_lookup_context_notify_acl_change(u32 acl_num);
@@ -43,6 +47,10 @@ void acl_plugin_lookup_context_notify_acl_change(u32 acl_num);
 void acl_plugin_show_lookup_context (u32 lc_index);
 void acl_plugin_show_lookup_user (u32 user_index);
 
+int acl_plugin_set_lookup_engine (u32 lc_index, acl_lookup_engine_t engine);
+uword unformat_acl_lookup_engine (unformat_input_t * input, va_list * args);
+u8 *format_acl_lookup_engine (u8 * s, va_list * args);
+
 /* These are in the hash matching for now */
 void acl_plugin_show_tables_mask_type (void);
 void acl_plugin_show_tables_acl_hash_info (u32 acl_index);
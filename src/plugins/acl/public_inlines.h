@@ -647,6 +647,140 @@ hash_multi_acl_match_5tuple (void *p_acl_main, u32 lc_index, fa_5tuple_t * pkt_5
   return 0;
 }
 
+/*
+ * Check the rules of a decision tree leaf, a block of them at a time,
+ * and return the index of the first one matching.
+ */
+always_inline u32
+dtree_match_leaf (acl_dtree_table_t * t, acl_dtree_rule_t * rules,
+                  acl_dtree_node_t * node, u32 * key, int is_ip6,
+                  fa_5tuple_t * pkt_5tuple, u32 best_rule_index)
+{
+  const u32 n_dims = is_ip6 ? ACL_DTREE_IP6_N_DIMS : ACL_DTREE_IP4_N_DIMS;
+  const u32 block_size = (2 * n_dims + 1) * ACL_DTREE_BLOCK_SIZE;
+  u32 *block = t->blocks + node->index * block_size;
+  u32 b, d;
+
+  for (b = 0; b < node->n_blocks; b++, block += block_size)
+    {
+      u32 *lo = block;
+      u32 *hi = block + n_dims * ACL_DTREE_BLOCK_SIZE;
+      u32 *ri = hi + n_dims * ACL_DTREE_BLOCK_SIZE;
+      /* four bits set for each lane whose rule matches in every dimension */
+      u64 lanes;
+
+      /* a match found in another partition comes before the rest of these */
+      if (ri[0] >= best_rule_index)
+        break;
+
+#if defined(CLIB_HAVE_VEC256)
+      u32x8 m = u32x8_splat (~0);
+      for (d = 0; d < n_dims; d++)
+        {
+          u32x8 v = u32x8_splat (key[d]);
+          m &= (u32x8) ((u32x8_load_unaligned (lo + d * 8) <= v) &
+                        (v <= u32x8_load_unaligned (hi + d * 8)));
+        }
+      lanes = u8x32_msb_mask ((u8x32) m);
+#elif defined(CLIB_HAVE_VEC128) && defined(CLIB_HAVE_VEC128_MSB_MASK)
+      u32x4 m0 = u32x4_splat (~0), m1 = m0;
+      for (d = 0; d < n_dims; d++)
+        {
+          u32x4 v = u32x4_splat (key[d]);
+          m0 &= (u32x4) ((u32x4_load_unaligned (lo + d * 8) <= v) &
+                         (v <= u32x4_load_unaligned (hi + d * 8)));
+          m1 &= (u32x4) ((u32x4_load_unaligned (lo + d * 8 + 4) <= v) &
+                         (v <= u32x4_load_unaligned (hi + d * 8 + 4)));
+        }
+      lanes = u8x16_msb_mask ((u8x16) m0) |
+        ((u64) u8x16_msb_mask ((u8x16) m1) << 16);
+#else
+      u32 lane;
+      lanes = 0;
+      for (lane = 0; lane < ACL_DTREE_BLOCK_SIZE; lane++)
+        {
+          int match = 1;
+          for (d = 0; d < n_dims; d++)
+            match &= (lo[d * 8 + lane] <= key[d]) & (key[d] <= hi[d * 8 + lane]);
+          lanes |= (u64) (match ? 0xf : 0) << (4 * lane);
+        }
+#endif
+
+      /* the lanes are in the order the rules are matched */
+      while (lanes)
+        {
+          u32 i = count_trailing_zeros (lanes) / 4;
+          acl_dtree_rule_t *r = rules + ri[i];
+
+          lanes &= ~(0xfULL << (4 * i));
+          if (ri[i] >= best_rule_index)
+            return ~0;
+          if (PREDICT_FALSE (r->tcp_flags_mask) &&
+              (!pkt_5tuple->pkt.tcp_flags_valid ||
+               (pkt_5tuple->pkt.tcp_flags & r->tcp_flags_mask) != r->tcp_flags_value))
+            continue;
+          return ri[i];
+        }
+    }
+  return ~0;
+}
+
+always_inline int
+dtree_multi_acl_match_5tuple (void *p_acl_main, u32 lc_index, fa_5tuple_t * pkt_5tuple,
+                       int is_ip6, u8 *action, u32 *acl_pos_p, u32 * acl_match_p,
+                       u32 * rule_match_p, u32 * trace_bitmap)
+{
+  acl_main_t *am = p_acl_main;
+  acl_dtree_t *dt = vec_elt (am->dtree_by_lc_index, lc_index);
+  u32 key[ACL_DTREE_MAX_N_DIMS], *l4_key;
+  u32 i, part, rule_index = ~0;
+
+  if (is_ip6)
+    {
+      for (i = 0; i < 4; i++)
+        {
+          key[i] = clib_net_to_host_u32 (pkt_5tuple->ip6_addr[0].as_u32[i]);
+          key[4 + i] = clib_net_to_host_u32 (pkt_5tuple->ip6_addr[1].as_u32[i]);
+        }
+      l4_key = key + 8;
+    }
+  else
+    {
+      key[0] = clib_net_to_host_u32 (pkt_5tuple->ip4_addr[0].as_u32);
+      key[1] = clib_net_to_host_u32 (pkt_5tuple->ip4_addr[1].as_u32);
+      l4_key = key + 2;
+    }
+  l4_key[0] = (pkt_5tuple->pkt.l4_valid ? ACL_DTREE_L4_VALID : 0) | pkt_5tuple->l4.proto;
+  l4_key[1] = pkt_5tuple->l4.port[0];
+  l4_key[2] = pkt_5tuple->l4.port[1];
+
+  /* the first match is the one with the lowest index over all partitions */
+  for (part = 0; part < ACL_DTREE_N_PARTITIONS; part++)
+    {
+      acl_dtree_table_t *t = &dt->tables[is_ip6][part];
+      acl_dtree_node_t *node = t->nodes;
+      u32 ri;
+
+      if (0 == t->n_rules)
+        continue;
+      while (node->dim != ACL_DTREE_LEAF)
+        node = t->nodes + node->index + (key[node->dim] > node->threshold);
+      ri = dtree_match_leaf (t, dt->rules, node, key, is_ip6, pkt_5tuple,
+                             rule_index);
+      if (ri < rule_index)
+        rule_index = ri;
+    }
+  if (rule_index == ~0)
+    return 0;
+
+  acl_dtree_rule_t *r = vec_elt_at_index (dt->rules, rule_index);
+  *acl_pos_p = r->acl_position;
+  *acl_match_p = r->acl_index;
+  *rule_match_p = r->ace_index;
+  *action = r->action;
+  return 1;
+}
+
 
 
 always_inline int
@@ -671,6 +805,9 @@ acl_plugin_match_5tuple_inline (void *p_acl_main, u32 lc_index,
        */
       return linear_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
                                  r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
+    } else if (vec_elt (am->dtree_by_lc_index, lc_index)) {
+      return dtree_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
+                                 r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
     } else {
       return hash_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
                                  r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
@@ -706,6 +843,9 @@ acl_plugin_match_5tuple_inline_and_count (void *p_acl_main, u32 lc_index,
        */
       ret = linear_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
                                  r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
+    } else if (vec_elt (am->dtree_by_lc_index, lc_index)) {
+      ret = dtree_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
+                                 r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
     } else {
       ret = hash_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
                                  r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
@@ -22,6 +22,7 @@
 
 #include <acl/acl.h>
 #include <vnet/ip/icmp46_packet.h>
+#include <vpp/stats/stat_segment.h>
 
 #include <plugins/acl/fa_node.h>
 #include <plugins/acl/acl.h>
@@ -81,6 +82,51 @@ format_ip4_session_bihash_kv (u8 * s, va_list * args)
 }
 
 
+static void
+acl_fa_session_cache_gauge_fn (stat_segment_directory_entry_t * e, u32 index)
+{
+  acl_main_t *am = &acl_main;
+  u64 hits, misses;
+
+  if (index & 2)
+    clib_bihash_lookup_cache_counters_40_8 (&am->fa_ip6_sessions_hash,
+					    &hits, &misses);
+  else
+    clib_bihash_lookup_cache_counters_16_8 (&am->fa_ip4_sessions_hash,
+					    &hits, &misses);
+
+  e->value = (index & 1) ? misses : hits;
+}
+
+static void
+acl_fa_enable_session_lookup_caches (acl_main_t * am)
+{
+  u32 n_threads = vec_len (am->per_worker_data);
+  clib_error_t *error;
+  u8 *name = 0;
+  int i;
+
+  clib_bihash_lookup_cache_enable_40_8 (&am->fa_ip6_sessions_hash,
+					n_threads,
+					am->fa_conn_table_lookup_cache_sets);
+  clib_bihash_lookup_cache_enable_16_8 (&am->fa_ip4_sessions_hash,
+					n_threads,
+					am->fa_conn_table_lookup_cache_sets);
+
+  /* index bit 1: ip6, bit 0: misses */
+  for (i = 0; i < 4; i++)
+    {
+      vec_reset_length (name);
+      name = format (name, "/acl/sessions/%s/lookup-cache-%s%c",
+		     (i & 2) ? "ip6" : "ip4", (i & 1) ? "misses" : "hits", 0);
+      error = stat_segment_register_gauge (name,
+					   acl_fa_session_cache_gauge_fn, i);
+      if (error)
+	clib_error_report (error);
+    }
+  vec_free (name);
+}
+
 static void
 acl_fa_verify_init_sessions (acl_main_t * am)
 {
@@ -116,6 +162,9 @@ acl_fa_verify_init_sessions (acl_main_t * am)
       clib_bihash_set_kvp_format_fn_16_8 (&am->fa_ip4_sessions_hash,
 					  format_ip4_session_bihash_kv);
 
+      if (am->fa_conn_table_lookup_cache_sets)
+	acl_fa_enable_session_lookup_caches (am);
+
       am->fa_sessions_hash_is_initialized = 1;
     }
 }
@@ -588,15 +588,17 @@ acl_fa_find_session (acl_main_t * am, int is_ip6, u32 sw_if_index0,
   if (is_ip6)
     {
       clib_bihash_kv_40_8_t kv_result;
-      res = (clib_bihash_search_inline_2_40_8
-	     (&am->fa_ip6_sessions_hash, &p5tuple->kv_40_8, &kv_result) == 0);
+      res = (clib_bihash_search_cached_40_8
+	     (&am->fa_ip6_sessions_hash, os_get_thread_index (),
+	      &p5tuple->kv_40_8, &kv_result) == 0);
       *pvalue_sess = kv_result.value;
     }
   else
     {
       clib_bihash_kv_16_8_t kv_result;
-      res = (clib_bihash_search_inline_2_16_8
-	     (&am->fa_ip4_sessions_hash, &p5tuple->kv_16_8, &kv_result) == 0);
+      res = (clib_bihash_search_cached_16_8
+	     (&am->fa_ip4_sessions_hash, os_get_thread_index (),
+	      &p5tuple->kv_16_8, &kv_result) == 0);
       *pvalue_sess = kv_result.value;
     }
   return res;
@@ -641,18 +643,18 @@ acl_fa_find_session_with_hash (acl_main_t * am, int is_ip6, u32 sw_if_index0,
     {
       clib_bihash_kv_40_8_t kv_result;
       kv_result.value = ~0ULL;
-      res = (clib_bihash_search_inline_2_with_hash_40_8
-	     (&am->fa_ip6_sessions_hash, hash, &p5tuple->kv_40_8,
-	      &kv_result) == 0);
+      res = (clib_bihash_search_cached_with_hash_40_8
+	     (&am->fa_ip6_sessions_hash, os_get_thread_index (), hash,
+	      &p5tuple->kv_40_8, &kv_result) == 0);
       *pvalue_sess = kv_result.value;
     }
   else
     {
       clib_bihash_kv_16_8_t kv_result;
       kv_result.value = ~0ULL;
-      res = (clib_bihash_search_inline_2_with_hash_16_8
-	     (&am->fa_ip4_sessions_hash, hash, &p5tuple->kv_16_8,
-	      &kv_result) == 0);
+      res = (clib_bihash_search_cached_with_hash_16_8
+	     (&am->fa_ip4_sessions_hash, os_get_thread_index (), hash,
+	      &p5tuple->kv_16_8, &kv_result) == 0);
       *pvalue_sess = kv_result.value;
     }
   return res;
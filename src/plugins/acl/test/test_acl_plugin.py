@@ -1433,6 +1433,48 @@ class TestACLplugin(VppTestCase):
 
         self.logger.info("ACLP_TEST_FINISH_0315")
 
+    def test_0400_lookup_engines(self):
+        """ decision tree and hash lookups agree
+        """
+        self.logger.info("ACLP_TEST_START_0400")
+
+        for af in ["", " ip6"]:
+            reply = self.vapi.cli("test acl-plugin lookup-engines "
+                                  "rules 2000 packets 20000" + af)
+            self.logger.info(reply)
+            self.assertNotIn("disagree", reply)
+            self.assertIn("dtree:", reply)
+
+        self.logger.info("ACLP_TEST_FINISH_0400")
+
+    def test_0401_tcp_permit_v4_dtree(self):
+        """ permit TCPv4 + non-match range with the decision tree engine
+        """
+        self.logger.info("ACLP_TEST_START_0401")
+
+        self.vapi.cli("set acl-plugin lookup-engine dtree")
+
+        # Add an ACL
+        rules = []
+        rules.append(self.create_rule(self.IPV4, self.DENY, self.PORTS_RANGE_2,
+                                      self.proto[self.IP][self.TCP]))
+        rules.append(self.create_rule(self.IPV4, self.PERMIT, self.PORTS_RANGE,
+                                      self.proto[self.IP][self.TCP]))
+        # deny ip any any in the end
+        rules.append(self.create_rule(self.IPV4, self.DENY, self.PORTS_ALL, 0))
+
+        # Apply rules
+        self.apply_rules(rules, "permit ipv4 tcp dtree")
+        self.assertIn("engine: dtree",
+                      self.vapi.cli("show acl-plugin lookup context"))
+
+        # Traffic should still pass
+        self.run_verify_test(self.IP, self.IPV4, self.proto[self.IP][self.TCP])
+
+        self.vapi.cli("set acl-plugin lookup-engine hash")
+
+        self.logger.info("ACLP_TEST_FINISH_0401")
+
 
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
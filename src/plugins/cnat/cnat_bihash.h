@@ -20,6 +20,7 @@
 #undef BIHASH_KVP_AT_BUCKET_LEVEL
 #undef BIHASH_LAZY_INSTANTIATE
 #undef BIHASH_BUCKET_PREFETCH_CACHE_LINES
+#undef BIHASH_PAGE_SCAN
 
 #define BIHASH_TYPE			   _40_56
 #define BIHASH_KVP_PER_PAGE 2
@@ -34,6 +34,49 @@ struct rte_mempool **dpdk_mempool_by_buffer_pool_index = 0;
 struct rte_mempool **dpdk_no_cache_mempool_by_buffer_pool_index = 0;
 struct rte_mbuf *dpdk_mbuf_template_by_pool_index = 0;
 
+/* DMA map the pages of a physmem map and add them to mp's memory list */
+static void
+dpdk_buffer_pool_map_physmem (vlib_main_t * vm, struct rte_mempool *mp,
+			      u32 physmem_map_index)
+{
+  enum rte_iova_mode iova_mode = rte_eal_iova_mode ();
+  uword i;
+  size_t page_sz;
+  vlib_physmem_map_t *pm;
+  int do_vfio_map = 1;
+
+  pm = vlib_physmem_get_map (vm, physmem_map_index);
+  page_sz = 1ULL << pm->log2_page_size;
+
+  for (i = 0; i < pm->n_pages; i++)
+    {
+      char *va = ((char *) pm->base) + i * page_sz;
+      uword pa = (iova_mode == RTE_IOVA_VA) ?
+	pointer_to_uword (va) : pm->page_table[i];
+
+      if (do_vfio_map &&
+#if RTE_VERSION < RTE_VERSION_NUM(19, 11, 0, 0)
+	  rte_vfio_dma_map (pointer_to_uword (va), pa, page_sz))
+#else
+	  rte_vfio_container_dma_map (RTE_VFIO_DEFAULT_CONTAINER_FD,
+				      pointer_to_uword (va), pa, page_sz))
+#endif
+	do_vfio_map = 0;
+
+      struct rte_mempool_memhdr *memhdr;
+      memhdr = clib_mem_alloc (sizeof (*memhdr));
+      memhdr->mp = mp;
+      memhdr->addr = va;
+      memhdr->iova = pa;
+      memhdr->len = page_sz;
+      memhdr->free_cb = 0;
+      memhdr->opaque = 0;
+
+      STAILQ_INSERT_TAIL (&mp->mem_list, memhdr, next);
+      mp->nb_mem_chunks++;
+    }
+}
+
 clib_error_t *
 dpdk_buffer_pool_init (vlib_main_t * vm, vlib_buffer_pool_t * bp)
 {
@@ -136,44 +179,51 @@ dpdk_buffer_pool_init (vlib_main_t * vm, vlib_buffer_pool_t * bp)
 
   /* map DMA pages if at least one physical device exists */
   if (rte_eth_dev_count_avail ())
-    {
-      uword i;
-      size_t page_sz;
-      vlib_physmem_map_t *pm;
-      int do_vfio_map = 1;
+    dpdk_buffer_pool_map_physmem (vm, mp, bp->physmem_map_index);
 
-      pm = vlib_physmem_get_map (vm, bp->physmem_map_index);
-      page_sz = 1ULL << pm->log2_page_size;
+  return 0;
+}
 
-      for (i = 0; i < pm->n_pages; i++)
-	{
-	  char *va = ((char *) pm->base) + i * page_sz;
-	  uword pa = (iova_mode == RTE_IOVA_VA) ?
-	    pointer_to_uword (va) : pm->page_table[i];
+/* Add buffers grown into a vlib buffer pool to its mempools */
+static clib_error_t *
+dpdk_buffer_pool_grow (vlib_main_t * vm, vlib_buffer_pool_t * bp,
+		       u32 physmem_map_index, u32 * buffers, u32 n_buffers)
+{
+  struct rte_mempool *mp, *nmp;
+  enum rte_iova_mode iova_mode;
+  u32 i;
 
-	  if (do_vfio_map &&
-#if RTE_VERSION < RTE_VERSION_NUM(19, 11, 0, 0)
-	      rte_vfio_dma_map (pointer_to_uword (va), pa, page_sz))
-#else
-	      rte_vfio_container_dma_map (RTE_VFIO_DEFAULT_CONTAINER_FD,
-					  pointer_to_uword (va), pa, page_sz))
-#endif
-	    do_vfio_map = 0;
-
-	  struct rte_mempool_memhdr *memhdr;
-	  memhdr = clib_mem_alloc (sizeof (*memhdr));
-	  memhdr->mp = mp;
-	  memhdr->addr = va;
-	  memhdr->iova = pa;
-	  memhdr->len = page_sz;
-	  memhdr->free_cb = 0;
-	  memhdr->opaque = 0;
-
-	  STAILQ_INSERT_TAIL (&mp->mem_list, memhdr, next);
-	  mp->nb_mem_chunks++;
-	}
+  if (bp->index >= vec_len (dpdk_mempool_by_buffer_pool_index) ||
+      dpdk_mempool_by_buffer_pool_index[bp->index] == 0)
+    return 0;
+
+  mp = dpdk_mempool_by_buffer_pool_index[bp->index];
+  nmp = dpdk_no_cache_mempool_by_buffer_pool_index[bp->index];
+  iova_mode = rte_eal_iova_mode ();
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      struct rte_mempool_objhdr *hdr;
+      vlib_buffer_t *b = vlib_get_buffer (vm, buffers[i]);
+      struct rte_mbuf *mb = rte_mbuf_from_vlib_buffer (b);
+      hdr = (struct rte_mempool_objhdr *) RTE_PTR_SUB (mb, sizeof (*hdr));
+      hdr->mp = mp;
+      hdr->iova = (iova_mode == RTE_IOVA_VA) ?
+	pointer_to_uword (mb) : vlib_physmem_get_pa (vm, mb);
+      STAILQ_INSERT_TAIL (&mp->elt_list, hdr, next);
+      STAILQ_INSERT_TAIL (&nmp->elt_list, hdr, next);
+      mp->populated_size++;
+      nmp->populated_size++;
+      mp->size++;
+      nmp->size++;
+
+      rte_pktmbuf_init (mp, 0, mb, mp->populated_size - 1);
+      vlib_buffer_copy_template (b, &bp->buffer_template);
     }
 
+  if (rte_eth_dev_count_avail ())
+    dpdk_buffer_pool_map_physmem (vm, mp, physmem_map_index);
+
   return 0;
 }
 
@@ -461,6 +511,8 @@ dpdk_buffer_pools_create (vlib_main_t * vm)
     if (bp->start && (err = dpdk_buffer_pool_init (vm, bp)))
       return err;
   /* *INDENT-ON* */
+
+  vlib_buffer_register_pool_grow_callback (vm, dpdk_buffer_pool_grow);
   return 0;
 }
 
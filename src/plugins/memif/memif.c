@@ -365,6 +365,24 @@ memif_init_regions_and_queues (memif_if_t * mif)
   clib_error_t *err;
 
   ASSERT (vec_len (mif->regions) == 0);
+
+  /*
+   * Zero-copy exports one region per buffer pool, so pools must not
+   * grow past the memory they had when the regions were exported.
+   */
+  if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+    {
+      vlib_buffer_pool_t *bp;
+      /* *INDENT-OFF* */
+      vec_foreach (bp, vm->buffer_main->buffer_pools)
+	if (vec_len (bp->grow_physmem_map_indices))
+	  return clib_error_return (0, "zero-copy not supported with "
+				    "buffer pool %s, it has grown", bp->name);
+      vec_foreach (bp, vm->buffer_main->buffer_pools)
+	bp->flags |= VLIB_BUFFER_POOL_F_GROWTH_DISABLED;
+      /* *INDENT-ON* */
+    }
+
   vec_add2_aligned (mif->regions, r, 1, CLIB_CACHE_LINE_BYTES);
 
   buffer_offset = (mif->run.num_s2m_rings + mif->run.num_m2s_rings) *
@@ -37,6 +37,9 @@ typedef struct
   u64 linear;
   u64 resplit;
   u64 working_copy_lost;
+  u64 resize;
+  u64 resize_migrate;
+  u64 resize_done;
   u64 *splits;
 } bihash_stats_t;
 
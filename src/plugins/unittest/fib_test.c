@@ -7431,6 +7431,12 @@ fib_test_label (void)
     adj_unlock(ai_v4_10_10_11_2);
     adj_unlock(ai_mpls_10_10_11_1);
 
+    /*
+     * the bucket arrays replaced by the updates above release their
+     * locks on the adjacencies after a grace period
+     */
+    vlib_epoch_synchronize();
+
     FIB_TEST((0 == adj_nbr_db_size()), "ADJ DB size is %d",
              adj_nbr_db_size());
 
@@ -10688,6 +10694,251 @@ fib_test_sticky (void)
     return 0;
 }
 
+/*
+ * The flows, of which there are many per-bucket, hashed to each of
+ * the load-balance's choices
+ */
+#define N_FLOWS (8 * LB_RESILIENT_N_BUCKETS)
+
+static void
+fib_test_lb_flows (const dpo_id_t *dpo,
+                   index_t *flows)
+{
+    const load_balance_t *lb;
+    u32 ii;
+
+    lb = load_balance_get(dpo->dpoi_index);
+
+    for (ii = 0; ii < N_FLOWS; ii++)
+    {
+        flows[ii] = load_balance_get_bucket_i(
+            lb, ii & lb->lb_n_buckets_minus_1)->dpoi_index;
+    }
+}
+
+static u32
+fib_test_lb_flows_moved (const index_t *before,
+                         const index_t *after)
+{
+    u32 ii, n_moved = 0;
+
+    for (ii = 0; ii < N_FLOWS; ii++)
+    {
+        n_moved += (before[ii] != after[ii]);
+    }
+    return (n_moved);
+}
+
+static int
+fib_test_resilient (void)
+{
+    fib_route_path_t *r_paths = NULL, *r_paths8, *r_path9 = NULL;
+    static index_t flows[2][2][N_FLOWS];
+    u32 ii, lb_count, n_moved[2];
+    index_t lbi;
+    test_main_t *tm = &test_main;
+    dpo_id_t dpo[2] = {
+        DPO_INVALID,
+        DPO_INVALID,
+    };
+    fib_node_index_t fei[2];
+    const load_balance_t *lb;
+    index_t *f;
+    int res = 0;
+#define N_R_PATHS 9
+
+    adj_index_t ais[N_R_PATHS];
+    bfd_session_t bfds[N_R_PATHS] = {{0}};
+    const fib_prefix_t pfx[2] = {
+        {
+            /* resilient */
+            .fp_len = 24,
+            .fp_proto = FIB_PROTOCOL_IP4,
+            .fp_addr = {
+                .ip4.as_u32 = clib_host_to_net_u32(0x0b0b0b00),
+            },
+        },
+        {
+            /* not */
+            .fp_len = 24,
+            .fp_proto = FIB_PROTOCOL_IP4,
+            .fp_addr = {
+                .ip4.as_u32 = clib_host_to_net_u32(0x0b0b0c00),
+            },
+        },
+    };
+
+    lb_count = pool_elts(load_balance_pool);
+
+    for (ii = 0; ii < N_R_PATHS; ii++)
+    {
+        ip46_address_t nh = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a02 + ii),
+        };
+
+        ais[ii] = adj_nbr_add_or_lock(FIB_PROTOCOL_IP4,
+                                      VNET_LINK_IP4,
+                                      &nh, tm->hw[0]->sw_if_index);
+
+        bfds[ii].udp.key.peer_addr = nh;
+        bfds[ii].udp.key.sw_if_index = tm->hw[0]->sw_if_index;
+        bfds[ii].hop_type = BFD_HOP_TYPE_SINGLE;
+        bfds[ii].local_state = BFD_STATE_init;
+        adj_bfd_notify(BFD_LISTEN_EVENT_CREATE, &bfds[ii]);
+        bfds[ii].local_state = BFD_STATE_up;
+        adj_bfd_notify(BFD_LISTEN_EVENT_UPDATE, &bfds[ii]);
+
+        fib_route_path_t rp = {
+            .frp_proto = DPO_PROTO_IP4,
+            .frp_addr = nh,
+            .frp_sw_if_index = tm->hw[0]->sw_if_index,
+            .frp_weight = 1,
+            .frp_fib_index = ~0,
+        };
+        vec_add1(r_paths, rp);
+    }
+
+    /*
+     * the same 8 paths for both prefixes, the 9th is added later
+     */
+    r_paths8 = vec_dup(r_paths);
+    _vec_len(r_paths8) = N_R_PATHS - 1;
+    vec_add1(r_path9, r_paths[N_R_PATHS - 1]);
+
+    fei[0] = fib_table_entry_path_add2(0, &pfx[0], FIB_SOURCE_API,
+                                       FIB_ENTRY_FLAG_RESILIENT, r_paths8);
+    fei[1] = fib_table_entry_path_add2(0, &pfx[1], FIB_SOURCE_API,
+                                       FIB_ENTRY_FLAG_NONE, r_paths8);
+
+    for (ii = 0; ii < 2; ii++)
+    {
+        fib_entry_contribute_forwarding(fei[ii],
+                                        FIB_FORW_CHAIN_TYPE_UNICAST_IP4,
+                                        &dpo[ii]);
+        fib_test_lb_flows(&dpo[ii], flows[ii][0]);
+    }
+
+    lbi = dpo[0].dpoi_index;
+    lb = load_balance_get(lbi);
+    FIB_TEST((LB_RESILIENT_N_BUCKETS == lb->lb_n_buckets),
+             "resilient LB has %d buckets", lb->lb_n_buckets);
+    FIB_TEST((lb->lb_flags & LOAD_BALANCE_FLAG_RESILIENT),
+             "resilient LB flags");
+
+    for (ii = 0; ii < N_R_PATHS - 1; ii++)
+    {
+        u32 jj, n = 0;
+
+        for (jj = 0; jj < lb->lb_n_buckets; jj++)
+        {
+            n += (load_balance_get_bucket_i(lb, jj)->dpoi_index == ais[ii]);
+        }
+        FIB_TEST((LB_RESILIENT_N_BUCKETS / (N_R_PATHS - 1) == n),
+                 "path %d has %d buckets", ii, n);
+    }
+
+    /*
+     * take down one of the paths. only its flows move in the resilient
+     * LB, but many more in the other.
+     */
+    bfds[3].local_state = BFD_STATE_down;
+    adj_bfd_notify(BFD_LISTEN_EVENT_UPDATE, &bfds[3]);
+
+    for (ii = 0; ii < 2; ii++)
+    {
+        fib_entry_contribute_forwarding(fei[ii],
+                                        FIB_FORW_CHAIN_TYPE_UNICAST_IP4,
+                                        &dpo[ii]);
+        fib_test_lb_flows(&dpo[ii], flows[ii][1]);
+        n_moved[ii] = fib_test_lb_flows_moved(flows[ii][0], flows[ii][1]);
+    }
+    FIB_TEST((dpo[0].dpoi_index == lbi),
+             "resilient LB updated in place");
+    FIB_TEST((N_FLOWS / (N_R_PATHS - 1) == n_moved[0]),
+             "path down: %d/%d flows moved", n_moved[0], N_FLOWS);
+    for (ii = 0; ii < N_FLOWS; ii++)
+    {
+        if (flows[0][0][ii] != flows[0][1][ii] &&
+            flows[0][0][ii] != ais[3])
+            break;
+    }
+    FIB_TEST((N_FLOWS == ii), "path down: only the down path's flows moved");
+    FIB_TEST((n_moved[1] > n_moved[0]),
+             "path down: %d/%d flows moved without resilience",
+             n_moved[1], N_FLOWS);
+
+    /*
+     * and back up. the flows it gets come equally from the others.
+     */
+    bfds[3].local_state = BFD_STATE_up;
+    adj_bfd_notify(BFD_LISTEN_EVENT_UPDATE, &bfds[3]);
+
+    for (ii = 0; ii < 2; ii++)
+    {
+        fib_entry_contribute_forwarding(fei[ii],
+                                        FIB_FORW_CHAIN_TYPE_UNICAST_IP4,
+                                        &dpo[ii]);
+        fib_test_lb_flows(&dpo[ii], flows[ii][0]);
+        n_moved[ii] = fib_test_lb_flows_moved(flows[ii][1], flows[ii][0]);
+    }
+    FIB_TEST((N_FLOWS / (N_R_PATHS - 1) == n_moved[0]),
+             "path up: %d/%d flows moved", n_moved[0], N_FLOWS);
+    FIB_TEST((n_moved[1] > n_moved[0]),
+             "path up: %d/%d flows moved without resilience",
+             n_moved[1], N_FLOWS);
+
+    /*
+     * a new path. the flows that move, move only to the new path.
+     */
+    fib_table_entry_path_add2(0, &pfx[0], FIB_SOURCE_API,
+                              FIB_ENTRY_FLAG_RESILIENT, r_path9);
+    fib_table_entry_path_add2(0, &pfx[1], FIB_SOURCE_API,
+                              FIB_ENTRY_FLAG_NONE, r_path9);
+
+    for (ii = 0; ii < 2; ii++)
+    {
+        fib_entry_contribute_forwarding(fei[ii],
+                                        FIB_FORW_CHAIN_TYPE_UNICAST_IP4,
+                                        &dpo[ii]);
+        fib_test_lb_flows(&dpo[ii], flows[ii][1]);
+        n_moved[ii] = fib_test_lb_flows_moved(flows[ii][0], flows[ii][1]);
+    }
+    f = flows[0][1];
+    for (ii = 0; ii < N_FLOWS; ii++)
+    {
+        if (flows[0][0][ii] != f[ii] && f[ii] != ais[N_R_PATHS - 1])
+            break;
+    }
+    FIB_TEST((N_FLOWS == ii), "path add: flows moved only to the new path");
+    FIB_TEST((n_moved[0] <= N_FLOWS / (N_R_PATHS - 1)),
+             "path add: %d/%d flows moved", n_moved[0], N_FLOWS);
+    FIB_TEST((n_moved[1] > n_moved[0]),
+             "path add: %d/%d flows moved without resilience",
+             n_moved[1], N_FLOWS);
+
+    /*
+     * clean-up
+     */
+    for (ii = 0; ii < 2; ii++)
+    {
+        dpo_reset(&dpo[ii]);
+        fib_table_entry_delete(0, &pfx[ii], FIB_SOURCE_API);
+    }
+    for (ii = 0; ii < N_R_PATHS; ii++)
+    {
+        adj_bfd_notify(BFD_LISTEN_EVENT_DELETE, &bfds[ii]);
+        adj_unlock(ais[ii]);
+    }
+    vec_free(r_paths);
+    vec_free(r_paths8);
+    vec_free(r_path9);
+
+    vlib_epoch_synchronize();
+    FIB_TEST(lb_count == pool_elts(load_balance_pool), "no leaked LBs");
+
+    return (res);
+}
+
 static clib_error_t *
 fib_test (vlib_main_t * vm,
           unformat_input_t * input,
@@ -10749,6 +11000,10 @@ fib_test (vlib_main_t * vm,
     {
         res += fib_test_sticky();
     }
+    else if (unformat (input, "resilient"))
+    {
+        res += fib_test_resilient();
+    }
     else
     {
         res += fib_test_v4();
@@ -10758,6 +11013,7 @@ fib_test (vlib_main_t * vm,
         res += fib_test_pref();
         res += fib_test_label();
         res += fib_test_inherit();
+        res += fib_test_resilient();
         res += lfib_test();
 
         /*
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <vlib/vlib.h>
+#include <vppinfra/random.h>
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip4_mtrie.h>
+#include <vnet/ip/ip4_poptrie.h>
+
+typedef struct
+{
+  ip4_address_t addr;
+  u32 len;
+  u32 lb_index;
+} ip4_poptrie_test_route_t;
+
+typedef struct
+{
+  u32 n_routes;
+  u32 n_lookups;
+  u32 n_deletes;
+  u32 seed;
+  int verbose;
+
+  ip4_poptrie_test_route_t *routes;
+  ip4_address_t *addrs;
+  ip4_fib_mtrie_t *mtrie;
+  ip4_poptrie_t *poptrie;
+} ip4_poptrie_test_main_t;
+
+static ip4_poptrie_test_main_t ip4_poptrie_test_main;
+
+/*
+ * Prefix lengths roughly as found in an internet table: mostly /24,
+ * then /16 to /23, with some shorter and some host routes.
+ */
+static u32
+ip4_poptrie_test_random_len (u32 * seed)
+{
+  u32 r = random_u32 (seed) % 100;
+
+  if (r < 55)
+    return 24;
+  if (r < 85)
+    return 16 + random_u32 (seed) % 8;
+  if (r < 92)
+    return 8 + random_u32 (seed) % 8;
+  return 25 + random_u32 (seed) % 8;
+}
+
+static u32
+ip4_poptrie_test_mask (u32 len)
+{
+  return (len ? (u32) ~0 << (32 - len) : 0);
+}
+
+/*
+ * The longest of the test's routes, other than the route itself, that
+ * covers the route. The default route always does.
+ */
+static ip4_poptrie_test_route_t *
+ip4_poptrie_test_cover (ip4_poptrie_test_main_t * tm,
+			ip4_poptrie_test_route_t * r)
+{
+  ip4_poptrie_test_route_t *c, *best = NULL;
+  u32 a = clib_net_to_host_u32 (r->addr.as_u32);
+
+  vec_foreach (c, tm->routes)
+  {
+    if (c == r || c->len >= r->len)
+      continue;
+    if ((a & ip4_poptrie_test_mask (c->len)) !=
+	clib_net_to_host_u32 (c->addr.as_u32))
+      continue;
+    if (NULL == best || c->len > best->len)
+      best = c;
+  }
+  return (best);
+}
+
+always_inline u32
+ip4_poptrie_test_mtrie_lookup (ip4_fib_mtrie_t * m, ip4_address_t * a)
+{
+  ip4_fib_mtrie_leaf_t leaf;
+
+  leaf = ip4_fib_mtrie_lookup_step_one (m, a);
+  leaf = ip4_fib_mtrie_lookup_step (m, leaf, a, 2);
+  leaf = ip4_fib_mtrie_lookup_step (m, leaf, a, 3);
+
+  return (ip4_fib_mtrie_leaf_get_adj_index (leaf));
+}
+
+static int
+ip4_poptrie_test_verify (vlib_main_t * vm, ip4_poptrie_test_main_t * tm)
+{
+  ip4_poptrie_test_route_t *r;
+  ip4_address_t *a, ra;
+  u32 m, p;
+
+  vec_foreach (a, tm->addrs)
+  {
+    m = ip4_poptrie_test_mtrie_lookup (tm->mtrie, a);
+    p = ip4_poptrie_lookup (tm->poptrie, a);
+    if (m != p)
+      {
+	vlib_cli_output (vm, "FAIL: %U mtrie:%d poptrie:%d",
+			 format_ip4_address, a, m, p);
+	return 1;
+      }
+  }
+
+  /* the first and last address of each route */
+  vec_foreach (r, tm->routes)
+  {
+    ra.as_u32 = r->addr.as_u32;
+    if (ip4_poptrie_test_mtrie_lookup (tm->mtrie, &ra) !=
+	ip4_poptrie_lookup (tm->poptrie, &ra))
+      goto fail;
+    ra.as_u32 |= clib_host_to_net_u32 (~ip4_poptrie_test_mask (r->len));
+    if (ip4_poptrie_test_mtrie_lookup (tm->mtrie, &ra) !=
+	ip4_poptrie_lookup (tm->poptrie, &ra))
+      goto fail;
+  }
+  return 0;
+
+fail:
+  vlib_cli_output (vm, "FAIL: %U in %U/%d",
+		   format_ip4_address, &ra,
+		   format_ip4_address, &r->addr, r->len);
+  return 1;
+}
+
+static f64
+ip4_poptrie_test_time_mtrie (ip4_poptrie_test_main_t * tm, u64 * sum)
+{
+  ip4_address_t *a;
+  u64 t0;
+
+  t0 = clib_cpu_time_now ();
+  vec_foreach (a, tm->addrs)
+  {
+    *sum += ip4_poptrie_test_mtrie_lookup (tm->mtrie, a);
+  }
+  return ((f64) (clib_cpu_time_now () - t0) / vec_len (tm->addrs));
+}
+
+static f64
+ip4_poptrie_test_time_poptrie (ip4_poptrie_test_main_t * tm, u64 * sum)
+{
+  ip4_address_t *a;
+  u64 t0;
+
+  t0 = clib_cpu_time_now ();
+  vec_foreach (a, tm->addrs)
+  {
+    *sum += ip4_poptrie_lookup (tm->poptrie, a);
+  }
+  return ((f64) (clib_cpu_time_now () - t0) / vec_len (tm->addrs));
+}
+
+/*
+ * Time each structure over the same addresses, the best of a few
+ * passes, so that neither is charged for warming the caches.
+ */
+static void
+ip4_poptrie_test_time (vlib_main_t * vm, ip4_poptrie_test_main_t * tm)
+{
+  f64 m = 1e9, p = 1e9;
+  u64 sum = 0;
+  int i;
+
+  for (i = 0; i < 3; i++)
+    {
+      m = clib_min (m, ip4_poptrie_test_time_mtrie (tm, &sum));
+      p = clib_min (p, ip4_poptrie_test_time_poptrie (tm, &sum));
+    }
+
+  vlib_cli_output (vm, "%d lookups (check %llx)", vec_len (tm->addrs), sum);
+  vlib_cli_output (vm, "  mtrie:   %.2f clocks/lookup, memory %U",
+		   m, format_memory_size,
+		   ip4_fib_mtrie_memory_usage (tm->mtrie));
+  vlib_cli_output (vm, "  poptrie: %.2f clocks/lookup, memory %U",
+		   p, format_memory_size,
+		   ip4_poptrie_memory_usage (tm->poptrie));
+}
+
+static clib_error_t *
+test_ip4_poptrie (vlib_main_t * vm, ip4_poptrie_test_main_t * tm)
+{
+  ip4_poptrie_test_route_t *r, *c;
+  clib_error_t *error = NULL;
+  uword *seen;
+  u32 i, a;
+  u64 key;
+
+  tm->mtrie = clib_mem_alloc_aligned (sizeof (*tm->mtrie),
+				      CLIB_CACHE_LINE_BYTES);
+  ip4_mtrie_init (tm->mtrie);
+  tm->poptrie = ip4_poptrie_create ();
+
+  /* a default route first, then unique random routes */
+  seen = hash_create (0, sizeof (uword));
+  vec_add2 (tm->routes, r, 1);
+  r->addr.as_u32 = 0;
+  r->len = 0;
+  r->lb_index = 1;
+  hash_set (seen, 0, 1);
+
+  while (vec_len (tm->routes) < tm->n_routes)
+    {
+      u32 len = ip4_poptrie_test_random_len (&tm->seed);
+
+      a = random_u32 (&tm->seed) & ip4_poptrie_test_mask (len);
+      key = ((u64) a << 8) | len;
+      if (hash_get (seen, key))
+	continue;
+      hash_set (seen, key, 1);
+
+      vec_add2 (tm->routes, r, 1);
+      r->addr.as_u32 = clib_host_to_net_u32 (a);
+      r->len = len;
+      r->lb_index = vec_len (tm->routes) + 1;
+    }
+  hash_free (seen);
+
+  vec_foreach (r, tm->routes)
+  {
+    ip4_fib_mtrie_route_add (tm->mtrie, &r->addr, r->len, r->lb_index);
+    ip4_poptrie_route_add (tm->poptrie, &r->addr, r->len, r->lb_index);
+  }
+
+  for (i = 0; i < tm->n_lookups; i++)
+    {
+      ip4_address_t *ia;
+
+      vec_add2 (tm->addrs, ia, 1);
+      ia->as_u32 = random_u32 (&tm->seed);
+    }
+
+  vlib_cli_output (vm, "%d routes", vec_len (tm->routes));
+  if (tm->verbose)
+    vlib_cli_output (vm, "%U", format_ip4_poptrie, tm->poptrie, 0);
+
+  if (ip4_poptrie_test_verify (vm, tm))
+    {
+      error = clib_error_return (0, "mtrie and poptrie differ after add");
+      goto done;
+    }
+  ip4_poptrie_test_time (vm, tm);
+
+  /* remove some routes, each replaced by its cover */
+  for (i = 0; i < tm->n_deletes && vec_len (tm->routes) > 1; i++)
+    {
+      r = tm->routes + 1 +
+	random_u32 (&tm->seed) % (vec_len (tm->routes) - 1);
+      c = ip4_poptrie_test_cover (tm, r);
+
+      ip4_fib_mtrie_route_del (tm->mtrie, &r->addr, r->len, r->lb_index,
+			       c->len, c->lb_index);
+      ip4_poptrie_route_del (tm->poptrie, &r->addr, r->len, r->lb_index,
+			     c->len, c->lb_index);
+      vec_del1 (tm->routes, r - tm->routes);
+    }
+
+  if (ip4_poptrie_test_verify (vm, tm))
+    {
+      error = clib_error_return (0, "mtrie and poptrie differ after delete");
+      goto done;
+    }
+  vlib_cli_output (vm, "%d routes after %d deletes",
+		   vec_len (tm->routes), tm->n_deletes);
+  ip4_poptrie_test_time (vm, tm);
+
+done:
+  ip4_mtrie_flush (tm->mtrie);
+  ip4_mtrie_free (tm->mtrie);
+  ip4_poptrie_free (tm->poptrie);
+  vlib_epoch_synchronize ();
+  clib_mem_free (tm->mtrie);
+  vec_free (tm->routes);
+  vec_free (tm->addrs);
+
+  return (error);
+}
+
+static clib_error_t *
+test_ip4_poptrie_command_fn (vlib_main_t * vm,
+			     unformat_input_t * input,
+			     vlib_cli_command_t * cmd)
+{
+  ip4_poptrie_test_main_t *tm = &ip4_poptrie_test_main;
+
+  tm->n_routes = 100000;
+  tm->n_lookups = 1000000;
+  tm->n_deletes = 1000;
+  tm->seed = 0xdeaddabe;
+  tm->verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "routes %u", &tm->n_routes))
+	;
+      else if (unformat (input, "lookups %u", &tm->n_lookups))
+	;
+      else if (unformat (input, "deletes %u", &tm->n_deletes))
+	;
+      else if (unformat (input, "seed %u", &tm->seed))
+	;
+      else if (unformat (input, "verbose"))
+	tm->verbose = 1;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (tm->n_routes == 0 || tm->n_lookups == 0)
+    return clib_error_return (0, "routes and lookups must be non-zero");
+
+  return (test_ip4_poptrie (vm, tm));
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_ip4_poptrie_command, static) =
+{
+  .path = "test ip4 poptrie",
+  .short_help = "test ip4 poptrie [routes <n>] [lookups <n>] [deletes <n>] "
+    "[seed <n>] [verbose]",
+  .function = test_ip4_poptrie_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <fcntl.h>
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vppinfra/random.h>
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip6_tree_bitmap.h>
+
+#include <vppinfra/bihash_24_8.h>
+#include <vppinfra/bihash_template.h>
+#include <vppinfra/bihash_template.c>
+
+typedef struct
+{
+  ip6_address_t addr;
+  u32 len;
+  u32 lb_index;
+} ip6_tree_bitmap_test_route_t;
+
+typedef struct
+{
+  u32 n_routes;
+  u32 n_lookups;
+  u32 n_deletes;
+  u32 seed;
+  int verbose;
+  u8 *file;
+
+  ip6_tree_bitmap_test_route_t *routes;
+  ip6_address_t *addrs;
+
+  /* the reference; a hash probed per prefix length, as the FIB does */
+  clib_bihash_24_8_t hash;
+  i32 refcounts[129];
+  u8 *lengths;
+
+  ip6_tree_bitmap_t *tbm;
+} ip6_tree_bitmap_test_main_t;
+
+static ip6_tree_bitmap_test_main_t ip6_tree_bitmap_test_main;
+
+static void
+ip6_tree_bitmap_test_mk_addr (ip6_address_t * a, u128 key)
+{
+  a->as_u64[0] = clib_host_to_net_u64 (key >> 64);
+  a->as_u64[1] = clib_host_to_net_u64 (key);
+}
+
+static u128
+ip6_tree_bitmap_test_mask (u32 len)
+{
+  return (len ? ~(u128) 0 << (128 - len) : 0);
+}
+
+static u128
+ip6_tree_bitmap_test_random (u32 * seed)
+{
+  u128 r = 0;
+  int i;
+
+  for (i = 0; i < 4; i++)
+    r = (r << 32) | random_u32 (seed);
+
+  return (r);
+}
+
+/*
+ * Prefix lengths roughly as found in the IPv6 default-free zone: half
+ * /48, then /32, /44, /40 and /36 with a scattering of the others from
+ * /19 to /64.
+ */
+static u32
+ip6_tree_bitmap_test_random_len (u32 * seed)
+{
+  u32 r = random_u32 (seed) % 100;
+
+  if (r < 48)
+    return 48;
+  if (r < 61)
+    return 32;
+  if (r < 68)
+    return 44;
+  if (r < 74)
+    return 40;
+  if (r < 78)
+    return 36;
+  if (r < 82)
+    return 46;
+  if (r < 85)
+    return 47;
+  if (r < 88)
+    return 29;
+  return 19 + random_u32 (seed) % 46;
+}
+
+static void
+ip6_tree_bitmap_test_hash_add_del (ip6_tree_bitmap_test_main_t * tm,
+				   ip6_tree_bitmap_test_route_t * r,
+				   int is_add)
+{
+  clib_bihash_kv_24_8_t kv;
+  u32 len;
+
+  kv.key[0] = r->addr.as_u64[0];
+  kv.key[1] = r->addr.as_u64[1];
+  kv.key[2] = r->len;
+  kv.value = r->lb_index;
+  clib_bihash_add_del_24_8 (&tm->hash, &kv, is_add);
+
+  if (is_add ? 0 == tm->refcounts[r->len]++ : 0 == --tm->refcounts[r->len])
+    {
+      vec_reset_length (tm->lengths);
+      for (len = 128; len != ~0; len--)
+	if (tm->refcounts[len])
+	  vec_add1 (tm->lengths, len);
+    }
+}
+
+/*
+ * Add a route to the test's list and to the reference, unless it is
+ * already there.
+ */
+static void
+ip6_tree_bitmap_test_route_add (ip6_tree_bitmap_test_main_t * tm,
+				const ip6_address_t * addr, u32 len)
+{
+  ip6_tree_bitmap_test_route_t *r;
+  clib_bihash_kv_24_8_t kv, value;
+
+  kv.key[0] = addr->as_u64[0];
+  kv.key[1] = addr->as_u64[1];
+  kv.key[2] = len;
+  if (0 == clib_bihash_search_24_8 (&tm->hash, &kv, &value))
+    return;
+
+  vec_add2 (tm->routes, r, 1);
+  r->addr = *addr;
+  r->len = len;
+  r->lb_index = vec_len (tm->routes);
+  ip6_tree_bitmap_test_hash_add_del (tm, r, 1);
+}
+
+always_inline u32
+ip6_tree_bitmap_test_hash_lookup (ip6_tree_bitmap_test_main_t * tm,
+				  const ip6_address_t * a)
+{
+  clib_bihash_kv_24_8_t kv, value;
+  ip6_address_t *mask;
+  int i;
+
+  kv.key[0] = a->as_u64[0];
+  kv.key[1] = a->as_u64[1];
+
+  for (i = 0; i < vec_len (tm->lengths); i++)
+    {
+      mask = &ip6_main.fib_masks[tm->lengths[i]];
+      kv.key[0] &= mask->as_u64[0];
+      kv.key[1] &= mask->as_u64[1];
+      kv.key[2] = tm->lengths[i];
+
+      if (0 == clib_bihash_search_inline_2_24_8 (&tm->hash, &kv, &value))
+	return (value.value);
+    }
+  return (0);
+}
+
+static int
+ip6_tree_bitmap_test_verify (vlib_main_t * vm,
+			     ip6_tree_bitmap_test_main_t * tm)
+{
+  ip6_tree_bitmap_test_route_t *r;
+  ip6_address_t *a, ra;
+  u32 h, t;
+
+  vec_foreach (a, tm->addrs)
+  {
+    h = ip6_tree_bitmap_test_hash_lookup (tm, a);
+    t = ip6_tree_bitmap_lookup (tm->tbm, a);
+    if (h != t)
+      {
+	vlib_cli_output (vm, "FAIL: %U hash:%d tree-bitmap:%d",
+			 format_ip6_address, a, h, t);
+	return 1;
+      }
+  }
+
+  /* the first and last address of each route */
+  vec_foreach (r, tm->routes)
+  {
+    ra = r->addr;
+    if (ip6_tree_bitmap_test_hash_lookup (tm, &ra) !=
+	ip6_tree_bitmap_lookup (tm->tbm, &ra))
+      goto fail;
+    ip6_tree_bitmap_test_mk_addr (&ra,
+				  ip6_tree_bitmap_key (&r->addr) |
+				  ~ip6_tree_bitmap_test_mask (r->len));
+    if (ip6_tree_bitmap_test_hash_lookup (tm, &ra) !=
+	ip6_tree_bitmap_lookup (tm->tbm, &ra))
+      goto fail;
+  }
+  return 0;
+
+fail:
+  vlib_cli_output (vm, "FAIL: %U in %U/%d",
+		   format_ip6_address, &ra,
+		   format_ip6_address, &r->addr, r->len);
+  return 1;
+}
+
+static f64
+ip6_tree_bitmap_test_time_hash (ip6_tree_bitmap_test_main_t * tm, u64 * sum)
+{
+  ip6_address_t *a;
+  u64 t0;
+
+  t0 = clib_cpu_time_now ();
+  vec_foreach (a, tm->addrs)
+  {
+    *sum += ip6_tree_bitmap_test_hash_lookup (tm, a);
+  }
+  return ((f64) (clib_cpu_time_now () - t0) / vec_len (tm->addrs));
+}
+
+static f64
+ip6_tree_bitmap_test_time_tbm (ip6_tree_bitmap_test_main_t * tm, u64 * sum)
+{
+  ip6_address_t *a;
+  u64 t0;
+
+  t0 = clib_cpu_time_now ();
+  vec_foreach (a, tm->addrs)
+  {
+    *sum += ip6_tree_bitmap_lookup (tm->tbm, a);
+  }
+  return ((f64) (clib_cpu_time_now () - t0) / vec_len (tm->addrs));
+}
+
+static void
+ip6_tree_bitmap_test_time (vlib_main_t * vm, ip6_tree_bitmap_test_main_t * tm)
+{
+  f64 h = 1e9, t = 1e9;
+  u64 sum = 0;
+  int i;
+
+  for (i = 0; i < 3; i++)
+    {
+      h = clib_min (h, ip6_tree_bitmap_test_time_hash (tm, &sum));
+      t = clib_min (t, ip6_tree_bitmap_test_time_tbm (tm, &sum));
+    }
+
+  vlib_cli_output (vm, "%d lookups, %d prefix lengths (check %llx)",
+		   vec_len (tm->addrs), vec_len (tm->lengths), sum);
+  vlib_cli_output (vm, "  hash:        %.2f clocks/lookup", h);
+  vlib_cli_output (vm, "  tree-bitmap: %.2f clocks/lookup, %U",
+		   t, format_ip6_tree_bitmap, tm->tbm, 0);
+}
+
+static clib_error_t *
+ip6_tree_bitmap_test_read_file (ip6_tree_bitmap_test_main_t * tm)
+{
+  unformat_input_t input;
+  ip6_address_t addr;
+  int fd;
+  u32 len;
+
+  fd = open ((char *) tm->file, O_RDONLY);
+  if (fd < 0)
+    return clib_error_return_unix (0, "open `%s'", tm->file);
+
+  unformat_init_clib_file (&input, fd);
+
+  while (unformat_check_input (&input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (&input, "%U/%d", unformat_ip6_address, &addr, &len) &&
+	  len <= 128)
+	{
+	  ip6_address_mask (&addr, &ip6_main.fib_masks[len]);
+	  ip6_tree_bitmap_test_route_add (tm, &addr, len);
+	}
+      else
+	unformat_skip_line (&input);
+    }
+
+  unformat_free (&input);
+  close (fd);
+
+  return (NULL);
+}
+
+/*
+ * Random routes, clustered as they are in the 2000::/3 unicast space:
+ * the longer prefixes are mostly below a smaller set of /32s.
+ */
+static void
+ip6_tree_bitmap_test_random_routes (ip6_tree_bitmap_test_main_t * tm)
+{
+  u128 *holders = NULL, key;
+  ip6_address_t addr;
+  u32 i, len;
+
+  for (i = 0; i < clib_max (tm->n_routes / 8, 1); i++)
+    vec_add1 (holders,
+	      ((u128) 1 << 125) |
+	      (ip6_tree_bitmap_test_random (&tm->seed) &
+	       ip6_tree_bitmap_test_mask (32) & ~ip6_tree_bitmap_test_mask (3)));
+
+  while (vec_len (tm->routes) < tm->n_routes)
+    {
+      len = ip6_tree_bitmap_test_random_len (&tm->seed);
+      key = ip6_tree_bitmap_test_random (&tm->seed);
+
+      if (len > 32)
+	key = (holders[random_u32 (&tm->seed) % vec_len (holders)] |
+	       (key & ~ip6_tree_bitmap_test_mask (32)));
+      else
+	key = ((u128) 1 << 125) | (key & ~ip6_tree_bitmap_test_mask (3));
+
+      ip6_tree_bitmap_test_mk_addr (&addr,
+				    key & ip6_tree_bitmap_test_mask (len));
+      ip6_tree_bitmap_test_route_add (tm, &addr, len);
+    }
+
+  vec_free (holders);
+}
+
+static clib_error_t *
+test_ip6_tree_bitmap (vlib_main_t * vm, ip6_tree_bitmap_test_main_t * tm)
+{
+  ip6_tree_bitmap_test_route_t *r;
+  clib_error_t *error = NULL;
+  ip6_address_t addr;
+  u32 i, n_deletes;
+  u128 key;
+  f64 t0;
+
+  clib_memset (tm->refcounts, 0, sizeof (tm->refcounts));
+  clib_bihash_init_24_8 (&tm->hash, "test ip6 tree-bitmap",
+			 64 << 10, 256 << 20);
+  tm->tbm = ip6_tree_bitmap_create ();
+
+  /* a default route first */
+  clib_memset (&addr, 0, sizeof (addr));
+  ip6_tree_bitmap_test_route_add (tm, &addr, 0);
+
+  if (tm->file)
+    error = ip6_tree_bitmap_test_read_file (tm);
+  else
+    ip6_tree_bitmap_test_random_routes (tm);
+  if (error)
+    goto done;
+
+  t0 = vlib_time_now (vm);
+  vec_foreach (r, tm->routes)
+  {
+    ip6_tree_bitmap_route_add (tm->tbm, &r->addr, r->len, r->lb_index);
+  }
+  vlib_cli_output (vm, "%d routes, tree-bitmap built in %.3fs",
+		   vec_len (tm->routes), vlib_time_now (vm) - t0);
+
+  /* mostly addresses within the routes, some anywhere in 2000::/3 */
+  for (i = 0; i < tm->n_lookups; i++)
+    {
+      ip6_address_t *ia;
+
+      key = ip6_tree_bitmap_test_random (&tm->seed);
+      if (random_u32 (&tm->seed) % 10)
+	{
+	  r = tm->routes + random_u32 (&tm->seed) % vec_len (tm->routes);
+	  key = ((ip6_tree_bitmap_key (&r->addr) &
+		  ip6_tree_bitmap_test_mask (r->len)) |
+		 (key & ~ip6_tree_bitmap_test_mask (r->len)));
+	}
+      else
+	key = ((u128) 1 << 125) | (key & ~ip6_tree_bitmap_test_mask (3));
+
+      vec_add2 (tm->addrs, ia, 1);
+      ip6_tree_bitmap_test_mk_addr (ia, key);
+    }
+
+  if (tm->verbose)
+    vlib_cli_output (vm, "%U", format_ip6_tree_bitmap, tm->tbm, 1);
+
+  if (ip6_tree_bitmap_test_verify (vm, tm))
+    {
+      error = clib_error_return (0, "hash and tree-bitmap differ after add");
+      goto done;
+    }
+  ip6_tree_bitmap_test_time (vm, tm);
+
+  /* remove some routes, never the default */
+  n_deletes = clib_min (tm->n_deletes, vec_len (tm->routes) - 1);
+  for (i = 0; i < n_deletes; i++)
+    {
+      r = tm->routes + 1 +
+	random_u32 (&tm->seed) % (vec_len (tm->routes) - 1);
+
+      ip6_tree_bitmap_test_hash_add_del (tm, r, 0);
+      ip6_tree_bitmap_route_del (tm->tbm, &r->addr, r->len);
+      vec_del1 (tm->routes, r - tm->routes);
+    }
+
+  if (ip6_tree_bitmap_test_verify (vm, tm))
+    {
+      error = clib_error_return (0,
+				 "hash and tree-bitmap differ after delete");
+      goto done;
+    }
+  vlib_cli_output (vm, "%d routes after %d deletes",
+		   vec_len (tm->routes), n_deletes);
+  ip6_tree_bitmap_test_time (vm, tm);
+
+  /* and all of them, which should leave only the root */
+  vec_foreach (r, tm->routes)
+  {
+    ip6_tree_bitmap_route_del (tm->tbm, &r->addr, r->len);
+  }
+  if (tm->tbm->n_nodes != 1 || tm->tbm->n_routes != 0)
+    error = clib_error_return (0, "FAIL: %d nodes, %d routes left",
+			       tm->tbm->n_nodes, tm->tbm->n_routes);
+
+done:
+  ip6_tree_bitmap_free (tm->tbm);
+  vlib_epoch_synchronize ();
+  clib_bihash_free_24_8 (&tm->hash);
+  vec_free (tm->lengths);
+  vec_free (tm->routes);
+  vec_free (tm->addrs);
+
+  return (error);
+}
+
+static clib_error_t *
+test_ip6_tree_bitmap_command_fn (vlib_main_t * vm,
+				 unformat_input_t * input,
+				 vlib_cli_command_t * cmd)
+{
+  ip6_tree_bitmap_test_main_t *tm = &ip6_tree_bitmap_test_main;
+  clib_error_t *error;
+
+  tm->n_routes = 150000;
+  tm->n_lookups = 1000000;
+  tm->n_deletes = 1000;
+  tm->seed = 0xdeaddabe;
+  tm->verbose = 0;
+  tm->file = NULL;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "routes %u", &tm->n_routes))
+	;
+      else if (unformat (input, "lookups %u", &tm->n_lookups))
+	;
+      else if (unformat (input, "deletes %u", &tm->n_deletes))
+	;
+      else if (unformat (input, "seed %u", &tm->seed))
+	;
+      else if (unformat (input, "file %s", &tm->file))
+	vec_terminate_c_string (tm->file);
+      else if (unformat (input, "verbose"))
+	tm->verbose = 1;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (tm->n_routes == 0 || tm->n_lookups == 0)
+    return clib_error_return (0, "routes and lookups must be non-zero");
+
+  error = test_ip6_tree_bitmap (vm, tm);
+  vec_free (tm->file);
+
+  return (error);
+}
+
+/*?
+ * Cross-check the IPv6 tree bitmap against the per prefix length hash
+ * probing of the forwarding table, and compare the cost of lookups in
+ * each. The routes are random with a DFZ-like distribution of prefix
+ * lengths, or read from a file of "<prefix>/<length>" lines, for example
+ * a dump of a full table.
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_ip6_tree_bitmap_command, static) =
+{
+  .path = "test ip6 tree-bitmap",
+  .short_help = "test ip6 tree-bitmap [routes <n>] [lookups <n>] "
+    "[deletes <n>] [seed <n>] [file <prefixes>] [verbose]",
+  .function = test_ip6_tree_bitmap_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <vlib/vlib.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/ip/ip.h>
+#include <vnet/ip-neighbor/ip_neighbor.h>
+
+/*
+ * Populate a table of dynamic ip4 neighbours on a loopback and let them
+ * age out. Reports the cost of adding them and the longest time the age
+ * process held the main thread while probing and removing them.
+ */
+typedef struct
+{
+  u32 n_neighbors;
+  u32 age;
+  int no_fib_entry;
+
+  u32 sw_if_index;
+} ip_neighbor_test_main_t;
+
+static ip_neighbor_test_main_t ip_neighbor_test_main = {
+  .sw_if_index = ~0,
+};
+
+static walk_rc_t
+ip_neighbor_test_count (index_t ipni, void *arg)
+{
+  u32 *n = arg;
+
+  (*n)++;
+
+  return (WALK_CONTINUE);
+}
+
+static u32
+ip_neighbor_test_n_neighbors (ip_neighbor_test_main_t * tm)
+{
+  u32 n = 0;
+
+  ip_neighbor_walk (AF_IP4, tm->sw_if_index, ip_neighbor_test_count, &n);
+
+  return (n);
+}
+
+static clib_error_t *
+ip_neighbor_test_scale (vlib_main_t * vm, ip_neighbor_test_main_t * tm)
+{
+  vlib_node_runtime_t *rt;
+  ip_neighbor_flags_t flags;
+  u32 limit, age, i, n;
+  clib_error_t *error;
+  f64 t0, deadline;
+  bool recycle;
+  u64 c0;
+  int rv;
+
+  error = NULL;
+
+  if (~0 == tm->sw_if_index)
+    {
+      ip4_address_t addr = {
+	.as_u32 = clib_host_to_net_u32 (0x0a000001),
+      };
+      u8 mac[6] = { 0 };
+
+      if (vnet_create_loopback_interface (&tm->sw_if_index, mac, 0, 0))
+	return clib_error_return (0, "failed to create loopback");
+
+      vnet_sw_interface_set_flags (vnet_get_main (), tm->sw_if_index,
+				   VNET_SW_INTERFACE_FLAG_ADMIN_UP);
+      error = ip4_add_del_interface_address (vm, tm->sw_if_index,
+					     &addr, 8, 0);
+      if (error)
+	return (error);
+    }
+
+  ip_neighbor_config_get (AF_IP4, &limit, &age, &recycle);
+  ip_neighbor_config (AF_IP4, 0, 0, false);
+
+  flags = IP_NEIGHBOR_FLAG_DYNAMIC;
+  if (tm->no_fib_entry)
+    flags |= IP_NEIGHBOR_FLAG_NO_FIB_ENTRY;
+
+  c0 = clib_cpu_time_now ();
+  t0 = vlib_time_now (vm);
+
+  for (i = 0; i < tm->n_neighbors; i++)
+    {
+      ip_address_t ip = {
+	.ip.ip4.as_u32 = clib_host_to_net_u32 (0x0a000002 + i),
+	.version = AF_IP4,
+      };
+      mac_address_t mac = {
+	.bytes = {0x02, 0, 0, 0, 0, 0},
+      };
+
+      mac.bytes[2] = i >> 24;
+      mac.bytes[3] = i >> 16;
+      mac.bytes[4] = i >> 8;
+      mac.bytes[5] = i;
+
+      rv = ip_neighbor_add (&ip, &mac, tm->sw_if_index, flags, NULL);
+
+      if (rv)
+	{
+	  error = clib_error_return (0, "add of neighbor %d failed: %d",
+				     i, rv);
+	  goto done;
+	}
+    }
+
+  vlib_cli_output (vm, "%d neighbors added in %.2fs, %.0f clocks/add",
+		   tm->n_neighbors, vlib_time_now (vm) - t0,
+		   (f64) (clib_cpu_time_now () - c0) / tm->n_neighbors);
+
+  /* enable aging; this starts a timer for each */
+  c0 = clib_cpu_time_now ();
+  ip_neighbor_config (AF_IP4, 0, tm->age, false);
+  vlib_cli_output (vm, "aging enabled in %.0f clocks/neighbor",
+		   (f64) (clib_cpu_time_now () - c0) / tm->n_neighbors);
+
+  rt = vlib_node_get_runtime
+    (vm, vlib_get_node_by_name (vm, (u8 *) "ip4-neighbor-age-process")->
+     index);
+  rt->max_clock = 0;
+
+  /*
+   * each is probed 3 times, a second apart, before it is removed. Give up
+   * only once no more are being removed.
+   */
+  t0 = vlib_time_now (vm);
+  deadline = t0 + tm->age + 10;
+  n = tm->n_neighbors;
+
+  do
+    {
+      u32 n_last = n;
+
+      vlib_process_suspend (vm, 0.5);
+      n = ip_neighbor_test_n_neighbors (tm);
+
+      if (n != n_last)
+	deadline = clib_max (deadline, vlib_time_now (vm) + 5);
+    }
+  while (n && vlib_time_now (vm) < deadline);
+
+  if (n)
+    error = clib_error_return (0, "%d neighbors not aged out", n);
+  else
+    vlib_cli_output (vm, "all aged out in %.2fs, age process max %u clocks "
+		     "per run", vlib_time_now (vm) - t0, rt->max_clock);
+
+done:
+  ip_neighbor_del_all (AF_IP4, tm->sw_if_index);
+  ip_neighbor_config (AF_IP4, limit, age, recycle);
+
+  return (error);
+}
+
+static clib_error_t *
+test_ip_neighbor_command_fn (vlib_main_t * vm,
+			     unformat_input_t * input,
+			     vlib_cli_command_t * cmd)
+{
+  ip_neighbor_test_main_t *tm = &ip_neighbor_test_main;
+  unformat_input_t _line_input, *line_input = &_line_input;
+
+  tm->n_neighbors = 1000000;
+  tm->age = 2;
+  tm->no_fib_entry = 0;
+
+  if (unformat_user (input, unformat_line_input, line_input))
+    {
+      while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+	{
+	  if (unformat (line_input, "neighbors %u", &tm->n_neighbors))
+	    ;
+	  else if (unformat (line_input, "age %u", &tm->age))
+	    ;
+	  else if (unformat (line_input, "no-fib-entry"))
+	    tm->no_fib_entry = 1;
+	  else
+	    {
+	      clib_error_t *error;
+
+	      error = clib_error_return (0, "unknown input '%U'",
+					 format_unformat_error, line_input);
+	      unformat_free (line_input);
+	      return (error);
+	    }
+	}
+      unformat_free (line_input);
+    }
+
+  if (tm->n_neighbors == 0 || tm->n_neighbors > (1 << 24) - 2 ||
+      tm->age == 0)
+    return clib_error_return (0, "neighbors must be 1 to 16M, "
+			      "age non-zero");
+
+  return (ip_neighbor_test_scale (vm, tm));
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_ip_neighbor_command, static) =
+{
+  .path = "test ip neighbor scale",
+  .short_help = "test ip neighbor scale [neighbors <n>] [age <seconds>] "
+    "[no-fib-entry]",
+  .function = test_ip_neighbor_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -74,6 +74,18 @@ buffer_gauges_update_available_fn (stat_segment_directory_entry_t * e,
 static void
 buffer_gauges_update_used_fn (stat_segment_directory_entry_t * e, u32 index);
 
+static void
+buffer_gauges_update_total_fn (stat_segment_directory_entry_t * e,
+			       u32 index);
+
+static void
+buffer_gauges_update_used_high_watermark_fn (stat_segment_directory_entry_t
+					     * e, u32 index);
+
+static void
+buffer_gauges_update_free_low_watermark_fn (stat_segment_directory_entry_t *
+					    e, u32 index);
+
 uword
 vlib_buffer_length_in_chain_slow_path (vlib_main_t * vm,
 				       vlib_buffer_t * b_first)
@@ -517,6 +529,47 @@ vlib_buffer_alloc_size (uword ext_hdr_size, uword data_size)
   return alloc_size;
 }
 
+/* Initialize the buffers in physmem map m, store their indices */
+static u32
+vlib_buffer_pool_carve (vlib_main_t * vm, vlib_buffer_pool_t * bp,
+			vlib_physmem_map_t * m, u32 * buffers)
+{
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  u32 alloc_size, n_alloc_per_page, n_buffers = 0;
+  uword i, j;
+
+  alloc_size = vlib_buffer_alloc_size (bm->ext_hdr_size, bp->data_size);
+  n_alloc_per_page = (1ULL << m->log2_page_size) / alloc_size;
+
+  for (j = 0; j < m->n_pages; j++)
+    for (i = 0; i < n_alloc_per_page; i++)
+      {
+	u8 *p;
+	u32 bi;
+
+	p = m->base + (j << m->log2_page_size) + i * alloc_size;
+	p += bm->ext_hdr_size;
+
+	/*
+	 * Waste 1 buffer (maximum) so that 0 is never a valid buffer index.
+	 * Allows various places to ASSERT (bi != 0). Much easier
+	 * than debugging downstream crashes in successor nodes.
+	 */
+	if (p == m->base)
+	  continue;
+
+	vlib_buffer_copy_template ((vlib_buffer_t *) p, &bp->buffer_template);
+
+	bi = vlib_get_buffer_index (vm, (vlib_buffer_t *) p);
+
+	buffers[n_buffers++] = bi;
+
+	vlib_get_buffer (vm, bi);
+      }
+
+  return n_buffers;
+}
+
 u8
 vlib_buffer_pool_create (vlib_main_t * vm, char *name, u32 data_size,
 			 u32 physmem_map_index)
@@ -526,7 +579,6 @@ vlib_buffer_pool_create (vlib_main_t * vm, char *name, u32 data_size,
   vlib_physmem_map_t *m = vlib_physmem_get_map (vm, physmem_map_index);
   uword start = pointer_to_uword (m->base);
   uword size = (uword) m->n_pages << m->log2_page_size;
-  uword i, j;
   u32 alloc_size, n_alloc_per_page;
 
   if (vec_len (bm->buffer_pools) >= 255)
@@ -582,33 +634,116 @@ vlib_buffer_pool_create (vlib_main_t * vm, char *name, u32 data_size,
 
   clib_spinlock_init (&bp->lock);
 
-  for (j = 0; j < m->n_pages; j++)
-    for (i = 0; i < n_alloc_per_page; i++)
-      {
-	u8 *p;
-	u32 bi;
+  bp->n_avail = vlib_buffer_pool_carve (vm, bp, m, bp->buffers);
+  bp->free_low_watermark = ~0;
 
-	p = m->base + (j << m->log2_page_size) + i * alloc_size;
-	p += bm->ext_hdr_size;
+  return bp->index;
+}
 
-	/*
-	 * Waste 1 buffer (maximum) so that 0 is never a valid buffer index.
-	 * Allows various places to ASSERT (bi != 0). Much easier
-	 * than debugging downstream crashes in successor nodes.
-	 */
-	if (p == m->base)
-	  continue;
+/*
+ * Add at least n_buffers buffers to a pool, backed by a new physmem
+ * map. Must be called on the main thread with the worker barrier held.
+ */
+clib_error_t *
+vlib_buffer_pool_grow (vlib_main_t * vm, u8 buffer_pool_index, u32 n_buffers)
+{
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, buffer_pool_index);
+  vlib_buffer_pool_grow_cb_t **cb;
+  vlib_physmem_map_t *m;
+  clib_error_t *error = 0;
+  uword start, end, pagesize;
+  u32 physmem_map_index, alloc_size, n_alloc_per_page, n_pages, n_new;
+  u32 *buffers = 0, *old_buffers, *new_buffers;
+  u8 *name;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (bp->flags & VLIB_BUFFER_POOL_F_GROWTH_DISABLED)
+    return clib_error_return (0, "growth disabled on buffer pool %s",
+			      bp->name);
+
+  if (bm->max_buffers_per_numa)
+    {
+      if (bp->n_buffers >= bm->max_buffers_per_numa)
+	return clib_error_return (0, "buffer pool %s at maximum size %u",
+				  bp->name, bm->max_buffers_per_numa);
+      n_buffers = clib_min (n_buffers,
+			    bm->max_buffers_per_numa - bp->n_buffers);
+    }
 
-	vlib_buffer_copy_template ((vlib_buffer_t *) p, &bp->buffer_template);
+  if (n_buffers == 0)
+    return 0;
 
-	bi = vlib_get_buffer_index (vm, (vlib_buffer_t *) p);
+  /* same page size as the memory the pool was created with */
+  m = vlib_physmem_get_map (vm, bp->physmem_map_index);
+  pagesize = 1ULL << m->log2_page_size;
+  alloc_size = vlib_buffer_alloc_size (bm->ext_hdr_size, bp->data_size);
+  n_alloc_per_page = pagesize / alloc_size;
+  n_pages = (n_buffers - 1) / n_alloc_per_page + 1;
 
-	bp->buffers[bp->n_avail++] = bi;
+  name = format (0, "%s-%u%c", bp->name,
+		 vec_len (bp->grow_physmem_map_indices) + 1, 0);
+  error = vlib_physmem_shared_map_create (vm, (char *) name,
+					  (uword) n_pages * pagesize,
+					  m->log2_page_size, bp->numa_node,
+					  &physmem_map_index);
+  vec_free (name);
+  if (error)
+    return error;
 
-	vlib_get_buffer (vm, bi);
-      }
+  /*
+   * Buffer indices are offsets from buffer_mem_start, which can't move
+   * once indices are in use. pmalloc can't give arenas back, so a map
+   * we can't use is lost until restart.
+   */
+  m = vlib_physmem_get_map (vm, physmem_map_index);
+  start = pointer_to_uword (m->base);
+  end = start + ((uword) m->n_pages << m->log2_page_size);
+  if (start < bm->buffer_mem_start ||
+      (u64) (end - bm->buffer_mem_start) >
+      ((u64) 1 << (32 + CLIB_LOG2_CACHE_LINE_BYTES)))
+    return clib_error_return (0, "physmem map %u is outside of buffer "
+			      "index range", physmem_map_index);
 
-  return bp->index;
+  bm->buffer_mem_size = clib_max (bm->buffer_mem_size,
+				  end - bm->buffer_mem_start);
+  if (start < bp->start)
+    {
+      bp->size += bp->start - start;
+      bp->start = start;
+    }
+  bp->size = clib_max (bp->size, end - bp->start);
+  vec_add1 (bp->grow_physmem_map_indices, physmem_map_index);
+
+  vec_validate (buffers, m->n_pages * n_alloc_per_page - 1);
+  n_new = vlib_buffer_pool_carve (vm, bp, m, buffers);
+
+  /* let drivers map the new memory before any of it can be allocated */
+  vec_foreach (cb, bm->pool_grow_callbacks)
+    if ((error = (*cb) (vm, bp, physmem_map_index, buffers, n_new)))
+      goto done;
+
+  new_buffers = clib_mem_alloc_aligned ((bp->n_buffers + n_new) *
+					sizeof (u32), CLIB_CACHE_LINE_BYTES);
+
+  clib_spinlock_lock (&bp->lock);
+  old_buffers = bp->buffers;
+  vlib_buffer_copy_indices (new_buffers, old_buffers, bp->n_avail);
+  vlib_buffer_copy_indices (new_buffers + bp->n_avail, buffers, n_new);
+  bp->buffers = new_buffers;
+  bp->n_avail += n_new;
+  bp->n_buffers += n_new;
+  clib_spinlock_unlock (&bp->lock);
+
+  clib_mem_free (old_buffers);
+
+  vlib_log_info (bm->log_default, "buffer pool %s grown by %u buffers to "
+		 "%u", bp->name, n_new, bp->n_buffers);
+
+done:
+  vec_free (buffers);
+  return error;
 }
 
 static u8 *
@@ -663,6 +798,81 @@ VLIB_CLI_COMMAND (show_buffers_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_buffer_pool (vlib_main_t * vm, unformat_input_t * input,
+		 vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  vlib_buffer_pool_t *bp;
+  clib_error_t *error = 0;
+  u32 index = vlib_buffer_pool_get_default_for_numa (vm, vm->numa_node);
+  u32 n_grow = 0, clear_watermarks = 0;
+  int enable = -1;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "index %u", &index))
+	;
+      else if (unformat (line_input, "grow %u", &n_grow))
+	;
+      else if (unformat (line_input, "growth enable"))
+	enable = 1;
+      else if (unformat (line_input, "growth disable"))
+	enable = 0;
+      else if (unformat (line_input, "clear-watermarks"))
+	clear_watermarks = 1;
+      else
+	{
+	  error = clib_error_return (0, "parse error: '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (index >= vec_len (bm->buffer_pools))
+    {
+      error = clib_error_return (0, "unknown buffer pool index %u", index);
+      goto done;
+    }
+
+  bp = vec_elt_at_index (bm->buffer_pools, index);
+
+  if (enable == 1)
+    bp->flags &= ~VLIB_BUFFER_POOL_F_GROWTH_DISABLED;
+  else if (enable == 0)
+    bp->flags |= VLIB_BUFFER_POOL_F_GROWTH_DISABLED;
+
+  if (clear_watermarks)
+    {
+      bp->used_high_watermark = 0;
+      bp->free_low_watermark = ~0;
+    }
+
+  if (n_grow)
+    {
+      vlib_worker_thread_barrier_sync (vm);
+      error = vlib_buffer_pool_grow (vm, index, n_grow);
+      vlib_worker_thread_barrier_release (vm);
+    }
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_buffer_pool_command, static) = {
+  .path = "set buffer-pool",
+  .short_help = "set buffer-pool [index <n>] [grow <n-buffers>] "
+    "[growth enable|disable] [clear-watermarks]",
+  .function = set_buffer_pool,
+};
+/* *INDENT-ON* */
+
 clib_error_t *
 vlib_buffer_worker_init (vlib_main_t * vm)
 {
@@ -785,6 +995,14 @@ vlib_buffer_main_alloc (vlib_main_t * vm)
   bm->default_data_size = VLIB_BUFFER_DEFAULT_DATA_SIZE;
 }
 
+void
+vlib_buffer_register_pool_grow_callback (vlib_main_t * vm,
+					 vlib_buffer_pool_grow_cb_t * cb)
+{
+  vlib_buffer_main_alloc (vm);
+  vec_add1 (vm->buffer_main->pool_grow_callbacks, cb);
+}
+
 static u32
 buffer_get_cached (vlib_buffer_pool_t * bp)
 {
@@ -848,6 +1066,112 @@ buffer_gauges_update_cached_fn (stat_segment_directory_entry_t * e, u32 index)
   e->value = buffer_get_cached (bp);
 }
 
+static void
+buffer_gauges_update_total_fn (stat_segment_directory_entry_t * e, u32 index)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_buffer_pool_t *bp = buffer_get_by_index (vm->buffer_main, index);
+  if (!bp)
+    return;
+
+  e->value = bp->n_buffers;
+}
+
+/* Sample pool occupancy, return the number of free buffers */
+static u32
+buffer_pool_update_watermarks (vlib_buffer_pool_t * bp)
+{
+  u32 n_free = bp->n_avail + buffer_get_cached (bp);
+  u32 n_used = bp->n_buffers - n_free;
+
+  bp->used_high_watermark = clib_max (bp->used_high_watermark, n_used);
+  bp->free_low_watermark = clib_min (bp->free_low_watermark, n_free);
+  return n_free;
+}
+
+static void
+buffer_gauges_update_used_high_watermark_fn (stat_segment_directory_entry_t
+					     * e, u32 index)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_buffer_pool_t *bp = buffer_get_by_index (vm->buffer_main, index);
+  if (!bp)
+    return;
+
+  buffer_pool_update_watermarks (bp);
+  e->value = bp->used_high_watermark;
+}
+
+static void
+buffer_gauges_update_free_low_watermark_fn (stat_segment_directory_entry_t *
+					    e, u32 index)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_buffer_pool_t *bp = buffer_get_by_index (vm->buffer_main, index);
+  if (!bp)
+    return;
+
+  buffer_pool_update_watermarks (bp);
+  e->value = bp->free_low_watermark;
+}
+
+/*
+ * Sample pool occupancy, and grow pools which are running low on free
+ * buffers when growth is configured. Workers can't map memory, so this
+ * polls rather than waiting for allocations to fail.
+ */
+static uword
+buffer_pool_monitor_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+			     vlib_frame_t * f)
+{
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  vlib_buffer_pool_t *bp;
+  clib_error_t *error;
+  u32 n_free;
+
+  while (1)
+    {
+      vlib_process_suspend (vm, bm->max_buffers_per_numa ? 10e-3 : 1.0);
+
+      vec_foreach (bp, bm->buffer_pools)
+      {
+	if (bp->n_buffers == 0)
+	  continue;
+
+	n_free = buffer_pool_update_watermarks (bp);
+
+	if (bm->max_buffers_per_numa == 0 ||
+	    bp->n_buffers >= bm->max_buffers_per_numa ||
+	    (bp->flags & VLIB_BUFFER_POOL_F_GROWTH_DISABLED) ||
+	    n_free >= bm->grow_step / 2)
+	  continue;
+
+	vlib_worker_thread_barrier_sync (vm);
+	error = vlib_buffer_pool_grow (vm, bp->index, bm->grow_step);
+	vlib_worker_thread_barrier_release (vm);
+
+	if (error)
+	  {
+	    /* don't retry every poll, growth can be re-enabled from cli */
+	    vlib_log_err (bm->log_default, "buffer pool %s: %U, disabling "
+			  "growth", bp->name, format_clib_error, error);
+	    clib_error_free (error);
+	    bp->flags |= VLIB_BUFFER_POOL_F_GROWTH_DISABLED;
+	  }
+      }
+    }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (buffer_pool_monitor_node, static) = {
+  .function = buffer_pool_monitor_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "buffer-pool-monitor",
+};
+/* *INDENT-ON* */
+
 clib_error_t *
 vlib_buffer_main_init (struct vlib_main_t * vm)
 {
@@ -908,6 +1232,10 @@ vlib_buffer_main_init (struct vlib_main_t * vm)
       goto done;
     }
 
+  if (bm->max_buffers_per_numa && bm->grow_step == 0)
+    bm->grow_step = bm->buffers_per_numa ? bm->buffers_per_numa :
+      VLIB_BUFFER_DEFAULT_BUFFERS_PER_NUMA;
+
   /* *INDENT-OFF* */
   clib_bitmap_foreach (numa_node, bmp)
     {
@@ -936,6 +1264,25 @@ vlib_buffer_main_init (struct vlib_main_t * vm)
     name = format (name, "/buffer-pools/%s/available%c", bp->name, 0);
     stat_segment_register_gauge (name, buffer_gauges_update_available_fn,
 				 bp - bm->buffer_pools);
+
+    vec_reset_length (name);
+    name = format (name, "/buffer-pools/%s/total%c", bp->name, 0);
+    stat_segment_register_gauge (name, buffer_gauges_update_total_fn,
+				 bp - bm->buffer_pools);
+
+    vec_reset_length (name);
+    name = format (name, "/buffer-pools/%s/used-high-watermark%c", bp->name,
+		   0);
+    stat_segment_register_gauge (name,
+				 buffer_gauges_update_used_high_watermark_fn,
+				 bp - bm->buffer_pools);
+
+    vec_reset_length (name);
+    name = format (name, "/buffer-pools/%s/free-low-watermark%c", bp->name,
+		   0);
+    stat_segment_register_gauge (name,
+				 buffer_gauges_update_free_low_watermark_fn,
+				 bp - bm->buffer_pools);
   }
 
 done:
@@ -965,6 +1312,11 @@ vlib_buffers_configure (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "default data-size %u",
 			 &bm->default_data_size))
 	;
+      else if (unformat (input, "max-buffers-per-numa %u",
+			 &bm->max_buffers_per_numa))
+	;
+      else if (unformat (input, "grow-step %u", &bm->grow_step))
+	;
       else
 	return unformat_parse_error (input);
     }
@@ -423,6 +423,16 @@ typedef struct
   u32 n_cached;
 } vlib_buffer_pool_thread_t;
 
+#define foreach_vlib_buffer_pool_flag \
+  _ (0, GROWTH_DISABLED, "growth-disabled")
+
+typedef enum
+{
+#define _(b, n, s) VLIB_BUFFER_POOL_F_##n = (1 << b),
+  foreach_vlib_buffer_pool_flag
+#undef _
+} vlib_buffer_pool_flags_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
@@ -430,6 +440,7 @@ typedef struct
   uword size;
   uword log2_page_size;
   u8 index;
+  u8 flags;
   u32 numa_node;
   u32 physmem_map_index;
   u32 data_size;
@@ -442,10 +453,29 @@ typedef struct
   /* per-thread data */
   vlib_buffer_pool_thread_t *threads;
 
+  /* physmem maps added at runtime, see vlib_buffer_pool_grow */
+  u32 *grow_physmem_map_indices;
+
+  /* occupancy watermarks, sampled by the main thread */
+  u32 used_high_watermark;
+  u32 free_low_watermark;
+
   /* buffer metadata template */
   vlib_buffer_t buffer_template;
 } vlib_buffer_pool_t;
 
+/*
+ * Called on the main thread, with the worker barrier held, when
+ * n_buffers new buffers backed by physmem map physmem_map_index are
+ * about to be added to a pool. Drivers which need DMA mappings or
+ * per-buffer state for pool memory register one of these.
+ */
+typedef clib_error_t *(vlib_buffer_pool_grow_cb_t) (struct vlib_main_t * vm,
+						     vlib_buffer_pool_t * bp,
+						     u32 physmem_map_index,
+						     u32 * buffers,
+						     u32 n_buffers);
+
 #define VLIB_BUFFER_MAX_NUMA_NODES 32
 
 typedef struct
@@ -471,11 +501,21 @@ typedef struct
   u32 default_data_size;
   clib_mem_page_sz_t log2_page_size;
 
+  /* runtime growth, disabled if max_buffers_per_numa is 0 */
+  u32 max_buffers_per_numa;
+  u32 grow_step;
+  vlib_buffer_pool_grow_cb_t **pool_grow_callbacks;
+
   /* logging */
   vlib_log_class_t log_default;
 } vlib_buffer_main_t;
 
 clib_error_t *vlib_buffer_main_init (struct vlib_main_t *vm);
+clib_error_t *vlib_buffer_pool_grow (struct vlib_main_t *vm,
+				     u8 buffer_pool_index, u32 n_buffers);
+void vlib_buffer_register_pool_grow_callback (struct vlib_main_t *vm,
+					      vlib_buffer_pool_grow_cb_t *
+					      cb);
 
 /*
  */
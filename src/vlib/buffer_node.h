@@ -490,6 +490,60 @@ next:
   vlib_put_next_frame (vm, node, next_index, n_left_to_next);
 }
 
+/*
+ * Hand n_buffers off to thread_index. Unless drop_on_congestion, wait
+ * for room in the destination ring. Otherwise drop everything if the
+ * destination is above the high threshold and whatever doesn't fit.
+ * Returns the number of buffers dropped.
+ */
+static_always_inline u32
+vlib_frame_queue_enqueue_buffers (vlib_main_t * vm,
+				  vlib_frame_queue_main_t * fqm,
+				  u32 thread_index, u32 * buffers,
+				  u32 n_buffers, int drop_on_congestion)
+{
+  vlib_frame_queue_t *fq = fqm->vlib_frame_queues[thread_index];
+  u32 n_enq = 0;
+
+  ASSERT (fq);
+
+  if (drop_on_congestion)
+    {
+      if (PREDICT_TRUE (clib_mpmc_ring_n_used (fq->ring) <
+			fqm->queue_hi_thresh))
+	n_enq = clib_mpmc_ring_enqueue_burst (fq->ring, buffers, n_buffers);
+
+      if (PREDICT_FALSE (n_enq < n_buffers))
+	{
+	  fq->enqueue_full_events++;
+	  vlib_buffer_free (vm, buffers + n_enq, n_buffers - n_enq);
+	}
+    }
+  else
+    {
+      /* Wait until there is room in the ring */
+      while (1)
+	{
+	  n_enq += clib_mpmc_ring_enqueue_burst (fq->ring, buffers + n_enq,
+						 n_buffers - n_enq);
+	  if (PREDICT_TRUE (n_enq == n_buffers))
+	    break;
+	  vlib_mains[thread_index]->check_frame_queues = 1;
+	  vlib_worker_thread_barrier_check ();
+	}
+    }
+
+  if (n_enq)
+    vlib_mains[thread_index]->check_frame_queues = 1;
+
+  return n_buffers - n_enq;
+}
+
+/*
+ * Buffers are staged per destination thread and handed off with one
+ * ring enqueue per destination, so partial frames don't take up queue
+ * space and producers only contend once per call.
+ */
 static_always_inline u32
 vlib_buffer_enqueue_to_thread (vlib_main_t * vm, u32 frame_queue_index,
 			       u32 * buffer_indices, u16 * thread_indices,
@@ -499,94 +553,49 @@ vlib_buffer_enqueue_to_thread (vlib_main_t * vm, u32 frame_queue_index,
   vlib_frame_queue_main_t *fqm;
   vlib_frame_queue_per_thread_data_t *ptd;
   u32 n_left = n_packets;
-  u32 drop_list[VLIB_FRAME_SIZE], *dbi = drop_list, n_drop = 0;
-  vlib_frame_queue_elt_t *hf = 0;
-  u32 n_left_to_next_thread = 0, *to_next_thread = 0;
-  u32 next_thread_index, current_thread_index = ~0;
+  u32 n_drop = 0;
+  u32 next_thread_index, *pending;
+  u16 *n_pending;
   int i;
 
   fqm = vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
   ptd = vec_elt_at_index (fqm->per_thread_data, vm->thread_index);
+  n_pending = ptd->n_pending_by_thread_index;
 
   while (n_left)
     {
       next_thread_index = thread_indices[0];
+      pending = ptd->pending_buffers + next_thread_index * VLIB_FRAME_SIZE;
 
-      if (next_thread_index != current_thread_index)
-	{
-	  if (drop_on_congestion &&
-	      is_vlib_frame_queue_congested
-	      (frame_queue_index, next_thread_index, fqm->queue_hi_thresh,
-	       ptd->congested_handoff_queue_by_thread_index))
-	    {
-	      dbi[0] = buffer_indices[0];
-	      dbi++;
-	      n_drop++;
-	      goto next;
-	    }
-
-	  if (hf)
-	    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_thread;
-
-	  hf = vlib_get_worker_handoff_queue_elt (frame_queue_index,
-						  next_thread_index,
-						  ptd->handoff_queue_elt_by_thread_index);
-
-	  n_left_to_next_thread = VLIB_FRAME_SIZE - hf->n_vectors;
-	  to_next_thread = &hf->buffer_index[hf->n_vectors];
-	  current_thread_index = next_thread_index;
-	}
-
-      to_next_thread[0] = buffer_indices[0];
-      to_next_thread++;
-      n_left_to_next_thread--;
+      pending[n_pending[next_thread_index]++] = buffer_indices[0];
 
-      if (n_left_to_next_thread == 0)
+      if (PREDICT_FALSE (n_pending[next_thread_index] == VLIB_FRAME_SIZE))
 	{
-	  hf->n_vectors = VLIB_FRAME_SIZE;
-	  vlib_put_frame_queue_elt (hf);
-	  vlib_mains[current_thread_index]->check_frame_queues = 1;
-	  current_thread_index = ~0;
-	  ptd->handoff_queue_elt_by_thread_index[next_thread_index] = 0;
-	  hf = 0;
+	  n_drop += vlib_frame_queue_enqueue_buffers (vm, fqm,
+						      next_thread_index,
+						      pending, VLIB_FRAME_SIZE,
+						      drop_on_congestion);
+	  n_pending[next_thread_index] = 0;
 	}
 
-      /* next */
-    next:
       thread_indices += 1;
       buffer_indices += 1;
       n_left -= 1;
     }
 
-  if (hf)
-    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_thread;
-
-  /* Ship frames to the thread nodes */
-  for (i = 0; i < vec_len (ptd->handoff_queue_elt_by_thread_index); i++)
+  /* Ship what's left to the thread nodes */
+  for (i = 0; i < vec_len (ptd->n_pending_by_thread_index); i++)
     {
-      if (ptd->handoff_queue_elt_by_thread_index[i])
-	{
-	  hf = ptd->handoff_queue_elt_by_thread_index[i];
-	  /*
-	   * It works better to let the handoff node
-	   * rate-adapt, always ship the handoff queue element.
-	   */
-	  if (1 || hf->n_vectors == hf->last_n_vectors)
-	    {
-	      vlib_put_frame_queue_elt (hf);
-	      vlib_mains[i]->check_frame_queues = 1;
-	      ptd->handoff_queue_elt_by_thread_index[i] = 0;
-	    }
-	  else
-	    hf->last_n_vectors = hf->n_vectors;
-	}
-      ptd->congested_handoff_queue_by_thread_index[i] =
-	(vlib_frame_queue_t *) (~0);
+      if (n_pending[i] == 0)
+	continue;
+
+      pending = ptd->pending_buffers + i * VLIB_FRAME_SIZE;
+      n_drop += vlib_frame_queue_enqueue_buffers (vm, fqm, i, pending,
+						  n_pending[i],
+						  drop_on_congestion);
+      n_pending[i] = 0;
     }
 
-  if (drop_on_congestion && n_drop)
-    vlib_buffer_free (vm, drop_list, n_drop);
-
   return n_packets - n_drop;
 }
 
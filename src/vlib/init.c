@@ -345,9 +345,12 @@ call_init_exit_functions_internal (vlib_main_t * vm,
     {
       if (call_once && !hash_get (vm->init_functions_called, i->f))
 	{
+	  f64 start = unix_time_now ();
+
 	  if (call_once)
 	    hash_set1 (vm->init_functions_called, i->f);
 	  error = i->f (vm);
+	  i->time_taken = unix_time_now () - start;
 	  if (error)
 	    return error;
 	}
@@ -409,6 +412,7 @@ vlib_call_all_config_functions (vlib_main_t * vm,
   vlib_config_function_runtime_t *c, **all;
   uword *hash = 0, *p;
   uword i;
+  f64 start;
 
   hash = hash_create_string (0, sizeof (uword));
   all = 0;
@@ -454,7 +458,9 @@ vlib_call_all_config_functions (vlib_main_t * vm,
 	continue;
       hash_set1 (vm->init_functions_called, c->function);
 
+      start = unix_time_now ();
       error = c->function (vm, &c->input);
+      c->time_taken = unix_time_now () - start;
       if (error)
 	goto done;
     }
@@ -487,6 +493,62 @@ vlib_init_dump (void)
     }
 }
 
+typedef struct
+{
+  char *name;
+  f64 time_taken;
+} init_function_timing_t;
+
+static int
+init_function_timing_cmp (void *a1, void *a2)
+{
+  init_function_timing_t *t1 = a1, *t2 = a2;
+
+  return t1->time_taken < t2->time_taken ?
+    1 : (t1->time_taken > t2->time_taken ? -1 : 0);
+}
+
+/* Functions of the given class which took any time, slowest first. */
+static void
+show_init_function_timing (vlib_main_t * vm,
+			   _vlib_init_function_list_elt_t * head,
+			   int with_config, u32 max)
+{
+  init_function_timing_t *timings = 0, *t;
+  vlib_config_function_runtime_t *c;
+  f64 total = 0;
+
+  for (; head; head = head->next_init_function)
+    if (head->time_taken > 0)
+      {
+	vec_add2 (timings, t, 1);
+	t->name = head->name;
+	t->time_taken = head->time_taken;
+      }
+
+  if (with_config)
+    for (c = vm->config_function_registrations; c; c = c->next_registration)
+      if (c->time_taken > 0)
+	{
+	  vec_add2 (timings, t, 1);
+	  t->name = c->name;
+	  t->time_taken = c->time_taken;
+	}
+
+  vec_sort_with_function (timings, init_function_timing_cmp);
+
+  vlib_cli_output (vm, "%-50s%12s", "Function", "Time (ms)");
+  vec_foreach (t, timings)
+  {
+    if (t - timings < max)
+      vlib_cli_output (vm, "%-50s%12.3f", t->name, t->time_taken * 1e3);
+    total += t->time_taken;
+  }
+  vlib_cli_output (vm, "%-50s%12.3f", "Total", total * 1e3);
+
+  vec_free (timings);
+}
+
 static clib_error_t *
 show_init_function_command_fn (vlib_main_t * vm,
 			       unformat_input_t * input,
@@ -494,6 +556,8 @@ show_init_function_command_fn (vlib_main_t * vm,
 {
   int which = 1;
   int verbose = 0;
+  int timing = 0;
+  u32 max = ~0;
   int i, n_init_fns;
   _vlib_init_function_list_elt_t *head, *this;
   uword *index_by_name;
@@ -517,6 +581,10 @@ show_init_function_command_fn (vlib_main_t * vm,
 	;
       else if (unformat (input, "verbose"))
 	verbose = 1;
+      else if (unformat (input, "timing %u", &max))
+	timing = 1;
+      else if (unformat (input, "timing"))
+	timing = 1;
       else
 	break;
     }
@@ -536,6 +604,13 @@ show_init_function_command_fn (vlib_main_t * vm,
       return clib_error_return (0, "BUG");
     }
 
+  if (timing)
+    {
+      /* Config functions are timed along with init functions */
+      show_init_function_timing (vm, head, which == 1, max);
+      return 0;
+    }
+
   if (verbose == 0)
     {
       this = head;
@@ -653,16 +728,21 @@ show_init_function_command_fn (vlib_main_t * vm,
 }
 
 /*?
- * Show init function order
+ * Show init function order, or with 'timing' the time each function
+ * took, slowest first, optionally limited to the first nn. Init
+ * function timing includes the config functions. Together with
+ * 'show plugins timing' this accounts for most of the startup time.
  *
  * @cliexpar
- * @cliexstart{show init-function [init | enter | exit] [verbose [nn]]}
+ * @cliexstart{show init-function [init | enter | exit] [verbose [nn]]
+ *   [timing [nn]]}
  * @cliexend
  ?*/
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (show_init_function, static) = {
   .path = "show init-function",
-  .short_help = "show init-function [init | enter | exit][verbose [nn]]",
+  .short_help = "show init-function [init | enter | exit][verbose [nn]]"
+    "[timing [nn]]",
   .function = show_init_function_command_fn,
 };
 /* *INDENT-ON* */
@@ -58,6 +58,9 @@ typedef struct _vlib_init_function_list_elt
   char **runs_before;
   char **runs_after;
   char **init_order;
+  /* Seconds spent in the function, including any init functions it
+     called directly */
+  f64 time_taken;
 } _vlib_init_function_list_elt_t;
 
 /* Configuration functions: called with configuration input just before
@@ -81,6 +84,9 @@ typedef struct vlib_config_function_runtime_t
 
   /* Name used to distinguish input on command line. */
   char name[32];
+
+  /* Seconds spent in the function */
+  f64 time_taken;
 } vlib_config_function_runtime_t;
 
 #define VLIB_REMOVE_FROM_LINKED_LIST(first,p,next)              \
@@ -942,6 +942,42 @@ vlib_pci_disable_msix_irq (vlib_main_t * vm, vlib_pci_dev_handle_t h,
 			VFIO_IRQ_SET_ACTION_TRIGGER, fds);
 }
 
+static clib_error_t *
+linux_pci_vfio_map_physmem_map (vlib_main_t * vm, u32 physmem_map_index)
+{
+  vlib_physmem_map_t *pm = vlib_physmem_get_map (vm, physmem_map_index);
+  clib_error_t *err;
+  u32 i;
+
+  for (i = 0; i < pm->n_pages; i++)
+    if ((err = vfio_map_physmem_page (vm, pm->base +
+				      (i << pm->log2_page_size))))
+      return err;
+
+  return 0;
+}
+
+/* DMA map buffer memory added at runtime if any device does VA DMA */
+static clib_error_t *
+linux_pci_buffer_pool_grow (vlib_main_t * vm, vlib_buffer_pool_t * bp,
+			    u32 physmem_map_index, u32 * buffers,
+			    u32 n_buffers)
+{
+  linux_pci_main_t *lpm = &linux_pci_main;
+  linux_pci_device_t *p;
+  int va_dma = 0;
+
+  /* *INDENT-OFF* */
+  pool_foreach (p, lpm->linux_pci_devices)
+    va_dma |= p->supports_va_dma;
+  /* *INDENT-ON* */
+
+  if (!va_dma)
+    return 0;
+
+  return linux_pci_vfio_map_physmem_map (vm, physmem_map_index);
+}
+
 static clib_error_t *
 add_device_vfio (vlib_main_t * vm, linux_pci_device_t * p,
 		 vlib_pci_device_info_t * di, pci_device_registration_t * r)
@@ -1004,11 +1040,18 @@ add_device_vfio (vlib_main_t * vm, linux_pci_device_t * p,
       /* *INDENT-OFF* */
       vec_foreach (bp, vm->buffer_main->buffer_pools)
 	{
-	  u32 i;
+	  u32 i, *mi, *map_indices = 0;
 	  vlib_physmem_map_t *pm;
-	  pm = vlib_physmem_get_map (vm, bp->physmem_map_index);
-	  for (i = 0; i < pm->n_pages; i++)
-	    vfio_map_physmem_page (vm, pm->base + (i << pm->log2_page_size));
+	  vec_add1 (map_indices, bp->physmem_map_index);
+	  vec_append (map_indices, bp->grow_physmem_map_indices);
+	  vec_foreach (mi, map_indices)
+	    {
+	      pm = vlib_physmem_get_map (vm, mi[0]);
+	      for (i = 0; i < pm->n_pages; i++)
+		vfio_map_physmem_page (vm, pm->base +
+				       (i << pm->log2_page_size));
+	    }
+	  vec_free (map_indices);
 	}
       /* *INDENT-ON* */
     }
@@ -1490,6 +1533,8 @@ linux_pci_init (vlib_main_t * vm)
 
   ASSERT (sizeof (vlib_pci_addr_t) == sizeof (u32));
 
+  vlib_buffer_register_pool_grow_callback (vm, linux_pci_buffer_pool_grow);
+
   addrs = vlib_pci_get_all_dev_addrs ();
   /* *INDENT-OFF* */
   vec_foreach (addr, addrs)
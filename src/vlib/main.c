@@ -324,16 +324,22 @@ vlib_next_frame_change_ownership (vlib_main_t * vm,
       /* Get frame from previous owner. */
       vlib_next_frame_t *owner_next_frame;
       vlib_next_frame_t tmp;
+      u32 fused;
 
       owner_next_frame =
 	vlib_node_get_next_frame (vm,
 				  next_node->owner_node_index,
 				  next_node->owner_next_index);
 
-      /* Swap target next frame with owner's. */
+      /* Swap target next frame with owner's. Fusion belongs to the
+         edge, not to the frame, so it stays where it was. */
+      fused = (owner_next_frame->flags ^ next_frame->flags) &
+	VLIB_FRAME_FUSED;
       tmp = owner_next_frame[0];
       owner_next_frame[0] = next_frame[0];
       next_frame[0] = tmp;
+      owner_next_frame->flags ^= fused;
+      next_frame->flags ^= fused;
 
       /*
        * If next_frame is already pending, we have to track down
@@ -352,6 +358,14 @@ vlib_next_frame_change_ownership (vlib_main_t * vm,
 		      next_frame - vm->node_main.next_frames;
 		  }
 	      }
+	      vec_foreach (p, nm->fused_frames)
+	      {
+		if (p->frame == next_frame->frame)
+		  {
+		    p->next_frame_index =
+		      next_frame - vm->node_main.next_frames;
+		  }
+	      }
 	    }
 	}
     }
@@ -532,7 +546,10 @@ vlib_put_next_frame (vlib_main_t * vm,
 	  next_node = vlib_get_next_node (vm, r->node_index, next_index);
 	  next_runtime = vlib_node_get_runtime (vm, next_node->index);
 
-	  vec_add2 (nm->pending_frames, p, 1);
+	  if (PREDICT_FALSE (nf->flags & VLIB_FRAME_FUSED))
+	    vec_add2 (nm->fused_frames, p, 1);
+	  else
+	    vec_add2 (nm->pending_frames, p, 1);
 
 	  p->frame = nf->frame;
 	  p->node_runtime_index = nf->node_runtime_index;
@@ -637,6 +654,28 @@ vlib_node_sync_stats (vlib_main_t * vm, vlib_node_t * n)
   }
 }
 
+static_always_inline void
+vlib_node_runtime_update_histograms (vlib_main_t * vm,
+				     vlib_node_runtime_t * node,
+				     uword n_vectors, uword n_clocks)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  uword i;
+
+  i = node->node_index * VLIB_NODE_N_CLOCKS_HISTOGRAM_BINS +
+    vlib_node_histogram_bin (n_clocks, VLIB_NODE_N_CLOCKS_HISTOGRAM_BINS);
+
+  /* nodes created after the histograms were enabled are not tracked */
+  if (PREDICT_FALSE (i >= vec_len (nm->clocks_histogram)))
+    return;
+
+  nm->clocks_histogram[i]++;
+  nm->vectors_histogram[node->node_index *
+			VLIB_NODE_N_VECTORS_HISTOGRAM_BINS +
+			vlib_node_histogram_bin
+			(n_vectors, VLIB_NODE_N_VECTORS_HISTOGRAM_BINS)]++;
+}
+
 always_inline u32
 vlib_node_runtime_update_stats (vlib_main_t * vm,
 				vlib_node_runtime_t * node,
@@ -663,6 +702,9 @@ vlib_node_runtime_update_stats (vlib_main_t * vm,
 
   r = vlib_node_runtime_update_main_loop_vector_stats (vm, node, n_vectors);
 
+  if (PREDICT_FALSE (vm->node_main.clocks_histogram != 0))
+    vlib_node_runtime_update_histograms (vm, node, n_vectors, n_clocks);
+
   if (PREDICT_FALSE (ca1 < ca0 || v1 < v0 || cl1 < cl0))
     {
       node->calls_since_last_overflow = ca0;
@@ -1140,8 +1182,8 @@ dispatch_node (vlib_main_t * vm,
 }
 
 static u64
-dispatch_pending_node (vlib_main_t * vm, uword pending_frame_index,
-		       u64 last_time_stamp)
+dispatch_pending_frame (vlib_main_t * vm, vlib_pending_frame_t ** frames,
+			uword pending_frame_index, u64 last_time_stamp)
 {
   vlib_node_main_t *nm = &vm->node_main;
   vlib_frame_t *f;
@@ -1151,7 +1193,7 @@ dispatch_pending_node (vlib_main_t * vm, uword pending_frame_index,
   vlib_pending_frame_t *p;
 
   /* See comment below about dangling references to nm->pending_frames */
-  p = nm->pending_frames + pending_frame_index;
+  p = *frames + pending_frame_index;
 
   n = vec_elt_at_index (nm->nodes_by_type[VLIB_NODE_TYPE_INTERNAL],
 			p->node_runtime_index);
@@ -1224,7 +1266,7 @@ dispatch_pending_node (vlib_main_t * vm, uword pending_frame_index,
        * of new frames, and hence in the reallocation of nm->pending_frames.
        * Recompute p, or no supper. This was broken for more than 10 years.
        */
-      p = nm->pending_frames + pending_frame_index;
+      p = *frames + pending_frame_index;
 
       /*
        * p->next_frame_index can change during node dispatch if node
@@ -1259,6 +1301,56 @@ dispatch_pending_node (vlib_main_t * vm, uword pending_frame_index,
   return last_time_stamp;
 }
 
+/*
+ * Dispatch frames put to fused next frames by the node which just
+ * returned. Frames put by the nodes dispatched here are appended and
+ * dispatched in turn, so a fused chain runs to completion on the same
+ * frames before the main loop moves on.
+ */
+static u64
+dispatch_fused_frames (vlib_main_t * vm, u64 last_time_stamp)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  uword i;
+
+  for (i = 0; i < vec_len (nm->fused_frames); i++)
+    last_time_stamp = dispatch_pending_frame (vm, &nm->fused_frames, i,
+					      last_time_stamp);
+  _vec_len (nm->fused_frames) = 0;
+
+  return last_time_stamp;
+}
+
+static_always_inline u64
+dispatch_pending_node (vlib_main_t * vm, uword pending_frame_index,
+		       u64 last_time_stamp)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+
+  last_time_stamp = dispatch_pending_frame (vm, &nm->pending_frames,
+					    pending_frame_index,
+					    last_time_stamp);
+  if (PREDICT_FALSE (vec_len (nm->fused_frames)))
+    last_time_stamp = dispatch_fused_frames (vm, last_time_stamp);
+
+  return last_time_stamp;
+}
+
+static_always_inline u64
+dispatch_input_node (vlib_main_t * vm, vlib_node_runtime_t * n,
+		     vlib_node_state_t dispatch_state, u64 last_time_stamp)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+
+  last_time_stamp = dispatch_node (vm, n, VLIB_NODE_TYPE_INPUT,
+				   dispatch_state, /* frame */ 0,
+				   last_time_stamp);
+  if (PREDICT_FALSE (vec_len (nm->fused_frames)))
+    last_time_stamp = dispatch_fused_frames (vm, last_time_stamp);
+
+  return last_time_stamp;
+}
+
 always_inline uword
 vlib_process_stack_is_valid (vlib_process_t * p)
 {
@@ -1534,6 +1626,8 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
     {
       vec_resize (nm->pending_frames, 32);
       _vec_len (nm->pending_frames) = 0;
+      vec_resize (nm->fused_frames, 32);
+      _vec_len (nm->fused_frames) = 0;
     }
 
   /* Mark time of main loop start. */
@@ -1587,7 +1681,12 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 	}
 
       if (!is_main)
-	vlib_worker_thread_barrier_check ();
+	{
+	  vlib_worker_thread_barrier_check ();
+	  vlib_epoch_quiesce (vm);
+	}
+      else if (PREDICT_FALSE (vlib_epoch_main.n_deferred))
+	vlib_epoch_reclaim ();
 
       if (PREDICT_FALSE (vm->check_frame_queues + frame_queue_check_counter))
 	{
@@ -1624,11 +1723,8 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 
       /* Next process input nodes. */
       vec_foreach (n, nm->nodes_by_type[VLIB_NODE_TYPE_INPUT])
-	cpu_time_now = dispatch_node (vm, n,
-				      VLIB_NODE_TYPE_INPUT,
-				      VLIB_NODE_STATE_POLLING,
-				      /* frame */ 0,
-				      cpu_time_now);
+	cpu_time_now = dispatch_input_node (vm, n, VLIB_NODE_STATE_POLLING,
+					    cpu_time_now);
 
       if (PREDICT_TRUE (is_main && vm->queue_signal_pending == 0))
 	vm->queue_signal_callback (vm);
@@ -1645,9 +1741,9 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 	      clib_interrupt_clear (nm->interrupts, int_num);
 	      n = vec_elt_at_index (nm->nodes_by_type[VLIB_NODE_TYPE_INPUT],
 				    int_num);
-	      cpu_time_now = dispatch_node (vm, n, VLIB_NODE_TYPE_INPUT,
-					    VLIB_NODE_STATE_INTERRUPT,
-					    /* frame */ 0, cpu_time_now);
+	      cpu_time_now = dispatch_input_node (vm, n,
+						  VLIB_NODE_STATE_INTERRUPT,
+						  cpu_time_now);
 	    }
 	}
 
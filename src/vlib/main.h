@@ -248,6 +248,9 @@ typedef struct vlib_main_t
     (struct vlib_main_t *, u64 t);
   clib_spinlock_t worker_thread_main_loop_callback_lock;
 
+  /* last reclamation epoch seen by this thread, see vlib_epoch_quiesce */
+  volatile u64 epoch_seen;
+
   /* debugging */
   volatile int parked_at_barrier;
 
@@ -129,6 +129,11 @@ vlib_node_runtime_update (vlib_main_t * vm, u32 node_index, u32 next_index)
 	    && pf->next_frame_index >= i)
 	  pf->next_frame_index += n_insert;
       }
+      vec_foreach (pf, nm->fused_frames)
+      {
+	if (pf->next_frame_index >= i)
+	  pf->next_frame_index += n_insert;
+      }
       /* *INDENT-OFF* */
       pool_foreach (pf, nm->suspended_process_frames)  {
 	  if (pf->next_frame_index != ~0 && pf->next_frame_index >= i)
@@ -849,6 +854,178 @@ vlib_node_set_march_variant (vlib_main_t *vm, u32 node_index,
     }
   return -1;
 }
+
+/*
+ * Enable, resize or disable the per-node dispatch histograms on every
+ * thread. Enabling again picks up nodes created since.
+ */
+void
+vlib_node_histograms_enable_disable (vlib_main_t *vm, int enable)
+{
+  u32 n_nodes = vec_len (vm->node_main.nodes);
+  int i;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      vlib_node_main_t *nm;
+
+      if (vlib_mains[i] == 0)
+	continue;
+
+      nm = &vlib_mains[i]->node_main;
+      if (enable && n_nodes)
+	{
+	  vec_validate (nm->clocks_histogram,
+			n_nodes * VLIB_NODE_N_CLOCKS_HISTOGRAM_BINS - 1);
+	  vec_validate (nm->vectors_histogram,
+			n_nodes * VLIB_NODE_N_VECTORS_HISTOGRAM_BINS - 1);
+	}
+      else
+	{
+	  vec_free (nm->clocks_histogram);
+	  vec_free (nm->vectors_histogram);
+	}
+    }
+
+  vlib_worker_thread_barrier_release (vm);
+}
+
+/*
+ * Fuse or unfuse the edge from node_index to its next_index on every
+ * thread. Frames put to a fused edge are dispatched as soon as the
+ * putting node returns, on the same frame, without going through the
+ * main loop pending vector. Process nodes cannot be fused from, and
+ * nodes may not be fused to themselves.
+ */
+int
+vlib_node_set_fused_next (vlib_main_t *vm, u32 node_index, u32 next_index,
+			  int is_enable)
+{
+  vlib_node_t *n = vlib_get_node (vm, node_index);
+  int i;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (n->type != VLIB_NODE_TYPE_INTERNAL && n->type != VLIB_NODE_TYPE_INPUT)
+    return -1;
+  if (next_index >= vec_len (n->next_nodes)
+      || n->next_nodes[next_index] == ~0
+      || n->next_nodes[next_index] == node_index)
+    return -1;
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      vlib_next_frame_t *nf;
+      vlib_node_runtime_t *rt;
+
+      if (vlib_mains[i] == 0)
+	continue;
+
+      rt = vlib_node_get_runtime (vlib_mains[i], node_index);
+      nf = vlib_node_runtime_get_next_frame (vlib_mains[i], rt, next_index);
+      if (is_enable)
+	nf->flags |= VLIB_FRAME_FUSED;
+      else
+	nf->flags &= ~VLIB_FRAME_FUSED;
+    }
+
+  vlib_worker_thread_barrier_release (vm);
+  return 0;
+}
+
+int
+vlib_node_is_fused_next (vlib_main_t *vm, u32 node_index, u32 next_index)
+{
+  vlib_node_t *n = vlib_get_node (vm, node_index);
+  vlib_node_runtime_t *rt;
+
+  if (n->type != VLIB_NODE_TYPE_INTERNAL && n->type != VLIB_NODE_TYPE_INPUT)
+    return 0;
+
+  rt = vlib_node_get_runtime (vm, node_index);
+  if (next_index >= rt->n_next_nodes)
+    return 0;
+
+  return (vlib_node_runtime_get_next_frame (vm, rt, next_index)->flags &
+	  VLIB_FRAME_FUSED) != 0;
+}
+
+/*
+ * Fuse every edge which, summed over all threads, carried at least
+ * min_pct percent and min_vectors of the vectors sent by its node.
+ * Returns the number of edges newly fused.
+ */
+u32
+vlib_node_fuse_hot_edges (vlib_main_t *vm, u32 min_pct, u64 min_vectors)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  u64 *by_next = 0, total;
+  u32 node_index, n_fused = 0;
+  int i, j;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  for (node_index = 0; node_index < vec_len (nm->nodes); node_index++)
+    {
+      vlib_node_t *n = nm->nodes[node_index];
+
+      if ((n->type != VLIB_NODE_TYPE_INTERNAL &&
+	   n->type != VLIB_NODE_TYPE_INPUT) ||
+	  vec_len (n->next_nodes) == 0)
+	continue;
+
+      /* n_vectors_by_next_node is shared by all threads' node clones,
+         next frame counters are per thread. */
+      vec_reset_length (by_next);
+      vec_validate (by_next, vec_len (n->next_nodes) - 1);
+      vec_foreach_index (j, by_next)
+	by_next[j] = vec_elt (n->n_vectors_by_next_node, j);
+
+      for (i = 0; i < vec_len (vlib_mains); i++)
+	{
+	  vlib_node_runtime_t *rt;
+
+	  if (vlib_mains[i] == 0)
+	    continue;
+
+	  rt = vlib_node_get_runtime (vlib_mains[i], node_index);
+	  for (j = 0; j < rt->n_next_nodes && j < vec_len (by_next); j++)
+	    by_next[j] += vlib_node_runtime_get_next_frame (vlib_mains[i], rt,
+							    j)
+			    ->vectors_since_last_overflow;
+	}
+
+      total = 0;
+      vec_foreach_index (j, by_next)
+	total += by_next[j];
+
+      if (total < min_vectors)
+	continue;
+
+      vec_foreach_index (j, by_next)
+      {
+	if (by_next[j] < min_vectors || by_next[j] * 100 < total * min_pct ||
+	    vlib_node_is_fused_next (vm, node_index, j))
+	  continue;
+	if (vlib_node_set_fused_next (vm, node_index, j, 1) == 0)
+	  n_fused++;
+      }
+    }
+
+  vlib_worker_thread_barrier_release (vm);
+
+  vec_free (by_next);
+  return n_fused;
+}
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
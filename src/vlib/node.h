@@ -405,6 +405,10 @@ typedef struct
 #define VLIB_FRAME_NO_FREE_AFTER_DISPATCH \
   VLIB_NODE_FLAG_FRAME_NO_FREE_AFTER_DISPATCH
 
+  /* Frames put to this next are dispatched right after the current
+     node returns, rather than from the main loop pending vector. */
+#define VLIB_FRAME_FUSED (1 << 13)
+
   /* Don't append this frame */
 #define VLIB_FRAME_NO_APPEND (1 << 14)
 
@@ -693,6 +697,10 @@ typedef struct
   /* Vector of internal node's frames waiting to be called. */
   vlib_pending_frame_t *pending_frames;
 
+  /* Frames put to fused next frames, dispatched as soon as the node
+     which put them returns. */
+  vlib_pending_frame_t *fused_frames;
+
   /* Timing wheel for scheduling time-based node dispatch. */
   void *timing_wheel;
 
@@ -743,8 +751,24 @@ typedef struct
 
   /* Node Function march Variant by Suffix Hash */
   uword *node_fn_march_variant_by_suffix;
+
+  /* Optional log2 histograms of clocks and vectors per dispatch,
+     indexed by node index * number of bins + bin, 0 when disabled. */
+  u64 *clocks_histogram;
+  u64 *vectors_histogram;
 } vlib_node_main_t;
 
+/* Bin 0 counts zero, bin b > 0 counts [2^(b-1), 2^b), the last bin is
+   open ended. */
+#define VLIB_NODE_N_CLOCKS_HISTOGRAM_BINS 32
+#define VLIB_NODE_N_VECTORS_HISTOGRAM_BINS 10
+
+always_inline u32
+vlib_node_histogram_bin (uword n, u32 n_bins)
+{
+  return n == 0 ? 0 : clib_min (1 + min_log2 (n), n_bins - 1);
+}
+
 typedef u16 vlib_error_t;
 
 always_inline u32
@@ -522,6 +522,8 @@ clear_node_runtime (vlib_main_t * vm,
 	  r = vlib_node_get_runtime (stat_vm, n->index);
 	  r->max_clock = 0;
 	}
+      vec_zero (nm->clocks_histogram);
+      vec_zero (nm->vectors_histogram);
       /* Note: input/output rates computed using vlib_global_main */
       nm->time_last_runtime_stats_clear = vlib_time_now (vm);
     }
@@ -764,6 +766,253 @@ VLIB_CLI_COMMAND (set_node_fn_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_node_histograms (vlib_main_t * vm, unformat_input_t * input,
+		     vlib_cli_command_t * cmd)
+{
+  int enable;
+
+  if (unformat (input, "on") || unformat (input, "enable"))
+    enable = 1;
+  else if (unformat (input, "off") || unformat (input, "disable"))
+    enable = 0;
+  else
+    return clib_error_return (0, "please specify on or off");
+
+  vlib_node_histograms_enable_disable (vm, enable);
+  return 0;
+}
+
+/*?
+ * Collect log2 histograms of clocks and vectors per dispatch for every
+ * node on every thread. They are shown by 'show node histogram' and
+ * exported in the stats segment, and cleared by 'clear runtime'.
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_node_histograms_command, static) = {
+  .path = "set node histograms",
+  .short_help = "set node histograms <on|off>",
+  .function = set_node_histograms,
+};
+/* *INDENT-ON* */
+
+static u8 *
+format_vlib_node_histogram (u8 * s, va_list * va)
+{
+  u64 *h = va_arg (*va, u64 *);
+  u32 n_bins = va_arg (*va, u32);
+  u64 total = 0;
+  u32 b;
+
+  for (b = 0; b < n_bins; b++)
+    total += h[b];
+
+  for (b = 0; b < n_bins; b++)
+    {
+      if (h[b] == 0)
+	continue;
+      if (b == 0)
+	s = format (s, "\n  %-24s", "0");
+      else if (b == n_bins - 1)
+	s = format (s, "\n  >= %-21llu", 1ULL << (b - 1));
+      else
+	s = format (s, "\n  %10llu - %-11llu", 1ULL << (b - 1),
+		    (1ULL << b) - 1);
+      s = format (s, "%16llu %6.2f%%", h[b], 100.0 * h[b] / total);
+    }
+
+  return s;
+}
+
+static clib_error_t *
+show_node_histogram (vlib_main_t * vm, unformat_input_t * input,
+		     vlib_cli_command_t * cmd)
+{
+  u32 node_index, i;
+
+  if (!unformat (input, "%U", unformat_vlib_node, vm, &node_index))
+    return clib_error_return (0, "please specify node name");
+
+  if (vm->node_main.clocks_histogram == 0)
+    return clib_error_return (0, "node histograms are not enabled, "
+			      "see 'set node histograms'");
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      vlib_node_main_t *nm;
+      u64 *h;
+
+      if (vlib_mains[i] == 0)
+	continue;
+
+      nm = &vlib_mains[i]->node_main;
+      if ((node_index + 1) * VLIB_NODE_N_CLOCKS_HISTOGRAM_BINS >
+	  vec_len (nm->clocks_histogram))
+	continue;
+
+      vlib_cli_output (vm, "Thread %d %s, node %U", i,
+		       vlib_worker_threads[i].name, format_vlib_node_name, vm,
+		       node_index);
+
+      h = nm->clocks_histogram + node_index *
+	VLIB_NODE_N_CLOCKS_HISTOGRAM_BINS;
+      vlib_cli_output (vm, " clocks per dispatch:%U",
+		       format_vlib_node_histogram, h,
+		       VLIB_NODE_N_CLOCKS_HISTOGRAM_BINS);
+
+      h = nm->vectors_histogram + node_index *
+	VLIB_NODE_N_VECTORS_HISTOGRAM_BINS;
+      vlib_cli_output (vm, " vectors per dispatch:%U",
+		       format_vlib_node_histogram, h,
+		       VLIB_NODE_N_VECTORS_HISTOGRAM_BINS);
+    }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_node_histogram_command, static) = {
+  .path = "show node histogram",
+  .short_help = "show node histogram <node-name>",
+  .function = show_node_histogram,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+set_node_fusion (vlib_main_t * vm, unformat_input_t * input,
+		 vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  u32 node_index = ~0, next_node_index = ~0, min_pct = 90, n_fused;
+  u64 min_vectors = 1 << 20;
+  int is_auto = 0, is_enable = 1;
+  uword next_index;
+  clib_error_t *err = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, "please specify nodes or auto");
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "auto"))
+	is_auto = 1;
+      else if (unformat (line_input, "threshold %u", &min_pct))
+	;
+      else if (unformat (line_input, "min-vectors %llu", &min_vectors))
+	;
+      else if (unformat (line_input, "disable"))
+	is_enable = 0;
+      else if (node_index == ~0 &&
+	       unformat (line_input, "%U", unformat_vlib_node, vm,
+			 &node_index))
+	;
+      else if (unformat (line_input, "%U", unformat_vlib_node, vm,
+			 &next_node_index))
+	;
+      else
+	{
+	  err = clib_error_return (0, "unknown input '%U'",
+				   format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (is_auto)
+    {
+      if (min_pct == 0 || min_pct > 100)
+	{
+	  err = clib_error_return (0, "threshold must be 1 to 100 percent");
+	  goto done;
+	}
+      n_fused = vlib_node_fuse_hot_edges (vm, min_pct, min_vectors);
+      vlib_cli_output (vm, "fused %u edges", n_fused);
+      goto done;
+    }
+
+  if (node_index == ~0 || next_node_index == ~0)
+    {
+      err = clib_error_return (0, "please specify from and to node names");
+      goto done;
+    }
+
+  next_index = vlib_node_get_next (vm, node_index, next_node_index);
+  if (next_index == ~0)
+    {
+      err = clib_error_return (0, "%U is not a next node of %U",
+			       format_vlib_node_name, vm, next_node_index,
+			       format_vlib_node_name, vm, node_index);
+      goto done;
+    }
+
+  if (vlib_node_set_fused_next (vm, node_index, next_index, is_enable))
+    err = clib_error_return (0, "edge %U -> %U cannot be fused",
+			     format_vlib_node_name, vm, node_index,
+			     format_vlib_node_name, vm, next_node_index);
+
+done:
+  unformat_free (line_input);
+  return err;
+}
+
+/*?
+ * Fuse the edge between two nodes. Frames put to a fused edge are
+ * dispatched as soon as the from node returns, instead of being queued
+ * on the main loop pending vector, so that a hot linear chain such as
+ * ethernet-input, ip4-input-no-checksum, ip4-lookup, ip4-rewrite runs to
+ * completion while its buffers are still in cache. Packets taking other
+ * edges are dispatched as usual. With 'auto', every edge carrying at
+ * least 'threshold' percent (default 90) and 'min-vectors' (default
+ * 1M) of its node's vectors since start is fused.
+ *
+ * @cliexpar
+ * @cliexcmd{set node fusion ip4-lookup ip4-rewrite}
+ * @cliexcmd{set node fusion auto threshold 95}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_node_fusion_command, static) = {
+  .path = "set node fusion",
+  .short_help = "set node fusion {<from-node> <to-node> [disable] | "
+    "auto [threshold <pct>] [min-vectors <n>]}",
+  .function = set_node_fusion,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+show_node_fusion (vlib_main_t * vm, unformat_input_t * input,
+		  vlib_cli_command_t * cmd)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  u32 node_index, next_index;
+  vlib_node_t *n;
+  int n_fused = 0;
+
+  for (node_index = 0; node_index < vec_len (nm->nodes); node_index++)
+    {
+      n = nm->nodes[node_index];
+      vec_foreach_index (next_index, n->next_nodes)
+      {
+	if (!vlib_node_is_fused_next (vm, node_index, next_index))
+	  continue;
+	vlib_cli_output (vm, "%v -> %U", n->name, format_vlib_node_name, vm,
+			 n->next_nodes[next_index]);
+	n_fused++;
+      }
+    }
+
+  if (n_fused == 0)
+    vlib_cli_output (vm, "no fused edges");
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_node_fusion_command, static) = {
+  .path = "show node fusion",
+  .short_help = "show node fusion",
+  .function = show_node_fusion,
+};
+/* *INDENT-ON* */
+
 /* Dummy function to get us linked in. */
 void
 vlib_node_cli_reference (void)
@@ -1245,6 +1245,13 @@ vlib_node_set_dispatch_wrapper (vlib_main_t *vm, vlib_node_function_t *fn)
 int vlib_node_set_march_variant (vlib_main_t *vm, u32 node_index,
 				 clib_march_variant_type_t march_variant);
 
+void vlib_node_histograms_enable_disable (vlib_main_t *vm, int enable);
+
+int vlib_node_set_fused_next (vlib_main_t *vm, u32 node_index, u32 next_index,
+			      int is_enable);
+int vlib_node_is_fused_next (vlib_main_t *vm, u32 node_index, u32 next_index);
+u32 vlib_node_fuse_hot_edges (vlib_main_t *vm, u32 min_pct, u64 min_vectors);
+
 vlib_node_function_t *
 vlib_node_get_preferred_node_fn_variant (vlib_main_t *vm,
 					 vlib_node_fn_registration_t *regs);
@@ -374,26 +374,7 @@ vlib_frame_queue_alloc (int nelts)
   clib_memset (fq, 0, sizeof (*fq));
   fq->nelts = nelts;
   fq->vector_threshold = 128;	// packets
-  vec_validate_aligned (fq->elts, nelts - 1, CLIB_CACHE_LINE_BYTES);
-
-  if (1)
-    {
-      if (((uword) & fq->tail) & (CLIB_CACHE_LINE_BYTES - 1))
-	fformat (stderr, "WARNING: fq->tail unaligned\n");
-      if (((uword) & fq->head) & (CLIB_CACHE_LINE_BYTES - 1))
-	fformat (stderr, "WARNING: fq->head unaligned\n");
-      if (((uword) fq->elts) & (CLIB_CACHE_LINE_BYTES - 1))
-	fformat (stderr, "WARNING: fq->elts unaligned\n");
-
-      if (sizeof (fq->elts[0]) % CLIB_CACHE_LINE_BYTES)
-	fformat (stderr, "WARNING: fq->elts[0] size %d\n",
-		 sizeof (fq->elts[0]));
-      if (nelts & (nelts - 1))
-	{
-	  fformat (stderr, "FATAL: nelts MUST be a power of 2\n");
-	  abort ();
-	}
-    }
+  fq->ring = clib_mpmc_ring_alloc (nelts * VLIB_FRAME_SIZE);
 
   return (fq);
 }
@@ -720,6 +701,9 @@ start_workers (vlib_main_t * vm)
       /* We'll need the rpc vector lock... */
       clib_spinlock_init (&vm->pending_rpc_lock);
 
+      /* ...and the epoch lock, workers may retire objects too */
+      clib_spinlock_init (&vlib_epoch_main.lock);
+
       /* Ask for an initial barrier sync */
       *vlib_worker_threads->workers_at_barrier = 0;
       *vlib_worker_threads->wait_at_barrier = 1;
@@ -810,7 +794,8 @@ start_workers (vlib_main_t * vm)
 		  u32 save_flags;
 
 		  save_node_runtime_index = nf->node_runtime_index;
-		  save_flags = nf->flags & VLIB_FRAME_NO_FREE_AFTER_DISPATCH;
+		  save_flags = nf->flags & (VLIB_FRAME_NO_FREE_AFTER_DISPATCH |
+					    VLIB_FRAME_FUSED);
 		  vlib_next_frame_init (nf);
 		  nf->node_runtime_index = save_node_runtime_index;
 		  nf->flags = save_flags;
@@ -820,6 +805,9 @@ start_workers (vlib_main_t * vm)
 	      nm_clone->pending_frames = 0;
 	      vec_validate (nm_clone->pending_frames, 10);
 	      _vec_len (nm_clone->pending_frames) = 0;
+	      nm_clone->fused_frames = 0;
+	      vec_validate (nm_clone->fused_frames, 10);
+	      _vec_len (nm_clone->fused_frames) = 0;
 
 	      /* fork nodes */
 	      nm_clone->nodes = 0;
@@ -1089,7 +1077,8 @@ vlib_worker_thread_node_refork (void)
       u32 save_flags;
 
       save_node_runtime_index = nf->node_runtime_index;
-      save_flags = nf->flags & VLIB_FRAME_NO_FREE_AFTER_DISPATCH;
+      save_flags = nf->flags & (VLIB_FRAME_NO_FREE_AFTER_DISPATCH |
+				VLIB_FRAME_FUSED);
       vlib_next_frame_init (nf);
       nf->node_runtime_index = save_node_runtime_index;
       nf->flags = save_flags;
@@ -1700,22 +1689,178 @@ vlib_worker_wait_one_loop (void)
   return;
 }
 
+vlib_epoch_main_t vlib_epoch_main;
+
+u64
+vlib_epoch_advance (void)
+{
+  return clib_atomic_add_fetch (&vlib_epoch_main.current, 1);
+}
+
+/* Oldest epoch any worker may still be in */
+static u64
+vlib_epoch_min_seen (void)
+{
+  u64 min = ~0ULL, seen;
+  u32 ii;
+
+  /* Workers parked at the barrier hold no references */
+  if (vlib_worker_thread_barrier_held ())
+    return min;
+
+  for (ii = 1; ii < vec_len (vlib_mains); ii++)
+    {
+      if (vlib_mains[ii] == 0)
+	continue;
+      seen = clib_atomic_load_acq_n (&vlib_mains[ii]->epoch_seen);
+      min = clib_min (min, seen);
+    }
+
+  return min;
+}
+
+/* Has every worker been through a quiescent state since epoch began? */
+int
+vlib_epoch_is_past (u64 epoch)
+{
+  return vlib_epoch_min_seen () >= epoch;
+}
+
+void
+vlib_epoch_call_after_grace (vlib_epoch_callback_t * fn, void *data,
+			     u32 n_data_bytes)
+{
+  vlib_epoch_main_t *em = &vlib_epoch_main;
+  vlib_epoch_deferred_t *d;
+
+  clib_spinlock_lock_if_init (&em->lock);
+
+  vec_add2 (em->deferred, d, 1);
+  d->fn = fn;
+  d->data = 0;
+  vec_add (d->data, data, n_data_bytes);
+  /* advance under the lock, so the list stays in epoch order */
+  d->epoch = vlib_epoch_advance ();
+  em->n_deferred = vec_len (em->deferred);
+  em->n_retired++;
+
+  clib_spinlock_unlock_if_init (&em->lock);
+}
+
+/* Run the callbacks whose grace period has passed. Main thread only. */
+void
+vlib_epoch_reclaim (void)
+{
+  vlib_epoch_main_t *em = &vlib_epoch_main;
+  vlib_epoch_deferred_t *d;
+  u64 min_seen;
+  u32 n = 0;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (em->n_deferred == 0)
+    return;
+
+  min_seen = vlib_epoch_min_seen ();
+
+  clib_spinlock_lock_if_init (&em->lock);
+
+  vec_foreach (d, em->deferred)
+    {
+      if (d->epoch > min_seen)
+	break;
+      n++;
+    }
+
+  vec_reset_length (em->ready);
+  if (n)
+    {
+      vec_add (em->ready, em->deferred, n);
+      vec_delete (em->deferred, n, 0);
+      em->n_deferred = vec_len (em->deferred);
+    }
+
+  clib_spinlock_unlock_if_init (&em->lock);
+
+  /* callbacks may retire more objects, so run them unlocked */
+  vec_foreach (d, em->ready)
+    {
+      d->fn (d->data);
+      vec_free (d->data);
+    }
+  em->n_reclaimed += n;
+}
+
+/* Wait for a full grace period, then reclaim. Main thread only. */
+void
+vlib_epoch_synchronize (void)
+{
+  u64 epoch;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  epoch = vlib_epoch_advance ();
+  while (!vlib_epoch_is_past (epoch))
+    CLIB_PAUSE ();
+
+  vlib_epoch_reclaim ();
+}
+
+static void
+vlib_epoch_mem_free_cb (void *data)
+{
+  clib_mem_free (*(void **) data);
+}
+
+void
+vlib_epoch_mem_free (void *p)
+{
+  if (p)
+    vlib_epoch_call_after_grace (vlib_epoch_mem_free_cb, &p, sizeof (p));
+}
+
+static void
+vlib_epoch_vec_free_cb (void *data)
+{
+  void *v = *(void **) data;
+  vec_free (v);
+}
+
+void
+vlib_epoch_vec_free (void *v)
+{
+  if (v)
+    vlib_epoch_call_after_grace (vlib_epoch_vec_free_cb, &v, sizeof (v));
+}
+
+static void
+vlib_epoch_pool_free_cb (void *data)
+{
+  void *p = *(void **) data;
+  pool_free (p);
+}
+
+void
+vlib_epoch_pool_free (void *p)
+{
+  if (p)
+    vlib_epoch_call_after_grace (vlib_epoch_pool_free_cb, &p, sizeof (p));
+}
+
 /*
- * Check the frame queue to see if any frames are available.
- * If so, pull the packets off the frames and put them to
- * the handoff node.
+ * Check the frame queue to see if any buffers are available.
+ * If so, pull them off the ring in frame sized bursts and put them
+ * to the handoff node.
  */
 int
 vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm)
 {
   u32 thread_id = vm->thread_index;
   vlib_frame_queue_t *fq = fqm->vlib_frame_queues[thread_id];
-  vlib_frame_queue_elt_t *elt;
-  u32 *from, *to;
+  u32 *to;
   vlib_frame_t *f;
-  int msg_type;
   int processed = 0;
-  u32 n_left_to_node;
+  u32 n_vectors;
   u32 vectors = 0;
 
   ASSERT (fq);
@@ -1730,20 +1875,24 @@ vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm)
     {
       frame_queue_trace_t *fqt;
       frame_queue_nelt_counter_t *fqh;
-      u32 elix;
+      u32 elix, n_used, n_elts;
 
       fqt = &fqm->frame_queue_traces[thread_id];
 
+      /* The ring holds buffers, report it in frame sized elements */
+      n_used = clib_mpmc_ring_n_used (fq->ring);
+      n_elts = clib_min (fq->nelts, FRAME_QUEUE_MAX_NELTS);
+
       fqt->nelts = fq->nelts;
-      fqt->head = fq->head;
-      fqt->head_hint = fq->head_hint;
-      fqt->tail = fq->tail;
+      fqt->head = fq->ring->cons_tail;
+      fqt->head_hint = fqt->head;
+      fqt->tail = fq->ring->prod_tail;
       fqt->threshold = fq->vector_threshold;
-      fqt->n_in_use = fqt->tail - fqt->head;
-      if (fqt->n_in_use >= fqt->nelts)
+      fqt->n_in_use = round_pow2 (n_used, VLIB_FRAME_SIZE) / VLIB_FRAME_SIZE;
+      if (fqt->n_in_use >= n_elts)
 	{
 	  // if beyond max then use max
-	  fqt->n_in_use = fqt->nelts - 1;
+	  fqt->n_in_use = n_elts - 1;
 	}
 
       /* Record the number of elements in use in the histogram */
@@ -1751,91 +1900,45 @@ vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm)
       fqh->count[fqt->n_in_use]++;
 
       /* Record a snapshot of the elements in use */
-      for (elix = 0; elix < fqt->nelts; elix++)
+      for (elix = 0; elix < n_elts; elix++)
 	{
-	  elt = fq->elts + ((fq->head + 1 + elix) & (fq->nelts - 1));
-	  if (1 || elt->valid)
-	    {
-	      fqt->n_vectors[elix] = elt->n_vectors;
-	    }
+	  n_vectors = n_used > elix * VLIB_FRAME_SIZE ?
+	    n_used - elix * VLIB_FRAME_SIZE : 0;
+	  fqt->n_vectors[elix] = clib_min (n_vectors, VLIB_FRAME_SIZE);
 	}
       fqt->written = 1;
     }
 
-  while (1)
+  /*
+   * Limit the number of packets pushed into the graph. This thread is
+   * the only consumer, so whatever is in use can be dequeued.
+   */
+  while (vectors < fq->vector_threshold
+	 && clib_mpmc_ring_n_used (fq->ring))
     {
       vlib_buffer_t *b;
-      if (fq->head == fq->tail)
-	{
-	  fq->head_hint = fq->head;
-	  return processed;
-	}
-
-      elt = fq->elts + ((fq->head + 1) & (fq->nelts - 1));
-
-      if (!elt->valid)
-	{
-	  fq->head_hint = fq->head;
-	  return processed;
-	}
-
-      from = elt->buffer_index;
-      msg_type = elt->msg_type;
-
-      ASSERT (msg_type == VLIB_FRAME_QUEUE_ELT_DISPATCH_FRAME);
-      ASSERT (elt->n_vectors <= VLIB_FRAME_SIZE);
 
       f = vlib_get_frame_to_node (vm, fqm->node_index);
+      to = vlib_frame_vector_args (f);
+
+      n_vectors = clib_mpmc_ring_dequeue_burst (fq->ring, to,
+						VLIB_FRAME_SIZE);
+      ASSERT (n_vectors);
 
       /* If the first vector is traced, set the frame trace flag */
-      b = vlib_get_buffer (vm, from[0]);
+      b = vlib_get_buffer (vm, to[0]);
       if (b->flags & VLIB_BUFFER_IS_TRACED)
 	f->frame_flags |= VLIB_NODE_FLAG_TRACE;
 
-      to = vlib_frame_vector_args (f);
-
-      n_left_to_node = elt->n_vectors;
-
-      while (n_left_to_node >= 4)
-	{
-	  to[0] = from[0];
-	  to[1] = from[1];
-	  to[2] = from[2];
-	  to[3] = from[3];
-	  to += 4;
-	  from += 4;
-	  n_left_to_node -= 4;
-	}
-
-      while (n_left_to_node > 0)
-	{
-	  to[0] = from[0];
-	  to++;
-	  from++;
-	  n_left_to_node--;
-	}
-
-      vectors += elt->n_vectors;
-      f->n_vectors = elt->n_vectors;
+      f->n_vectors = n_vectors;
       vlib_put_frame_to_node (vm, fqm->node_index, f);
 
-      elt->valid = 0;
-      elt->n_vectors = 0;
-      elt->msg_type = 0xfefefefe;
-      CLIB_MEMORY_BARRIER ();
-      fq->head++;
+      vectors += n_vectors;
+      fq->dequeues++;
+      fq->dequeue_vectors += n_vectors;
       processed++;
-
-      /*
-       * Limit the number of packets pushed into the graph
-       */
-      if (vectors >= fq->vector_threshold)
-	{
-	  fq->head_hint = fq->head;
-	  return processed;
-	}
     }
-  ASSERT (0);
+
   return processed;
 }
 
@@ -1894,7 +1997,7 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
 
   fqm->node_index = node_index;
   fqm->frame_queue_nelts = frame_queue_nelts;
-  fqm->queue_hi_thresh = frame_queue_nelts - num_threads;
+  fqm->queue_hi_thresh = (frame_queue_nelts - num_threads) * VLIB_FRAME_SIZE;
 
   vec_validate (fqm->vlib_frame_queues, tm->n_vlib_mains - 1);
   vec_validate (fqm->per_thread_data, tm->n_vlib_mains - 1);
@@ -1906,11 +2009,10 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
       vec_add1 (fqm->vlib_frame_queues, fq);
 
       ptd = vec_elt_at_index (fqm->per_thread_data, i);
-      vec_validate (ptd->handoff_queue_elt_by_thread_index,
-		    tm->n_vlib_mains - 1);
-      vec_validate_init_empty (ptd->congested_handoff_queue_by_thread_index,
-			       tm->n_vlib_mains - 1,
-			       (vlib_frame_queue_t *) (~0));
+      vec_validate_aligned (ptd->pending_buffers,
+			    tm->n_vlib_mains * VLIB_FRAME_SIZE - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      vec_validate (ptd->n_pending_by_thread_index, tm->n_vlib_mains - 1);
     }
 
   return (fqm - tm->frame_queue_mains);
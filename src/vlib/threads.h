@@ -17,6 +17,7 @@
 
 #include <vlib/main.h>
 #include <vppinfra/callback.h>
+#include <vppinfra/mpmc_ring.h>
 #include <linux/sched.h>
 
 extern vlib_main_t **vlib_mains;
@@ -71,19 +72,6 @@ typedef enum
   VLIB_FRAME_QUEUE_ELT_DISPATCH_FRAME,
 } vlib_frame_queue_msg_type_t;
 
-typedef struct
-{
-  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
-  volatile u32 valid;
-  u32 msg_type;
-  u32 n_vectors;
-  u32 last_n_vectors;
-
-  /* 256 * 4 = 1024 bytes, even mult of cache line size */
-  u32 buffer_index[VLIB_FRAME_SIZE];
-}
-vlib_frame_queue_elt_t;
-
 typedef struct
 {
   /* First cache line */
@@ -121,7 +109,6 @@ typedef struct
 {
   /* enqueue side */
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
-  volatile u64 tail;
   u64 enqueues;
   u64 enqueue_ticks;
   u64 enqueue_vectors;
@@ -129,34 +116,36 @@ typedef struct
 
   /* dequeue side */
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
-  volatile u64 head;
   u64 dequeues;
   u64 dequeue_ticks;
   u64 dequeue_vectors;
   u64 trace;
   u64 vector_threshold;
 
-  /* dequeue hint to enqueue side */
+  /* read-only, constant, shared */
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
-  volatile u64 head_hint;
 
-  /* read-only, constant, shared */
-    CLIB_CACHE_LINE_ALIGN_MARK (cacheline3);
-  vlib_frame_queue_elt_t *elts;
+  /*
+   * Buffer indices handed off to this thread. Any thread may enqueue,
+   * room for nelts frames worth of buffers.
+   */
+  clib_mpmc_ring_t *ring;
   u32 nelts;
 }
 vlib_frame_queue_t;
 
 typedef struct
 {
-  vlib_frame_queue_elt_t **handoff_queue_elt_by_thread_index;
-  vlib_frame_queue_t **congested_handoff_queue_by_thread_index;
+  /* buffers staged for handoff, VLIB_FRAME_SIZE per destination thread */
+  u32 *pending_buffers;
+  u16 *n_pending_by_thread_index;
 } vlib_frame_queue_per_thread_data_t;
 
 typedef struct
 {
   u32 node_index;
   u32 frame_queue_nelts;
+  /* in buffers, drop_on_congestion handoffs drop above this */
   u32 queue_hi_thresh;
 
   vlib_frame_queue_t **vlib_frame_queues;
@@ -215,6 +204,90 @@ void vlib_worker_thread_node_refork (void);
  */
 void vlib_worker_wait_one_loop (void);
 
+/*
+ * Epoch based deferred reclamation.
+ *
+ * Workers take no locks when they read shared forwarding state. Instead
+ * each worker announces a quiescent state once per main loop by copying
+ * the global epoch into its vlib_main_t, at a point where it holds no
+ * references to shared objects. A writer first unpublishes an object
+ * (swaps a pointer, overwrites an index) and then hands it to
+ * vlib_epoch_call_after_grace(), which bumps the epoch. Once every
+ * worker has announced that epoch or a later one none of them can still
+ * see the object, and the callback runs on the main thread.
+ */
+
+typedef void (vlib_epoch_callback_t) (void *data);
+
+typedef struct
+{
+  u64 epoch;
+  vlib_epoch_callback_t *fn;
+  u8 *data;
+} vlib_epoch_deferred_t;
+
+typedef struct
+{
+  /* bumped each time something is retired, read by every worker loop */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u64 current;
+
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  clib_spinlock_t lock;
+
+  /* pending callbacks, in non-decreasing epoch order */
+  vlib_epoch_deferred_t *deferred;
+  volatile u32 n_deferred;
+
+  /* callbacks being run, reused */
+  vlib_epoch_deferred_t *ready;
+
+  u64 n_retired;
+  u64 n_reclaimed;
+} vlib_epoch_main_t;
+
+extern vlib_epoch_main_t vlib_epoch_main;
+
+u64 vlib_epoch_advance (void);
+int vlib_epoch_is_past (u64 epoch);
+void vlib_epoch_call_after_grace (vlib_epoch_callback_t * fn, void *data,
+				  u32 n_data_bytes);
+void vlib_epoch_reclaim (void);
+void vlib_epoch_synchronize (void);
+void vlib_epoch_mem_free (void *p);
+void vlib_epoch_vec_free (void *v);
+void vlib_epoch_pool_free (void *p);
+
+/* Worker side: called at the top of each main loop */
+always_inline void
+vlib_epoch_quiesce (vlib_main_t * vm)
+{
+  clib_atomic_store_rel_n (&vm->epoch_seen,
+			   clib_atomic_load_acq_n (&vlib_epoch_main.current));
+}
+
+/*
+ * Make sure the next get from pool P does not reallocate it. If it
+ * would, a copy with room to grow is published in place of P and the
+ * old memory is freed after a grace period, so workers may keep reading
+ * P without the barrier. Main thread only.
+ */
+#define vlib_epoch_pool_reserve_aligned(P,A)				\
+do {									\
+  u8 _will_expand;							\
+  pool_get_aligned_will_expand ((P), _will_expand, (A));		\
+  if (_will_expand && vlib_num_workers ())				\
+    {									\
+      typeof (P) _old = (P);						\
+      typeof (P) _new = pool_dup_aligned (_old, (A));			\
+      pool_alloc_aligned (_new, clib_max (pool_len (_old), 16), (A));	\
+      clib_atomic_store_rel_n (&(P), _new);				\
+      vlib_epoch_pool_free (_old);					\
+    }									\
+} while (0)
+
+#define vlib_epoch_pool_reserve(P) vlib_epoch_pool_reserve_aligned(P,0)
+
 static_always_inline uword
 vlib_get_thread_index (void)
 {
@@ -534,94 +607,6 @@ vlib_thread_is_main_w_barrier (void)
 	       && vlib_worker_threads->wait_at_barrier[0])));
 }
 
-static inline void
-vlib_put_frame_queue_elt (vlib_frame_queue_elt_t * hf)
-{
-  CLIB_MEMORY_BARRIER ();
-  hf->valid = 1;
-}
-
-static inline vlib_frame_queue_elt_t *
-vlib_get_frame_queue_elt (u32 frame_queue_index, u32 index)
-{
-  vlib_frame_queue_t *fq;
-  vlib_frame_queue_elt_t *elt;
-  vlib_thread_main_t *tm = &vlib_thread_main;
-  vlib_frame_queue_main_t *fqm =
-    vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
-  u64 new_tail;
-
-  fq = fqm->vlib_frame_queues[index];
-  ASSERT (fq);
-
-  new_tail = clib_atomic_add_fetch (&fq->tail, 1);
-
-  /* Wait until a ring slot is available */
-  while (new_tail >= fq->head_hint + fq->nelts)
-    vlib_worker_thread_barrier_check ();
-
-  elt = fq->elts + (new_tail & (fq->nelts - 1));
-
-  /* this would be very bad... */
-  while (elt->valid)
-    ;
-
-  elt->msg_type = VLIB_FRAME_QUEUE_ELT_DISPATCH_FRAME;
-  elt->last_n_vectors = elt->n_vectors = 0;
-
-  return elt;
-}
-
-static inline vlib_frame_queue_t *
-is_vlib_frame_queue_congested (u32 frame_queue_index,
-			       u32 index,
-			       u32 queue_hi_thresh,
-			       vlib_frame_queue_t **
-			       handoff_queue_by_worker_index)
-{
-  vlib_frame_queue_t *fq;
-  vlib_thread_main_t *tm = &vlib_thread_main;
-  vlib_frame_queue_main_t *fqm =
-    vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
-
-  fq = handoff_queue_by_worker_index[index];
-  if (fq != (vlib_frame_queue_t *) (~0))
-    return fq;
-
-  fq = fqm->vlib_frame_queues[index];
-  ASSERT (fq);
-
-  if (PREDICT_FALSE (fq->tail >= (fq->head_hint + queue_hi_thresh)))
-    {
-      /* a valid entry in the array will indicate the queue has reached
-       * the specified threshold and is congested
-       */
-      handoff_queue_by_worker_index[index] = fq;
-      fq->enqueue_full_events++;
-      return fq;
-    }
-
-  return NULL;
-}
-
-static inline vlib_frame_queue_elt_t *
-vlib_get_worker_handoff_queue_elt (u32 frame_queue_index,
-				   u32 vlib_worker_index,
-				   vlib_frame_queue_elt_t **
-				   handoff_queue_elt_by_worker_index)
-{
-  vlib_frame_queue_elt_t *elt;
-
-  if (handoff_queue_elt_by_worker_index[vlib_worker_index])
-    return handoff_queue_elt_by_worker_index[vlib_worker_index];
-
-  elt = vlib_get_frame_queue_elt (frame_queue_index, vlib_worker_index);
-
-  handoff_queue_elt_by_worker_index[vlib_worker_index] = elt;
-
-  return elt;
-}
-
 u8 *vlib_thread_stack_init (uword thread_index);
 int vlib_thread_cb_register (struct vlib_main_t *vm,
 			     vlib_thread_callbacks_t * cb);
@@ -19,6 +19,7 @@
 #include <vppinfra/elf.h>
 #include <dlfcn.h>
 #include <dirent.h>
+#include <pthread.h>
 
 plugin_main_t vlib_plugin_main;
 
@@ -155,23 +156,35 @@ r2_to_reg (elf_main_t * em, vlib_plugin_r2_t * r2,
 }
 
 
+/*
+ * Read the plugin registration from the ELF file, without dlopen'ing
+ * it. Runs on the plugin read threads, so it must not log or touch
+ * plugin main state other than this plugin's info.
+ */
 static int
-load_one_plugin (plugin_main_t * pm, plugin_info_t * pi, int from_early_init)
+read_one_plugin (plugin_main_t * pm, plugin_info_t * pi)
 {
-  void *handle;
-  int reread_reg = 1;
   clib_error_t *error;
   elf_main_t em = { 0 };
   elf_section_t *section;
   u8 *data;
-  char *version_required;
   vlib_plugin_registration_t *reg;
   vlib_plugin_r2_t *r2;
-  plugin_config_t *pc = 0;
-  uword *p;
+  f64 start = unix_time_now ();
+  int rv = -1;
 
-  if (elf_read_file (&em, (char *) pi->filename))
-    return -1;
+  pi->reg = 0;
+  pi->reg_data = 0;
+  pi->reread_reg = 1;
+  vec_reset_length (pi->read_error);
+
+  if ((error = elf_read_file (&em, (char *) pi->filename)))
+    {
+      pi->read_error = format (pi->read_error, "%U%c", format_clib_error,
+			       error, 0);
+      clib_error_free (error);
+      goto done;
+    }
 
   /* New / improved (well, not really) registration structure? */
   error = elf_get_section_by_name (&em, ".vlib_plugin_r2", &section);
@@ -184,39 +197,131 @@ load_one_plugin (plugin_main_t * pm, plugin_info_t * pi, int from_early_init)
 
       reg->default_disabled = r2->default_disabled != 0;
       error = r2_to_reg (&em, r2, reg);
+      vec_free (data);
       if (error)
 	{
-	  PLUGIN_LOG_ERR ("Bad r2 registration: %s\n", (char *) pi->name);
-	  return -1;
+	  clib_error_free (error);
+	  clib_mem_free (reg);
+	  pi->read_error = format (pi->read_error,
+				   "Bad r2 registration: %s%c", pi->name, 0);
+	  goto done;
 	}
-      if (pm->plugins_default_disable)
-	reg->default_disabled = 1;
-      reread_reg = 0;
-      goto process_reg;
+      pi->reg = reg;
+      pi->reread_reg = 0;
+      rv = 0;
+      goto done;
     }
+  clib_error_free (error);
 
   error = elf_get_section_by_name (&em, ".vlib_plugin_registration",
 				   &section);
   if (error)
     {
-      PLUGIN_LOG_ERR ("Not a plugin: %s\n", (char *) pi->name);
-      return -1;
+      clib_error_free (error);
+      pi->read_error = format (pi->read_error, "Not a plugin: %s%c",
+			       pi->name, 0);
+      goto done;
     }
 
   data = elf_get_section_contents (&em, section->index, 1);
-  reg = (vlib_plugin_registration_t *) data;
-
   if (vec_len (data) != sizeof (*reg))
     {
-      PLUGIN_LOG_ERR ("vlib_plugin_registration size mismatch in plugin %s\n",
-		      (char *) pi->name);
-      goto error;
+      vec_free (data);
+      pi->read_error =
+	format (pi->read_error,
+		"vlib_plugin_registration size mismatch in plugin %s%c",
+		pi->name, 0);
+      goto done;
     }
 
+  /* Replaced by the dlsym'ed registration once loaded */
+  pi->reg_data = data;
+  pi->reg = (vlib_plugin_registration_t *) data;
+  rv = 0;
+
+done:
+  elf_main_free (&em);
+  pi->read_time = unix_time_now () - start;
+  return rv;
+}
+
+static void *
+plugin_read_thread_fn (void *arg)
+{
+  plugin_main_t *pm = arg;
+  u32 i;
+
+  while ((i = clib_atomic_fetch_add (&pm->read_next_index, 1)) <
+	 vec_len (pm->plugin_info))
+    read_one_plugin (pm, vec_elt_at_index (pm->plugin_info, i));
+
+  return 0;
+}
+
+/*
+ * Reading plugin ELF files and parsing their symbol tables is the bulk
+ * of the plugin load time and is independent per plugin, so it is
+ * spread over a few threads. dlopen runs plugin constructors which
+ * register nodes, init functions, CLI commands and so on onto
+ * unlocked global lists, so it stays serial and in name order.
+ */
+static void
+read_all_plugins (plugin_main_t * pm)
+{
+  pthread_t *threads = 0, *t;
+  u32 n_threads = pm->n_load_threads;
+  f64 start = unix_time_now ();
+  int i;
+
+  if (n_threads == 0)
+    n_threads = clib_min (sysconf (_SC_NPROCESSORS_ONLN), 8);
+  n_threads = clib_min (n_threads, vec_len (pm->plugin_info));
+
+  pm->read_next_index = 0;
+  for (i = 1; i < n_threads; i++)
+    {
+      vec_add2 (threads, t, 1);
+      if (pthread_create (t, NULL, plugin_read_thread_fn, pm))
+	{
+	  _vec_len (threads) -= 1;
+	  break;
+	}
+    }
+
+  pm->n_read_threads = vec_len (threads) + 1;
+
+  /* Do our share, then wait for the others */
+  plugin_read_thread_fn (pm);
+
+  vec_foreach (t, threads)
+    pthread_join (t[0], NULL);
+  vec_free (threads);
+
+  pm->read_phase_time = unix_time_now () - start;
+}
+
+static int
+load_one_plugin (plugin_main_t * pm, plugin_info_t * pi, int from_early_init)
+{
+  void *handle;
+  clib_error_t *error;
+  char *version_required;
+  vlib_plugin_registration_t *reg;
+  plugin_config_t *pc = 0;
+  uword *p;
+  f64 start = unix_time_now ();
+
+  if (pi->reg == 0)
+    {
+      if (vec_len (pi->read_error))
+	PLUGIN_LOG_ERR ("%s", pi->read_error);
+      return -1;
+    }
+
+  reg = pi->reg;
   if (pm->plugins_default_disable)
     reg->default_disabled = 1;
 
-process_reg:
   p = hash_get_mem (pm->config_index_by_name, pi->name);
   if (p)
     {
@@ -315,7 +420,7 @@ process_reg:
 
   pi->handle = handle;
 
-  if (reread_reg)
+  if (pi->reread_reg)
     reg = dlsym (pi->handle, "vlib_plugin_registration");
 
   pi->reg = reg;
@@ -353,13 +458,17 @@ process_reg:
   else
     PLUGIN_LOG_NOTICE ("Loaded plugin: %s", pi->name);
 
-  vec_free (data);
-  elf_main_free (&em);
+  vec_free (pi->reg_data);
+  pi->load_time = unix_time_now () - start;
   return 0;
 
 error:
-  vec_free (data);
-  elf_main_free (&em);
+  if (pi->reread_reg)
+    vec_free (pi->reg_data);
+  else
+    clib_mem_free (pi->reg);
+  pi->reg = 0;
+  pi->reg_data = 0;
   return -1;
 }
 
@@ -422,6 +531,7 @@ vlib_load_new_plugins (plugin_main_t * pm, int from_early_init)
   plugin_info_t *pi;
   u8 **plugin_path;
   uword *not_loaded_indices = 0;
+  f64 start;
   int i;
 
   plugin_path = split_plugin_path (pm);
@@ -495,8 +605,11 @@ vlib_load_new_plugins (plugin_main_t * pm, int from_early_init)
   vec_sort_with_function (pm->plugin_info, plugin_name_sort_cmp);
 
   /*
-   * Attempt to load the plugins
+   * Read all registrations, then attempt to load the plugins
    */
+  read_all_plugins (pm);
+
+  start = unix_time_now ();
   for (i = 0; i < vec_len (pm->plugin_info); i++)
     {
       pi = vec_elt_at_index (pm->plugin_info, i);
@@ -507,6 +620,7 @@ vlib_load_new_plugins (plugin_main_t * pm, int from_early_init)
 	  vec_add1 (not_loaded_indices, i);
 	}
     }
+  pm->load_phase_time = unix_time_now () - start;
 
   /*
    * Honor override list
@@ -565,6 +679,7 @@ vlib_load_new_plugins (plugin_main_t * pm, int from_early_init)
 	    }
 	  vec_free (pi->name);
 	  vec_free (pi->filename);
+	  vec_free (pi->read_error);
 	  vec_delete (pm->plugin_info, 1, not_loaded_indices[i]);
 	}
       vec_free (not_loaded_indices);
@@ -660,6 +775,62 @@ VLIB_CLI_COMMAND (plugins_show_cmd, static) =
 };
 /* *INDENT-ON* */
 
+static int
+plugin_load_time_cmp (void *a1, void *a2)
+{
+  plugin_info_t *p1 = a1;
+  plugin_info_t *p2 = a2;
+  f64 t1 = p1->read_time + p1->load_time;
+  f64 t2 = p2->read_time + p2->load_time;
+
+  return t1 < t2 ? 1 : (t1 > t2 ? -1 : 0);
+}
+
+static clib_error_t *
+vlib_plugins_show_timing_cmd_fn (vlib_main_t * vm,
+				 unformat_input_t * input,
+				 vlib_cli_command_t * cmd)
+{
+  plugin_main_t *pm = &vlib_plugin_main;
+  plugin_info_t *sorted, *pi;
+  f64 read_total = 0, load_total = 0;
+
+  sorted = vec_dup (pm->plugin_info);
+  vec_sort_with_function (sorted, plugin_load_time_cmp);
+
+  vlib_cli_output (vm, "%-40s%12s%12s", "Plugin", "Read (ms)", "Load (ms)");
+  vec_foreach (pi, sorted)
+  {
+    vlib_cli_output (vm, "%-40s%12.3f%12.3f", pi->name, pi->read_time * 1e3,
+		     pi->load_time * 1e3);
+    read_total += pi->read_time;
+    load_total += pi->load_time;
+  }
+  vlib_cli_output (vm, "%-40s%12.3f%12.3f", "Total", read_total * 1e3,
+		   load_total * 1e3);
+  vlib_cli_output (vm, "Read phase %.3f ms wall clock on %u threads, "
+		   "load phase %.3f ms", pm->read_phase_time * 1e3,
+		   pm->n_read_threads, pm->load_phase_time * 1e3);
+
+  vec_free (sorted);
+  return 0;
+}
+
+/*?
+ * Show the time each loaded plugin took at startup, slowest first.
+ * 'Read' is reading and parsing the plugin ELF file, done in parallel,
+ * 'Load' is dlopen and the plugin early init function, done serially.
+ * See 'show init-function timing' for the time spent in init functions.
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (plugins_show_timing_cmd, static) =
+{
+  .path = "show plugins timing",
+  .short_help = "show plugins timing",
+  .function = vlib_plugins_show_timing_cmd_fn,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 config_one_plugin (vlib_main_t * vm, char *name, unformat_input_t * input)
 {
@@ -761,6 +932,8 @@ done:
 	pm->vat_plugin_path = s;
       else if (unformat (input, "vat-name-filter %s", &s))
 	pm->vat_plugin_name_filter = s;
+      else if (unformat (input, "load-threads %u", &pm->n_load_threads))
+	;
       else if (unformat (input, "plugin default %U",
 			 unformat_vlib_cli_sub_input, &sub_input))
 	{
@@ -104,6 +104,15 @@ typedef struct
   /* plugin registration */
   vlib_plugin_registration_t *reg;
   char *version;
+
+  /* registration section read before dlopen, and why that failed */
+  u8 *reg_data;
+  u8 *read_error;
+  u8 reread_reg;
+
+  /* seconds spent reading the ELF file, and in dlopen and early init */
+  f64 read_time;
+  f64 load_time;
 } plugin_info_t;
 
 typedef struct
@@ -128,6 +137,16 @@ typedef struct
   u8 *vat_plugin_name_filter;
   u8 plugins_default_disable;
 
+  /* threads reading plugin files at startup, 0 picks one per cpu,
+     up to 8 */
+  u32 n_load_threads;
+  u32 n_read_threads;
+  u32 read_next_index;
+
+  /* wall clock seconds of the last read and load phases */
+  f64 read_phase_time;
+  f64 load_phase_time;
+
   /* plugin configs and hash by name */
   plugin_config_t *configs;
   uword *config_index_by_name;
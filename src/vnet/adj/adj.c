@@ -70,25 +70,25 @@ adj_alloc (fib_protocol_t proto)
 
     ASSERT (vm->thread_index == 0);
 
-    pool_get_aligned_will_expand (adj_pool, need_barrier_sync,
-                                  CLIB_CACHE_LINE_BYTES);
-    /* If the adj_pool will expand, stop the parade. */
-    if (need_barrier_sync)
-        vlib_worker_thread_barrier_sync (vm);
+    /*
+     * If the adj_pool would expand, grow a copy and retire the old one
+     * once the workers are past it, rather than stop the parade.
+     */
+    vlib_epoch_pool_reserve_aligned (adj_pool, CLIB_CACHE_LINE_BYTES);
 
     pool_get_aligned(adj_pool, adj, CLIB_CACHE_LINE_BYTES);
 
     adj_poison(adj);
 
-    /* Validate adjacency counters. */
-    if (need_barrier_sync == 0)
-    {
-        /* If the adj counter pool will expand, stop the parade */
-        need_barrier_sync = vlib_validate_combined_counter_will_expand
-            (&adjacency_counters, adj_get_index (adj));
-        if (need_barrier_sync)
-            vlib_worker_thread_barrier_sync (vm);
-    }
+    /*
+     * Validate adjacency counters. The workers write them without
+     * atomics, so they cannot be copied under their feet; if the adj
+     * counter pool will expand, stop the parade.
+     */
+    need_barrier_sync = vlib_validate_combined_counter_will_expand
+        (&adjacency_counters, adj_get_index (adj));
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync (vm);
     vlib_validate_combined_counter(&adjacency_counters,
                                    adj_get_index(adj));
 
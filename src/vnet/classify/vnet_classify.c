@@ -160,10 +160,28 @@ vnet_classify_new_table (vnet_classify_main_t *cm, const u8 *mask,
   return (t);
 }
 
+typedef struct
+{
+  u32x4 *mask;
+  vnet_classify_bucket_t *buckets;
+  void *mheap;
+} vnet_classify_table_free_args_t;
+
+static void
+vnet_classify_table_free (void *data)
+{
+  vnet_classify_table_free_args_t *a = data;
+
+  vec_free (a->mask);
+  vec_free (a->buckets);
+  clib_mem_destroy_heap (a->mheap);
+}
+
 void
 vnet_classify_delete_table_index (vnet_classify_main_t * cm,
 				  u32 table_index, int del_chain)
 {
+  vnet_classify_table_free_args_t args;
   vnet_classify_table_t *t;
 
   /* Tolerate multiple frees, up to a point */
@@ -175,12 +193,21 @@ vnet_classify_delete_table_index (vnet_classify_main_t * cm,
     /* Recursively delete the entire chain */
     vnet_classify_delete_table_index (cm, t->next_table_index, del_chain);
 
-  vec_free (t->mask);
-  vec_free (t->buckets);
-  clib_mem_destroy_heap (t->mheap);
+  /* The workers may still be walking the table, free it when they're past */
+  args.mask = t->mask;
+  args.buckets = t->buckets;
+  args.mheap = t->mheap;
+  vlib_epoch_call_after_grace (vnet_classify_table_free, &args,
+			       sizeof (args));
+
+  t->mask = 0;
+  t->buckets = 0;
+  t->mheap = 0;
   pool_put (cm->tables, t);
 }
 
+static void vnet_classify_entry_reclaim (vnet_classify_table_t * t);
+
 static vnet_classify_entry_t *
 vnet_classify_entry_alloc (vnet_classify_table_t * t, u32 log2_pages)
 {
@@ -193,6 +220,9 @@ vnet_classify_entry_alloc (vnet_classify_table_t * t, u32 log2_pages)
     (sizeof (vnet_classify_entry_t) + (t->match_n_vectors * sizeof (u32x4)))
     * t->entries_per_page * (1 << log2_pages);
 
+  if (vec_len (t->retired_pages))
+    vnet_classify_entry_reclaim (t);
+
   if (log2_pages >= vec_len (t->freelists) || t->freelists[log2_pages] == 0)
     {
       oldheap = clib_mem_set_heap (t->mheap);
@@ -225,6 +255,49 @@ vnet_classify_entry_free (vnet_classify_table_t * t,
   t->freelists[log2_pages] = v;
 }
 
+/*
+ * A page which was replaced in a bucket may still be read by the workers,
+ * it goes back on the freelist once they have all been around their main
+ * loop since.
+ */
+static void
+vnet_classify_entry_retire (vnet_classify_table_t * t,
+			    vnet_classify_entry_t * v, u32 log2_pages)
+{
+  vnet_classify_retired_page_t *r;
+  void *oldheap;
+
+  CLIB_SPINLOCK_ASSERT_LOCKED (&t->writer_lock);
+
+  oldheap = clib_mem_set_heap (t->mheap);
+  vec_add2 (t->retired_pages, r, 1);
+  clib_mem_set_heap (oldheap);
+
+  r->v = v;
+  r->log2_pages = log2_pages;
+  r->epoch = vlib_epoch_advance ();
+}
+
+static void
+vnet_classify_entry_reclaim (vnet_classify_table_t * t)
+{
+  vnet_classify_retired_page_t *r;
+  u32 n = 0;
+
+  CLIB_SPINLOCK_ASSERT_LOCKED (&t->writer_lock);
+
+  vec_foreach (r, t->retired_pages)
+    {
+      if (!vlib_epoch_is_past (r->epoch))
+	break;
+      vnet_classify_entry_free (t, r->v, r->log2_pages);
+      n++;
+    }
+
+  if (n)
+    vec_delete (t->retired_pages, n, 0);
+}
+
 static inline void make_working_copy
   (vnet_classify_table_t * t, vnet_classify_bucket_t * b)
 {
@@ -633,7 +706,7 @@ expand_ok:
   b->as_u64 = tmp_b.as_u64;
   t->active_elements++;
   v = vnet_classify_get_entry (t, t->saved_bucket.offset);
-  vnet_classify_entry_free (t, v, old_log2_pages);
+  vnet_classify_entry_retire (t, v, old_log2_pages);
 
 unlock:
   clib_spinlock_unlock (&t->writer_lock);
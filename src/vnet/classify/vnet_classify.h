@@ -144,6 +144,14 @@ typedef struct
   };
 } vnet_classify_bucket_t;
 
+/* A page replaced in a bucket, waiting for the workers to be past it */
+typedef struct
+{
+  vnet_classify_entry_t *v;
+  u64 epoch;
+  u32 log2_pages;
+} vnet_classify_retired_page_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
@@ -193,6 +201,9 @@ typedef struct
   /* Free entry freelists */
   vnet_classify_entry_t **freelists;
 
+  /* Replaced pages, oldest first, not yet back on the freelists */
+  vnet_classify_retired_page_t *retired_pages;
+
   /* Writer (only) lock for this table */
   clib_spinlock_t writer_lock;
 
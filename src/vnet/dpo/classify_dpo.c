@@ -26,12 +26,8 @@ static classify_dpo_t *
 classify_dpo_alloc (void)
 {
     classify_dpo_t *cd;
-    vlib_main_t *vm;
-    u8 did_barrier_sync;
 
-    dpo_pool_barrier_sync (vm, classify_dpo_pool, did_barrier_sync);
-    pool_get_aligned(classify_dpo_pool, cd, CLIB_CACHE_LINE_BYTES);
-    dpo_pool_barrier_release (vm, did_barrier_sync);
+    dpo_pool_get(classify_dpo_pool, cd);
 
     clib_memset(cd, 0, sizeof(*cd));
 
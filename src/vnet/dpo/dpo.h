@@ -526,47 +526,24 @@ dpo_get_next_node_by_type_and_proto (dpo_type_t   child_type,
 
 
 /**
- * @brief Barrier sync if a dpo pool is about to expand
+ * @brief Get an element from a DPO pool that the workers read
  *
- * @param VM (output)
- *  vlib_main_t *, invariably &vlib_global_main
+ * If the pool is about to expand, a bigger copy is published and the
+ * old pool is freed once the workers are past it, so there is no need
+ * to barrier sync.
  *
  * @param P
  *  pool pointer
  *
- * @param YESNO (output)
- *  typically a u8, 1 => expand will occur, worker barrier held
- *                  0 => no expand, barrier not held
- *
- * @return YESNO set
+ * @param E (output)
+ *  the new element
  */
 
-#define dpo_pool_barrier_sync(VM,P,YESNO)                               \
+#define dpo_pool_get(P,E)                                               \
 do {                                                                    \
-    pool_get_aligned_will_expand ((P), YESNO, CLIB_CACHE_LINE_BYTES);   \
-                                                                        \
-    if (YESNO)                                                          \
-    {                                                                   \
-        VM = vlib_get_main();                                           \
-        ASSERT ((VM)->thread_index == 0);                               \
-        vlib_worker_thread_barrier_sync((VM));                          \
-    }                                                                   \
-} while(0);
-
-/**
- * @brief Release barrier sync after dpo pool expansion
- *
- * @param VM
- *  vlib_main_t pointer, must be &vlib_global_main
- *
- * @param YESNO
- *  typically a u8, 1 => release required
- *                  0 => no release required
- * @return none
- */
-
-#define dpo_pool_barrier_release(VM,YESNO) \
-    if ((YESNO)) vlib_worker_thread_barrier_release((VM));
+    vlib_epoch_pool_reserve_aligned ((P), CLIB_CACHE_LINE_BYTES);       \
+    pool_get_aligned ((P), (E), CLIB_CACHE_LINE_BYTES);                 \
+} while(0)
 
 #endif
 
@@ -24,6 +24,7 @@
 #include <vnet/fib/mpls_fib.h>
 #include <vnet/ip/ip4_inlines.h>
 #include <vnet/ip/ip6_inlines.h>
+#include <vnet/ip/ip_flow_cache.h>
 
 // clang-format off
 
@@ -100,10 +101,9 @@ load_balance_alloc_i (void)
     vlib_main_t *vm = vlib_get_main();
     ASSERT (vm->thread_index == 0);
 
-    pool_get_aligned_will_expand (load_balance_pool, need_barrier_sync,
-                                  CLIB_CACHE_LINE_BYTES);
-    if (need_barrier_sync)
-        vlib_worker_thread_barrier_sync (vm);
+    /* grow by publish-then-reclaim, the workers keep reading the old pool */
+    vlib_epoch_pool_reserve_aligned (load_balance_pool,
+                                     CLIB_CACHE_LINE_BYTES);
 
     pool_get_aligned(load_balance_pool, lb, CLIB_CACHE_LINE_BYTES);
     clib_memset(lb, 0, sizeof(*lb));
@@ -111,17 +111,15 @@ load_balance_alloc_i (void)
     lb->lb_map = INDEX_INVALID;
     lb->lb_urpf = INDEX_INVALID;
 
-    if (need_barrier_sync == 0)
-    {
-        need_barrier_sync += vlib_validate_combined_counter_will_expand
-            (&(load_balance_main.lbm_to_counters),
-             load_balance_get_index(lb));
-        need_barrier_sync += vlib_validate_combined_counter_will_expand
-            (&(load_balance_main.lbm_via_counters),
-             load_balance_get_index(lb));
-        if (need_barrier_sync)
-            vlib_worker_thread_barrier_sync (vm);
-    }
+    /* counters are written by the workers without atomics, so need the barrier */
+    need_barrier_sync += vlib_validate_combined_counter_will_expand
+        (&(load_balance_main.lbm_to_counters),
+         load_balance_get_index(lb));
+    need_barrier_sync += vlib_validate_combined_counter_will_expand
+        (&(load_balance_main.lbm_via_counters),
+         load_balance_get_index(lb));
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync (vm);
 
     vlib_validate_combined_counter(&(load_balance_main.lbm_to_counters),
                                    load_balance_get_index(lb));
@@ -293,6 +291,7 @@ load_balance_set_bucket (index_t lbi,
     ASSERT(bucket < lb->lb_n_buckets);
 
     load_balance_set_bucket_i(lb, bucket, buckets, next);
+    ip_flow_cache_invalidate();
 }
 
 int
@@ -600,6 +599,75 @@ load_balance_fill_buckets_sticky (load_balance_t *lb,
     vec_free(fwding_paths);
 }
 
+/*
+ * Fill the buckets of a resilient load-balance. Each path is given its
+ * share of the fixed number of buckets. A bucket keeps the path it has
+ * if that path is still present and has not reached its share, the
+ * others are shared, round-robin, amongst the paths that need more.
+ */
+static void
+load_balance_fill_buckets_resilient (load_balance_t *lb,
+                                     load_balance_path_t *nhs,
+                                     dpo_id_t *buckets,
+                                     u32 n_buckets)
+{
+    u32 *quota, *free_buckets, *bucket, sum_weight, n_left, ii, jj;
+    load_balance_path_t *nh;
+
+    quota = free_buckets = NULL;
+    sum_weight = 0;
+
+    vec_foreach (nh, nhs)
+    {
+        sum_weight += nh->path_weight;
+    }
+    n_left = n_buckets;
+    vec_validate(quota, vec_len(nhs) - 1);
+    vec_foreach_index (ii, nhs)
+    {
+        quota[ii] = ((u64) nhs[ii].path_weight * n_buckets) / sum_weight;
+        n_left -= quota[ii];
+    }
+    for (ii = 0; n_left > 0; n_left--, ii = (ii + 1) % vec_len(nhs))
+    {
+        quota[ii]++;
+    }
+
+    for (ii = 0; ii < n_buckets; ii++)
+    {
+        if (dpo_id_is_valid(&buckets[ii]))
+        {
+            vec_foreach_index (jj, nhs)
+            {
+                if (quota[jj] &&
+                    0 == dpo_cmp(&buckets[ii], &nhs[jj].path_dpo))
+                    break;
+            }
+            if (jj < vec_len(nhs))
+            {
+                quota[jj]--;
+                continue;
+            }
+        }
+        vec_add1(free_buckets, ii);
+    }
+
+    jj = 0;
+    vec_foreach (bucket, free_buckets)
+    {
+        while (0 == quota[jj])
+        {
+            jj = (jj + 1) % vec_len(nhs);
+        }
+        load_balance_set_bucket_i(lb, *bucket, buckets, &nhs[jj].path_dpo);
+        quota[jj]--;
+        jj = (jj + 1) % vec_len(nhs);
+    }
+
+    vec_free(free_buckets);
+    vec_free(quota);
+}
+
 static void
 load_balance_fill_buckets (load_balance_t *lb,
                            load_balance_path_t *nhs,
@@ -607,7 +675,11 @@ load_balance_fill_buckets (load_balance_t *lb,
                            u32 n_buckets,
                            load_balance_flags_t flags)
 {
-    if (flags & LOAD_BALANCE_FLAG_STICKY)
+    if (flags & LOAD_BALANCE_FLAG_RESILIENT)
+    {
+        load_balance_fill_buckets_resilient(lb, nhs, buckets, n_buckets);
+    }
+    else if (flags & LOAD_BALANCE_FLAG_STICKY)
     {
         load_balance_fill_buckets_sticky(lb, nhs, buckets, n_buckets);
     }
@@ -625,6 +697,29 @@ load_balance_set_n_buckets (load_balance_t *lb,
     lb->lb_n_buckets_minus_1 = n_buckets-1;
 }
 
+static void
+load_balance_buckets_free (void *data)
+{
+    dpo_id_t *buckets = *(dpo_id_t **) data, *tmp_dpo;
+
+    vec_foreach(tmp_dpo, buckets)
+    {
+        dpo_reset(tmp_dpo);
+    }
+    vec_free(buckets);
+}
+
+/**
+ * A replaced bucket array may still be in use by the workers, so it, and
+ * the locks it holds on the choices, are released after a grace period.
+ */
+static void
+load_balance_buckets_retire (dpo_id_t *buckets)
+{
+    vlib_epoch_call_after_grace(load_balance_buckets_free,
+                                &buckets, sizeof(buckets));
+}
+
 void
 load_balance_multipath_update (const dpo_id_t *dpo,
                                const load_balance_path_t * raw_nhs,
@@ -634,7 +729,6 @@ load_balance_multipath_update (const dpo_id_t *dpo,
     u32 sum_of_weights, n_buckets, ii;
     index_t lbmi, old_lbmi;
     load_balance_t *lb;
-    dpo_id_t *tmp_dpo;
 
     nhs = NULL;
 
@@ -652,6 +746,15 @@ load_balance_multipath_update (const dpo_id_t *dpo,
 
     ASSERT (n_buckets >= vec_len (raw_nhs));
 
+    if (flags & LOAD_BALANCE_FLAG_RESILIENT)
+    {
+        /*
+         * a map is of no use, the buckets are not contiguous per-path
+         */
+        ASSERT(!(flags & LOAD_BALANCE_FLAG_USES_MAP));
+        n_buckets = clib_max(n_buckets, LB_RESILIENT_N_BUCKETS);
+    }
+
     /*
      * Save the old load-balance map used, and get a new one if required.
      */
@@ -757,7 +860,7 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                      * we are not crossing the threshold. We need a new bucket array to
                      * hold the increased number of choices.
                      */
-                    dpo_id_t *new_buckets, *old_buckets, *tmp_dpo;
+                    dpo_id_t *new_buckets, *old_buckets;
 
                     new_buckets = NULL;
                     old_buckets = load_balance_get_buckets(lb);
@@ -773,11 +876,7 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                     CLIB_MEMORY_BARRIER();
                     load_balance_set_n_buckets(lb, n_buckets);
 
-                    vec_foreach(tmp_dpo, old_buckets)
-                    {
-                        dpo_reset(tmp_dpo);
-                    }
-                    vec_free(old_buckets);
+                    load_balance_buckets_retire(old_buckets);
                 }
             }
 
@@ -816,11 +915,8 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                 load_balance_set_n_buckets(lb, n_buckets);
                 CLIB_MEMORY_BARRIER();
 
-                vec_foreach(tmp_dpo, lb->lb_buckets)
-                {
-                    dpo_reset(tmp_dpo);
-                }
-                vec_free(lb->lb_buckets);
+                load_balance_buckets_retire(lb->lb_buckets);
+                lb->lb_buckets = NULL;
             }
             else
             {
@@ -858,6 +954,11 @@ load_balance_multipath_update (const dpo_id_t *dpo,
     vec_free(fixed_nhs);
 
     load_balance_map_unlock(old_lbmi);
+
+    /*
+     * flows cached against the old buckets are now stale
+     */
+    ip_flow_cache_invalidate();
 }
 
 static void
@@ -82,22 +82,34 @@ typedef struct load_balance_path_t_ {
 typedef enum load_balance_attr_t_ {
     LOAD_BALANCE_ATTR_USES_MAP = 0,
     LOAD_BALANCE_ATTR_STICKY = 1,
+    LOAD_BALANCE_ATTR_RESILIENT = 2,
 } load_balance_attr_t;
 
 #define LOAD_BALANCE_ATTR_NAMES  {                  \
     [LOAD_BALANCE_ATTR_USES_MAP] = "uses-map",      \
     [LOAD_BALANCE_ATTR_STICKY] = "sticky",          \
+    [LOAD_BALANCE_ATTR_RESILIENT] = "resilient",    \
 }
 
 #define FOR_EACH_LOAD_BALANCE_ATTR(_attr)                       \
-    for (_attr = 0; _attr <= LOAD_BALANCE_ATTR_STICKY; _attr++)
+    for (_attr = 0; _attr <= LOAD_BALANCE_ATTR_RESILIENT; _attr++)
 
 typedef enum load_balance_flags_t_ {
     LOAD_BALANCE_FLAG_NONE = 0,
     LOAD_BALANCE_FLAG_USES_MAP = (1 << 0),
     LOAD_BALANCE_FLAG_STICKY = (1 << 1),
+    LOAD_BALANCE_FLAG_RESILIENT = (1 << 2),
 } __attribute__((packed)) load_balance_flags_t;
 
+/**
+ * The number of buckets in a resilient load-balance.
+ * The table is large and its size does not depend on the paths, so a
+ * change in the paths moves only the buckets that must move, i.e. those
+ * of a removed path or the share given to a new one, and the flows
+ * hashed to all other buckets keep their path.
+ */
+#define LB_RESILIENT_N_BUCKETS 512
+
 /**
  * The FIB DPO provieds;
  *  - load-balancing over the next DPOs in the chain/graph
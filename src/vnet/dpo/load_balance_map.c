@@ -19,6 +19,7 @@
 #include <vnet/fib/fib_node_list.h>
 #include <vnet/dpo/load_balance_map.h>
 #include <vnet/dpo/load_balance.h>
+#include <vnet/ip/ip_flow_cache.h>
 
 /**
  * A hash-table of load-balance maps by path index.
@@ -387,12 +388,8 @@ load_balance_map_alloc (const load_balance_path_t *paths)
 {
     load_balance_map_t *lbm;
     u32 ii;
-    vlib_main_t *vm;
-    u8 did_barrier_sync;
 
-    dpo_pool_barrier_sync (vm, load_balance_map_pool, did_barrier_sync);
-    pool_get_aligned(load_balance_map_pool, lbm, CLIB_CACHE_LINE_BYTES);
-    dpo_pool_barrier_release (vm, did_barrier_sync);
+    dpo_pool_get(load_balance_map_pool, lbm);
 
     clib_memset(lbm, 0, sizeof(*lbm));
 
@@ -523,6 +520,11 @@ load_balance_map_path_state_change (fib_node_index_t path_index)
         return;
 
     fib_node_list_walk(p[0], load_balance_map_path_state_change_walk, NULL);
+
+    /*
+     * the cached flows may use the buckets of the down path
+     */
+    ip_flow_cache_invalidate();
 }
 
 /**
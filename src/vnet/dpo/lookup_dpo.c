@@ -63,12 +63,8 @@ static lookup_dpo_t *
 lookup_dpo_alloc (void)
 {
     lookup_dpo_t *lkd;
-    vlib_main_t *vm;
-    u8 did_barrier_sync;
 
-    dpo_pool_barrier_sync (vm, lookup_dpo_pool, did_barrier_sync);
-    pool_get_aligned(lookup_dpo_pool, lkd, CLIB_CACHE_LINE_BYTES);
-    dpo_pool_barrier_release (vm, did_barrier_sync);
+    dpo_pool_get(lookup_dpo_pool, lkd);
 
     return (lkd);
 }
@@ -273,16 +269,7 @@ ip4_src_fib_lookup_one (u32 src_fib_index0,
                         const ip4_address_t * addr0,
                         u32 * src_adj_index0)
 {
-    ip4_fib_mtrie_leaf_t leaf0;
-    ip4_fib_mtrie_t * mtrie0;
-
-    mtrie0 = &ip4_fib_get (src_fib_index0)->mtrie;
-
-    leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, addr0);
-    leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, addr0, 2);
-    leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, addr0, 3);
-
-    src_adj_index0[0] = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
+    src_adj_index0[0] = ip4_fib_forwarding_lookup (src_fib_index0, addr0);
 }
 
 always_inline void
@@ -293,23 +280,9 @@ ip4_src_fib_lookup_two (u32 src_fib_index0,
                         u32 * src_adj_index0,
                         u32 * src_adj_index1)
 {
-    ip4_fib_mtrie_leaf_t leaf0, leaf1;
-    ip4_fib_mtrie_t * mtrie0, * mtrie1;
-
-    mtrie0 = &ip4_fib_get (src_fib_index0)->mtrie;
-    mtrie1 = &ip4_fib_get (src_fib_index1)->mtrie;
-
-    leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, addr0);
-    leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, addr1);
-
-    leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, addr0, 2);
-    leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, addr1, 2);
-
-    leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, addr0, 3);
-    leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, addr1, 3);
-
-    src_adj_index0[0] = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
-    src_adj_index1[0] = ip4_fib_mtrie_leaf_get_adj_index (leaf1);
+    ip4_fib_forwarding_lookup_x2 (src_fib_index0, src_fib_index1,
+                                  addr0, addr1,
+                                  src_adj_index0, src_adj_index1);
 }
 
 /**
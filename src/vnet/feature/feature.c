@@ -375,6 +375,36 @@ vnet_feature_is_enabled (const char *arc_name, const char *feature_node_name,
   return 0;
 }
 
+u32 *
+vnet_feature_get_enabled_nodes (u8 arc_index, u32 sw_if_index)
+{
+  vnet_feature_main_t *fm = &feature_main;
+  vnet_feature_config_main_t *cm;
+  vnet_config_main_t *ccm;
+  vnet_config_t *current_config;
+  vnet_config_feature_t *f;
+  u32 *nodes = NULL;
+  u32 ci, *p;
+
+  cm = &fm->feature_config_mains[arc_index];
+
+  if (sw_if_index >= vec_len (cm->config_index_by_sw_if_index))
+    return (NULL);
+
+  ci = vec_elt (cm->config_index_by_sw_if_index, sw_if_index);
+
+  if (ci == ~0)
+    return (NULL);
+
+  ccm = &cm->config_main;
+  p = heap_elt_at_index (ccm->config_string_heap, ci);
+  current_config = pool_elt_at_index (ccm->config_pool, p[-1]);
+
+  vec_foreach (f, current_config->features)
+    vec_add1 (nodes, f->node_index);
+
+  return (nodes);
+}
 
 u32
 vnet_feature_modify_end_node (u8 arc_index,
@@ -492,6 +492,12 @@ int
 vnet_feature_is_enabled (const char *arc_name, const char *feature_node_name,
 			 u32 sw_if_index);
 
+/**
+ * @brief The graph nodes of the features enabled on an interface, in the
+ * order in which they run. The caller frees the vector.
+ */
+u32 *vnet_feature_get_enabled_nodes (u8 arc_index, u32 sw_if_index);
+
 #endif /* included_feature_h */
 
 /*
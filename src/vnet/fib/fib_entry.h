@@ -83,10 +83,15 @@ typedef enum fib_entry_attribute_t_ {
      * provided by the best source, or failing that, by the cover.
      */
     FIB_ENTRY_ATTRIBUTE_INTERPOSE,
+    /**
+     * Resilient hashing. The entry's load-balance has a large fixed number
+     * of buckets and a change in the paths moves as few flows as it can.
+     */
+    FIB_ENTRY_ATTRIBUTE_RESILIENT,
     /**
      * Marker. add new entries before this one.
      */
-    FIB_ENTRY_ATTRIBUTE_LAST = FIB_ENTRY_ATTRIBUTE_INTERPOSE,
+    FIB_ENTRY_ATTRIBUTE_LAST = FIB_ENTRY_ATTRIBUTE_RESILIENT,
 } fib_entry_attribute_t;
 
 #define FIB_ENTRY_ATTRIBUTES {		       		\
@@ -101,6 +106,7 @@ typedef enum fib_entry_attribute_t_ {
     [FIB_ENTRY_ATTRIBUTE_NO_ATTACHED_EXPORT] = "no-attached-export",	\
     [FIB_ENTRY_ATTRIBUTE_COVERED_INHERIT] = "covered-inherit",  \
     [FIB_ENTRY_ATTRIBUTE_INTERPOSE] = "interpose",  \
+    [FIB_ENTRY_ATTRIBUTE_RESILIENT] = "resilient",  \
 }
 
 #define FOR_EACH_FIB_ATTRIBUTE(_item)			\
@@ -121,6 +127,7 @@ typedef enum fib_entry_flag_t_ {
     FIB_ENTRY_FLAG_MULTICAST = (1 << FIB_ENTRY_ATTRIBUTE_MULTICAST),
     FIB_ENTRY_FLAG_COVERED_INHERIT = (1 << FIB_ENTRY_ATTRIBUTE_COVERED_INHERIT),
     FIB_ENTRY_FLAG_INTERPOSE = (1 << FIB_ENTRY_ATTRIBUTE_INTERPOSE),
+    FIB_ENTRY_FLAG_RESILIENT = (1 << FIB_ENTRY_ATTRIBUTE_RESILIENT),
 } __attribute__((packed)) fib_entry_flag_t;
 
 extern u8 * format_fib_entry_flags(u8 *s, va_list *args);
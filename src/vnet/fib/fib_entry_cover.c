@@ -14,6 +14,7 @@
  */
 
 #include <vnet/fib/fib_entry_cover.h>
+#include <vnet/fib/fib_table.h>
 #include <vnet/fib/fib_entry_src.h>
 #include <vnet/fib/fib_node_list.h>
 #include <vnet/fib/fib_entry_delegate.h>
@@ -159,6 +160,39 @@ fib_entry_cover_change_notify (fib_node_index_t cover_index,
 			 uword_to_pointer(covered, void*));
 }
 
+static walk_rc_t
+fib_entry_cover_changes_one (fib_entry_t *cover,
+			     fib_node_index_t covered,
+			     void *args)
+{
+    fib_node_index_t new_cover;
+
+    /*
+     * the covered entry's cover is now its longest match less specific,
+     * if that is no longer 'cover'.
+     */
+    new_cover = fib_table_get_less_specific(fib_entry_get_fib_index(covered),
+                                            fib_entry_get_prefix(covered));
+
+    if (new_cover != fib_entry_get_index(cover))
+    {
+	fib_entry_cover_changed(covered);
+    }
+    return (WALK_CONTINUE);
+}
+
+void
+fib_entry_cover_changes_notify (fib_node_index_t cover_index)
+{
+    fib_entry_t *cover;
+
+    cover = fib_entry_get(cover_index);
+
+    fib_entry_cover_walk(cover,
+			 fib_entry_cover_changes_one,
+			 NULL);
+}
+
 static walk_rc_t
 fib_entry_cover_update_one (fib_entry_t *cover,
 			    fib_node_index_t covered,
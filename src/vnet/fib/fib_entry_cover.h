@@ -37,6 +37,12 @@ extern void fib_entry_cover_walk(fib_entry_t *cover,
 
 extern void fib_entry_cover_change_notify(fib_node_index_t cover_index,
 					  fib_node_index_t covered_index);
+/**
+ * Inform the entries covered by the cover of any number of more
+ * specifics inserted beneath it, i.e. those whose cover is now one
+ * of the more specifics.
+ */
+extern void fib_entry_cover_changes_notify(fib_node_index_t cover_index);
 extern void fib_entry_cover_update_notify(fib_entry_t *cover);
 
 #endif
@@ -261,12 +261,17 @@ typedef struct fib_entry_src_collect_forwarding_ctx_t_
 
 /**
  * @brief Determine whether this FIB entry should use a load-balance MAP
- * to support PIC edge fast convergence
+ * to support PIC edge fast convergence, or resilient hashing which
+ * needs no MAP.
  */
 static load_balance_flags_t
 fib_entry_calc_lb_flags (fib_entry_src_collect_forwarding_ctx_t *ctx,
                          const fib_entry_src_t *esrc)
 {
+    if (esrc->fes_entry_flags & FIB_ENTRY_FLAG_RESILIENT)
+    {
+        return (LOAD_BALANCE_FLAG_RESILIENT);
+    }
     /**
      * We'll use a LB map if the path-list has multiple recursive paths.
      * recursive paths implies BGP, and hence scale.
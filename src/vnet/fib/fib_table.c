@@ -169,6 +169,29 @@ fib_table_entry_remove (fib_table_t *fib_table,
     fib_entry_unlock(fib_entry_index);
 }
 
+/**
+ * The depth of the nested batches of table updates and, while in a batch,
+ * the covers that have had more specifics inserted beneath them.
+ */
+static u32 fib_table_batch_depth;
+static fib_node_index_t *fib_table_batch_covers;
+static uword *fib_table_batch_cover_db;
+
+static void
+fib_table_batch_cover_add (fib_node_index_t fib_entry_cover_index)
+{
+    if (NULL != hash_get(fib_table_batch_cover_db, fib_entry_cover_index))
+        return;
+
+    /*
+     * keep the cover until the end of the batch, it may be deleted
+     * by a later update
+     */
+    fib_entry_lock(fib_entry_cover_index);
+    hash_set(fib_table_batch_cover_db, fib_entry_cover_index, 1);
+    vec_add1(fib_table_batch_covers, fib_entry_cover_index);
+}
+
 static void
 fib_table_post_insert_actions (fib_table_t *fib_table,
 			       const fib_prefix_t *prefix,
@@ -208,8 +231,15 @@ fib_table_post_insert_actions (fib_table_t *fib_table,
          */
         if (!fib_entry_is_host(fib_entry_index))
         {
-            fib_entry_cover_change_notify(fib_entry_cover_index,
-                                          fib_entry_index);
+            /*
+             * in a batch the cover's covered entries are walked once, for
+             * all the entries inserted beneath it, when the batch ends.
+             */
+            if (fib_table_batch_depth)
+                fib_table_batch_cover_add(fib_entry_cover_index);
+            else
+                fib_entry_cover_change_notify(fib_entry_cover_index,
+                                              fib_entry_index);
         }
     }
 }
@@ -810,6 +840,93 @@ fib_table_entry_update (u32 fib_index,
     return (fib_entry_index);
 }
 
+void
+fib_table_batch_begin (u32 fib_index,
+                       fib_protocol_t proto)
+{
+    fib_table_batch_depth++;
+
+    switch (proto)
+    {
+    case FIB_PROTOCOL_IP4:
+        ip4_fib_table_batch_begin(ip4_fib_get(fib_index));
+        break;
+    case FIB_PROTOCOL_IP6:
+    case FIB_PROTOCOL_MPLS:
+        break;
+    }
+}
+
+void
+fib_table_batch_end (u32 fib_index,
+                     fib_protocol_t proto)
+{
+    fib_node_index_t *covers, *cover;
+
+    ASSERT(fib_table_batch_depth);
+
+    switch (proto)
+    {
+    case FIB_PROTOCOL_IP4:
+        ip4_fib_table_batch_end(ip4_fib_get(fib_index));
+        break;
+    case FIB_PROTOCOL_IP6:
+    case FIB_PROTOCOL_MPLS:
+        break;
+    }
+
+    if (--fib_table_batch_depth)
+        return;
+
+    /*
+     * the walks may themselves insert entries, which are now not deferred
+     */
+    covers = fib_table_batch_covers;
+    fib_table_batch_covers = NULL;
+    hash_free(fib_table_batch_cover_db);
+
+    vec_foreach(cover, covers)
+    {
+        fib_entry_cover_changes_notify(*cover);
+        fib_entry_unlock(*cover);
+    }
+    vec_free(covers);
+}
+
+void
+fib_table_entry_update_batch (u32 fib_index,
+                              fib_source_t source,
+                              fib_table_batch_entry_t *entries)
+{
+    fib_table_batch_entry_t *entry;
+    fib_protocol_t proto;
+
+    if (0 == vec_len(entries))
+        return;
+
+    proto = entries[0].fbe_prefix.fp_proto;
+
+    fib_table_batch_begin(fib_index, proto);
+
+    vec_foreach(entry, entries)
+    {
+        ASSERT(proto == entry->fbe_prefix.fp_proto);
+
+        if (vec_len(entry->fbe_paths))
+            fib_table_entry_update(fib_index,
+                                   &entry->fbe_prefix,
+                                   source,
+                                   entry->fbe_flags,
+                                   entry->fbe_paths);
+        else
+            fib_table_entry_delete(fib_index,
+                                   &entry->fbe_prefix,
+                                   source);
+    }
+
+    fib_table_batch_end(fib_index, proto);
+}
+
 fib_node_index_t
 fib_table_entry_update_one_path (u32 fib_index,
 				 const fib_prefix_t *prefix,
@@ -476,6 +476,82 @@ extern fib_node_index_t fib_table_entry_update(u32 fib_index,
 					       fib_entry_flag_t flags,
 					       fib_route_path_t *paths);
 
+/**
+ * @brief
+ *  Begin a batch of updates to a table.
+ *  Within a batch the work each update does for the entries it affects,
+ *  but that it does not change itself, is deferred until the batch ends,
+ *  when it is done once for all the batch's updates. That is; informing
+ *  the entries tracking a cover that a more specific has been inserted
+ *  beneath it, and rebuilding the parts of the forwarding structures
+ *  that are rebuilt rather than updated in place.
+ *  Batches can nest, the deferred work is done when the outermost ends.
+ *
+ * @param fib_index
+ *  The index of the FIB
+ *
+ * @paran proto
+ *  The protocol of the entries in the table
+ */
+extern void fib_table_batch_begin(u32 fib_index,
+                                  fib_protocol_t proto);
+
+/**
+ * @brief
+ *  End a batch of updates to a table.
+ *
+ * @param fib_index
+ *  The index of the FIB
+ *
+ * @paran proto
+ *  The protocol of the entries in the table
+ */
+extern void fib_table_batch_end(u32 fib_index,
+                                fib_protocol_t proto);
+
+/**
+ * @brief
+ *  One update of a batch
+ */
+typedef struct fib_table_batch_entry_t_
+{
+    /**
+     * The prefix of the entry
+     */
+    fib_prefix_t fbe_prefix;
+
+    /**
+     * Flags for the entry
+     */
+    fib_entry_flag_t fbe_flags;
+
+    /**
+     * The entry's new set of paths. No paths remove the source from
+     * the entry.
+     */
+    fib_route_path_t *fbe_paths;
+} fib_table_batch_entry_t;
+
+/**
+ * @brief
+ *  Update, or delete, many entries in the table from the same source.
+ *  Each entry with paths is updated as by fib_table_entry_update(), each
+ *  without is deleted as by fib_table_entry_delete(). The entries are
+ *  processed in order, in one batch.
+ *
+ * @param fib_index
+ *  The index of the FIB
+ *
+ * @param source
+ *  The ID of the client/source adding the entry.
+ *
+ * @param entries
+ *  A vector of updates. The paths are not const since they may be modified.
+ */
+extern void fib_table_entry_update_batch(u32 fib_index,
+                                         fib_source_t source,
+                                         fib_table_batch_entry_t *entries);
+
 /**
  * @brief
  *  Update the entry to have just one path. If the entry does not
@@ -16,6 +16,7 @@
 #include <vnet/fib/fib_table.h>
 #include <vnet/fib/fib_entry.h>
 #include <vnet/fib/ip4_fib.h>
+#include <vnet/ip/ip_flow_cache.h>
 
 /*
  * A table of prefixes to be added to tables and the sources for them
@@ -99,6 +100,10 @@ static const ip4_fib_table_special_prefix_t ip4_specials[] = {
     }
 };
 
+/**
+ * Whether new tables use the poptrie rather than the mtrie
+ */
+static int ip4_fib_poptrie_default;
 
 static u32
 ip4_create_fib_with_table_id (u32 table_id,
@@ -130,6 +135,9 @@ ip4_create_fib_with_table_id (u32 table_id,
     fib_table_lock(fib_table->ft_index, FIB_PROTOCOL_IP4, src);
 
     ip4_mtrie_init(&v4_fib->mtrie);
+    v4_fib->poptrie = (ip4_fib_poptrie_default ?
+                       ip4_poptrie_create() :
+                       NULL);
 
     /*
      * add the special entries into the new FIB
@@ -196,6 +204,11 @@ ip4_fib_table_destroy (u32 fib_index)
 
     vec_free(fib_table->ft_src_route_counts);
     ip4_mtrie_free(&v4_fib->mtrie);
+    if (NULL != v4_fib->poptrie)
+    {
+        ip4_poptrie_free(v4_fib->poptrie);
+        v4_fib->poptrie = NULL;
+    }
 
     pool_put(ip4_main.v4_fibs, v4_fib);
     pool_put(ip4_main.fibs, fib_table);
@@ -377,7 +390,12 @@ ip4_fib_table_fwding_dpo_update (ip4_fib_t *fib,
 				 u32 len,
 				 const dpo_id_t *dpo)
 {
-    ip4_fib_mtrie_route_add(&fib->mtrie, addr, len, dpo->dpoi_index);
+    if (NULL != fib->poptrie)
+        ip4_poptrie_route_add(fib->poptrie, addr, len, dpo->dpoi_index);
+    else
+        ip4_fib_mtrie_route_add(&fib->mtrie, addr, len, dpo->dpoi_index);
+
+    ip_flow_cache_invalidate();
 }
 
 void
@@ -398,10 +416,117 @@ ip4_fib_table_fwding_dpo_remove (ip4_fib_t *fib,
     cover_prefix = fib_entry_get_prefix(cover_index);
     cover_dpo = fib_entry_contribute_ip_forwarding(cover_index);
 
-    ip4_fib_mtrie_route_del(&fib->mtrie,
-                            addr, len, dpo->dpoi_index,
-                            cover_prefix->fp_len,
-                            cover_dpo->dpoi_index);
+    if (NULL != fib->poptrie)
+        ip4_poptrie_route_del(fib->poptrie,
+                              addr, len, dpo->dpoi_index,
+                              cover_prefix->fp_len,
+                              cover_dpo->dpoi_index);
+    else
+        ip4_fib_mtrie_route_del(&fib->mtrie,
+                                addr, len, dpo->dpoi_index,
+                                cover_prefix->fp_len,
+                                cover_dpo->dpoi_index);
+
+    ip_flow_cache_invalidate();
+}
+
+void
+ip4_fib_table_batch_begin (ip4_fib_t *fib)
+{
+    /*
+     * the mtrie is updated in place, there's nothing to defer
+     */
+    if (NULL != fib->poptrie)
+        ip4_poptrie_batch_begin(fib->poptrie);
+}
+
+void
+ip4_fib_table_batch_end (ip4_fib_t *fib)
+{
+    if (NULL != fib->poptrie)
+        ip4_poptrie_batch_end(fib->poptrie);
+
+    /*
+     * the deferred updates are now visible to the data-plane
+     */
+    ip_flow_cache_invalidate();
+}
+
+static fib_table_walk_rc_t
+ip4_fib_table_poptrie_add (fib_node_index_t fei,
+                           void *arg)
+{
+    const fib_prefix_t *pfx;
+    const dpo_id_t *dpo;
+
+    /*
+     * only the entries that are installed in the forwarding trie
+     * have a load-balance
+     */
+    dpo = fib_entry_contribute_ip_forwarding(fei);
+    if (DPO_LOAD_BALANCE != dpo->dpoi_type)
+        return (FIB_TABLE_WALK_CONTINUE);
+
+    pfx = fib_entry_get_prefix(fei);
+    ip4_poptrie_route_add(arg, &pfx->fp_addr.ip4, pfx->fp_len,
+                          dpo->dpoi_index);
+
+    return (FIB_TABLE_WALK_CONTINUE);
+}
+
+static fib_table_walk_rc_t
+ip4_fib_table_mtrie_add (fib_node_index_t fei,
+                         void *arg)
+{
+    const fib_prefix_t *pfx;
+    const dpo_id_t *dpo;
+
+    dpo = fib_entry_contribute_ip_forwarding(fei);
+    if (DPO_LOAD_BALANCE != dpo->dpoi_type)
+        return (FIB_TABLE_WALK_CONTINUE);
+
+    pfx = fib_entry_get_prefix(fei);
+    ip4_fib_mtrie_route_add(arg, &pfx->fp_addr.ip4, pfx->fp_len,
+                            dpo->dpoi_index);
+
+    return (FIB_TABLE_WALK_CONTINUE);
+}
+
+void
+ip4_fib_table_set_poptrie (u32 fib_index,
+                           int enable)
+{
+    ip4_fib_t *fib = ip4_fib_get(fib_index);
+    ip4_poptrie_t *poptrie;
+
+    if (!enable == (NULL == fib->poptrie))
+        return;
+
+    /*
+     * populate the structure the data-plane is moving to while it still
+     * uses the other, switch, and once no worker can still be walking the
+     * old structure empty it.
+     */
+    if (enable)
+    {
+        poptrie = ip4_poptrie_create();
+        ip4_fib_table_walk(fib, ip4_fib_table_poptrie_add, poptrie);
+
+        clib_atomic_store_rel_n(&fib->poptrie, poptrie);
+        vlib_epoch_synchronize();
+
+        ip4_mtrie_flush(&fib->mtrie);
+    }
+    else
+    {
+        poptrie = fib->poptrie;
+        ip4_fib_table_walk(fib, ip4_fib_table_mtrie_add, &fib->mtrie);
+
+        clib_atomic_store_rel_n(&fib->poptrie, NULL);
+        vlib_epoch_synchronize();
+
+        ip4_poptrie_free(poptrie);
+    }
 }
 
 void
@@ -633,6 +758,8 @@ ip4_show_fib (vlib_main_t * vm,
 
 
             mtrie_size = ip4_fib_mtrie_memory_usage(&fib->mtrie);
+            if (NULL != fib->poptrie)
+                mtrie_size += ip4_poptrie_memory_usage(fib->poptrie);
             hash_size = 0;
 
 	    for (i = 0; i < ARRAY_LEN (fib->fib_entry_by_dst_address); i++)
@@ -655,14 +782,15 @@ ip4_show_fib (vlib_main_t * vm,
             continue;
         }
 
-	s = format(s, "%U, fib_index:%d, flow hash:[%U] epoch:%d flags:%U locks:[",
+	s = format(s, "%U, fib_index:%d, flow hash:[%U] epoch:%d flags:%U lookup:%s locks:[",
                    format_fib_table_name, fib->index,
                    FIB_PROTOCOL_IP4,
                    fib->index,
                    format_ip_flow_hash_config,
                    fib_table->ft_flow_hash_config,
                    fib_table->ft_epoch,
-                   format_fib_table_flags, fib_table->ft_flags);
+                   format_fib_table_flags, fib_table->ft_flags,
+                   (NULL != fib->poptrie ? "poptrie" : "mtrie"));
         vec_foreach_index(source, fib_table->ft_locks)
         {
             if (0 != fib_table->ft_locks[source])
@@ -679,7 +807,12 @@ ip4_show_fib (vlib_main_t * vm,
 	/* Show summary? */
 	if (mtrie)
         {
-	    vlib_cli_output (vm, "%U", format_ip4_fib_mtrie, &fib->mtrie, verbose);
+            if (NULL != fib->poptrie)
+                vlib_cli_output (vm, "%U", format_ip4_poptrie,
+                                 fib->poptrie, verbose);
+            else
+                vlib_cli_output (vm, "%U", format_ip4_fib_mtrie,
+                                 &fib->mtrie, verbose);
             continue;
         }
 	if (! verbose)
@@ -867,3 +1000,90 @@ VLIB_CLI_COMMAND (ip4_show_fib_command, static) = {
     .function = ip4_show_fib,
 };
 /* *INDENT-ON* */
+
+static clib_error_t *
+ip4_fib_set_lookup (vlib_main_t * vm,
+                    unformat_input_t * main_input,
+                    vlib_cli_command_t * cmd)
+{
+    unformat_input_t _line_input, *input = &_line_input;
+    clib_error_t *error = NULL;
+    u32 table_id = 0, fib_index;
+    int poptrie = -1;
+
+    if (!unformat_user (main_input, unformat_line_input, input))
+        return (clib_error_return (0, "specify mtrie or poptrie"));
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+        if (unformat (input, "table %d", &table_id))
+            ;
+        else if (unformat (input, "poptrie"))
+            poptrie = 1;
+        else if (unformat (input, "mtrie"))
+            poptrie = 0;
+        else
+        {
+            error = clib_error_return (0, "unknown input '%U'",
+                                       format_unformat_error, input);
+            goto done;
+        }
+    }
+
+    if (-1 == poptrie)
+    {
+        error = clib_error_return (0, "specify mtrie or poptrie");
+        goto done;
+    }
+
+    fib_index = ip4_fib_index_from_table_id(table_id);
+
+    if (~0 == fib_index)
+    {
+        error = clib_error_return (0, "no such table %d", table_id);
+        goto done;
+    }
+
+    ip4_fib_table_set_poptrie(fib_index, poptrie);
+
+done:
+    unformat_free (input);
+    return (error);
+}
+
+/*?
+ * This command selects the structure used to lookup addresses in an
+ * IPv4 FIB table. The mtrie (16-8-8 stride) is the default. The poptrie
+ * is a bitmap compressed trie that uses much less memory per /16 that
+ * holds more specific routes. The routes are moved from one structure to
+ * the other without interrupting forwarding.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip fib lookup table 7 poptrie}
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (ip4_fib_set_lookup_command, static) = {
+    .path = "set ip fib lookup",
+    .short_help = "set ip fib lookup [table <table-id>] <mtrie|poptrie>",
+    .function = ip4_fib_set_lookup,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+ip4_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "fib-lookup poptrie"))
+        ip4_fib_poptrie_default = 1;
+      else if (unformat (input, "fib-lookup mtrie"))
+        ip4_fib_poptrie_default = 0;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  return 0;
+}
+
+VLIB_EARLY_CONFIG_FUNCTION (ip4_config, "ip4");
@@ -35,12 +35,19 @@
 #include <vnet/fib/fib_entry.h>
 #include <vnet/fib/fib_table.h>
 #include <vnet/ip/ip4_mtrie.h>
+#include <vnet/ip/ip4_poptrie.h>
 
 typedef struct ip4_fib_t_
 {
   /** Required for pool_get_aligned */
   CLIB_CACHE_LINE_ALIGN_MARK(cacheline0);
 
+  /**
+   * Poptrie for fast lookups. When set it is used in place of the mtrie,
+   * which is then empty.
+   */
+  ip4_poptrie_t *poptrie;
+
   /**
    * Mtrie for fast lookups. Hash is used to maintain overlapping prefixes.
    * First member so it's in the first cacheline.
@@ -87,6 +94,13 @@ extern void ip4_fib_table_fwding_dpo_remove(ip4_fib_t *fib,
 extern u32 ip4_fib_table_lookup_lb (ip4_fib_t *fib,
 				    const ip4_address_t * dst);
 
+/**
+ * @brief Begin/end a batch of updates to the forwarding structures.
+ * See fib_table_batch_begin()
+ */
+extern void ip4_fib_table_batch_begin(ip4_fib_t *fib);
+extern void ip4_fib_table_batch_end(ip4_fib_t *fib);
+
 /**
  * @brief Walk all entries in a FIB table
  * N.B: This is NOT safe to deletes. If you need to delete walk the whole
@@ -156,14 +170,23 @@ u32 ip4_fib_index_from_table_id (u32 table_id)
 
 extern u32 ip4_fib_table_get_index_for_sw_if_index(u32 sw_if_index);
 
+/**
+ * @brief Enable/disable the poptrie as the lookup structure of the FIB.
+ * The routes are moved from one structure to the other.
+ */
+extern void ip4_fib_table_set_poptrie(u32 fib_index, int enable);
+
 always_inline index_t
-ip4_fib_forwarding_lookup (u32 fib_index,
-                           const ip4_address_t * addr)
+ip4_fib_table_forwarding_lookup (const ip4_fib_t * fib,
+                                 const ip4_address_t * addr)
 {
     ip4_fib_mtrie_leaf_t leaf;
-    ip4_fib_mtrie_t * mtrie;
+    const ip4_fib_mtrie_t * mtrie;
+
+    if (PREDICT_FALSE (NULL != fib->poptrie))
+        return (ip4_poptrie_lookup (fib->poptrie, addr));
 
-    mtrie = &ip4_fib_get(fib_index)->mtrie;
+    mtrie = &fib->mtrie;
 
     leaf = ip4_fib_mtrie_lookup_step_one (mtrie, addr);
     leaf = ip4_fib_mtrie_lookup_step (mtrie, leaf, addr, 2);
@@ -172,6 +195,13 @@ ip4_fib_forwarding_lookup (u32 fib_index,
     return (ip4_fib_mtrie_leaf_get_adj_index(leaf));
 }
 
+always_inline index_t
+ip4_fib_forwarding_lookup (u32 fib_index,
+                           const ip4_address_t * addr)
+{
+    return (ip4_fib_table_forwarding_lookup (ip4_fib_get(fib_index), addr));
+}
+
 static_always_inline void
 ip4_fib_forwarding_lookup_x2 (u32 fib_index0,
                               u32 fib_index1,
@@ -182,9 +212,20 @@ ip4_fib_forwarding_lookup_x2 (u32 fib_index0,
 {
     ip4_fib_mtrie_leaf_t leaf[2];
     ip4_fib_mtrie_t * mtrie[2];
+    ip4_fib_t * fib[2];
+
+    fib[0] = ip4_fib_get(fib_index0);
+    fib[1] = ip4_fib_get(fib_index1);
+
+    if (PREDICT_FALSE (NULL != fib[0]->poptrie || NULL != fib[1]->poptrie))
+    {
+        *lb0 = ip4_fib_table_forwarding_lookup (fib[0], addr0);
+        *lb1 = ip4_fib_table_forwarding_lookup (fib[1], addr1);
+        return;
+    }
 
-    mtrie[0] = &ip4_fib_get(fib_index0)->mtrie;
-    mtrie[1] = &ip4_fib_get(fib_index1)->mtrie;
+    mtrie[0] = &fib[0]->mtrie;
+    mtrie[1] = &fib[1]->mtrie;
 
     leaf[0] = ip4_fib_mtrie_lookup_step_one (mtrie[0], addr0);
     leaf[1] = ip4_fib_mtrie_lookup_step_one (mtrie[1], addr1);
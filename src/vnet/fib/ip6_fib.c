@@ -16,6 +16,7 @@
 #include <vnet/fib/ip6_fib.h>
 #include <vnet/fib/fib_table.h>
 #include <vnet/dpo/ip6_ll_dpo.h>
+#include <vnet/ip/ip_flow_cache.h>
 
 #include <vppinfra/bihash_24_8.h>
 #include <vppinfra/bihash_template.c>
@@ -26,6 +27,11 @@ ip6_fib_table_instance_t ip6_fib_table[IP6_FIB_NUM_TABLES];
 u32 ip6_fib_table_nbuckets;
 uword ip6_fib_table_size;
 
+/**
+ * Whether new tables use a tree bitmap for forwarding lookups
+ */
+static int ip6_fib_tree_bitmap_default;
+
 static void
 vnet_ip6_fib_init (u32 fib_index)
 {
@@ -92,6 +98,10 @@ create_fib_with_table_id (u32 table_id,
     fib_table->ft_flags = flags;
     fib_table->ft_desc = desc;
 
+    v6_fib->tree_bitmap = (ip6_fib_tree_bitmap_default ?
+                           ip6_tree_bitmap_create() :
+                           NULL);
+
     vnet_ip6_fib_init(fib_table->ft_index);
     fib_table_lock(fib_table->ft_index, FIB_PROTOCOL_IP6, src);
 
@@ -175,6 +185,7 @@ ip6_fib_table_destroy (u32 fib_index)
 	hash_unset (ip6_main.fib_index_by_table_id, fib_table->ft_table_id);
     }
     vec_free(fib_table->ft_src_route_counts);
+    ip6_fib_table_set_tree_bitmap(fib_table->ft_index, 0);
     pool_put_index(ip6_main.v6_fibs, fib_table->ft_index);
     pool_put(ip6_main.fibs, fib_table);
 }
@@ -371,6 +382,7 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
 {
     ip6_fib_table_instance_t *table;
     clib_bihash_kv_24_8_t kv;
+    ip6_tree_bitmap_t *tbm;
     ip6_address_t *mask;
     u64 fib;
 
@@ -385,6 +397,10 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
 
     clib_bihash_add_del_24_8(&table->ip6_hash, &kv, 1);
 
+    tbm = ip6_fib_get(fib_index)->tree_bitmap;
+    if (NULL != tbm)
+        ip6_tree_bitmap_route_add(tbm, addr, len, dpo->dpoi_index);
+
     if (0 == table->dst_address_length_refcounts[len]++)
     {
         table->non_empty_dst_address_length_bitmap =
@@ -392,6 +408,8 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
                              128 - len, 1);
         compute_prefix_lengths_in_search_order (table);
     }
+
+    ip_flow_cache_invalidate();
 }
 
 void
@@ -402,6 +420,7 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
 {
     ip6_fib_table_instance_t *table;
     clib_bihash_kv_24_8_t kv;
+    ip6_tree_bitmap_t *tbm;
     ip6_address_t *mask;
     u64 fib;
 
@@ -416,6 +435,10 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
 
     clib_bihash_add_del_24_8(&table->ip6_hash, &kv, 0);
 
+    tbm = ip6_fib_get(fib_index)->tree_bitmap;
+    if (NULL != tbm)
+        ip6_tree_bitmap_route_del(tbm, addr, len);
+
     /* refcount accounting */
     ASSERT (table->dst_address_length_refcounts[len] > 0);
     if (--table->dst_address_length_refcounts[len] == 0)
@@ -425,6 +448,67 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
                              128 - len, 0);
 	compute_prefix_lengths_in_search_order (table);
     }
+
+    ip_flow_cache_invalidate();
+}
+
+static int
+ip6_fib_tree_bitmap_add_cb (clib_bihash_kv_24_8_t * kvp,
+                            void *arg)
+{
+    ip6_fib_t *fib = arg;
+    ip6_address_t addr;
+
+    if ((kvp->key[2] >> 32) == fib->index)
+    {
+        addr.as_u64[0] = kvp->key[0];
+        addr.as_u64[1] = kvp->key[1];
+
+        ip6_tree_bitmap_route_add(fib->tree_bitmap, &addr,
+                                  kvp->key[2] & 0xffffffff,
+                                  kvp->value);
+    }
+    return (BIHASH_WALK_CONTINUE);
+}
+
+void
+ip6_fib_table_set_tree_bitmap (u32 fib_index,
+                               int enable)
+{
+    ip6_fib_t *fib = ip6_fib_get(fib_index);
+    ip6_tree_bitmap_t *tbm;
+
+    if (!enable == (NULL == fib->tree_bitmap))
+        return;
+
+    if (enable)
+    {
+        /*
+         * populate the tree from the forwarding hash, out of sight of
+         * the workers, then switch.
+         */
+        ip6_fib_t tmp = {
+            .index = fib_index,
+            .tree_bitmap = ip6_tree_bitmap_create(),
+        };
+
+        clib_bihash_foreach_key_value_pair_24_8(
+            &ip6_fib_table[IP6_FIB_TABLE_FWDING].ip6_hash,
+            ip6_fib_tree_bitmap_add_cb,
+            &tmp);
+
+        clib_atomic_store_rel_n(&fib->tree_bitmap, tmp.tree_bitmap);
+    }
+    else
+    {
+        /*
+         * the hash is always up to date, switch back to it and free the
+         * tree once no worker can still be walking it.
+         */
+        tbm = fib->tree_bitmap;
+        clib_atomic_store_rel_n(&fib->tree_bitmap, NULL);
+        ip6_tree_bitmap_free(tbm);
+    }
 }
 
 /**
@@ -600,10 +684,17 @@ u8 *
 format_ip6_fib_table_memory (u8 * s, va_list * args)
 {
     uword bytes_inuse;
+    ip6_fib_t *fib;
 
     bytes_inuse = (alloc_arena_next(&(ip6_fib_table[IP6_FIB_TABLE_NON_FWDING].ip6_hash)) +
                    alloc_arena_next(&(ip6_fib_table[IP6_FIB_TABLE_FWDING].ip6_hash)));
 
+    pool_foreach (fib, ip6_main.v6_fibs)
+    {
+        if (NULL != fib->tree_bitmap)
+            bytes_inuse += ip6_tree_bitmap_memory_usage(fib->tree_bitmap);
+    }
+
     s = format(s, "%=30s %=6d %=12ld\n",
                "IPv6 unicast",
                pool_elts(ip6_main.fibs),
@@ -693,6 +784,15 @@ ip6_show_fib (vlib_main_t * vm,
                          BV (format_bihash),
                          &ip6_fib_table[IP6_FIB_TABLE_FWDING].ip6_hash,
                          detail);
+        pool_foreach (fib, im6->v6_fibs)
+        {
+            if (NULL != fib->tree_bitmap)
+                vlib_cli_output (vm, "%U Tree Bitmap:\n  %U\n",
+                                 format_fib_table_name, fib->index,
+                                 FIB_PROTOCOL_IP6,
+                                 format_ip6_tree_bitmap,
+                                 fib->tree_bitmap, detail);
+        }
         return (NULL);
     }
 
@@ -709,14 +809,15 @@ ip6_show_fib (vlib_main_t * vm,
         if (fib_table->ft_flags & FIB_TABLE_FLAG_IP6_LL)
             continue;
 
-	s = format(s, "%U, fib_index:%d, flow hash:[%U] epoch:%d flags:%U locks:[",
+	s = format(s, "%U, fib_index:%d, flow hash:[%U] epoch:%d flags:%U lookup:%s locks:[",
                    format_fib_table_name, fib->index,
                    FIB_PROTOCOL_IP6,
                    fib->index,
                    format_ip_flow_hash_config,
                    fib_table->ft_flow_hash_config,
                    fib_table->ft_epoch,
-                   format_fib_table_flags, fib_table->ft_flags);
+                   format_fib_table_flags, fib_table->ft_flags,
+                   (NULL != fib->tree_bitmap ? "tree-bitmap" : "hash"));
 
         vec_foreach_index(source, fib_table->ft_locks)
         {
@@ -869,6 +970,75 @@ VLIB_CLI_COMMAND (ip6_show_fib_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+ip6_fib_set_lookup (vlib_main_t * vm,
+                    unformat_input_t * main_input,
+                    vlib_cli_command_t * cmd)
+{
+    unformat_input_t _line_input, *input = &_line_input;
+    clib_error_t *error = NULL;
+    u32 table_id = 0, fib_index;
+    int tree_bitmap = -1;
+
+    if (!unformat_user (main_input, unformat_line_input, input))
+        return (clib_error_return (0, "specify hash or tree-bitmap"));
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+        if (unformat (input, "table %d", &table_id))
+            ;
+        else if (unformat (input, "tree-bitmap"))
+            tree_bitmap = 1;
+        else if (unformat (input, "hash"))
+            tree_bitmap = 0;
+        else
+        {
+            error = clib_error_return (0, "unknown input '%U'",
+                                       format_unformat_error, input);
+            goto done;
+        }
+    }
+
+    if (-1 == tree_bitmap)
+    {
+        error = clib_error_return (0, "specify hash or tree-bitmap");
+        goto done;
+    }
+
+    fib_index = ip6_fib_index_from_table_id(table_id);
+
+    if (~0 == fib_index)
+    {
+        error = clib_error_return (0, "no such table %d", table_id);
+        goto done;
+    }
+
+    ip6_fib_table_set_tree_bitmap(fib_index, tree_bitmap);
+
+done:
+    unformat_free (input);
+    return (error);
+}
+
+/*?
+ * This command selects the structure used for forwarding lookups in an
+ * IPv6 FIB table. By default a hash table is probed once per prefix
+ * length present in any table, longest first. The tree bitmap is a
+ * multibit trie whose lookup cost is bounded by the address length,
+ * whatever the number of prefix lengths. The switch does not interrupt
+ * forwarding.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip6 fib lookup table 7 tree-bitmap}
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (ip6_fib_set_lookup_command, static) = {
+    .path = "set ip6 fib lookup",
+    .short_help = "set ip6 fib lookup [table <table-id>] <hash|tree-bitmap>",
+    .function = ip6_fib_set_lookup,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 ip6_config (vlib_main_t * vm, unformat_input_t * input)
 {
@@ -882,6 +1052,10 @@ ip6_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "heap-size %U",
 			 unformat_memory_size, &heapsize))
 	;
+      else if (unformat (input, "fib-lookup tree-bitmap"))
+        ip6_fib_tree_bitmap_default = 1;
+      else if (unformat (input, "fib-lookup hash"))
+        ip6_fib_tree_bitmap_default = 0;
       else
 	return clib_error_return (0, "unknown input '%U'",
 				  format_unformat_error, input);
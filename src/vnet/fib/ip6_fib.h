@@ -111,16 +111,26 @@ extern void ip6_fib_table_walk(u32 fib_index,
                                fib_table_walk_fn_t fn,
                                void *ctx);
 
+/**
+ * @brief Enable/disable the tree bitmap as the lookup structure of the FIB.
+ */
+extern void ip6_fib_table_set_tree_bitmap(u32 fib_index, int enable);
+
 always_inline u32
 ip6_fib_table_fwding_lookup (u32 fib_index,
                              const ip6_address_t * dst)
 {
     ip6_fib_table_instance_t *table;
     clib_bihash_kv_24_8_t kv, value;
+    const ip6_tree_bitmap_t *tbm;
     int i, len;
     int rv;
     u64 fib;
 
+    tbm = ip6_main.v6_fibs[fib_index].tree_bitmap;
+    if (PREDICT_FALSE (NULL != tbm))
+        return (ip6_tree_bitmap_lookup (tbm, dst));
+
     table = &ip6_fib_table[IP6_FIB_TABLE_FWDING];
     len = vec_len (table->prefix_lengths_in_search_order);
 
@@ -551,6 +551,9 @@ typedef struct
 
   /* mode */
   vnet_hw_if_rx_mode mode : 8;
+
+  /* thread set by the operator, never moved by the rebalancer */
+  u8 placement_pinned : 1;
 #define VNET_HW_IF_RXQ_THREAD_ANY      ~0
 #define VNET_HW_IF_RXQ_NO_RX_INTERRUPT ~0
 } vnet_hw_if_rx_queue_t;
@@ -0,0 +1,498 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/devices/devices.h>
+#include <vnet/interface/rx_queue_funcs.h>
+
+/*
+ * Load-aware rx queue rebalancer.
+ *
+ * Every interval, the rx packet rate of each queue is estimated from the
+ * per-thread interface rx counters (split evenly between the queues of
+ * one interface polled by the same thread) and smoothed. The per-worker
+ * load is the sum of its queue loads. If the busiest worker is actually
+ * busy (its average vector size is at least min-vector-rate) and its
+ * load exceeds the least loaded worker's by more than imbalance percent,
+ * the queue which best evens out the pair is moved. At most one queue
+ * moves per interval, and a queue which moved is left alone for
+ * hold-down intervals. Queues placed with "set interface rx-placement"
+ * are never moved.
+ */
+
+typedef struct
+{
+  /* smoothed rx packets per interval, by queue index */
+  f64 *load_by_queue;
+
+  /* interval before which the queue may not move again, by queue index */
+  u32 *hold_until_by_queue;
+
+  /* rx packet counter at the last sample, by thread and sw_if_index */
+  u64 **last_rx_packets;
+
+  /* node vectors and calls at the last sample, by thread */
+  u64 *last_vectors;
+  u64 *last_calls;
+
+  /* average vector size over the last interval, by thread */
+  f64 *vector_rate_by_thread;
+
+  /* sum of queue loads, by thread */
+  f64 *load_by_thread;
+
+  /* configuration */
+  u8 enabled;
+  f64 interval;
+  u32 imbalance_percent;
+  u32 min_vector_rate;
+  u32 hold_down;
+
+  /* stats */
+  u32 n_intervals;
+  u32 n_moves;
+} vnet_hw_if_rxq_rebalance_main_t;
+
+static vnet_hw_if_rxq_rebalance_main_t vnet_hw_if_rxq_rebalance_main;
+
+VLIB_REGISTER_LOG_CLASS (if_rxq_rebalance_log, static) = {
+  .class_name = "interface",
+  .subclass_name = "rx-rebalance",
+};
+
+#define log_info(fmt, ...)                                                    \
+  vlib_log_info (if_rxq_rebalance_log.class, fmt, __VA_ARGS__)
+
+typedef enum
+{
+  RXQ_REBALANCE_EVENT_CONFIG = 1,
+} rxq_rebalance_event_t;
+
+static void
+rxq_rebalance_reset (vnet_hw_if_rxq_rebalance_main_t *rm)
+{
+  u64 **v;
+
+  vec_foreach (v, rm->last_rx_packets)
+    vec_free (v[0]);
+  vec_free (rm->last_rx_packets);
+  vec_free (rm->last_vectors);
+  vec_free (rm->last_calls);
+  vec_free (rm->load_by_queue);
+  vec_free (rm->hold_until_by_queue);
+  vec_free (rm->vector_rate_by_thread);
+  vec_free (rm->load_by_thread);
+  rm->n_intervals = 0;
+}
+
+static void
+rxq_rebalance_sample_threads (vnet_hw_if_rxq_rebalance_main_t *rm)
+{
+  vnet_device_main_t *vdm = &vnet_device_main;
+  u32 n_threads = vec_len (vlib_mains);
+  u64 vectors, calls;
+  u32 ti;
+
+  vec_validate_init_empty (rm->last_vectors, n_threads - 1, ~0ULL);
+  vec_validate_init_empty (rm->last_calls, n_threads - 1, ~0ULL);
+  vec_validate (rm->vector_rate_by_thread, n_threads - 1);
+
+  for (ti = vdm->first_worker_thread_index;
+       ti <= vdm->last_worker_thread_index; ti++)
+    {
+      vlib_main_t *vm = vlib_mains[ti];
+
+      vectors = vm->internal_node_vectors;
+      calls = vm->internal_node_calls;
+
+      if (rm->last_calls[ti] != ~0ULL && calls > rm->last_calls[ti])
+	rm->vector_rate_by_thread[ti] =
+	  (f64) (vectors - rm->last_vectors[ti]) /
+	  (f64) (calls - rm->last_calls[ti]);
+      else
+	rm->vector_rate_by_thread[ti] = 0;
+
+      rm->last_vectors[ti] = vectors;
+      rm->last_calls[ti] = calls;
+    }
+}
+
+static void
+rxq_rebalance_sample_queues (vnet_hw_if_rxq_rebalance_main_t *rm)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_interface_main_t *im = &vnm->interface_main;
+  vlib_combined_counter_main_t *cm =
+    im->combined_sw_if_counters + VNET_INTERFACE_COUNTER_RX;
+  u32 n_threads = vec_len (vlib_mains);
+  u32 *n_queues_by_thread = 0;
+  vnet_hw_if_rx_queue_t *rxq;
+  vnet_hw_interface_t *hi;
+  u32 *qi;
+
+  vec_validate (rm->last_rx_packets, n_threads - 1);
+  vec_validate (n_queues_by_thread, n_threads - 1);
+  vec_validate (rm->load_by_thread, n_threads - 1);
+  vec_zero (rm->load_by_thread);
+
+  if (pool_elts (im->hw_if_rx_queues))
+    {
+      vec_validate (rm->load_by_queue, pool_len (im->hw_if_rx_queues) - 1);
+      vec_validate (rm->hold_until_by_queue,
+		    pool_len (im->hw_if_rx_queues) - 1);
+    }
+
+  pool_foreach (hi, im->hw_interfaces)
+    {
+      u32 sw_if_index = hi->sw_if_index;
+      u64 *last, packets, delta;
+
+      if (vec_len (hi->rx_queue_indices) == 0 ||
+	  sw_if_index >= vlib_combined_counter_n_counters (cm))
+	continue;
+
+      vec_zero (n_queues_by_thread);
+      vec_foreach (qi, hi->rx_queue_indices)
+	n_queues_by_thread[vnet_hw_if_get_rx_queue (vnm, qi[0])
+			     ->thread_index]++;
+
+      vec_foreach (qi, hi->rx_queue_indices)
+	{
+	  u32 ti;
+
+	  rxq = vnet_hw_if_get_rx_queue (vnm, qi[0]);
+	  ti = rxq->thread_index;
+
+	  vec_validate_init_empty (rm->last_rx_packets[ti], sw_if_index,
+				   ~0ULL);
+	  last = rm->last_rx_packets[ti] + sw_if_index;
+	  packets = cm->counters[ti][sw_if_index].packets;
+
+	  /* first sample, or counters were cleared */
+	  delta = (last[0] == ~0ULL || packets < last[0]) ? 0 :
+							    packets - last[0];
+
+	  rm->load_by_queue[qi[0]] =
+	    0.5 * rm->load_by_queue[qi[0]] +
+	    0.5 * (f64) delta / (f64) n_queues_by_thread[ti];
+	  rm->load_by_thread[ti] += rm->load_by_queue[qi[0]];
+	}
+
+      /* counters are per thread, update once all queues have seen them */
+      vec_foreach (qi, hi->rx_queue_indices)
+	{
+	  rxq = vnet_hw_if_get_rx_queue (vnm, qi[0]);
+	  rm->last_rx_packets[rxq->thread_index][sw_if_index] =
+	    cm->counters[rxq->thread_index][sw_if_index].packets;
+	}
+    }
+
+  vec_free (n_queues_by_thread);
+}
+
+static void
+rxq_rebalance_one (vnet_hw_if_rxq_rebalance_main_t *rm)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_interface_main_t *im = &vnm->interface_main;
+  vnet_device_main_t *vdm = &vnet_device_main;
+  vnet_hw_if_rx_queue_t *rxq;
+  vnet_hw_interface_t *hi;
+  u32 ti, hot = ~0, cold = ~0, best = ~0;
+  f64 diff, best_dist = 0;
+
+  for (ti = vdm->first_worker_thread_index;
+       ti <= vdm->last_worker_thread_index; ti++)
+    {
+      if (hot == ~0 || rm->load_by_thread[ti] > rm->load_by_thread[hot])
+	hot = ti;
+      if (cold == ~0 || rm->load_by_thread[ti] < rm->load_by_thread[cold])
+	cold = ti;
+    }
+
+  if (hot == cold || rm->load_by_thread[hot] == 0)
+    return;
+
+  if (rm->vector_rate_by_thread[hot] < rm->min_vector_rate)
+    return;
+
+  diff = rm->load_by_thread[hot] - rm->load_by_thread[cold];
+  if (diff * 100 <= rm->load_by_thread[hot] * rm->imbalance_percent)
+    return;
+
+  /*
+   * Moving a queue with load l leaves max (hot - l, cold + l), which is
+   * lowest for l = diff / 2 and only an improvement for l < diff.
+   */
+  pool_foreach (rxq, im->hw_if_rx_queues)
+    {
+      u32 qi = rxq - im->hw_if_rx_queues;
+      f64 l = rm->load_by_queue[qi], dist;
+
+      if (rxq->thread_index != hot || rxq->placement_pinned ||
+	  rm->hold_until_by_queue[qi] > rm->n_intervals || l <= 0 ||
+	  l >= diff)
+	continue;
+
+      dist = l > diff / 2 ? l - diff / 2 : diff / 2 - l;
+      if (best == ~0 || dist < best_dist)
+	{
+	  best = qi;
+	  best_dist = dist;
+	}
+    }
+
+  if (best == ~0)
+    return;
+
+  rxq = vnet_hw_if_get_rx_queue (vnm, best);
+  hi = vnet_get_hw_interface (vnm, rxq->hw_if_index);
+
+  log_info ("moving interface %v queue-id %u from thread %u to %u "
+	    "(load %.0f -> %.0f, queue load %.0f)",
+	    hi->name, rxq->queue_id, hot, cold, rm->load_by_thread[hot],
+	    rm->load_by_thread[cold], rm->load_by_queue[best]);
+
+  vnet_hw_if_set_rx_queue_thread_index (vnm, best, cold);
+  vnet_hw_if_update_runtime_data (vnm, rxq->hw_if_index);
+
+  rm->load_by_thread[hot] -= rm->load_by_queue[best];
+  rm->load_by_thread[cold] += rm->load_by_queue[best];
+  rm->hold_until_by_queue[best] = rm->n_intervals + rm->hold_down;
+  rm->n_moves++;
+}
+
+static uword
+rxq_rebalance_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
+		       vlib_frame_t *f)
+{
+  vnet_hw_if_rxq_rebalance_main_t *rm = &vnet_hw_if_rxq_rebalance_main;
+  uword event_type, *event_data = 0;
+
+  while (1)
+    {
+      if (rm->enabled)
+	vlib_process_wait_for_event_or_clock (vm, rm->interval);
+      else
+	vlib_process_wait_for_event (vm);
+
+      event_type = vlib_process_get_events (vm, &event_data);
+      vec_reset_length (event_data);
+
+      if (event_type == RXQ_REBALANCE_EVENT_CONFIG)
+	{
+	  /* start over from a fresh baseline */
+	  rxq_rebalance_reset (rm);
+	  continue;
+	}
+
+      if (!rm->enabled)
+	continue;
+
+      rxq_rebalance_sample_threads (rm);
+      rxq_rebalance_sample_queues (rm);
+
+      /* the first interval only establishes the counter baseline */
+      if (rm->n_intervals++ == 0)
+	continue;
+
+      rxq_rebalance_one (rm);
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (rxq_rebalance_process_node, static) = {
+  .function = rxq_rebalance_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "rx-queue-rebalance-process",
+};
+
+static clib_error_t *
+set_interface_rx_placement_rebalance (vlib_main_t *vm,
+				      unformat_input_t *input,
+				      vlib_cli_command_t *cmd)
+{
+  vnet_hw_if_rxq_rebalance_main_t *rm = &vnet_hw_if_rxq_rebalance_main;
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_device_main_t *vdm = &vnet_device_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_hw_if_rx_queue_t *rxq;
+  clib_error_t *error = 0;
+  int enable = -1, unpin = 0;
+  f64 interval = rm->interval;
+  u32 imbalance = rm->imbalance_percent;
+  u32 min_vector_rate = rm->min_vector_rate;
+  u32 hold_down = rm->hold_down;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "enable"))
+	enable = 1;
+      else if (unformat (line_input, "disable"))
+	enable = 0;
+      else if (unformat (line_input, "interval %f", &interval))
+	;
+      else if (unformat (line_input, "imbalance %u", &imbalance))
+	;
+      else if (unformat (line_input, "min-vector-rate %u", &min_vector_rate))
+	;
+      else if (unformat (line_input, "hold-down %u", &hold_down))
+	;
+      else if (unformat (line_input, "unpin"))
+	unpin = 1;
+      else
+	{
+	  error = clib_error_return (0, "parse error: '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (interval < 0.1)
+    {
+      error = clib_error_return (0, "interval must be at least 0.1 seconds");
+      goto done;
+    }
+
+  if (imbalance == 0 || imbalance > 100)
+    {
+      error = clib_error_return (0, "imbalance must be between 1 and 100");
+      goto done;
+    }
+
+  if (enable == 1 && vdm->first_worker_thread_index == 0)
+    {
+      error = clib_error_return (0, "rx queue rebalancing needs workers");
+      goto done;
+    }
+
+  if (unpin)
+    pool_foreach (rxq, vnm->interface_main.hw_if_rx_queues)
+      rxq->placement_pinned = 0;
+
+  rm->interval = interval;
+  rm->imbalance_percent = imbalance;
+  rm->min_vector_rate = min_vector_rate;
+  rm->hold_down = hold_down;
+  if (enable != -1)
+    rm->enabled = enable;
+
+  vlib_process_signal_event (vm, rxq_rebalance_process_node.index,
+			     RXQ_REBALANCE_EVENT_CONFIG, 0);
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Enable or disable automatic rx queue rebalancing, and tune it. Every
+ * '<em>interval</em>' seconds the busiest worker gives one queue to the
+ * least busy one, if it is busy (its average vector size is at least
+ * '<em>min-vector-rate</em>') and its rx packet rate exceeds the other
+ * worker's by more than '<em>imbalance</em>' percent. A queue which moved
+ * stays put for '<em>hold-down</em>' intervals. Queues placed with
+ * 'set interface rx-placement' are not moved until '<em>unpin</em>' is
+ * given.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface rx-placement rebalance enable interval 2}
+?*/
+VLIB_CLI_COMMAND (cmd_set_if_rx_placement_rebalance, static) = {
+  .path = "set interface rx-placement rebalance",
+  .short_help = "set interface rx-placement rebalance [enable|disable] "
+		"[interval <sec>] [imbalance <percent>] "
+		"[min-vector-rate <n>] [hold-down <intervals>] [unpin]",
+  .function = set_interface_rx_placement_rebalance,
+};
+
+static clib_error_t *
+show_interface_rx_placement_rebalance (vlib_main_t *vm,
+				       unformat_input_t *input,
+				       vlib_cli_command_t *cmd)
+{
+  vnet_hw_if_rxq_rebalance_main_t *rm = &vnet_hw_if_rxq_rebalance_main;
+  vnet_device_main_t *vdm = &vnet_device_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_hw_if_rx_queue_t *rxq;
+  u32 ti;
+
+  vlib_cli_output (vm,
+		   "rebalance %s, interval %.2fs, imbalance %u%%, "
+		   "min-vector-rate %u, hold-down %u",
+		   rm->enabled ? "enabled" : "disabled", rm->interval,
+		   rm->imbalance_percent, rm->min_vector_rate, rm->hold_down);
+  vlib_cli_output (vm, "%u intervals, %u queues moved", rm->n_intervals,
+		   rm->n_moves);
+
+  if (!rm->enabled || vdm->first_worker_thread_index == 0 ||
+      vec_len (rm->load_by_thread) <= vdm->last_worker_thread_index)
+    return 0;
+
+  vlib_cli_output (vm, "%-10s%16s%16s", "thread", "rx pkts/intvl",
+		   "vector rate");
+  for (ti = vdm->first_worker_thread_index;
+       ti <= vdm->last_worker_thread_index; ti++)
+    vlib_cli_output (vm, "%-10u%16.0f%16.2f", ti, rm->load_by_thread[ti],
+		     rm->vector_rate_by_thread[ti]);
+
+  vlib_cli_output (vm, "%-24s%-10s%-10s%16s", "interface", "queue",
+		   "thread", "rx pkts/intvl");
+  pool_foreach (rxq, vnm->interface_main.hw_if_rx_queues)
+    {
+      u32 qi = rxq - vnm->interface_main.hw_if_rx_queues;
+      vnet_hw_interface_t *hi = vnet_get_hw_interface (vnm, rxq->hw_if_index);
+
+      vlib_cli_output (vm, "%-24v%-10u%-10u%16.0f%s", hi->name, rxq->queue_id,
+		       rxq->thread_index,
+		       qi < vec_len (rm->load_by_queue) ? rm->load_by_queue[qi] :
+							  0,
+		       rxq->placement_pinned ? " (pinned)" : "");
+    }
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (cmd_show_if_rx_placement_rebalance, static) = {
+  .path = "show interface rx-placement rebalance",
+  .short_help = "show interface rx-placement rebalance",
+  .function = show_interface_rx_placement_rebalance,
+};
+
+static clib_error_t *
+rxq_rebalance_init (vlib_main_t *vm)
+{
+  vnet_hw_if_rxq_rebalance_main_t *rm = &vnet_hw_if_rxq_rebalance_main;
+
+  rm->interval = 1.0;
+  rm->imbalance_percent = 25;
+  rm->min_vector_rate = 32;
+  rm->hold_down = 5;
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (rxq_rebalance_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -1700,6 +1700,7 @@ set_hw_interface_rx_placement (u32 hw_if_index, u32 queue_id,
     return clib_error_return (0, "unknown queue %u on interface %s", queue_id,
 			      hw->name);
   vnet_hw_if_set_rx_queue_thread_index (vnm, queue_index, thread_index);
+  vnet_hw_if_get_rx_queue (vnm, queue_index)->placement_pinned = 1;
   vnet_hw_if_update_runtime_data (vnm, hw_if_index);
   return 0;
 }
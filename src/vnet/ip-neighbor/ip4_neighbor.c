@@ -59,6 +59,33 @@ ip4_neighbor_probe_dst (u32 sw_if_index, const ip4_address_t * dst)
 			vnet_get_main (), adj_get (ai), &src, dst);
 }
 
+/**
+ * Build, but do not send, an ARP request for dst. Returns the buffer
+ * index, or ~0, and the node to which it should be sent.
+ */
+u32
+ip4_neighbor_probe_dst_build (u32 sw_if_index,
+			      const ip4_address_t * dst, u32 * node_index)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  ip4_address_t src;
+  adj_index_t ai;
+  u32 bi;
+
+  ai = adj_glean_get (FIB_PROTOCOL_IP4, sw_if_index, NULL);
+
+  if (ADJ_INDEX_INVALID == ai || !fib_sas4_get (sw_if_index, dst, &src))
+    return (~0);
+
+  if (!ip4_neighbor_probe_build (vlib_get_main (), vnm, adj_get (ai),
+				 &src, dst, &bi))
+    return (~0);
+
+  *node_index = vnet_get_sup_hw_interface (vnm, sw_if_index)->output_node_index;
+
+  return (bi);
+}
+
 void
 ip4_neighbor_advertise (vlib_main_t * vm,
 			vnet_main_t * vnm,
@@ -26,26 +26,34 @@ extern void ip4_neighbor_advertise (vlib_main_t * vm,
 				    u32 sw_if_index,
 				    const ip4_address_t * addr);
 
+extern u32 ip4_neighbor_probe_dst_build (u32 sw_if_index,
+					 const ip4_address_t * dst,
+					 u32 * node_index);
+
+/**
+ * Build an ARP request for dst, ready to be sent to the interface's
+ * output node. Returns NULL if no buffer is available.
+ */
 always_inline vlib_buffer_t *
-ip4_neighbor_probe (vlib_main_t * vm,
-		    vnet_main_t * vnm,
-		    const ip_adjacency_t * adj0,
-		    const ip4_address_t * src, const ip4_address_t * dst)
+ip4_neighbor_probe_build (vlib_main_t * vm,
+			  vnet_main_t * vnm,
+			  const ip_adjacency_t * adj0,
+			  const ip4_address_t * src,
+			  const ip4_address_t * dst, u32 * bi)
 {
   vnet_hw_interface_t *hw_if0;
   ethernet_arp_header_t *h0;
   vlib_buffer_t *b0;
-  u32 bi0;
 
   /* Send ARP request. */
   h0 = vlib_packet_template_get_packet (vm,
 					&ip4_main.ip4_arp_request_packet_template,
-					&bi0);
+					bi);
   /* Seems we're out of buffers */
   if (PREDICT_FALSE (!h0))
     return (NULL);
 
-  b0 = vlib_get_buffer (vm, bi0);
+  b0 = vlib_get_buffer (vm, *bi);
 
   /* Add rewrite/encap string for ARP packet. */
   vnet_rewrite_one_header (adj0[0], h0, sizeof (ethernet_header_t));
@@ -63,6 +71,26 @@ ip4_neighbor_probe (vlib_main_t * vm,
 
   vlib_buffer_advance (b0, -adj0->rewrite_header.data_bytes);
 
+  return b0;
+}
+
+always_inline vlib_buffer_t *
+ip4_neighbor_probe (vlib_main_t * vm,
+		    vnet_main_t * vnm,
+		    const ip_adjacency_t * adj0,
+		    const ip4_address_t * src, const ip4_address_t * dst)
+{
+  vnet_hw_interface_t *hw_if0;
+  vlib_buffer_t *b0;
+  u32 bi0;
+
+  b0 = ip4_neighbor_probe_build (vm, vnm, adj0, src, dst, &bi0);
+
+  if (PREDICT_FALSE (!b0))
+    return (NULL);
+
+  hw_if0 = vnet_get_sup_hw_interface (vnm, adj0->rewrite_header.sw_if_index);
+
   {
     vlib_frame_t *f = vlib_get_frame_to_node (vm, hw_if0->output_node_index);
     u32 *to_next = vlib_frame_vector_args (f);
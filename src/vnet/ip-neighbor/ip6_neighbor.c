@@ -32,6 +32,27 @@ ip6_neighbor_probe_dst (u32 sw_if_index, const ip6_address_t * dst)
 			sw_if_index, &src, dst);
 }
 
+/**
+ * Build, but do not send, a neighbor solicitation for dst. Returns the
+ * buffer index, or ~0, and the node to which it should be sent.
+ */
+u32
+ip6_neighbor_probe_dst_build (u32 sw_if_index,
+			      const ip6_address_t * dst, u32 * node_index)
+{
+  ip6_address_t src;
+  u32 bi;
+
+  if (!fib_sas6_get (sw_if_index, dst, &src))
+    return (~0);
+
+  if (!ip6_neighbor_probe_build (vlib_get_main (), vnet_get_main (),
+				 sw_if_index, &src, dst, &bi, node_index))
+    return (~0);
+
+  return (bi);
+}
+
 void
 ip6_neighbor_advertise (vlib_main_t * vm,
 			vnet_main_t * vnm,
@@ -37,21 +37,29 @@ extern void ip6_neighbor_advertise (vlib_main_t * vm,
 extern void ip6_neighbor_probe_dst (u32 sw_if_index,
 				    const ip6_address_t * dst);
 
+extern u32 ip6_neighbor_probe_dst_build (u32 sw_if_index,
+					 const ip6_address_t * dst,
+					 u32 * node_index);
+
+/**
+ * Build a neighbor solicitation for dst, ready to be sent to the node
+ * returned in node_index. Returns NULL if no buffer is available.
+ */
 always_inline vlib_buffer_t *
-ip6_neighbor_probe (vlib_main_t * vm,
-		    vnet_main_t * vnm,
-		    u32 sw_if_index,
-		    const ip6_address_t * src, const ip6_address_t * dst)
+ip6_neighbor_probe_build (vlib_main_t * vm,
+			  vnet_main_t * vnm,
+			  u32 sw_if_index,
+			  const ip6_address_t * src,
+			  const ip6_address_t * dst, u32 * bi, u32 * node_index)
 {
   icmp6_neighbor_solicitation_header_t *h0;
   vnet_hw_interface_t *hw_if0;
   const ip_adjacency_t *adj;
   vlib_buffer_t *b0;
   int bogus_length;
-  u32 bi0 = 0;
 
   h0 = vlib_packet_template_get_packet
-    (vm, &ip6_neighbor_packet_template, &bi0);
+    (vm, &ip6_neighbor_packet_template, bi);
   if (!h0)
     return NULL;
 
@@ -59,9 +67,12 @@ ip6_neighbor_probe (vlib_main_t * vm,
    * an adjacency will result in a segv.
    */
   if (!ip6_link_is_enabled (sw_if_index))
-    return NULL;
+    {
+      vlib_buffer_free_one (vm, *bi);
+      return NULL;
+    }
 
-  b0 = vlib_get_buffer (vm, bi0);
+  b0 = vlib_get_buffer (vm, *bi);
 
   hw_if0 = vnet_get_sup_hw_interface (vnm, sw_if_index);
 
@@ -97,12 +108,31 @@ ip6_neighbor_probe (vlib_main_t * vm,
 
   b0->flags |= VNET_BUFFER_F_LOCALLY_ORIGINATED;
 
+  *node_index = adj->ia_node_index;
+
+  return b0;
+}
+
+always_inline vlib_buffer_t *
+ip6_neighbor_probe (vlib_main_t * vm,
+		    vnet_main_t * vnm,
+		    u32 sw_if_index,
+		    const ip6_address_t * src, const ip6_address_t * dst)
+{
+  vlib_buffer_t *b0;
+  u32 bi0, node_index;
+
+  b0 = ip6_neighbor_probe_build (vm, vnm, sw_if_index, src, dst,
+				 &bi0, &node_index);
+  if (!b0)
+    return NULL;
+
   {
-    vlib_frame_t *f = vlib_get_frame_to_node (vm, adj->ia_node_index);
+    vlib_frame_t *f = vlib_get_frame_to_node (vm, node_index);
     u32 *to_next = vlib_frame_vector_args (f);
     to_next[0] = bi0;
     f->n_vectors = 1;
-    vlib_put_frame_to_node (vm, adj->ia_node_index, f);
+    vlib_put_frame_to_node (vm, node_index, f);
   }
 
   return b0;
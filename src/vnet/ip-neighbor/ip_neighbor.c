@@ -16,6 +16,7 @@
  */
 
 #include <vppinfra/llist.h>
+#include <vppinfra/tw_timer_1t_3w_1024sl_ov.h>
 
 #include <vnet/ip-neighbor/ip_neighbor.h>
 #include <vnet/ip-neighbor/ip4_neighbor.h>
@@ -57,6 +58,10 @@ typedef struct ip_neighbor_db_t_
   u32 ipndb_n_elts;
   /** per-protocol number of elements per-fib-index*/
   u32 *ipndb_n_elts_per_fib;
+  /** the timers that drive aging and probing of dynamic neighbours */
+  TWT (tw_timer_wheel) ipndb_wheel;
+  /** neighbours whose timer has expired, not yet seen by the age process */
+  index_t *ipndb_expired;
 } ip_neighbor_db_t;
 
 static vlib_log_class_t ipn_logger;
@@ -136,6 +141,38 @@ ip_neighbor_get_sw_if_index (const ip_neighbor_t * ipn)
   return (ipn->ipn_key->ipnk_sw_if_index);
 }
 
+/**
+ * The aging timer wheel ticks 10 times a second. A timer, once started, is
+ * not moved when the neighbour is refreshed; when it expires the age
+ * process restarts it for the time remaining.
+ */
+#define IP_NEIGHBOR_TW_TICKS_PER_SECOND (10)
+#define IP_NEIGHBOR_TW_INTERVAL (1.0 / IP_NEIGHBOR_TW_TICKS_PER_SECOND)
+
+static void
+ip_neighbor_timer_stop (ip_neighbor_t * ipn)
+{
+  if (~0 != ipn->ipn_timer)
+    {
+      TW (tw_timer_stop) (&ip_neighbor_db[ip_neighbor_get_af (ipn)].
+			  ipndb_wheel, ipn->ipn_timer);
+      ipn->ipn_timer = ~0;
+    }
+}
+
+static void
+ip_neighbor_timer_start (ip_neighbor_t * ipn, u32 n_secs)
+{
+  ASSERT (~0 == ipn->ipn_timer);
+
+  /* a timer expires on the tick after its interval */
+  ipn->ipn_timer =
+    TW (tw_timer_start) (&ip_neighbor_db[ip_neighbor_get_af (ipn)].
+			 ipndb_wheel, ip_neighbor_get_index (ipn), 0,
+			 (u64) clib_max (n_secs, 1) *
+			 IP_NEIGHBOR_TW_TICKS_PER_SECOND - 1);
+}
+
 static void
 ip_neighbor_list_remove (ip_neighbor_t * ipn)
 {
@@ -151,6 +188,7 @@ ip_neighbor_list_remove (ip_neighbor_t * ipn)
 
       ipn->ipn_elt = ~0;
     }
+  ip_neighbor_timer_stop (ipn);
 }
 
 static void
@@ -183,6 +221,11 @@ ip_neighbor_refresh (ip_neighbor_t * ipn)
       elt->ipne_index = ip_neighbor_get_index (ipn);
       clib_llist_add (ip_neighbor_elt_pool, ipne_anchor, elt, head);
       ipn->ipn_elt = elt - ip_neighbor_elt_pool;
+
+      if (~0 == ipn->ipn_timer &&
+	  ip_neighbor_db[ip_neighbor_get_af (ipn)].ipndb_age)
+	ip_neighbor_timer_start
+	  (ipn, ip_neighbor_db[ip_neighbor_get_af (ipn)].ipndb_age + 1);
     }
 }
 
@@ -198,8 +241,14 @@ ip_neighbor_db_add (const ip_neighbor_t * ipn)
   vec_validate (ip_neighbor_db[af].ipndb_hash, sw_if_index);
 
   if (!ip_neighbor_db[af].ipndb_hash[sw_if_index])
-    ip_neighbor_db[af].ipndb_hash[sw_if_index]
-      = hash_create_mem (0, sizeof (ip_neighbor_key_t), sizeof (index_t));
+    {
+      ip_neighbor_db[af].ipndb_hash[sw_if_index]
+	= hash_create_mem (0, sizeof (ip_neighbor_key_t), sizeof (index_t));
+      /* shrinking a large table rehashes it all, in one go, as the
+       * neighbours age out */
+      hash_set_flags (ip_neighbor_db[af].ipndb_hash[sw_if_index],
+		      HASH_FLAG_NO_AUTO_SHRINK);
+    }
 
   hash_set_mem (ip_neighbor_db[af].ipndb_hash[sw_if_index],
 		ipn->ipn_key, ip_neighbor_get_index (ipn));
@@ -459,6 +508,7 @@ ip_neighbor_alloc (const ip_neighbor_key_t * key,
   ipn->ipn_fib_entry_index = FIB_NODE_INDEX_INVALID;
   ipn->ipn_flags = flags;
   ipn->ipn_elt = ~0;
+  ipn->ipn_timer = ~0;
 
   mac_address_copy (&ipn->ipn_mac, mac);
 
@@ -1511,8 +1561,98 @@ typedef enum ip_neighbor_age_state_t_
 
 #define IP_NEIGHBOR_PROCESS_SLEEP_LONG (0)
 
+/**
+ * The number of expired neighbours the age process handles before it
+ * yields, so that many neighbours expiring in the same tick do not stall
+ * the main thread.
+ */
+#define IP_NEIGHBOR_AGE_BATCH (256)
+#define IP_NEIGHBOR_PROCESS_SLEEP_SHORT (1e-4)
+
+/**
+ * The probes sent by the age process are collected into frames, one per
+ * destination node, rather than each being sent in a frame of its own.
+ */
+typedef struct ip_neighbor_probe_frame_t_
+{
+  u32 ipnpf_node_index;
+  vlib_frame_t *ipnpf_frame;
+} ip_neighbor_probe_frame_t;
+
+static void
+ip_neighbor_probe_frame_add (ip_neighbor_probe_frame_t ** frames,
+			     u32 node_index, u32 bi)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  ip_neighbor_probe_frame_t *ipnpf;
+  u32 *to_next;
+
+  vec_foreach (ipnpf, *frames)
+  {
+    if (ipnpf->ipnpf_node_index == node_index)
+      goto found;
+  }
+
+  vec_add2 (*frames, ipnpf, 1);
+  ipnpf->ipnpf_node_index = node_index;
+  ipnpf->ipnpf_frame = vlib_get_frame_to_node (vm, node_index);
+
+found:
+  to_next = vlib_frame_vector_args (ipnpf->ipnpf_frame);
+  to_next[ipnpf->ipnpf_frame->n_vectors++] = bi;
+
+  if (VLIB_FRAME_SIZE == ipnpf->ipnpf_frame->n_vectors)
+    {
+      vlib_put_frame_to_node (vm, node_index, ipnpf->ipnpf_frame);
+      vec_del1 (*frames, ipnpf - *frames);
+    }
+}
+
+static void
+ip_neighbor_probe_frame_flush (ip_neighbor_probe_frame_t ** frames)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  ip_neighbor_probe_frame_t *ipnpf;
+
+  vec_foreach (ipnpf, *frames)
+  {
+    vlib_put_frame_to_node (vm, ipnpf->ipnpf_node_index,
+			    ipnpf->ipnpf_frame);
+  }
+  vec_reset_length (*frames);
+}
+
+static void
+ip_neighbor_probe_dst_batch (u32 sw_if_index,
+			     ip_address_family_t af,
+			     const ip46_address_t * dst,
+			     ip_neighbor_probe_frame_t ** frames)
+{
+  u32 bi, node_index;
+
+  if (!vnet_sw_interface_is_admin_up (vnet_get_main (), sw_if_index))
+    return;
+
+  switch (af)
+    {
+    case AF_IP6:
+      bi = ip6_neighbor_probe_dst_build (sw_if_index, &dst->ip6,
+					 &node_index);
+      break;
+    case AF_IP4:
+    default:
+      bi = ip4_neighbor_probe_dst_build (sw_if_index, &dst->ip4,
+					 &node_index);
+      break;
+    }
+
+  if (~0 != bi)
+    ip_neighbor_probe_frame_add (frames, node_index, bi);
+}
+
 static ip_neighbor_age_state_t
-ip_neighbour_age_out (index_t ipni, f64 now, f64 * wait)
+ip_neighbour_age_out (index_t ipni, f64 now, u32 * wait,
+		      ip_neighbor_probe_frame_t ** frames)
 {
   ip_address_family_t af;
   ip_neighbor_t *ipn;
@@ -1539,8 +1679,9 @@ ip_neighbour_age_out (index_t ipni, f64 now, f64 * wait)
 	}
       else
 	{
-	  ip_neighbor_probe_dst (ip_neighbor_get_sw_if_index (ipn),
-				 af, &ip_addr_46 (&ipn->ipn_key->ipnk_ip));
+	  ip_neighbor_probe_dst_batch (ip_neighbor_get_sw_if_index (ipn),
+				       af, &ip_addr_46 (&ipn->ipn_key->ipnk_ip),
+				       frames);
 
 	  ipn->ipn_n_probes++;
 	  *wait = 1;
@@ -1566,14 +1707,20 @@ ip_neighbor_age_loop (vlib_main_t * vm,
 		      vlib_node_runtime_t * rt,
 		      vlib_frame_t * f, ip_address_family_t af)
 {
-  uword event_type, *event_data = NULL;
+  ip_neighbor_probe_frame_t *frames = NULL;
+  uword *event_data = NULL;
+  ip_neighbor_db_t *ndb;
   f64 timeout;
 
+  ndb = &ip_neighbor_db[af];
+
   /* Set the timeout to an effectively infinite value when the process starts */
   timeout = IP_NEIGHBOR_PROCESS_SLEEP_LONG;
 
   while (1)
     {
+      u32 n_expired, n_left, wait, i;
+      index_t ipni;
       f64 now;
 
       if (!timeout)
@@ -1581,77 +1728,60 @@ ip_neighbor_age_loop (vlib_main_t * vm,
       else
 	vlib_process_wait_for_event_or_clock (vm, timeout);
 
-      event_type = vlib_process_get_events (vm, &event_data);
+      /* a wakeup and the clock are handled alike; advance the wheel */
+      vlib_process_get_events (vm, &event_data);
       vec_reset_length (event_data);
 
       now = vlib_time_now (vm);
 
-      switch (event_type)
+      n_expired = vec_len (ndb->ipndb_expired);
+      ndb->ipndb_expired =
+	TW (tw_timer_expire_timers_vec) (&ndb->ipndb_wheel, now,
+					 ndb->ipndb_expired);
+
+      /* the timers of those that just expired are no longer running */
+      for (i = n_expired; i < vec_len (ndb->ipndb_expired); i++)
+	ip_neighbor_get (ndb->ipndb_expired[i])->ipn_timer = ~0;
+
+      /*
+       * handle a batch of the expired. Since the process yields between
+       * batches, a neighbour may since have been deleted, or refreshed
+       * and its timer restarted, in which case it is skipped.
+       */
+      n_left = IP_NEIGHBOR_AGE_BATCH;
+
+      while (n_left && vec_len (ndb->ipndb_expired))
 	{
-	case ~0:
-	  {
-	    /* timer expired */
-	    ip_neighbor_elt_t *elt, *head;
-	    f64 wait;
-
-	    timeout = ip_neighbor_db[af].ipndb_age;
-	    head = pool_elt_at_index (ip_neighbor_elt_pool,
-				      ip_neighbor_list_head[af]);
-
-          /* *INDENT-OFF*/
-          /* the list is time sorted, newest first, so start from the back
-           * and work forwards. Stop when we get to one that is alive */
-          restart:
-          clib_llist_foreach_reverse(ip_neighbor_elt_pool,
-                                     ipne_anchor, head, elt,
-          ({
-            ip_neighbor_age_state_t res;
-
-            res = ip_neighbour_age_out(elt->ipne_index, now, &wait);
-
-            if (IP_NEIGHBOR_AGE_ALIVE == res) {
-              /* the oldest neighbor has not yet expired, go back to sleep */
-              timeout = clib_min (wait, timeout);
-              break;
-            }
-            else if (IP_NEIGHBOR_AGE_DEAD == res) {
-              /* the oldest neighbor is dead, pop it, then restart the walk
-               * again from the back */
-              ip_neighbor_destroy (ip_neighbor_get(elt->ipne_index));
-              goto restart;
-            }
-
-            timeout = clib_min (wait, timeout);
-          }));
-          /* *INDENT-ON* */
-	    break;
-	  }
-	case IP_NEIGHBOR_AGE_PROCESS_WAKEUP:
-	  {
-
-	    if (!ip_neighbor_db[af].ipndb_age)
-	      {
-		/* aging has been disabled */
-		timeout = 0;
-		break;
-	      }
-	    ip_neighbor_elt_t *elt, *head;
-
-	    head = pool_elt_at_index (ip_neighbor_elt_pool,
-				      ip_neighbor_list_head[af]);
-	    /* no neighbors yet */
-	    if (clib_llist_is_empty (ip_neighbor_elt_pool, ipne_anchor, head))
-	      {
-		timeout = ip_neighbor_db[af].ipndb_age;
-		break;
-	      }
-
-	    /* poke the oldset neighbour for aging, which returns how long we sleep for */
-	    elt = clib_llist_prev (ip_neighbor_elt_pool, ipne_anchor, head);
-	    ip_neighbour_age_out (elt->ipne_index, now, &timeout);
-	    break;
-	  }
+	  ip_neighbor_age_state_t res;
+	  ip_neighbor_t *ipn;
+
+	  ipni = vec_pop (ndb->ipndb_expired);
+	  ipn = ip_neighbor_get (ipni);
+	  n_left--;
+
+	  if (NULL == ipn || ~0 != ipn->ipn_timer ||
+	      !ip_neighbor_is_dynamic (ipn) || !ndb->ipndb_age)
+	    continue;
+
+	  res = ip_neighbour_age_out (ipni, now, &wait, &frames);
+
+	  if (IP_NEIGHBOR_AGE_DEAD == res)
+	    ip_neighbor_destroy (ipn);
+	  else
+	    ip_neighbor_timer_start (ipn, wait);
 	}
+
+      ip_neighbor_probe_frame_flush (&frames);
+
+      if (vec_len (ndb->ipndb_expired))
+	/* more to do, come back soon */
+	timeout = IP_NEIGHBOR_PROCESS_SLEEP_SHORT;
+      else if (ndb->ipndb_age)
+	/* keep the wheel ticking */
+	timeout = IP_NEIGHBOR_TW_INTERVAL;
+      else
+	/* aging is disabled */
+	timeout = IP_NEIGHBOR_PROCESS_SLEEP_LONG;
     }
   return 0;
 }
@@ -1683,12 +1813,61 @@ VLIB_REGISTER_NODE (ip6_neighbor_age_process_node,static) = {
 };
 /* *INDENT-ON* */
 
+/**
+ * The age has changed; restart the timers of all dynamic neighbours for
+ * the time they have left, or stop them if aging is now disabled.
+ */
+static void
+ip_neighbor_age_restart (ip_address_family_t af)
+{
+  ip_neighbor_elt_t *elt, *head;
+  ip_neighbor_t *ipn;
+  u32 age, ttl;
+  f64 now;
+
+  now = vlib_time_now (vlib_get_main ());
+  age = ip_neighbor_db[af].ipndb_age;
+  head = pool_elt_at_index (ip_neighbor_elt_pool, ip_neighbor_list_head[af]);
+
+  /* *INDENT-OFF* */
+  clib_llist_foreach(ip_neighbor_elt_pool, ipne_anchor, head, elt,
+  ({
+    ip_neighbor_timer_stop (ip_neighbor_get (elt->ipne_index));
+  }));
+  /* *INDENT-ON* */
+
+  if (!age)
+    return;
+
+  /*
+   * the wheel does not tick while aging is disabled, so bring it up to
+   * date before starting timers relative to it. There are none to expire.
+   */
+  ip_neighbor_db[af].ipndb_expired =
+    TW (tw_timer_expire_timers_vec) (&ip_neighbor_db[af].ipndb_wheel, now,
+				     ip_neighbor_db[af].ipndb_expired);
+
+  /* *INDENT-OFF* */
+  clib_llist_foreach(ip_neighbor_elt_pool, ipne_anchor, head, elt,
+  ({
+    ipn = ip_neighbor_get (elt->ipne_index);
+    ttl = now - ipn->ipn_time_last_updated;
+    ip_neighbor_timer_start (ipn, (ttl > age ? 1 : age - ttl + 1));
+  }));
+  /* *INDENT-ON* */
+}
+
 int
 ip_neighbor_config (ip_address_family_t af, u32 limit, u32 age, bool recycle)
 {
   ip_neighbor_db[af].ipndb_limit = limit;
   ip_neighbor_db[af].ipndb_recycle = recycle;
-  ip_neighbor_db[af].ipndb_age = age;
+
+  if (ip_neighbor_db[af].ipndb_age != age)
+    {
+      ip_neighbor_db[af].ipndb_age = age;
+      ip_neighbor_age_restart (af);
+    }
 
   vlib_process_signal_event (vlib_get_main (),
 			     (AF_IP4 == af ?
@@ -1699,6 +1878,15 @@ ip_neighbor_config (ip_address_family_t af, u32 limit, u32 age, bool recycle)
   return (0);
 }
 
+void
+ip_neighbor_config_get (ip_address_family_t af,
+			u32 * limit, u32 * age, bool * recycle)
+{
+  *limit = ip_neighbor_db[af].ipndb_limit;
+  *age = ip_neighbor_db[af].ipndb_age;
+  *recycle = ip_neighbor_db[af].ipndb_recycle;
+}
+
 static clib_error_t *
 ip_neighbor_config_show (vlib_main_t * vm,
 			 unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -1819,8 +2007,12 @@ ip_neighbor_init (vlib_main_t * vm)
   ip_address_family_t af;
 
   FOR_EACH_IP_ADDRESS_FAMILY (af)
+  {
     ip_neighbor_list_head[af] =
-    clib_llist_make_head (ip_neighbor_elt_pool, ipne_anchor);
+      clib_llist_make_head (ip_neighbor_elt_pool, ipne_anchor);
+    TW (tw_timer_wheel_init) (&ip_neighbor_db[af].ipndb_wheel, NULL,
+			      IP_NEIGHBOR_TW_INTERVAL, ~0);
+  }
 
   return (NULL);
 }
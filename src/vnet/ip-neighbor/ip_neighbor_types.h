@@ -77,10 +77,12 @@ typedef struct ip_neighbor_t_
    * Aging related data
    *  - last time the neighbour was probed
    *  - number of probes - 3 and it's dead
+   *  - the aging timer, ~0 when not running
    */
   f64 ipn_time_last_updated;
   u8 ipn_n_probes;
   index_t ipn_elt;
+  u32 ipn_timer;
 
   /**
    * The index of the adj fib created for this neighbour
@@ -87,7 +87,10 @@
   _ (REASS_NO_BUF, "out of buffers (drop)")                             \
   _ (REASS_MALFORMED_PACKET, "malformed packets")                       \
   _ (REASS_INTERNAL_ERROR, "drops due to internal reassembly error")    \
-  _ (REASS_UNSUPP_IP_PROT, "unsupported ip protocol")
+  _ (REASS_UNSUPP_IP_PROT, "unsupported ip protocol")                   \
+  _ (REASS_TIMEOUT, "fragments dropped due to reassembly timeout")      \
+  _ (REASS_EVICTED, "fragments dropped due to reassembly memory limit") \
+  _ (REASS_IN_ORDER, "in-order fragment pairs")
 
 typedef enum
 {
@@ -52,6 +52,109 @@
  * This file contains the source code for IPv4 forwarding.
  */
 
+#if defined (CLIB_HAVE_VEC256)
+/**
+ * @brief Set the FIB index of, and lookup, 'n' (8 or 16) packets.
+ * When all the packets are in the same mtrie FIB, as they mostly are,
+ * they are looked up together with gathers; otherwise one at a time.
+ */
+static_always_inline void
+ip4_lookup_batch_n (ip4_main_t * im, vlib_buffer_t ** b, u32 * lbi, u32 n)
+{
+  u32 fib_index[16], dst[16], i, same = 1;
+  const ip4_fib_t *fib;
+  ip4_header_t *ip;
+
+  for (i = 0; i < n; i++)
+    {
+      ip_lookup_set_buffer_fib_index (im->fib_index_by_sw_if_index, b[i]);
+      ip = vlib_buffer_get_current (b[i]);
+
+      fib_index[i] = vnet_buffer (b[i])->ip.fib_index;
+      dst[i] = ip->dst_address.as_u32;
+      same &= (fib_index[i] == fib_index[0]);
+    }
+
+  fib = ip4_fib_get (fib_index[0]);
+
+  if (PREDICT_TRUE (same && NULL == fib->poptrie))
+    {
+#if defined (CLIB_HAVE_VEC512)
+      if (16 == n)
+	{
+	  u32x16_store_unaligned
+	    (ip4_fib_mtrie_lookup_x16 (&fib->mtrie,
+				       u32x16_load_unaligned (dst)), lbi);
+	  return;
+	}
+#endif
+      ASSERT (8 == n);
+      u32x8_store_unaligned
+	(ip4_fib_mtrie_lookup_x8 (&fib->mtrie, u32x8_load_unaligned (dst)),
+	 lbi);
+      return;
+    }
+
+  for (i = 0; i < n; i++)
+    lbi[i] = ip4_fib_forwarding_lookup (fib_index[i],
+					(ip4_address_t *) & dst[i]);
+}
+
+/**
+ * @brief Set the FIB index of, and lookup, all the packets of a frame
+ * before they are forwarded, so that the lookups are done in batches.
+ */
+static_always_inline void
+ip4_lookup_batch (ip4_main_t * im, vlib_buffer_t ** b, u32 * lbi,
+		  u32 n_left)
+{
+#if defined (CLIB_HAVE_VEC512)
+  const u32 n = 16;
+#else
+  const u32 n = 8;
+#endif
+  u32 i;
+
+  while (n_left >= n)
+    {
+      /* Prefetch next iteration. */
+      if (n_left >= 2 * n)
+	for (i = n; i < 2 * n; i++)
+	  {
+	    vlib_prefetch_buffer_header (b[i], LOAD);
+	    CLIB_PREFETCH (b[i]->data, sizeof (ip4_header_t), LOAD);
+	  }
+
+      ip4_lookup_batch_n (im, b, lbi, n);
+
+      b += n;
+      lbi += n;
+      n_left -= n;
+    }
+  if (n_left >= 8)
+    {
+      ip4_lookup_batch_n (im, b, lbi, 8);
+
+      b += 8;
+      lbi += 8;
+      n_left -= 8;
+    }
+  while (n_left > 0)
+    {
+      ip4_header_t *ip0;
+
+      ip0 = vlib_buffer_get_current (b[0]);
+      ip_lookup_set_buffer_fib_index (im->fib_index_by_sw_if_index, b[0]);
+
+      lbi[0] = ip4_fib_forwarding_lookup (vnet_buffer (b[0])->ip.fib_index,
+					  &ip0->dst_address);
+      b += 1;
+      lbi += 1;
+      n_left -= 1;
+    }
+}
+#endif
+
 always_inline uword
 ip4_lookup_inline (vlib_main_t * vm,
 		   vlib_node_runtime_t * node, vlib_frame_t * frame)
@@ -63,20 +166,29 @@ ip4_lookup_inline (vlib_main_t * vm,
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE];
   vlib_buffer_t **b = bufs;
   u16 nexts[VLIB_FRAME_SIZE], *next;
+  u32 lbis[VLIB_FRAME_SIZE], *lbi;
 
   from = vlib_frame_vector_args (frame);
   n_left = frame->n_vectors;
   next = nexts;
+  lbi = lbis;
   vlib_get_buffers (vm, from, bufs, n_left);
 
+#if defined (CLIB_HAVE_VEC256)
+  ip4_lookup_batch (im, bufs, lbis, n_left);
+#endif
+
 #if (CLIB_N_PREFETCHES >= 8)
   while (n_left >= 4)
     {
       ip4_header_t *ip0, *ip1, *ip2, *ip3;
       const load_balance_t *lb0, *lb1, *lb2, *lb3;
-      ip4_fib_mtrie_t *mtrie0, *mtrie1, *mtrie2, *mtrie3;
+#if !defined (CLIB_HAVE_VEC256)
+      const ip4_fib_t *fib0, *fib1, *fib2, *fib3;
+      const ip4_fib_mtrie_t *mtrie0, *mtrie1, *mtrie2, *mtrie3;
       ip4_fib_mtrie_leaf_t leaf0, leaf1, leaf2, leaf3;
       ip4_address_t *dst_addr0, *dst_addr1, *dst_addr2, *dst_addr3;
+#endif
       u32 lb_index0, lb_index1, lb_index2, lb_index3;
       flow_hash_config_t flow_hash_config0, flow_hash_config1;
       flow_hash_config_t flow_hash_config2, flow_hash_config3;
@@ -102,6 +214,12 @@ ip4_lookup_inline (vlib_main_t * vm,
       ip2 = vlib_buffer_get_current (b[2]);
       ip3 = vlib_buffer_get_current (b[3]);
 
+#if defined (CLIB_HAVE_VEC256)
+      lb_index0 = lbi[0];
+      lb_index1 = lbi[1];
+      lb_index2 = lbi[2];
+      lb_index3 = lbi[3];
+#else
       dst_addr0 = &ip0->dst_address;
       dst_addr1 = &ip1->dst_address;
       dst_addr2 = &ip2->dst_address;
@@ -112,30 +230,47 @@ ip4_lookup_inline (vlib_main_t * vm,
       ip_lookup_set_buffer_fib_index (im->fib_index_by_sw_if_index, b[2]);
       ip_lookup_set_buffer_fib_index (im->fib_index_by_sw_if_index, b[3]);
 
-      mtrie0 = &ip4_fib_get (vnet_buffer (b[0])->ip.fib_index)->mtrie;
-      mtrie1 = &ip4_fib_get (vnet_buffer (b[1])->ip.fib_index)->mtrie;
-      mtrie2 = &ip4_fib_get (vnet_buffer (b[2])->ip.fib_index)->mtrie;
-      mtrie3 = &ip4_fib_get (vnet_buffer (b[3])->ip.fib_index)->mtrie;
+      fib0 = ip4_fib_get (vnet_buffer (b[0])->ip.fib_index);
+      fib1 = ip4_fib_get (vnet_buffer (b[1])->ip.fib_index);
+      fib2 = ip4_fib_get (vnet_buffer (b[2])->ip.fib_index);
+      fib3 = ip4_fib_get (vnet_buffer (b[3])->ip.fib_index);
 
-      leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, dst_addr0);
-      leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, dst_addr1);
-      leaf2 = ip4_fib_mtrie_lookup_step_one (mtrie2, dst_addr2);
-      leaf3 = ip4_fib_mtrie_lookup_step_one (mtrie3, dst_addr3);
-
-      leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 2);
-      leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 2);
-      leaf2 = ip4_fib_mtrie_lookup_step (mtrie2, leaf2, dst_addr2, 2);
-      leaf3 = ip4_fib_mtrie_lookup_step (mtrie3, leaf3, dst_addr3, 2);
-
-      leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 3);
-      leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 3);
-      leaf2 = ip4_fib_mtrie_lookup_step (mtrie2, leaf2, dst_addr2, 3);
-      leaf3 = ip4_fib_mtrie_lookup_step (mtrie3, leaf3, dst_addr3, 3);
-
-      lb_index0 = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
-      lb_index1 = ip4_fib_mtrie_leaf_get_adj_index (leaf1);
-      lb_index2 = ip4_fib_mtrie_leaf_get_adj_index (leaf2);
-      lb_index3 = ip4_fib_mtrie_leaf_get_adj_index (leaf3);
+      if (PREDICT_FALSE (fib0->poptrie || fib1->poptrie ||
+			 fib2->poptrie || fib3->poptrie))
+	{
+	  lb_index0 = ip4_fib_table_forwarding_lookup (fib0, dst_addr0);
+	  lb_index1 = ip4_fib_table_forwarding_lookup (fib1, dst_addr1);
+	  lb_index2 = ip4_fib_table_forwarding_lookup (fib2, dst_addr2);
+	  lb_index3 = ip4_fib_table_forwarding_lookup (fib3, dst_addr3);
+	}
+      else
+	{
+	  mtrie0 = &fib0->mtrie;
+	  mtrie1 = &fib1->mtrie;
+	  mtrie2 = &fib2->mtrie;
+	  mtrie3 = &fib3->mtrie;
+
+	  leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, dst_addr0);
+	  leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, dst_addr1);
+	  leaf2 = ip4_fib_mtrie_lookup_step_one (mtrie2, dst_addr2);
+	  leaf3 = ip4_fib_mtrie_lookup_step_one (mtrie3, dst_addr3);
+
+	  leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 2);
+	  leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 2);
+	  leaf2 = ip4_fib_mtrie_lookup_step (mtrie2, leaf2, dst_addr2, 2);
+	  leaf3 = ip4_fib_mtrie_lookup_step (mtrie3, leaf3, dst_addr3, 2);
+
+	  leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 3);
+	  leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 3);
+	  leaf2 = ip4_fib_mtrie_lookup_step (mtrie2, leaf2, dst_addr2, 3);
+	  leaf3 = ip4_fib_mtrie_lookup_step (mtrie3, leaf3, dst_addr3, 3);
+
+	  lb_index0 = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
+	  lb_index1 = ip4_fib_mtrie_leaf_get_adj_index (leaf1);
+	  lb_index2 = ip4_fib_mtrie_leaf_get_adj_index (leaf2);
+	  lb_index3 = ip4_fib_mtrie_leaf_get_adj_index (leaf3);
+	}
+#endif
 
       ASSERT (lb_index0 && lb_index1 && lb_index2 && lb_index3);
       lb0 = load_balance_get (lb_index0);
@@ -238,6 +373,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 
       b += 4;
       next += 4;
+      lbi += 4;
       n_left -= 4;
     }
 #elif (CLIB_N_PREFETCHES >= 4)
@@ -245,9 +381,12 @@ ip4_lookup_inline (vlib_main_t * vm,
     {
       ip4_header_t *ip0, *ip1;
       const load_balance_t *lb0, *lb1;
-      ip4_fib_mtrie_t *mtrie0, *mtrie1;
+#if !defined (CLIB_HAVE_VEC256)
+      const ip4_fib_t *fib0, *fib1;
+      const ip4_fib_mtrie_t *mtrie0, *mtrie1;
       ip4_fib_mtrie_leaf_t leaf0, leaf1;
       ip4_address_t *dst_addr0, *dst_addr1;
+#endif
       u32 lb_index0, lb_index1;
       flow_hash_config_t flow_hash_config0, flow_hash_config1;
       u32 hash_c0, hash_c1;
@@ -265,26 +404,42 @@ ip4_lookup_inline (vlib_main_t * vm,
       ip0 = vlib_buffer_get_current (b[0]);
       ip1 = vlib_buffer_get_current (b[1]);
 
+#if defined (CLIB_HAVE_VEC256)
+      lb_index0 = lbi[0];
+      lb_index1 = lbi[1];
+#else
       dst_addr0 = &ip0->dst_address;
       dst_addr1 = &ip1->dst_address;
 
       ip_lookup_set_buffer_fib_index (im->fib_index_by_sw_if_index, b[0]);
       ip_lookup_set_buffer_fib_index (im->fib_index_by_sw_if_index, b[1]);
 
-      mtrie0 = &ip4_fib_get (vnet_buffer (b[0])->ip.fib_index)->mtrie;
-      mtrie1 = &ip4_fib_get (vnet_buffer (b[1])->ip.fib_index)->mtrie;
+      fib0 = ip4_fib_get (vnet_buffer (b[0])->ip.fib_index);
+      fib1 = ip4_fib_get (vnet_buffer (b[1])->ip.fib_index);
 
-      leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, dst_addr0);
-      leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, dst_addr1);
+      if (PREDICT_FALSE (fib0->poptrie || fib1->poptrie))
+	{
+	  lb_index0 = ip4_fib_table_forwarding_lookup (fib0, dst_addr0);
+	  lb_index1 = ip4_fib_table_forwarding_lookup (fib1, dst_addr1);
+	}
+      else
+	{
+	  mtrie0 = &fib0->mtrie;
+	  mtrie1 = &fib1->mtrie;
 
-      leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 2);
-      leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 2);
+	  leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, dst_addr0);
+	  leaf1 = ip4_fib_mtrie_lookup_step_one (mtrie1, dst_addr1);
 
-      leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 3);
-      leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 3);
+	  leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 2);
+	  leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 2);
 
-      lb_index0 = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
-      lb_index1 = ip4_fib_mtrie_leaf_get_adj_index (leaf1);
+	  leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 3);
+	  leaf1 = ip4_fib_mtrie_lookup_step (mtrie1, leaf1, dst_addr1, 3);
+
+	  lb_index0 = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
+	  lb_index1 = ip4_fib_mtrie_leaf_get_adj_index (leaf1);
+	}
+#endif
 
       ASSERT (lb_index0 && lb_index1);
       lb0 = load_balance_get (lb_index0);
@@ -341,6 +496,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 
       b += 2;
       next += 2;
+      lbi += 2;
       n_left -= 2;
     }
 #endif
@@ -348,23 +504,24 @@ ip4_lookup_inline (vlib_main_t * vm,
     {
       ip4_header_t *ip0;
       const load_balance_t *lb0;
-      ip4_fib_mtrie_t *mtrie0;
-      ip4_fib_mtrie_leaf_t leaf0;
+#if !defined (CLIB_HAVE_VEC256)
       ip4_address_t *dst_addr0;
+#endif
       u32 lbi0;
       flow_hash_config_t flow_hash_config0;
       const dpo_id_t *dpo0;
       u32 hash_c0;
 
       ip0 = vlib_buffer_get_current (b[0]);
+#if defined (CLIB_HAVE_VEC256)
+      lbi0 = lbi[0];
+#else
       dst_addr0 = &ip0->dst_address;
       ip_lookup_set_buffer_fib_index (im->fib_index_by_sw_if_index, b[0]);
 
-      mtrie0 = &ip4_fib_get (vnet_buffer (b[0])->ip.fib_index)->mtrie;
-      leaf0 = ip4_fib_mtrie_lookup_step_one (mtrie0, dst_addr0);
-      leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 2);
-      leaf0 = ip4_fib_mtrie_lookup_step (mtrie0, leaf0, dst_addr0, 3);
-      lbi0 = ip4_fib_mtrie_leaf_get_adj_index (leaf0);
+      lbi0 = ip4_fib_forwarding_lookup (vnet_buffer (b[0])->ip.fib_index,
+					dst_addr0);
+#endif
 
       ASSERT (lbi0);
       lb0 = load_balance_get (lbi0);
@@ -399,6 +556,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 
       b += 1;
       next += 1;
+      lbi += 1;
       n_left -= 1;
     }
 
@@ -136,6 +136,12 @@ ip4_input_inline (vlib_main_t * vm,
   u32 last_sw_if_index = ~0;
   u32 cnt = 0;
   int arc_enabled = 0;
+#ifdef IP4_INPUT_CHECK_N_VEC
+  /* the headers are checked in a second pass over the frame */
+  const int check_scalar = 0;
+#else
+  const int check_scalar = 1;
+#endif
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
@@ -227,7 +233,8 @@ ip4_input_inline (vlib_main_t * vm,
       ip[2] = vlib_buffer_get_current (b[2]);
       ip[3] = vlib_buffer_get_current (b[3]);
 
-      ip4_input_check_x4 (vm, error_node, b, ip, next, verify_checksum);
+      if (check_scalar)
+	ip4_input_check_x4 (vm, error_node, b, ip, next, verify_checksum);
 
       /* next */
       b += 4;
@@ -289,8 +296,9 @@ ip4_input_inline (vlib_main_t * vm,
       ip[0] = vlib_buffer_get_current (b[0]);
       ip[1] = vlib_buffer_get_current (b[1]);
 
-      ip4_input_check_x2 (vm, error_node, b[0], b[1], ip[0], ip[1],
-			  &next0, &next1, verify_checksum);
+      if (check_scalar)
+	ip4_input_check_x2 (vm, error_node, b[0], b[1], ip[0], ip[1],
+			    &next0, &next1, verify_checksum);
       next[0] = (u16) next0;
       next[1] = (u16) next1;
 
@@ -310,8 +318,9 @@ ip4_input_inline (vlib_main_t * vm,
 				   &cnt, &arc_enabled);
       next0 = ip4_input_set_next (sw_if_index[0], b[0], arc_enabled);
       ip[0] = vlib_buffer_get_current (b[0]);
-      ip4_input_check_x1 (vm, error_node, b[0], ip[0], &next0,
-			  verify_checksum);
+      if (check_scalar)
+	ip4_input_check_x1 (vm, error_node, b[0], ip[0], &next0,
+			    verify_checksum);
       next[0] = next0;
 
       /* next */
@@ -320,6 +329,35 @@ ip4_input_inline (vlib_main_t * vm,
       n_left_from -= 1;
     }
 
+#ifdef IP4_INPUT_CHECK_N_VEC
+  n_left_from = frame->n_vectors;
+  b = bufs;
+  next = nexts;
+
+  while (n_left_from >= IP4_INPUT_CHECK_N_VEC)
+    {
+      ip4_input_check_vec (vm, error_node, b, next, verify_checksum);
+
+      b += IP4_INPUT_CHECK_N_VEC;
+      next += IP4_INPUT_CHECK_N_VEC;
+      n_left_from -= IP4_INPUT_CHECK_N_VEC;
+    }
+
+  while (n_left_from)
+    {
+      u32 next0 = next[0];
+
+      ip4_input_check_x1 (vm, error_node, b[0],
+			  vlib_buffer_get_current (b[0]), &next0,
+			  verify_checksum);
+      next[0] = next0;
+
+      b += 1;
+      next += 1;
+      n_left_from -= 1;
+    }
+#endif
+
   vlib_increment_simple_counter (cm, thread_index, last_sw_if_index, cnt);
   vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
   return frame->n_vectors;
@@ -323,6 +323,89 @@ ip4_input_check_x1 (vlib_main_t * vm,
     }
 }
 
+/*
+ * Validate the headers of IP4_INPUT_CHECK_N_VEC packets at once.
+ * The words of the headers are transposed, so that each lane holds one
+ * packet, and the version and header length, checksum, TTL, fragment
+ * offset and length are checked in all lanes together. Packets that fail
+ * any check, which are rare, are checked again by the scalar code to
+ * find the exact error and their next node.
+ */
+#if defined (CLIB_HAVE_VEC512)
+#define IP4_INPUT_CHECK_N_VEC 16
+typedef u32x16 ip4_input_check_vec_t;
+#define ip4_input_check_vec_is_all_zero u32x16_is_all_zero
+#elif defined (CLIB_HAVE_VEC256)
+#define IP4_INPUT_CHECK_N_VEC 8
+typedef u32x8 ip4_input_check_vec_t;
+#define ip4_input_check_vec_is_all_zero u32x8_is_all_zero
+#endif
+
+#ifdef IP4_INPUT_CHECK_N_VEC
+static_always_inline void
+ip4_input_check_vec (vlib_main_t * vm,
+		     vlib_node_runtime_t * error_node,
+		     vlib_buffer_t ** b, u16 * next, int verify_checksum)
+{
+  ip4_input_check_vec_t w0, w1, w2, w3, w4, len, buf_len, sum, bad;
+  u32 *ip;
+  int i;
+
+  for (i = 0; i < IP4_INPUT_CHECK_N_VEC; i++)
+    {
+      ip = vlib_buffer_get_current (b[i]);
+      w0[i] = ip[0];
+      w1[i] = ip[1];
+      w2[i] = ip[2];
+      w3[i] = ip[3];
+      w4[i] = ip[4];
+      buf_len[i] = vlib_buffer_length_in_chain (vm, b[i]);
+    }
+
+  /*
+   * The words are in network order, loaded little endian; so the
+   * version and header length is the low byte of the first word, the
+   * length its top two bytes, the TTL the low byte of the third word
+   * and the fragment offset the top two bytes of the second.
+   */
+  bad = (ip4_input_check_vec_t) ((w0 & 0xff) != 0x45);
+  bad |= (ip4_input_check_vec_t) ((w2 & 0xff) == 0);
+  bad |= (ip4_input_check_vec_t)
+    ((((w1 >> 24) | ((w1 >> 8) & 0xff00)) & 0x1fff) == 1);
+
+  len = (w0 >> 24) | ((w0 >> 8) & 0xff00);
+  bad |= (ip4_input_check_vec_t) (len < (u32) sizeof (ip4_header_t));
+  bad |= (ip4_input_check_vec_t) (len > buf_len);
+
+  if (verify_checksum)
+    {
+      /* the ones' complement sum of the header's 16 bit words */
+      sum = (w0 & 0xffff) + (w0 >> 16);
+      sum += (w1 & 0xffff) + (w1 >> 16);
+      sum += (w2 & 0xffff) + (w2 >> 16);
+      sum += (w3 & 0xffff) + (w3 >> 16);
+      sum += (w4 & 0xffff) + (w4 >> 16);
+      sum = (sum & 0xffff) + (sum >> 16);
+      sum = (sum & 0xffff) + (sum >> 16);
+      bad |= (ip4_input_check_vec_t) (sum != 0xffff);
+    }
+
+  if (PREDICT_TRUE (ip4_input_check_vec_is_all_zero (bad)))
+    return;
+
+  for (i = 0; i < IP4_INPUT_CHECK_N_VEC; i++)
+    if (bad[i])
+      {
+	u32 next0 = next[i];
+
+	ip4_input_check_x1 (vm, error_node, b[i],
+			    vlib_buffer_get_current (b[i]), &next0,
+			    verify_checksum);
+	next[i] = next0;
+      }
+}
+#endif
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
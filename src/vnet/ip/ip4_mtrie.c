@@ -176,14 +176,30 @@ ply_create (ip4_fib_mtrie_t * m,
 	    u32 leaf_prefix_len, u32 ply_base_len)
 {
   ip4_fib_mtrie_8_ply_t *p;
-  /* Get cache aligned ply. */
-
+  /* Get cache aligned ply, without moving the pool under the workers. */
+  vlib_epoch_pool_reserve_aligned (ip4_ply_pool, CLIB_CACHE_LINE_BYTES);
   pool_get_aligned (ip4_ply_pool, p, CLIB_CACHE_LINE_BYTES);
 
   ply_8_init (p, init_leaf, leaf_prefix_len, ply_base_len);
   return ip4_fib_mtrie_leaf_set_next_ply_index (p - ip4_ply_pool);
 }
 
+static void
+ply_free (void *data)
+{
+  pool_put_index (ip4_ply_pool, *(u32 *) data);
+}
+
+/*
+ * An unlinked ply may still be walked by the workers until they are
+ * through their current loop, return it to the pool after that.
+ */
+static void
+ply_retire (u32 ply_index)
+{
+  vlib_epoch_call_after_grace (ply_free, &ply_index, sizeof (ply_index));
+}
+
 always_inline ip4_fib_mtrie_8_ply_t *
 get_next_ply_for_leaf (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
 {
@@ -214,6 +230,35 @@ ip4_mtrie_init (ip4_fib_mtrie_t * m)
   ply_16_init (&m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
 }
 
+static void
+ply_flush (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
+{
+  ip4_fib_mtrie_8_ply_t *p;
+  int i;
+
+  p = get_next_ply_for_leaf (m, l);
+
+  for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+    {
+      if (ip4_fib_mtrie_leaf_is_next_ply (p->leaves[i]))
+	ply_flush (m, p->leaves[i]);
+    }
+  ply_retire (ip4_fib_mtrie_leaf_get_next_ply_index (l));
+}
+
+void
+ip4_mtrie_flush (ip4_fib_mtrie_t * m)
+{
+  int i;
+
+  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+    {
+      if (ip4_fib_mtrie_leaf_is_next_ply (m->root_ply.leaves[i]))
+	ply_flush (m, m->root_ply.leaves[i]);
+    }
+  ply_16_init (&m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+}
+
 typedef struct
 {
   ip4_address_t dst_address;
@@ -542,14 +587,17 @@ unset_leaf (ip4_fib_mtrie_t * m,
 				   (a->cover_adj_index));
 	  old_ply->dst_address_bits_of_leaves[i] = a->cover_address_length;
 
+	  /* Next ply was deleted and is now unlinked. */
+	  if (!old_leaf_is_terminal)
+	    ply_retire (ip4_fib_mtrie_leaf_get_next_ply_index (old_leaf));
+
 	  old_ply->n_non_empty_leafs +=
 	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, i);
 
 	  ASSERT (old_ply->n_non_empty_leafs >= 0);
 	  if (old_ply->n_non_empty_leafs == 0 && dst_address_byte_index > 0)
 	    {
-	      pool_put (ip4_ply_pool, old_ply);
-	      /* Old ply was deleted. */
+	      /* Old ply was deleted, the caller unlinks and retires it. */
 	      return 1;
 	    }
 #if CLIB_DEBUG > 0
@@ -613,6 +661,10 @@ unset_root_leaf (ip4_fib_mtrie_t * m,
 				   ip4_fib_mtrie_leaf_set_adj_index
 				   (a->cover_adj_index));
 	  old_ply->dst_address_bits_of_leaves[slot] = a->cover_address_length;
+
+	  /* Next ply was deleted and is now unlinked. */
+	  if (!old_leaf_is_terminal)
+	    ply_retire (ip4_fib_mtrie_leaf_get_next_ply_index (old_leaf));
 	}
     }
 }
@@ -146,6 +146,12 @@ void ip4_mtrie_init (ip4_fib_mtrie_t * m);
  */
 void ip4_mtrie_free (ip4_fib_mtrie_t * m);
 
+/**
+ * @brief Remove all routes from an mtrie. The mtrie must no longer be
+ * visible to the data-plane.
+ */
+void ip4_mtrie_flush (ip4_fib_mtrie_t * m);
+
 /**
  * @brief Add a route/entry to the mtrie
  */
@@ -231,6 +237,88 @@ ip4_fib_mtrie_lookup_step_one (const ip4_fib_mtrie_t * m,
   return next_leaf;
 }
 
+/*
+ * Batched lookups of several addresses in the same mtrie.
+ * Each step gathers the leaves of all the addresses with one instruction,
+ * so the cache misses of the lookups overlap rather than follow each other.
+ * Only the addresses that have not yet reached a terminal leaf load from
+ * the next ply and the later steps are skipped once all have.
+ *
+ * The addresses are in network order, as read from the packets, so on
+ * these (little endian) CPUs the first 2 bytes are the low 16 bits.
+ * A ply is addressed as the index of its first leaf in the ply pool,
+ * so the pool is limited to 2^31 leaves, i.e. ~6.4 million plys.
+ */
+#define IP4_FIB_MTRIE_PLY_N_U32 \
+  (sizeof (ip4_fib_mtrie_8_ply_t) / sizeof (ip4_fib_mtrie_leaf_t))
+
+#ifdef CLIB_HAVE_VEC256
+/**
+ * @brief Lookup 8 addresses. Returns the LB indices.
+ */
+always_inline u32x8
+ip4_fib_mtrie_lookup_x8 (const ip4_fib_mtrie_t * m, u32x8 dst_addresses)
+{
+  const u32x8 one = u32x8_splat (1);
+  u32x8 leaf, non_terminal;
+
+  leaf = u32x8_gather_u32 (m->root_ply.leaves, dst_addresses & 0xffff);
+
+  /* all ones in the lanes that hold a ply index */
+  non_terminal = (leaf & one) - one;
+
+  if (!u32x8_is_all_zero (non_terminal))
+    {
+      leaf = u32x8_mask_gather_u32 (leaf, ip4_ply_pool->leaves,
+				    (leaf >> 1) * IP4_FIB_MTRIE_PLY_N_U32 +
+				    ((dst_addresses >> 16) & 0xff),
+				    non_terminal);
+      non_terminal = (leaf & one) - one;
+
+      if (!u32x8_is_all_zero (non_terminal))
+	leaf = u32x8_mask_gather_u32 (leaf, ip4_ply_pool->leaves,
+				      (leaf >> 1) * IP4_FIB_MTRIE_PLY_N_U32 +
+				      (dst_addresses >> 24), non_terminal);
+    }
+
+  return (leaf >> 1);
+}
+#endif
+
+#ifdef CLIB_HAVE_VEC512
+/**
+ * @brief Lookup 16 addresses. Returns the LB indices.
+ */
+always_inline u32x16
+ip4_fib_mtrie_lookup_x16 (const ip4_fib_mtrie_t * m, u32x16 dst_addresses)
+{
+  const u32x16 one = u32x16_splat (1);
+  u32x16 leaf;
+  u16 non_terminal;
+
+  leaf = u32x16_gather_u32 (m->root_ply.leaves, dst_addresses & 0xffff);
+
+  /* the lanes that hold a ply index */
+  non_terminal = ~u32x16_is_zero_mask (leaf & one);
+
+  if (non_terminal)
+    {
+      leaf = u32x16_mask_gather_u32 (leaf, ip4_ply_pool->leaves,
+				     (leaf >> 1) * IP4_FIB_MTRIE_PLY_N_U32 +
+				     ((dst_addresses >> 16) & 0xff),
+				     non_terminal);
+      non_terminal = ~u32x16_is_zero_mask (leaf & one);
+
+      if (non_terminal)
+	leaf = u32x16_mask_gather_u32 (leaf, ip4_ply_pool->leaves,
+				       (leaf >> 1) * IP4_FIB_MTRIE_PLY_N_U32 +
+				       (dst_addresses >> 24), non_terminal);
+    }
+
+  return (leaf >> 1);
+}
+#endif
+
 #endif /* included_ip_ip4_fib_h */
 
 /*
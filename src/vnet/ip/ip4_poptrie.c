@@ -0,0 +1,538 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip4_poptrie.h>
+
+/**
+ * Global pool of subtrees
+ */
+ip4_poptrie_subtree_t *ip4_poptrie_subtree_pool;
+
+/**
+ * Scratch state while building a subtree's block
+ */
+typedef struct ip4_poptrie_builder_t_
+{
+  ip4_poptrie_node_t *nodes;
+  u32 *leaves;
+} ip4_poptrie_builder_t;
+
+always_inline u32
+ip4_poptrie_stride (u32 depth)
+{
+  return (depth < 12 ? 6 : 4);
+}
+
+/*
+ * Does the route cover the 'end' bit long slot prefix 'sv'.
+ * The route must be no longer than the slot prefix.
+ */
+always_inline int
+ip4_poptrie_route_covers (const ip4_poptrie_route_t * r, u32 sv, u32 end)
+{
+  return ((sv >> (end - r->len)) == (r->addr >> (16 - r->len)));
+}
+
+/*
+ * Build node 'ni', which covers the 'depth' bit long prefix 'prefix' of
+ * the subtree, from the routes that are longer than 'depth' and below
+ * the prefix. The node's children are allocated together before any of
+ * them is built, so that they are contiguous and indexed from base1.
+ */
+static void
+ip4_poptrie_build_node (ip4_poptrie_builder_t * b,
+			u32 ni,
+			u32 prefix,
+			u32 depth, u32 dflt, const ip4_poptrie_route_t * routes)
+{
+  u32 stride, end, n_slots, best[64], best_len, sv, i, last, base1;
+  const ip4_poptrie_route_t *r;
+  ip4_poptrie_route_t *child_routes;
+  u64 vector = 0, leafvec = 0;
+
+  stride = ip4_poptrie_stride (depth);
+  end = depth + stride;
+  n_slots = 1 << stride;
+
+  for (i = 0; i < n_slots; i++)
+    {
+      sv = (prefix << stride) | i;
+      best[i] = dflt;
+      best_len = 0;
+
+      vec_foreach (r, routes)
+      {
+	if (r->len <= end)
+	  {
+	    if (r->len > best_len && ip4_poptrie_route_covers (r, sv, end))
+	      {
+		best[i] = r->lb_index;
+		best_len = r->len;
+	      }
+	  }
+	else if ((r->addr >> (16 - end)) == sv)
+	  vector |= 1ULL << i;
+      }
+    }
+
+  /*
+   * One leaf per run of identical leaf slots. The child slots in between
+   * do not break a run.
+   */
+  b->nodes[ni].base0 = vec_len (b->leaves);
+  last = IP4_POPTRIE_LEAF_COVER;
+  for (i = 0; i < n_slots; i++)
+    {
+      if (vector & (1ULL << i))
+	continue;
+      if (0 == leafvec || best[i] != last)
+	{
+	  vec_add1 (b->leaves, best[i]);
+	  leafvec |= 1ULL << i;
+	  last = best[i];
+	}
+    }
+
+  base1 = vec_len (b->nodes);
+  b->nodes[ni].vector = vector;
+  b->nodes[ni].leafvec = leafvec;
+  b->nodes[ni].base1 = base1;
+
+  if (0 == vector)
+    return;
+
+  vec_validate (b->nodes, base1 + count_set_bits (vector) - 1);
+
+  child_routes = NULL;
+  for (i = 0; i < n_slots; i++)
+    {
+      if (!(vector & (1ULL << i)))
+	continue;
+
+      sv = (prefix << stride) | i;
+      vec_reset_length (child_routes);
+      vec_foreach (r, routes)
+      {
+	if (r->len > end && (r->addr >> (16 - end)) == sv)
+	  vec_add1 (child_routes, *r);
+      }
+      ip4_poptrie_build_node (b, base1++, sv, end, best[i], child_routes);
+    }
+  vec_free (child_routes);
+}
+
+static uword
+ip4_poptrie_block_bytes (const ip4_poptrie_block_t * blk)
+{
+  return (sizeof (*blk) +
+	  blk->n_nodes * sizeof (blk->nodes[0]) +
+	  blk->n_leaves * sizeof (blk->leaves[0]));
+}
+
+static ip4_poptrie_block_t *
+ip4_poptrie_block_build (const ip4_poptrie_route_t * routes)
+{
+  ip4_poptrie_builder_t b = { 0 };
+  ip4_poptrie_block_t *blk;
+  u32 n_nodes, n_leaves;
+
+  vec_validate (b.nodes, 0);
+  ip4_poptrie_build_node (&b, 0, 0, 0, IP4_POPTRIE_LEAF_COVER, routes);
+
+  n_nodes = vec_len (b.nodes);
+  n_leaves = vec_len (b.leaves);
+
+  blk = clib_mem_alloc_aligned (sizeof (*blk) +
+				n_nodes * sizeof (b.nodes[0]) +
+				n_leaves * sizeof (b.leaves[0]),
+				CLIB_CACHE_LINE_BYTES);
+  blk->n_nodes = n_nodes;
+  blk->n_leaves = n_leaves;
+  blk->leaves = (u32 *) (blk->nodes + n_nodes);
+  clib_memcpy_fast (blk->nodes, b.nodes, n_nodes * sizeof (b.nodes[0]));
+  clib_memcpy_fast (blk->leaves, b.leaves, n_leaves * sizeof (b.leaves[0]));
+
+  vec_free (b.nodes);
+  vec_free (b.leaves);
+
+  return (blk);
+}
+
+/*
+ * Build a subtree from the routes and publish it in the root slot. A
+ * subtree is never modified once published, other than its cover, so a
+ * change to the routes builds a new one to replace the old.
+ */
+static void
+ip4_poptrie_subtree_publish (ip4_poptrie_t * p,
+			     u32 slot, u32 cover, ip4_poptrie_route_t * routes)
+{
+  ip4_poptrie_subtree_t *st;
+
+  /* Get a subtree, without moving the pool under the workers. */
+  vlib_epoch_pool_reserve_aligned (ip4_poptrie_subtree_pool,
+				   CLIB_CACHE_LINE_BYTES);
+  pool_get_aligned_zero (ip4_poptrie_subtree_pool, st,
+			 CLIB_CACHE_LINE_BYTES);
+
+  st->block = ip4_poptrie_block_build (routes);
+  st->root = st->block->nodes[0];
+  st->cover = cover;
+  st->routes = routes;
+  p->n_block_bytes += ip4_poptrie_block_bytes (st->block);
+
+  clib_atomic_store_rel_n (&p->root[slot],
+			   2 * (st - ip4_poptrie_subtree_pool));
+}
+
+static void
+ip4_poptrie_subtree_free (void *data)
+{
+  pool_put_index (ip4_poptrie_subtree_pool, *(u32 *) data);
+}
+
+/*
+ * An unlinked subtree may still be walked by the workers until they are
+ * through their current loop, free it after that.
+ */
+static void
+ip4_poptrie_subtree_retire (ip4_poptrie_t * p, u32 sti, int free_routes)
+{
+  ip4_poptrie_subtree_t *st;
+
+  st = pool_elt_at_index (ip4_poptrie_subtree_pool, sti);
+
+  p->n_block_bytes -= ip4_poptrie_block_bytes (st->block);
+
+  vlib_epoch_mem_free (st->block);
+  if (free_routes)
+    vec_free (st->routes);
+  vlib_epoch_call_after_grace (ip4_poptrie_subtree_free, &sti, sizeof (sti));
+}
+
+ip4_poptrie_t *
+ip4_poptrie_create (void)
+{
+  ip4_poptrie_t *p;
+  int i;
+
+  p = clib_mem_alloc_aligned (sizeof (*p), CLIB_CACHE_LINE_BYTES);
+  clib_memset (p, 0, sizeof (*p));
+
+  for (i = 0; i < ARRAY_LEN (p->root); i++)
+    p->root[i] = IP4_POPTRIE_LEAF_EMPTY;
+
+  return (p);
+}
+
+void
+ip4_poptrie_free (ip4_poptrie_t * p)
+{
+  int i;
+
+  for (i = 0; i < ARRAY_LEN (p->root); i++)
+    {
+      if (!ip4_poptrie_leaf_is_terminal (p->root[i]))
+	ip4_poptrie_subtree_retire (p, p->root[i] >> 1, 1);
+    }
+  clib_bitmap_free (p->batch_slots);
+  vlib_epoch_mem_free (p);
+}
+
+void
+ip4_poptrie_batch_begin (ip4_poptrie_t * p)
+{
+  p->batch_depth++;
+}
+
+void
+ip4_poptrie_batch_end (ip4_poptrie_t * p)
+{
+  ip4_poptrie_subtree_t *st;
+  ip4_poptrie_leaf_t l;
+  u32 slot;
+
+  /* the poptrie may have been created within the batch */
+  if (0 == p->batch_depth || --p->batch_depth)
+    return;
+
+  /* *INDENT-OFF* */
+  clib_bitmap_foreach (slot, p->batch_slots)
+    {
+      l = p->root[slot];
+
+      /* the subtree's routes may since have all been removed */
+      if (ip4_poptrie_leaf_is_terminal (l))
+	continue;
+
+      st = pool_elt_at_index (ip4_poptrie_subtree_pool, l >> 1);
+      ip4_poptrie_subtree_publish (p, slot, st->cover, st->routes);
+      ip4_poptrie_subtree_retire (p, l >> 1, 0);
+    }
+  /* *INDENT-ON* */
+
+  clib_bitmap_zero (p->batch_slots);
+}
+
+static ip4_poptrie_route_t *
+ip4_poptrie_subtree_find (ip4_poptrie_subtree_t * st,
+			  const ip4_poptrie_route_t * r)
+{
+  ip4_poptrie_route_t *sr;
+
+  vec_foreach (sr, st->routes)
+  {
+    if (sr->addr == r->addr && sr->len == r->len)
+      return (sr);
+  }
+  return (NULL);
+}
+
+always_inline void
+ip4_poptrie_mk_route (ip4_poptrie_route_t * r, u32 a, u32 len, u32 lb_index)
+{
+  r->addr = (a & ((u32) ~0 << (32 - len))) & 0xffff;
+  r->len = len - 16;
+  r->lb_index = lb_index;
+}
+
+void
+ip4_poptrie_route_add (ip4_poptrie_t * p,
+		       const ip4_address_t * dst_address,
+		       u32 dst_address_length, u32 lb_index)
+{
+  ip4_poptrie_route_t r, *sr, *routes;
+  ip4_poptrie_subtree_t *st;
+  ip4_poptrie_leaf_t l;
+  u32 a, slot, n_slots;
+
+  ASSERT (dst_address_length <= 32);
+  a = clib_net_to_host_u32 (dst_address->as_u32);
+
+  if (dst_address_length <= 16)
+    {
+      n_slots = 1 << (16 - dst_address_length);
+      slot = (a >> 16) & ~(n_slots - 1);
+
+      for (; n_slots > 0; n_slots--, slot++)
+	{
+	  /* a more specific route already occupies the slot */
+	  if (p->root_len[slot] > dst_address_length)
+	    continue;
+
+	  p->root_len[slot] = dst_address_length;
+	  l = p->root[slot];
+
+	  if (ip4_poptrie_leaf_is_terminal (l))
+	    clib_atomic_store_rel_n (&p->root[slot], 1 + 2 * lb_index);
+	  else
+	    clib_atomic_store_rel_n (&ip4_poptrie_subtree_pool[l >> 1].cover,
+				     lb_index);
+	}
+      return;
+    }
+
+  slot = a >> 16;
+  l = p->root[slot];
+  ip4_poptrie_mk_route (&r, a, dst_address_length, lb_index);
+
+  if (ip4_poptrie_leaf_is_terminal (l))
+    {
+      routes = NULL;
+      vec_add1 (routes, r);
+      ip4_poptrie_subtree_publish (p, slot, l >> 1, routes);
+      p->n_subtrees++;
+      return;
+    }
+
+  st = pool_elt_at_index (ip4_poptrie_subtree_pool, l >> 1);
+  sr = ip4_poptrie_subtree_find (st, &r);
+
+  if (sr)
+    sr->lb_index = lb_index;
+  else
+    vec_add1 (st->routes, r);
+
+  /* in a batch the subtree is rebuilt once, when the batch ends */
+  if (p->batch_depth)
+    {
+      p->batch_slots = clib_bitmap_set (p->batch_slots, slot, 1);
+      return;
+    }
+
+  /* the replacement takes over the route list */
+  ip4_poptrie_subtree_publish (p, slot, st->cover, st->routes);
+  ip4_poptrie_subtree_retire (p, l >> 1, 0);
+}
+
+void
+ip4_poptrie_route_del (ip4_poptrie_t * p,
+		       const ip4_address_t * dst_address,
+		       u32 dst_address_length,
+		       u32 lb_index,
+		       u32 cover_address_length, u32 cover_lb_index)
+{
+  ip4_poptrie_subtree_t *st;
+  ip4_poptrie_route_t r, *sr;
+  ip4_poptrie_leaf_t l;
+  u32 a, slot, n_slots;
+
+  ASSERT (dst_address_length <= 32);
+  a = clib_net_to_host_u32 (dst_address->as_u32);
+
+  if (dst_address_length <= 16)
+    {
+      n_slots = 1 << (16 - dst_address_length);
+      slot = (a >> 16) & ~(n_slots - 1);
+
+      for (; n_slots > 0; n_slots--, slot++)
+	{
+	  /* only the slots this route occupies revert to the cover */
+	  if (p->root_len[slot] != dst_address_length)
+	    continue;
+
+	  p->root_len[slot] = cover_address_length;
+	  l = p->root[slot];
+
+	  if (ip4_poptrie_leaf_is_terminal (l))
+	    clib_atomic_store_rel_n (&p->root[slot], 1 + 2 * cover_lb_index);
+	  else
+	    clib_atomic_store_rel_n (&ip4_poptrie_subtree_pool[l >> 1].cover,
+				     cover_lb_index);
+	}
+      return;
+    }
+
+  slot = a >> 16;
+  l = p->root[slot];
+
+  if (ip4_poptrie_leaf_is_terminal (l))
+    return;
+
+  st = pool_elt_at_index (ip4_poptrie_subtree_pool, l >> 1);
+  ip4_poptrie_mk_route (&r, a, dst_address_length, lb_index);
+  sr = ip4_poptrie_subtree_find (st, &r);
+
+  if (NULL == sr)
+    return;
+
+  vec_del1 (st->routes, sr - st->routes);
+
+  if (0 == vec_len (st->routes))
+    {
+      clib_atomic_store_rel_n (&p->root[slot], 1 + 2 * st->cover);
+      ip4_poptrie_subtree_retire (p, l >> 1, 1);
+      p->n_subtrees--;
+    }
+  else
+    {
+      /*
+       * not deferred in a batch, lookups must not find a removed route's
+       * load-balance once it is freed.
+       */
+      ip4_poptrie_subtree_publish (p, slot, st->cover, st->routes);
+      ip4_poptrie_subtree_retire (p, l >> 1, 0);
+    }
+}
+
+uword
+ip4_poptrie_memory_usage (ip4_poptrie_t * p)
+{
+  ip4_poptrie_subtree_t *st;
+  uword bytes, i;
+
+  bytes = sizeof (*p) + p->n_block_bytes;
+  for (i = 0; i < ARRAY_LEN (p->root); i++)
+    {
+      if (ip4_poptrie_leaf_is_terminal (p->root[i]))
+	continue;
+
+      st = pool_elt_at_index (ip4_poptrie_subtree_pool, p->root[i] >> 1);
+      bytes += sizeof (*st) + vec_len (st->routes) * sizeof (st->routes[0]);
+    }
+
+  return bytes;
+}
+
+u8 *
+format_ip4_poptrie (u8 * s, va_list * va)
+{
+  ip4_poptrie_t *p = va_arg (*va, ip4_poptrie_t *);
+  int verbose = va_arg (*va, int);
+  ip4_poptrie_route_t *r;
+  ip4_poptrie_subtree_t *st;
+  u32 i, n_nodes, n_leaves;
+  ip4_address_t ia;
+
+  n_nodes = n_leaves = 0;
+  for (i = 0; i < ARRAY_LEN (p->root); i++)
+    {
+      if (ip4_poptrie_leaf_is_terminal (p->root[i]))
+	continue;
+
+      st = pool_elt_at_index (ip4_poptrie_subtree_pool, p->root[i] >> 1);
+      n_nodes += st->block->n_nodes;
+      n_leaves += st->block->n_leaves;
+    }
+
+  s = format (s, "%d subtrees, %d nodes, %d leaves, memory usage %U\n",
+	      p->n_subtrees, n_nodes, n_leaves,
+	      format_memory_size, ip4_poptrie_memory_usage (p));
+
+  if (verbose)
+    {
+      s = format (s, "root");
+
+      for (i = 0; i < ARRAY_LEN (p->root); i++)
+	{
+	  ia.as_u32 = clib_host_to_net_u32 (i << 16);
+
+	  if (ip4_poptrie_leaf_is_terminal (p->root[i]))
+	    {
+	      if (p->root_len[i] > 0)
+		s = format (s, "\n    %U lb-index %d",
+			    format_ip4_address_and_length, &ia,
+			    p->root_len[i], p->root[i] >> 1);
+	      continue;
+	    }
+
+	  st = pool_elt_at_index (ip4_poptrie_subtree_pool, p->root[i] >> 1);
+	  s = format (s, "\n    %U cover lb-index %d, subtree %d, "
+		      "%d nodes, %d leaves",
+		      format_ip4_address_and_length, &ia, p->root_len[i],
+		      st->cover, p->root[i] >> 1,
+		      st->block->n_nodes, st->block->n_leaves);
+
+	  vec_foreach (r, st->routes)
+	  {
+	    ia.as_u32 = clib_host_to_net_u32 ((i << 16) | r->addr);
+	    s = format (s, "\n        %U lb-index %d",
+			format_ip4_address_and_length, &ia,
+			r->len + 16, r->lb_index);
+	  }
+	}
+    }
+
+  return s;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_ip_ip4_poptrie_h
+#define included_ip_ip4_poptrie_h
+
+#include <vppinfra/cache.h>
+#include <vppinfra/bitops.h>
+#include <vnet/ip/ip4_packet.h>	/* for ip4_address_t */
+
+/**
+ * @brief An IPv4 poptrie.
+ *
+ * A 16 bit direct-pointing root followed, for each /16 that holds more
+ * specific routes, by a subtree of bitmap compressed nodes with strides
+ * of 6, 6 and 4 bits. Each node holds two 64 bit vectors; 'vector' marks
+ * the slots that descend into a child node and 'leafvec' marks the slots
+ * that start a new run of identical leaves. The index of a slot's child
+ * or leaf is the population count of the vector below (and including)
+ * that slot, so identical neighbouring leaves are stored once and no
+ * empty slots are stored at all.
+ *
+ * The data-plane part of each subtree is one contiguous block. On every
+ * change a new subtree is built from the route list and swapped into the
+ * root slot atomically; the previous one is freed after an epoch grace
+ * period.
+ *
+ * Root slots use the same encoding as the mtrie:
+ *   1 + 2*lb_index for terminal leaves.
+ *   0 + 2*subtree_index for non-terminals.
+ */
+typedef u32 ip4_poptrie_leaf_t;
+
+#define IP4_POPTRIE_LEAF_EMPTY (1 + 2*0)
+
+/**
+ * A leaf in a subtree that is not covered by any of the subtree's routes
+ * takes its value from the subtree's cover, i.e. the root slot's route.
+ */
+#define IP4_POPTRIE_LEAF_COVER (~0)
+
+#define IP4_POPTRIE_ROOT_SIZE (1<<16)
+
+/**
+ * @brief One node of a subtree
+ */
+typedef struct ip4_poptrie_node_t_
+{
+  /** Slots that descend to a child node */
+  u64 vector;
+  /** Slots that start a run of identical leaves */
+  u64 leafvec;
+  /** Index of the node's first leaf in the block's leaves */
+  u32 base0;
+  /** Index of the node's first child in the block's nodes */
+  u32 base1;
+} ip4_poptrie_node_t;
+
+/**
+ * @brief The data-plane representation of a subtree.
+ * Nodes, with the subtree root first, followed by the leaves.
+ */
+typedef struct ip4_poptrie_block_t_
+{
+  u32 n_nodes;
+  u32 n_leaves;
+  u32 *leaves;
+  ip4_poptrie_node_t nodes[0];
+} ip4_poptrie_block_t;
+
+/**
+ * @brief A route within a subtree, i.e. one longer than 16 bits
+ */
+typedef struct ip4_poptrie_route_t_
+{
+  /** The low 16 bits of the address, in host order */
+  u16 addr;
+  /** Length relative to the /16, so 1 to 16 */
+  u8 len;
+  u32 lb_index;
+} ip4_poptrie_route_t;
+
+/**
+ * @brief The subtree below one root slot
+ */
+typedef struct ip4_poptrie_subtree_t_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /**
+   * Data-plane. A copy of the block's first node, so a lookup that
+   * descends finds it in the same cacheline as the block pointer, and
+   * the value for uncovered leaves.
+   */
+  ip4_poptrie_node_t root;
+  ip4_poptrie_block_t *block;
+  u32 cover;
+
+  /** Control-plane. The routes the block is built from */
+  ip4_poptrie_route_t *routes;
+} ip4_poptrie_subtree_t;
+
+typedef struct ip4_poptrie_t_
+{
+  /**
+   * The direct-pointing root, indexed by the top 16 bits of the host
+   * order address.
+   */
+  ip4_poptrie_leaf_t root[IP4_POPTRIE_ROOT_SIZE];
+
+  /**
+   * Prefix length of the route in each root slot.
+   */
+  u8 root_len[IP4_POPTRIE_ROOT_SIZE];
+
+  /**
+   * Number of subtrees and the bytes used by their blocks.
+   */
+  u32 n_subtrees;
+  uword n_block_bytes;
+
+  /**
+   * The depth of nested batches of updates and the root slots whose
+   * subtree is to be rebuilt at the end of the batch.
+   */
+  u32 batch_depth;
+  uword *batch_slots;
+} ip4_poptrie_t;
+
+/**
+ * @brief Create an empty poptrie
+ */
+ip4_poptrie_t *ip4_poptrie_create (void);
+
+/**
+ * @brief Free a poptrie, all of its subtrees and its routes
+ */
+void ip4_poptrie_free (ip4_poptrie_t * p);
+
+/**
+ * @brief Add a route/entry to the poptrie
+ */
+void ip4_poptrie_route_add (ip4_poptrie_t * p,
+			    const ip4_address_t * dst_address,
+			    u32 dst_address_length, u32 lb_index);
+/**
+ * @brief remove a route/entry from the poptrie
+ */
+void ip4_poptrie_route_del (ip4_poptrie_t * p,
+			    const ip4_address_t * dst_address,
+			    u32 dst_address_length,
+			    u32 lb_index,
+			    u32 cover_address_length, u32 cover_lb_index);
+
+/**
+ * @brief Begin a batch of updates. Until the batch ends a change to a
+ * subtree's routes does not rebuild the subtree, and lookups find the
+ * subtree as it was before the batch.
+ */
+void ip4_poptrie_batch_begin (ip4_poptrie_t * p);
+
+/**
+ * @brief End a batch of updates, rebuilding each changed subtree once.
+ */
+void ip4_poptrie_batch_end (ip4_poptrie_t * p);
+
+/**
+ * @brief return the memory used by the table
+ */
+uword ip4_poptrie_memory_usage (ip4_poptrie_t * p);
+
+/**
+ * @brief Format/display the contents of the poptrie
+ */
+format_function_t format_ip4_poptrie;
+
+/**
+ * @brief A global pool of subtrees
+ */
+extern ip4_poptrie_subtree_t *ip4_poptrie_subtree_pool;
+
+always_inline u32
+ip4_poptrie_leaf_is_terminal (ip4_poptrie_leaf_t l)
+{
+  return l & 1;
+}
+
+/**
+ * Index of the bit for slot 'i' in a node's vector, counting the bits
+ * of the vector at and below the slot.
+ */
+always_inline u32
+ip4_poptrie_popcount (u64 v, u32 i)
+{
+  return count_set_bits (v & ((2ULL << i) - 1));
+}
+
+/**
+ * @brief Lookup in a subtree, 'a' being the host order address.
+ */
+always_inline u32
+ip4_poptrie_subtree_lookup (const ip4_poptrie_subtree_t * st, u32 a)
+{
+  const ip4_poptrie_block_t *b;
+  const ip4_poptrie_node_t *n;
+  u32 i, l;
+
+  b = st->block;
+  n = &st->root;
+
+  i = (a >> 10) & 0x3f;
+  if (n->vector & (1ULL << i))
+    {
+      n = b->nodes + n->base1 + ip4_poptrie_popcount (n->vector, i) - 1;
+      i = (a >> 4) & 0x3f;
+      if (n->vector & (1ULL << i))
+	{
+	  n = b->nodes + n->base1 + ip4_poptrie_popcount (n->vector, i) - 1;
+	  i = a & 0xf;
+	}
+    }
+  l = b->leaves[n->base0 + ip4_poptrie_popcount (n->leafvec, i) - 1];
+
+  return (l == IP4_POPTRIE_LEAF_COVER ? st->cover : l);
+}
+
+/**
+ * @brief Lookup the load-balance index for the address
+ */
+always_inline u32
+ip4_poptrie_lookup (const ip4_poptrie_t * p,
+		    const ip4_address_t * dst_address)
+{
+  ip4_poptrie_leaf_t l;
+  u32 a;
+
+  a = clib_net_to_host_u32 (dst_address->as_u32);
+  l = p->root[a >> 16];
+
+  if (PREDICT_TRUE (ip4_poptrie_leaf_is_terminal (l)))
+    return (l >> 1);
+
+  return (ip4_poptrie_subtree_lookup (ip4_poptrie_subtree_pool + (l >> 1),
+				      a));
+}
+
+#endif /* included_ip_ip4_poptrie_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -50,6 +50,7 @@
 #include <vnet/ip/lookup.h>
 #include <vnet/ip/ip_interface.h>
 #include <vnet/ip/ip_flow_hash.h>
+#include <vnet/ip/ip6_tree_bitmap.h>
 
 typedef struct
 {
@@ -68,6 +69,12 @@ typedef struct
 
   /* Index into FIB vector. */
   u32 index;
+
+  /*
+   * Tree bitmap for forwarding lookups. When set it is used in place of
+   * the forwarding hash, which is still maintained.
+   */
+  ip6_tree_bitmap_t *tree_bitmap;
 } ip6_fib_t;
 
 typedef struct ip6_mfib_t
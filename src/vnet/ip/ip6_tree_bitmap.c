@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/ip/ip.h>
+#include <vnet/ip/ip6_tree_bitmap.h>
+
+u64 ip6_tree_bitmap_internal_masks[64];
+
+/*
+ * The 6 bits of the key that index the node at 'depth'. Those past the
+ * end of the address, in the last node, are zero.
+ */
+always_inline u32
+ip6_tree_bitmap_slot (u128 key, u32 depth)
+{
+  return ((key << (depth * IP6_TREE_BITMAP_STRIDE)) >>
+	  (128 - IP6_TREE_BITMAP_STRIDE));
+}
+
+/*
+ * The internal bit of the prefix of relative length 'rel' in the node
+ * whose 6 bits are 's'.
+ */
+always_inline u32
+ip6_tree_bitmap_internal_bit (u32 s, u32 rel)
+{
+  return ((1 << rel) - 1 + (s >> (IP6_TREE_BITMAP_STRIDE - rel)));
+}
+
+static ip6_tree_bitmap_node_t *
+ip6_tree_bitmap_nodes_alloc (u32 n)
+{
+  return (clib_mem_alloc_aligned (n * sizeof (ip6_tree_bitmap_node_t),
+				  sizeof (ip6_tree_bitmap_node_t)));
+}
+
+/*
+ * A copy of the array of 'n' elements 'old', with 'elt' inserted at
+ * 'i', so of n+1 elements.
+ */
+static void *
+ip6_tree_bitmap_array_insert (const void *old, u32 n, u32 i,
+			      const void *elt, u32 size)
+{
+  u8 *new;
+
+  new = clib_mem_alloc_aligned ((n + 1) * size, size);
+
+  if (i)
+    clib_memcpy_fast (new, old, i * size);
+  clib_memcpy_fast (new + i * size, elt, size);
+  if (n - i)
+    clib_memcpy_fast (new + (i + 1) * size, (u8 *) old + i * size,
+		      (n - i) * size);
+
+  return (new);
+}
+
+/*
+ * A copy of the array of 'n' elements 'old', without the element at 'i',
+ * so of n-1 elements, or NULL once empty.
+ */
+static void *
+ip6_tree_bitmap_array_delete (const void *old, u32 n, u32 i, u32 size)
+{
+  u8 *new;
+
+  if (1 == n)
+    return (NULL);
+
+  new = clib_mem_alloc_aligned ((n - 1) * size, size);
+
+  if (i)
+    clib_memcpy_fast (new, old, i * size);
+  if (n - i - 1)
+    clib_memcpy_fast (new + i * size, (u8 *) old + (i + 1) * size,
+		      (n - i - 1) * size);
+
+  return (new);
+}
+
+/*
+ * Publish a new value for the node at 'depth' on the path. The array of
+ * it and its siblings is copied, and the copy swapped into the parent.
+ */
+static void
+ip6_tree_bitmap_node_replace (ip6_tree_bitmap_t * t,
+			      ip6_tree_bitmap_node_t ** path,
+			      u32 depth, const ip6_tree_bitmap_node_t * nv)
+{
+  ip6_tree_bitmap_node_t **holder, *old, *new;
+  u32 n, i;
+
+  if (0 == depth)
+    {
+      holder = &t->root;
+      n = 1;
+    }
+  else
+    {
+      holder = &path[depth - 1]->children;
+      n = count_set_bits (path[depth - 1]->external);
+    }
+  old = *holder;
+  i = path[depth] - old;
+
+  new = ip6_tree_bitmap_nodes_alloc (n);
+  clib_memcpy_fast (new, old, n * sizeof (*new));
+  new[i] = *nv;
+
+  clib_atomic_store_rel_n (holder, new);
+  vlib_epoch_mem_free (old);
+}
+
+/*
+ * Walk down the tree as far as the key and its length allow. Returns the
+ * depth reached, with the nodes to it in 'path'.
+ */
+static u32
+ip6_tree_bitmap_descend (ip6_tree_bitmap_t * t,
+			 u128 key, u32 depth_max,
+			 ip6_tree_bitmap_node_t ** path)
+{
+  ip6_tree_bitmap_node_t *n;
+  u32 depth;
+  u64 bit;
+
+  n = path[0] = t->root;
+
+  for (depth = 0; depth < depth_max; depth++)
+    {
+      bit = 1ULL << ip6_tree_bitmap_slot (key, depth);
+
+      if (!(n->external & bit))
+	break;
+
+      n = n->children + count_set_bits (n->external & (bit - 1));
+      path[depth + 1] = n;
+    }
+
+  return (depth);
+}
+
+void
+ip6_tree_bitmap_route_add (ip6_tree_bitmap_t * t,
+			   const ip6_address_t * dst_address,
+			   u32 dst_address_length, u32 lb_index)
+{
+  ip6_tree_bitmap_node_t *path[IP6_TREE_BITMAP_MAX_DEPTH + 1];
+  ip6_tree_bitmap_node_t *n, nv, child;
+  u32 depth, depth_max, rel, i;
+  u64 pos;
+  u128 key;
+
+  ASSERT (dst_address_length <= 128);
+
+  key = ip6_tree_bitmap_key (dst_address);
+  depth_max = dst_address_length / IP6_TREE_BITMAP_STRIDE;
+  rel = dst_address_length % IP6_TREE_BITMAP_STRIDE;
+  pos = 1ULL << ip6_tree_bitmap_internal_bit (ip6_tree_bitmap_slot (key,
+								     depth_max),
+					      rel);
+
+  depth = ip6_tree_bitmap_descend (t, key, depth_max, path);
+  n = path[depth];
+
+  if (depth == depth_max)
+    {
+      i = count_set_bits (n->internal & (pos - 1));
+
+      if (n->internal & pos)
+	{
+	  /* an update of an existing route */
+	  clib_atomic_store_rel_n (&n->results[i], lb_index);
+	  return;
+	}
+
+      nv = *n;
+      nv.internal |= pos;
+      nv.results = ip6_tree_bitmap_array_insert (n->results,
+						 count_set_bits (n->internal),
+						 i, &lb_index,
+						 sizeof (lb_index));
+      ip6_tree_bitmap_node_replace (t, path, depth, &nv);
+      vlib_epoch_mem_free (n->results);
+      t->n_routes++;
+      return;
+    }
+
+  /*
+   * build the chain of nodes from the deepest that exists down to the
+   * route, out of sight of the workers, then link it in.
+   */
+  clib_memset (&child, 0, sizeof (child));
+  child.internal = pos;
+  child.results = clib_mem_alloc (sizeof (lb_index));
+  child.results[0] = lb_index;
+  t->n_nodes++;
+  t->n_routes++;
+
+  for (i = depth_max; i > depth + 1; i--)
+    {
+      ip6_tree_bitmap_node_t parent = {
+	.external = 1ULL << ip6_tree_bitmap_slot (key, i - 1),
+	.children = ip6_tree_bitmap_nodes_alloc (1),
+      };
+
+      parent.children[0] = child;
+      child = parent;
+      t->n_nodes++;
+    }
+
+  pos = 1ULL << ip6_tree_bitmap_slot (key, depth);
+  nv = *n;
+  nv.external |= pos;
+  nv.children = ip6_tree_bitmap_array_insert (n->children,
+					      count_set_bits (n->external),
+					      count_set_bits (n->external &
+							      (pos - 1)),
+					      &child, sizeof (child));
+  ip6_tree_bitmap_node_replace (t, path, depth, &nv);
+  vlib_epoch_mem_free (n->children);
+}
+
+void
+ip6_tree_bitmap_route_del (ip6_tree_bitmap_t * t,
+			   const ip6_address_t * dst_address,
+			   u32 dst_address_length)
+{
+  ip6_tree_bitmap_node_t *path[IP6_TREE_BITMAP_MAX_DEPTH + 1];
+  void *old[IP6_TREE_BITMAP_MAX_DEPTH + 2];
+  ip6_tree_bitmap_node_t *n, nv;
+  u32 depth, depth_max, rel, n_old;
+  u64 pos;
+  u128 key;
+
+  ASSERT (dst_address_length <= 128);
+
+  key = ip6_tree_bitmap_key (dst_address);
+  depth_max = dst_address_length / IP6_TREE_BITMAP_STRIDE;
+  rel = dst_address_length % IP6_TREE_BITMAP_STRIDE;
+  pos = 1ULL << ip6_tree_bitmap_internal_bit (ip6_tree_bitmap_slot (key,
+								     depth_max),
+					      rel);
+
+  depth = ip6_tree_bitmap_descend (t, key, depth_max, path);
+  n = path[depth];
+
+  if (depth != depth_max || !(n->internal & pos))
+    return;
+
+  n_old = 0;
+  nv = *n;
+  nv.internal &= ~pos;
+  nv.results = ip6_tree_bitmap_array_delete (n->results,
+					     count_set_bits (n->internal),
+					     count_set_bits (n->internal &
+							     (pos - 1)),
+					     sizeof (n->results[0]));
+  old[n_old++] = n->results;
+  t->n_routes--;
+
+  /*
+   * nodes left with neither routes nor children are removed from their
+   * parent, which may in turn be left empty.
+   */
+  while (depth > 0 && 0 == nv.internal && 0 == nv.external)
+    {
+      n = path[depth - 1];
+      pos = 1ULL << ip6_tree_bitmap_slot (key, depth - 1);
+
+      nv = *n;
+      nv.external &= ~pos;
+      nv.children = ip6_tree_bitmap_array_delete (n->children,
+						  count_set_bits
+						  (n->external),
+						  count_set_bits (n->external
+								  & (pos -
+								     1)),
+						  sizeof (*n));
+      old[n_old++] = n->children;
+      t->n_nodes--;
+      depth--;
+    }
+
+  ip6_tree_bitmap_node_replace (t, path, depth, &nv);
+
+  /* only once the workers can no longer reach them */
+  while (n_old--)
+    vlib_epoch_mem_free (old[n_old]);
+}
+
+ip6_tree_bitmap_t *
+ip6_tree_bitmap_create (void)
+{
+  ip6_tree_bitmap_t *t;
+
+  t = clib_mem_alloc (sizeof (*t));
+  clib_memset (t, 0, sizeof (*t));
+
+  t->root = ip6_tree_bitmap_nodes_alloc (1);
+  clib_memset (t->root, 0, sizeof (*t->root));
+  t->n_nodes = 1;
+
+  return (t);
+}
+
+static void
+ip6_tree_bitmap_node_free (ip6_tree_bitmap_node_t * n)
+{
+  u32 i;
+
+  for (i = 0; i < count_set_bits (n->external); i++)
+    ip6_tree_bitmap_node_free (&n->children[i]);
+
+  vlib_epoch_mem_free (n->children);
+  vlib_epoch_mem_free (n->results);
+}
+
+void
+ip6_tree_bitmap_free (ip6_tree_bitmap_t * t)
+{
+  ip6_tree_bitmap_node_free (t->root);
+  vlib_epoch_mem_free (t->root);
+  vlib_epoch_mem_free (t);
+}
+
+uword
+ip6_tree_bitmap_memory_usage (ip6_tree_bitmap_t * t)
+{
+  return (sizeof (*t) +
+	  t->n_nodes * sizeof (ip6_tree_bitmap_node_t) +
+	  t->n_routes * sizeof (u32));
+}
+
+static void
+ip6_tree_bitmap_node_count (const ip6_tree_bitmap_node_t * n,
+			    u32 depth, u32 * n_by_depth, u32 * routes_by_depth)
+{
+  u32 i;
+
+  n_by_depth[depth]++;
+  routes_by_depth[depth] += count_set_bits (n->internal);
+
+  for (i = 0; i < count_set_bits (n->external); i++)
+    ip6_tree_bitmap_node_count (&n->children[i], depth + 1,
+				n_by_depth, routes_by_depth);
+}
+
+u8 *
+format_ip6_tree_bitmap (u8 * s, va_list * va)
+{
+  ip6_tree_bitmap_t *t = va_arg (*va, ip6_tree_bitmap_t *);
+  int verbose = va_arg (*va, int);
+  u32 n_by_depth[IP6_TREE_BITMAP_MAX_DEPTH + 1];
+  u32 routes_by_depth[IP6_TREE_BITMAP_MAX_DEPTH + 1];
+  u32 depth, indent;
+
+  indent = format_get_indent (s);
+  s = format (s, "%d routes, %d nodes, memory usage %U",
+	      t->n_routes, t->n_nodes,
+	      format_memory_size, ip6_tree_bitmap_memory_usage (t));
+
+  if (verbose)
+    {
+      clib_memset (n_by_depth, 0, sizeof (n_by_depth));
+      clib_memset (routes_by_depth, 0, sizeof (routes_by_depth));
+      ip6_tree_bitmap_node_count (t->root, 0, n_by_depth, routes_by_depth);
+
+      s = format (s, "\n%U%=8s%=12s%=12s", format_white_space, indent,
+		  "depth", "nodes", "routes");
+      for (depth = 0; depth <= IP6_TREE_BITMAP_MAX_DEPTH; depth++)
+	{
+	  if (0 == n_by_depth[depth])
+	    continue;
+	  s = format (s, "\n%U%=8d%=12d%=12d", format_white_space, indent,
+		      depth, n_by_depth[depth], routes_by_depth[depth]);
+	}
+    }
+
+  return (s);
+}
+
+static clib_error_t *
+ip6_tree_bitmap_module_init (vlib_main_t * vm)
+{
+  u32 s, rel;
+
+  for (s = 0; s < ARRAY_LEN (ip6_tree_bitmap_internal_masks); s++)
+    for (rel = 0; rel < IP6_TREE_BITMAP_STRIDE; rel++)
+      ip6_tree_bitmap_internal_masks[s] |=
+	1ULL << ip6_tree_bitmap_internal_bit (s, rel);
+
+  return (NULL);
+}
+
+VLIB_INIT_FUNCTION (ip6_tree_bitmap_module_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
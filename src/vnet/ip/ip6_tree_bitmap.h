@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_ip_ip6_tree_bitmap_h
+#define included_ip_ip6_tree_bitmap_h
+
+#include <vppinfra/cache.h>
+#include <vppinfra/bitops.h>
+#include <vnet/ip/ip6_packet.h>	/* for ip6_address_t */
+
+/**
+ * @brief An IPv6 tree bitmap.
+ *
+ * A multibit trie with a stride of 6 bits, so a lookup visits at most
+ * 22 nodes whatever the number of prefix lengths in the table; a table
+ * of prefixes no longer than /48 is at most 9 nodes deep.
+ *
+ * Each node describes 6 bits of the address with two bitmaps:
+ *  - 'internal' marks the prefixes that end within the node, i.e. those
+ *    of length 0 to 5 relative to the node. The prefix of relative length
+ *    l with value b is at bit (1 << l) - 1 + b, so longer prefixes are at
+ *    higher bits.
+ *  - 'external' marks, for each of the 64 values of the node's 6 bits,
+ *    whether there is a child node.
+ * The children of a node are contiguous, as are its results, and each is
+ * found by the population count of its bitmap below the bit. Prefixes are
+ * not pushed to the leaves, a lookup instead remembers the last node with
+ * a matching internal prefix and reads only that node's result.
+ *
+ * Nodes are never modified in place once the data-plane can see them.
+ * A changed node is written to a copy of the array of its siblings which
+ * is then swapped into the parent with a single atomic store, the old
+ * array is freed after an epoch grace period.
+ */
+typedef struct ip6_tree_bitmap_node_t_
+{
+  /** Prefixes ending in the node */
+  u64 internal;
+  /** Slots that descend to a child node */
+  u64 external;
+  /** popcount(external) children */
+  struct ip6_tree_bitmap_node_t_ *children;
+  /** popcount(internal) load-balance indices */
+  u32 *results;
+} ip6_tree_bitmap_node_t;
+
+#define IP6_TREE_BITMAP_STRIDE 6
+
+/**
+ * The deepest node; /128s end in it at relative length 2.
+ */
+#define IP6_TREE_BITMAP_MAX_DEPTH (128 / IP6_TREE_BITMAP_STRIDE)
+
+typedef struct ip6_tree_bitmap_t_
+{
+  /**
+   * The root node, an array of one so that the root is replaced just as
+   * any other node is.
+   */
+  ip6_tree_bitmap_node_t *root;
+
+  /**
+   * Number of nodes and of prefixes in the tree.
+   */
+  u32 n_nodes;
+  u32 n_routes;
+} ip6_tree_bitmap_t;
+
+/**
+ * For each value of a node's 6 bits, the internal bits of the prefixes
+ * that match it.
+ */
+extern u64 ip6_tree_bitmap_internal_masks[64];
+
+/**
+ * @brief Create an empty tree
+ */
+ip6_tree_bitmap_t *ip6_tree_bitmap_create (void);
+
+/**
+ * @brief Free a tree and all of its nodes
+ */
+void ip6_tree_bitmap_free (ip6_tree_bitmap_t * t);
+
+/**
+ * @brief Add, or update, a route/entry
+ */
+void ip6_tree_bitmap_route_add (ip6_tree_bitmap_t * t,
+				const ip6_address_t * dst_address,
+				u32 dst_address_length, u32 lb_index);
+/**
+ * @brief remove a route/entry
+ */
+void ip6_tree_bitmap_route_del (ip6_tree_bitmap_t * t,
+				const ip6_address_t * dst_address,
+				u32 dst_address_length);
+
+/**
+ * @brief return the memory used by the table
+ */
+uword ip6_tree_bitmap_memory_usage (ip6_tree_bitmap_t * t);
+
+/**
+ * @brief Format/display the contents of the tree
+ */
+format_function_t format_ip6_tree_bitmap;
+
+/**
+ * @brief The host order address as one 128 bit value
+ */
+always_inline u128
+ip6_tree_bitmap_key (const ip6_address_t * a)
+{
+  return (((u128) clib_net_to_host_u64 (a->as_u64[0]) << 64) |
+	  clib_net_to_host_u64 (a->as_u64[1]));
+}
+
+/**
+ * @brief Lookup the load-balance index for the address
+ */
+always_inline u32
+ip6_tree_bitmap_lookup (const ip6_tree_bitmap_t * t,
+			const ip6_address_t * dst_address)
+{
+  const ip6_tree_bitmap_node_t *n, *match_node;
+  u64 match, bit;
+  u128 key;
+  u32 s;
+
+  key = ip6_tree_bitmap_key (dst_address);
+  n = t->root;
+  match_node = NULL;
+  match = 0;
+
+  while (1)
+    {
+      s = key >> (128 - IP6_TREE_BITMAP_STRIDE);
+      key <<= IP6_TREE_BITMAP_STRIDE;
+
+      if (n->internal & ip6_tree_bitmap_internal_masks[s])
+	{
+	  match_node = n;
+	  match = n->internal & ip6_tree_bitmap_internal_masks[s];
+	}
+
+      bit = 1ULL << s;
+      if (!(n->external & bit))
+	break;
+
+      n = n->children + count_set_bits (n->external & (bit - 1));
+    }
+
+  /* default route is always present */
+  if (PREDICT_FALSE (NULL == match_node))
+    return (0);
+
+  /* the longest match is the highest bit */
+  bit = 1ULL << min_log2 (match);
+
+  return (match_node->results[count_set_bits (match_node->internal &
+					      (bit - 1))]);
+}
+
+#endif /* included_ip_ip6_tree_bitmap_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
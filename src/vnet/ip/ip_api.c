@@ -83,6 +83,7 @@
   _ (IP_TABLE_REPLACE_END, ip_table_replace_end)                              \
   _ (IP_TABLE_FLUSH, ip_table_flush)                                          \
   _ (IP_ROUTE_ADD_DEL, ip_route_add_del)                                      \
+  _ (IP_ROUTE_ADD_DEL_BULK, ip_route_add_del_bulk)                            \
   _ (IP_ROUTE_LOOKUP, ip_route_lookup)                                        \
   _ (IP_TABLE_ADD_DEL, ip_table_add_del)                                      \
   _ (IP_PUNT_POLICE, ip_punt_police)                                          \
@@ -614,6 +615,70 @@ vl_api_ip_route_add_del_t_handler (vl_api_ip_route_add_del_t * mp)
   /* *INDENT-ON* */
 }
 
+void
+vl_api_ip_route_add_del_bulk_t_handler (vl_api_ip_route_add_del_bulk_t * mp)
+{
+  vl_api_ip_route_add_del_bulk_reply_t *rmp;
+  fib_table_batch_entry_t *entries = NULL, *entry = NULL;
+  vl_api_ip_route_bulk_entry_t *route;
+  fib_route_path_t rpath;
+  u32 fib_index = ~0, n_routes, ii;
+  fib_prefix_t pfx;
+  int rv = 0;
+
+  n_routes = ntohl (mp->n_routes);
+
+  /* decode all the routes before programming any */
+  for (ii = 0; ii < n_routes; ii++)
+    {
+      route = &mp->routes[ii];
+      ip_prefix_decode (&route->prefix, &pfx);
+
+      if (0 == ii)
+	{
+	  rv = fib_api_table_id_decode (pfx.fp_proto,
+					ntohl (mp->table_id), &fib_index);
+	  if (0 != rv)
+	    goto out;
+	}
+      else if (pfx.fp_proto != entries[0].fbe_prefix.fp_proto)
+	{
+	  rv = VNET_API_ERROR_INVALID_ADDRESS_FAMILY;
+	  goto out;
+	}
+
+      /* consecutive routes with the same prefix are one route's paths */
+      if (NULL == entry || 0 != fib_prefix_cmp (&entry->fbe_prefix, &pfx))
+	{
+	  vec_add2 (entries, entry, 1);
+	  entry->fbe_prefix = pfx;
+	  entry->fbe_flags = FIB_ENTRY_FLAG_NONE;
+	}
+
+      /* a delete has no paths */
+      if (!mp->is_add)
+	continue;
+
+      rv = fib_api_path_decode (&route->path, &rpath);
+      if (0 != rv)
+	goto out;
+
+      if ((rpath.frp_flags & FIB_ROUTE_PATH_LOCAL) &&
+	  (~0 == rpath.frp_sw_if_index))
+	entry->fbe_flags |= (FIB_ENTRY_FLAG_CONNECTED | FIB_ENTRY_FLAG_LOCAL);
+
+      vec_add1 (entry->fbe_paths, rpath);
+    }
+
+  fib_table_entry_update_batch (fib_index, FIB_SOURCE_API, entries);
+
+out:
+  vec_foreach (entry, entries) vec_free (entry->fbe_paths);
+  vec_free (entries);
+
+  REPLY_MACRO (VL_API_IP_ROUTE_ADD_DEL_BULK_REPLY);
+}
+
 void
 vl_api_ip_route_lookup_t_handler (vl_api_ip_route_lookup_t * mp)
 {
@@ -1797,6 +1862,8 @@ ip_api_hookup (vlib_main_t * vm)
    */
   am->is_mp_safe[VL_API_IP_ROUTE_ADD_DEL] = 1;
   am->is_mp_safe[VL_API_IP_ROUTE_ADD_DEL_REPLY] = 1;
+  am->is_mp_safe[VL_API_IP_ROUTE_ADD_DEL_BULK] = 1;
+  am->is_mp_safe[VL_API_IP_ROUTE_ADD_DEL_BULK_REPLY] = 1;
 
   /*
    * Set up the (msg_name, crc, message-id) table
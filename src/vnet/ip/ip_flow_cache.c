@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/ip/ip_flow_cache.h>
+#include <vnet/feature/feature.h>
+
+ip_flow_cache_main_t ip_flow_cache_main;
+
+static const char *ip_flow_cache_arc_names[N_AF] = {
+  [AF_IP4] = "ip4-unicast",
+  [AF_IP6] = "ip6-unicast",
+};
+
+static const char *ip_flow_cache_node_names[N_AF] = {
+  [AF_IP4] = "ip4-flow-cache",
+  [AF_IP6] = "ip6-flow-cache",
+};
+
+void
+ip_flow_cache_invalidate (void)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  u32 generation;
+
+  /*
+   * the workers read the generation before they use, or learn, the
+   * entries, so the change that prompted this is visible to any that
+   * see the new value.
+   */
+  generation = fcm->generation + 1;
+  if (0 == generation)
+    generation = 1;
+
+  clib_atomic_store_rel_n (&fcm->generation, generation);
+}
+
+static void
+ip_flow_cache_alloc (ip_address_family_t af)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  ip_flow_cache_per_thread_t *ptd;
+
+  vec_validate_aligned (fcm->per_thread,
+			vlib_get_thread_main ()->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+
+  vec_foreach (ptd, fcm->per_thread)
+    {
+      if (AF_IP4 == af && NULL == ptd->ip4_entries)
+	vec_validate (ptd->ip4_entries, fcm->n_entries_mask);
+      if (AF_IP6 == af && NULL == ptd->ip6_entries)
+	vec_validate (ptd->ip6_entries, fcm->n_entries_mask);
+    }
+}
+
+/**
+ * The cache is used on an interface only if all the features that follow
+ * it can be bypassed.
+ */
+static void
+ip_flow_cache_update_interface (ip_address_family_t af, u32 sw_if_index)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  const ip_flow_cache_feature_t *feature;
+  u32 *nodes, *node, cache_node_index;
+  u8 active, after;
+  uword *p;
+
+  vec_validate (fcm->active_by_sw_if_index[af], sw_if_index);
+  active = 0;
+
+  if (sw_if_index < vec_len (fcm->enabled_by_sw_if_index[af]) &&
+      fcm->enabled_by_sw_if_index[af][sw_if_index])
+    {
+      cache_node_index = (AF_IP4 == af ? ip4_flow_cache_node.index :
+					 ip6_flow_cache_node.index);
+      nodes = vnet_feature_get_enabled_nodes (
+	vnet_get_feature_arc_index (ip_flow_cache_arc_names[af]),
+	sw_if_index);
+      active = 1;
+      after = 0;
+
+      vec_foreach (node, nodes)
+	{
+	  if (*node == cache_node_index)
+	    {
+	      after = 1;
+	      continue;
+	    }
+	  if (!after || *node == fcm->lookup_node_index[af] ||
+	      *node == fcm->learn_node_index[af])
+	    continue;
+
+	  p = hash_get (fcm->feature_by_node_index, *node);
+
+	  if (NULL == p)
+	    {
+	      active = 0;
+	      break;
+	    }
+	  feature = vec_elt_at_index (fcm->features, p[0]);
+
+	  if (feature->is_cacheable && !feature->is_cacheable (sw_if_index))
+	    {
+	      active = 0;
+	      break;
+	    }
+	}
+      vec_free (nodes);
+    }
+
+  fcm->active_by_sw_if_index[af][sw_if_index] = active;
+}
+
+void
+ip_flow_cache_feature_update (void)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  ip_address_family_t af;
+  u32 sw_if_index;
+
+  FOR_EACH_IP_ADDRESS_FAMILY (af)
+  {
+    vec_foreach_index (sw_if_index, fcm->enabled_by_sw_if_index[af])
+      {
+	if (fcm->enabled_by_sw_if_index[af][sw_if_index])
+	  ip_flow_cache_update_interface (af, sw_if_index);
+      }
+  }
+
+  ip_flow_cache_invalidate ();
+}
+
+void
+ip_flow_cache_feature_register (const char *node_name,
+				ip_flow_cache_feature_is_cacheable_t fn)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  ip_flow_cache_feature_t *feature;
+  vlib_node_t *node;
+
+  node = vlib_get_node_by_name (vlib_get_main (), (u8 *) node_name);
+
+  if (NULL == node)
+    {
+      clib_warning ("flow-cache: no such node: %s", node_name);
+      return;
+    }
+
+  if (NULL == fcm->feature_by_node_index)
+    fcm->feature_by_node_index = hash_create (0, sizeof (uword));
+
+  vec_add2 (fcm->features, feature, 1);
+  feature->node_index = node->index;
+  feature->is_cacheable = fn;
+
+  hash_set (fcm->feature_by_node_index, node->index,
+	    feature - fcm->features);
+
+  ip_flow_cache_feature_update ();
+}
+
+int
+ip_flow_cache_enable_disable (ip_address_family_t af, u32 sw_if_index,
+			      int is_enable)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  u8 arc_index;
+  int rv;
+
+  vec_validate (fcm->enabled_by_sw_if_index[af], sw_if_index);
+
+  if (!is_enable == !fcm->enabled_by_sw_if_index[af][sw_if_index])
+    return (0);
+
+  arc_index = vnet_get_feature_arc_index (ip_flow_cache_arc_names[af]);
+
+  if (is_enable)
+    {
+      ip_flow_cache_alloc (af);
+
+      rv = vnet_feature_enable_disable (ip_flow_cache_arc_names[af],
+					ip_flow_cache_node_names[af],
+					sw_if_index, 1, 0, 0);
+      if (rv)
+	return (rv);
+
+      /* learn the flows that make it through all the features */
+      vnet_feature_modify_end_node (arc_index, sw_if_index,
+				    fcm->learn_node_index[af]);
+    }
+  else
+    {
+      vnet_feature_modify_end_node (arc_index, sw_if_index,
+				    fcm->lookup_node_index[af]);
+      rv = vnet_feature_enable_disable (ip_flow_cache_arc_names[af],
+					ip_flow_cache_node_names[af],
+					sw_if_index, 0, 0, 0);
+      if (rv)
+	return (rv);
+    }
+
+  fcm->enabled_by_sw_if_index[af][sw_if_index] = is_enable;
+  ip_flow_cache_update_interface (af, sw_if_index);
+  ip_flow_cache_invalidate ();
+
+  return (0);
+}
+
+static void
+ip_flow_cache_feature_update_cb (u32 sw_if_index, u8 arc_index,
+				 u8 is_enable, void *data)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  ip_address_family_t af;
+
+  FOR_EACH_IP_ADDRESS_FAMILY (af)
+  {
+    if (arc_index != vnet_get_feature_arc_index (ip_flow_cache_arc_names[af]))
+      continue;
+
+    /*
+     * a newly enabled feature has not seen the cached flows
+     */
+    if (sw_if_index < vec_len (fcm->enabled_by_sw_if_index[af]) &&
+	fcm->enabled_by_sw_if_index[af][sw_if_index])
+      {
+	ip_flow_cache_update_interface (af, sw_if_index);
+	ip_flow_cache_invalidate ();
+      }
+  }
+}
+
+static clib_error_t *
+ip_flow_cache_set_interface_cmd (vlib_main_t *vm, unformat_input_t *input,
+				 vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  clib_error_t *error = NULL;
+  u32 sw_if_index, is_enable;
+  ip_address_family_t af;
+  u8 afs[N_AF] = { 1, 1 };
+  int rv;
+
+  sw_if_index = ~0;
+  is_enable = 1;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "%U", unformat_ip_address_family, &af))
+	{
+	  clib_memset (afs, 0, sizeof (afs));
+	  afs[af] = 1;
+	}
+      else if (unformat (line_input, "disable"))
+	is_enable = 0;
+      else
+	{
+	  error = unformat_parse_error (line_input);
+	  goto done;
+	}
+    }
+
+  if (~0 == sw_if_index)
+    {
+      error = clib_error_return (0, "interface required");
+      goto done;
+    }
+
+  FOR_EACH_IP_ADDRESS_FAMILY (af)
+  {
+    if (!afs[af])
+      continue;
+
+    rv = ip_flow_cache_enable_disable (af, sw_if_index, is_enable);
+
+    if (rv)
+      {
+	error = clib_error_return (0, "%U flow-cache failed: %d",
+				   format_ip_address_family, af, rv);
+	goto done;
+      }
+  }
+
+done:
+  unformat_free (line_input);
+
+  return (error);
+}
+
+/*?
+ * Enable, or disable, the per-worker flow cache on an interface. Packets
+ * of cached flows skip the FIB lookup and the input features that follow
+ * the cache, if they all give a fixed verdict per flow. The cache is not
+ * used on an interface with any other input feature.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface ip flow-cache GigabitEthernet2/0/0}
+ * @cliexcmd{set interface ip flow-cache GigabitEthernet2/0/0 ip6 disable}
+ ?*/
+VLIB_CLI_COMMAND (ip_flow_cache_set_interface_command, static) = {
+  .path = "set interface ip flow-cache",
+  .short_help = "set interface ip flow-cache <interface> [ip4|ip6] [disable]",
+  .function = ip_flow_cache_set_interface_cmd,
+};
+
+static clib_error_t *
+ip_flow_cache_set_cmd (vlib_main_t *vm, unformat_input_t *input,
+		       vlib_cli_command_t *cmd)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  ip_flow_cache_per_thread_t *ptd;
+  u32 n_entries;
+  u8 had[N_AF];
+
+  if (!unformat (input, "entries %u", &n_entries))
+    return (clib_error_return (0, "unknown input '%U'",
+			       format_unformat_error, input));
+
+  if (n_entries < 2)
+    return (clib_error_return (0, "too few entries: %d", n_entries));
+
+  n_entries = max_pow2 (n_entries);
+  fcm->log2_n_entries = min_log2 (n_entries);
+  fcm->n_entries_mask = n_entries - 1;
+
+  /* the workers are stopped at the barrier, so the tables can be swapped */
+  had[AF_IP4] = had[AF_IP6] = 0;
+  vec_foreach (ptd, fcm->per_thread)
+    {
+      had[AF_IP4] |= (NULL != ptd->ip4_entries);
+      had[AF_IP6] |= (NULL != ptd->ip6_entries);
+      vec_free (ptd->ip4_entries);
+      vec_free (ptd->ip6_entries);
+    }
+  if (had[AF_IP4])
+    ip_flow_cache_alloc (AF_IP4);
+  if (had[AF_IP6])
+    ip_flow_cache_alloc (AF_IP6);
+
+  return (NULL);
+}
+
+/*?
+ * Set the number of entries in each worker's flow cache, rounded up to a
+ * power of 2. All cached flows are lost.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip flow-cache entries 1048576}
+ ?*/
+VLIB_CLI_COMMAND (ip_flow_cache_set_command, static) = {
+  .path = "set ip flow-cache",
+  .short_help = "set ip flow-cache entries <n>",
+  .function = ip_flow_cache_set_cmd,
+};
+
+static clib_error_t *
+ip_flow_cache_show_cmd (vlib_main_t *vm, unformat_input_t *input,
+			vlib_cli_command_t *cmd)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  ip_flow_cache_per_thread_t *ptd;
+  ip_address_family_t af;
+  u32 sw_if_index, ii, n_valid[N_AF];
+
+  vlib_cli_output (vm, "entries per-worker:%d generation:%d",
+		   fcm->n_entries_mask + 1, fcm->generation);
+
+  FOR_EACH_IP_ADDRESS_FAMILY (af)
+  {
+    vec_foreach_index (sw_if_index, fcm->enabled_by_sw_if_index[af])
+      {
+	if (!fcm->enabled_by_sw_if_index[af][sw_if_index])
+	  continue;
+	vlib_cli_output (vm, " %U %U: %s", format_ip_address_family, af,
+			 format_vnet_sw_if_index_name, vnm, sw_if_index,
+			 (ip_flow_cache_is_active (af, sw_if_index) ?
+			    "active" :
+			    "inactive"));
+      }
+  }
+
+  vec_foreach (ptd, fcm->per_thread)
+    {
+      n_valid[AF_IP4] = n_valid[AF_IP6] = 0;
+
+      vec_foreach_index (ii, ptd->ip4_entries)
+	n_valid[AF_IP4] +=
+	  (ptd->ip4_entries[ii].result.generation == fcm->generation);
+      vec_foreach_index (ii, ptd->ip6_entries)
+	n_valid[AF_IP6] +=
+	  (ptd->ip6_entries[ii].result.generation == fcm->generation);
+
+      vlib_cli_output (vm, " thread %d: ip4 flows:%d ip6 flows:%d",
+		       ptd - fcm->per_thread, n_valid[AF_IP4],
+		       n_valid[AF_IP6]);
+    }
+
+  return (NULL);
+}
+
+/*?
+ * Show the flow cache's configuration and the number of valid flows each
+ * worker has cached.
+ *
+ * @cliexpar
+ * @cliexstart{show ip flow-cache}
+ * entries per-worker:65536 generation:12
+ *  ip4 GigabitEthernet2/0/0: active
+ *  thread 0: ip4 flows:0 ip6 flows:0
+ *  thread 1: ip4 flows:1024 ip6 flows:0
+ * @cliexend
+ ?*/
+VLIB_CLI_COMMAND (ip_flow_cache_show_command, static) = {
+  .path = "show ip flow-cache",
+  .short_help = "show ip flow-cache",
+  .function = ip_flow_cache_show_cmd,
+};
+
+static clib_error_t *
+ip_flow_cache_init (vlib_main_t *vm)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+
+  fcm->generation = 1;
+  fcm->log2_n_entries = 16;
+  fcm->n_entries_mask = (1 << fcm->log2_n_entries) - 1;
+
+  fcm->lookup_node_index[AF_IP4] = ip4_lookup_node.index;
+  fcm->lookup_node_index[AF_IP6] = ip6_lookup_node.index;
+  fcm->learn_node_index[AF_IP4] = ip4_flow_cache_learn_node.index;
+  fcm->learn_node_index[AF_IP6] = ip6_flow_cache_learn_node.index;
+
+  if (NULL == fcm->feature_by_node_index)
+    fcm->feature_by_node_index = hash_create (0, sizeof (uword));
+
+  vnet_feature_register (ip_flow_cache_feature_update_cb, NULL);
+
+  return (NULL);
+}
+
+VLIB_INIT_FUNCTION (ip_flow_cache_init) = {
+  .runs_after = VLIB_INITS ("ip_main_init"),
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_ip_flow_cache_h
+#define included_ip_flow_cache_h
+
+#include <vnet/ip/ip.h>
+#include <vppinfra/crc32.h>
+#include <vppinfra/xxhash.h>
+
+/**
+ * @brief A per-worker exact-match flow cache.
+ *
+ * The cache is a feature on the ip[46]-unicast arcs. It remembers, per
+ * 5-tuple and FIB, the result of the FIB lookup, i.e. the DPO chosen
+ * from the load-balance. A packet that hits goes directly to that DPO,
+ * bypassing the lookup and the input features after the cache.
+ *
+ * Features may be bypassed only if they give the same verdict to all
+ * packets of a flow and do not modify them; such features register with
+ * ip_flow_cache_feature_register. If any other feature follows the cache
+ * on an interface then the cache is not used on that interface.
+ *
+ * Flows are learned, after the features, by a node that replaces the
+ * lookup as the end of the arc. So a flow that a feature drops is never
+ * learned.
+ *
+ * There is no explicit invalidation of entries. An entry records the
+ * cache's generation when it was learned and is valid only while the
+ * generation is unchanged. The generation is incremented by any change
+ * to the FIB forwarding, or to the policy of a bypassed feature.
+ *
+ * Each worker has its own direct-mapped table, so no locks are needed,
+ * and a collision simply replaces the older flow.
+ */
+
+typedef struct ip4_flow_cache_key_t_
+{
+  union
+  {
+    struct
+    {
+      ip4_address_t src;
+      ip4_address_t dst;
+      u16 src_port;
+      u16 dst_port;
+      u32 fib_index;
+      u8 proto;
+      u8 __pad[7];
+    };
+    u64 as_u64[3];
+  };
+} ip4_flow_cache_key_t;
+
+STATIC_ASSERT_SIZEOF (ip4_flow_cache_key_t, 3 * sizeof (u64));
+
+typedef struct ip6_flow_cache_key_t_
+{
+  union
+  {
+    struct
+    {
+      ip6_address_t src;
+      ip6_address_t dst;
+      u16 src_port;
+      u16 dst_port;
+      u32 fib_index;
+      u8 proto;
+      u8 __pad[7];
+    };
+    u64 as_u64[6];
+  };
+} ip6_flow_cache_key_t;
+
+STATIC_ASSERT_SIZEOF (ip6_flow_cache_key_t, 6 * sizeof (u64));
+
+/**
+ * The result of the lookup
+ */
+typedef struct ip_flow_cache_result_t_
+{
+  /** The generation when learned, 0 is never valid */
+  u32 generation;
+  /** The load-balance, for its counters */
+  u32 lb_index;
+  /** The DPO chosen from the load-balance */
+  u32 dpo_index;
+  u32 flow_hash;
+  u16 dpo_next_node;
+  u16 __pad[3];
+} ip_flow_cache_result_t;
+
+STATIC_ASSERT_SIZEOF (ip_flow_cache_result_t, 3 * sizeof (u64));
+
+typedef struct ip4_flow_cache_entry_t_
+{
+  ip4_flow_cache_key_t key;
+  ip_flow_cache_result_t result;
+} ip4_flow_cache_entry_t;
+
+typedef struct ip6_flow_cache_entry_t_
+{
+  ip6_flow_cache_key_t key;
+  ip_flow_cache_result_t result;
+} ip6_flow_cache_entry_t;
+
+typedef struct ip_flow_cache_per_thread_t_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  ip4_flow_cache_entry_t *ip4_entries;
+  ip6_flow_cache_entry_t *ip6_entries;
+} ip_flow_cache_per_thread_t;
+
+/**
+ * Whether a feature gives a fixed verdict to the flows on an interface,
+ * given its current configuration.
+ */
+typedef int (*ip_flow_cache_feature_is_cacheable_t) (u32 sw_if_index);
+
+typedef struct ip_flow_cache_feature_t_
+{
+  u32 node_index;
+  ip_flow_cache_feature_is_cacheable_t is_cacheable;
+} ip_flow_cache_feature_t;
+
+typedef struct ip_flow_cache_main_t_
+{
+  /**
+   * The cache generation. Entries learned in older generations are stale.
+   */
+  u32 generation;
+
+  /**
+   * The number of entries in each worker's table, a power of 2.
+   */
+  u32 log2_n_entries;
+  u32 n_entries_mask;
+
+  ip_flow_cache_per_thread_t *per_thread;
+
+  /**
+   * Per address family, per interface; whether the cache is enabled and
+   * whether it is used, i.e. all features after it can be bypassed.
+   */
+  u8 *enabled_by_sw_if_index[N_AF];
+  u8 *active_by_sw_if_index[N_AF];
+
+  /**
+   * The features that can be bypassed, and their index by graph node
+   */
+  ip_flow_cache_feature_t *features;
+  uword *feature_by_node_index;
+
+  u32 lookup_node_index[N_AF];
+  u32 learn_node_index[N_AF];
+} ip_flow_cache_main_t;
+
+extern ip_flow_cache_main_t ip_flow_cache_main;
+
+extern vlib_node_registration_t ip4_flow_cache_node;
+extern vlib_node_registration_t ip6_flow_cache_node;
+extern vlib_node_registration_t ip4_flow_cache_learn_node;
+extern vlib_node_registration_t ip6_flow_cache_learn_node;
+
+/**
+ * @brief Enable or disable the cache on an interface
+ */
+extern int ip_flow_cache_enable_disable (ip_address_family_t af,
+					 u32 sw_if_index, int is_enable);
+
+/**
+ * @brief Register a feature, on the ip[46]-unicast arc, that may be
+ * bypassed by cached flows. is_cacheable may be NULL if the feature is
+ * always cacheable.
+ */
+extern void
+ip_flow_cache_feature_register (const char *node_name,
+				ip_flow_cache_feature_is_cacheable_t fn);
+
+/**
+ * @brief The configuration of a registered feature has changed, so
+ * whether it can be bypassed may have too.
+ */
+extern void ip_flow_cache_feature_update (void);
+
+/**
+ * @brief Make stale all cached flows
+ */
+extern void ip_flow_cache_invalidate (void);
+
+always_inline u32
+ip_flow_cache_hash (const u64 *key, u32 n_u64)
+{
+#ifdef clib_crc32c_uses_intrinsics
+  return clib_crc32c ((u8 *) key, n_u64 * sizeof (u64));
+#else
+  u64 h = 0;
+  u32 i;
+
+  for (i = 0; i < n_u64; i++)
+    h ^= key[i];
+  return clib_xxhash (h);
+#endif
+}
+
+/**
+ * @brief Build the key of a packet. Returns 0 if the packet is not
+ * cacheable; only unfragmented TCP and UDP without options are.
+ */
+always_inline int
+ip4_flow_cache_mk_key (const vlib_buffer_t *b, const ip4_header_t *ip,
+		       u32 fib_index, ip4_flow_cache_key_t *key)
+{
+  const udp_header_t *udp;
+
+  if (PREDICT_FALSE ((ip->ip_version_and_header_length != 0x45) ||
+		     ip4_is_fragment (ip) ||
+		     (ip->protocol != IP_PROTOCOL_TCP &&
+		      ip->protocol != IP_PROTOCOL_UDP) ||
+		     (b->current_length < sizeof (*ip) + 4)))
+    return (0);
+
+  udp = (const udp_header_t *) (ip + 1);
+
+  key->as_u64[2] = 0;
+  key->src = ip->src_address;
+  key->dst = ip->dst_address;
+  key->src_port = udp->src_port;
+  key->dst_port = udp->dst_port;
+  key->fib_index = fib_index;
+  key->proto = ip->protocol;
+
+  return (1);
+}
+
+always_inline int
+ip6_flow_cache_mk_key (const vlib_buffer_t *b, const ip6_header_t *ip,
+		       u32 fib_index, ip6_flow_cache_key_t *key)
+{
+  const udp_header_t *udp;
+
+  if (PREDICT_FALSE ((ip->protocol != IP_PROTOCOL_TCP &&
+		      ip->protocol != IP_PROTOCOL_UDP) ||
+		     (b->current_length < sizeof (*ip) + 4)))
+    return (0);
+
+  udp = (const udp_header_t *) (ip + 1);
+
+  key->as_u64[5] = 0;
+  key->src = ip->src_address;
+  key->dst = ip->dst_address;
+  key->src_port = udp->src_port;
+  key->dst_port = udp->dst_port;
+  key->fib_index = fib_index;
+  key->proto = ip->protocol;
+
+  return (1);
+}
+
+always_inline int
+ip4_flow_cache_key_equal (const ip4_flow_cache_key_t *k1,
+			  const ip4_flow_cache_key_t *k2)
+{
+  return (0 == ((k1->as_u64[0] ^ k2->as_u64[0]) |
+		(k1->as_u64[1] ^ k2->as_u64[1]) |
+		(k1->as_u64[2] ^ k2->as_u64[2])));
+}
+
+always_inline int
+ip6_flow_cache_key_equal (const ip6_flow_cache_key_t *k1,
+			  const ip6_flow_cache_key_t *k2)
+{
+  return (0 == ((k1->as_u64[0] ^ k2->as_u64[0]) |
+		(k1->as_u64[1] ^ k2->as_u64[1]) |
+		(k1->as_u64[2] ^ k2->as_u64[2]) |
+		(k1->as_u64[3] ^ k2->as_u64[3]) |
+		(k1->as_u64[4] ^ k2->as_u64[4]) |
+		(k1->as_u64[5] ^ k2->as_u64[5])));
+}
+
+always_inline u8
+ip_flow_cache_is_active (ip_address_family_t af, u32 sw_if_index)
+{
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+
+  return (sw_if_index < vec_len (fcm->active_by_sw_if_index[af]) &&
+	  fcm->active_by_sw_if_index[af][sw_if_index]);
+}
+
+#endif /* included_ip_flow_cache_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,521 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/ip/ip_flow_cache.h>
+#include <vnet/ip/ip4_inlines.h>
+#include <vnet/ip/ip6_inlines.h>
+#include <vnet/dpo/load_balance_map.h>
+#include <vnet/fib/ip4_fib.h>
+#include <vnet/fib/ip6_fib.h>
+#include <vnet/feature/feature.h>
+
+#define foreach_ip_flow_cache_error                                           \
+  _ (HIT, "flows found")                                                      \
+  _ (MISS, "flows not found")                                                 \
+  _ (NOT_CACHEABLE, "packets not cacheable")                                  \
+  _ (INACTIVE, "interface has features that cannot be bypassed")
+
+typedef enum
+{
+#define _(sym, str) IP_FLOW_CACHE_ERROR_##sym,
+  foreach_ip_flow_cache_error
+#undef _
+    IP_FLOW_CACHE_N_ERROR,
+} ip_flow_cache_error_t;
+
+static char *ip_flow_cache_error_strings[] = {
+#define _(sym, string) string,
+  foreach_ip_flow_cache_error
+#undef _
+};
+
+#define foreach_ip_flow_cache_learn_error _ (LEARNED, "flows learned")
+
+typedef enum
+{
+#define _(sym, str) IP_FLOW_CACHE_LEARN_ERROR_##sym,
+  foreach_ip_flow_cache_learn_error
+#undef _
+    IP_FLOW_CACHE_LEARN_N_ERROR,
+} ip_flow_cache_learn_error_t;
+
+static char *ip_flow_cache_learn_error_strings[] = {
+#define _(sym, string) string,
+  foreach_ip_flow_cache_learn_error
+#undef _
+};
+
+typedef enum ip_flow_cache_trace_result_t_
+{
+  IP_FLOW_CACHE_TRACE_HIT,
+  IP_FLOW_CACHE_TRACE_MISS,
+  IP_FLOW_CACHE_TRACE_SKIP,
+  IP_FLOW_CACHE_TRACE_LEARN,
+} ip_flow_cache_trace_result_t;
+
+typedef struct ip_flow_cache_trace_t_
+{
+  ip_flow_cache_trace_result_t result;
+  u32 slot;
+  u32 lb_index;
+  u32 dpo_index;
+} ip_flow_cache_trace_t;
+
+static u8 *
+format_ip_flow_cache_trace (u8 *s, va_list *args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  ip_flow_cache_trace_t *t = va_arg (*args, ip_flow_cache_trace_t *);
+
+  switch (t->result)
+    {
+    case IP_FLOW_CACHE_TRACE_HIT:
+      s = format (s, "hit slot:%d lb:%d dpo:%d", t->slot, t->lb_index,
+		  t->dpo_index);
+      break;
+    case IP_FLOW_CACHE_TRACE_MISS:
+      s = format (s, "miss slot:%d", t->slot);
+      break;
+    case IP_FLOW_CACHE_TRACE_SKIP:
+      s = format (s, "not cached");
+      break;
+    case IP_FLOW_CACHE_TRACE_LEARN:
+      s = format (s, "learn slot:%d lb:%d dpo:%d", t->slot, t->lb_index,
+		  t->dpo_index);
+      break;
+    }
+
+  return (s);
+}
+
+always_inline u32
+ip_flow_cache_fib_index (ip_address_family_t af, const vlib_buffer_t *b)
+{
+  u32 *fib_index_by_sw_if_index =
+    (AF_IP4 == af ? ip4_main.fib_index_by_sw_if_index :
+		    ip6_main.fib_index_by_sw_if_index);
+
+  /* as ip_lookup_set_buffer_fib_index, but leaving the buffer untouched */
+  if ((u32) ~0 != vnet_buffer (b)->sw_if_index[VLIB_TX])
+    return (vnet_buffer (b)->sw_if_index[VLIB_TX]);
+
+  return (
+    vec_elt (fib_index_by_sw_if_index, vnet_buffer (b)->sw_if_index[VLIB_RX]));
+}
+
+/**
+ * The size, in u64s, of the key for the address family
+ */
+#define IP_FLOW_CACHE_KEY_N_U64(_af)                                          \
+  (AF_IP4 == (_af) ? ARRAY_LEN (((ip4_flow_cache_key_t *) 0)->as_u64) :       \
+		     ARRAY_LEN (((ip6_flow_cache_key_t *) 0)->as_u64))
+
+always_inline int
+ip_flow_cache_mk_key (ip_address_family_t af, vlib_buffer_t *b,
+		      u32 fib_index, u64 *key)
+{
+  if (AF_IP4 == af)
+    return (ip4_flow_cache_mk_key (b, vlib_buffer_get_current (b), fib_index,
+				   (ip4_flow_cache_key_t *) key));
+  else
+    return (ip6_flow_cache_mk_key (b, vlib_buffer_get_current (b), fib_index,
+				   (ip6_flow_cache_key_t *) key));
+}
+
+always_inline ip_flow_cache_result_t *
+ip_flow_cache_slot (ip_address_family_t af, ip_flow_cache_per_thread_t *ptd,
+		    u32 slot)
+{
+  if (AF_IP4 == af)
+    return (&ptd->ip4_entries[slot].result);
+  else
+    return (&ptd->ip6_entries[slot].result);
+}
+
+always_inline u64 *
+ip_flow_cache_slot_key (ip_address_family_t af,
+			ip_flow_cache_per_thread_t *ptd, u32 slot)
+{
+  if (AF_IP4 == af)
+    return (ptd->ip4_entries[slot].key.as_u64);
+  else
+    return (ptd->ip6_entries[slot].key.as_u64);
+}
+
+always_inline int
+ip_flow_cache_key_equal (ip_address_family_t af, const u64 *k1,
+			 const u64 *k2)
+{
+  if (AF_IP4 == af)
+    return (ip4_flow_cache_key_equal ((const ip4_flow_cache_key_t *) k1,
+				      (const ip4_flow_cache_key_t *) k2));
+  else
+    return (ip6_flow_cache_key_equal ((const ip6_flow_cache_key_t *) k1,
+				      (const ip6_flow_cache_key_t *) k2));
+}
+
+static_always_inline uword
+ip_flow_cache_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
+		      vlib_frame_t *frame, ip_address_family_t af)
+{
+  vlib_combined_counter_main_t *cm = &load_balance_main.lbm_to_counters;
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  u32 n_left, *from, thread_index, generation, mask;
+  u64 keys[VLIB_FRAME_SIZE][IP_FLOW_CACHE_KEY_N_U64 (AF_IP6)];
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u32 slots[VLIB_FRAME_SIZE], *slot;
+  u16 nexts[VLIB_FRAME_SIZE], *next;
+  u32 n_errors[IP_FLOW_CACHE_N_ERROR] = { 0 };
+  ip_flow_cache_per_thread_t *ptd;
+  u32 ii;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  thread_index = vm->thread_index;
+  ptd = vec_elt_at_index (fcm->per_thread, thread_index);
+  mask = fcm->n_entries_mask;
+  generation = clib_atomic_load_acq_n (&fcm->generation);
+
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  /*
+   * first pass; compute the slots of all the packets and prefetch them,
+   * so the misses of the table overlap.
+   */
+  for (ii = 0; ii < n_left; ii++)
+    {
+      u32 sw_if_index = vnet_buffer (bufs[ii])->sw_if_index[VLIB_RX];
+
+      if (ii + 4 < n_left)
+	{
+	  vlib_prefetch_buffer_header (bufs[ii + 4], LOAD);
+	  vlib_prefetch_buffer_data (bufs[ii + 4], LOAD);
+	}
+
+      if (PREDICT_FALSE (!ip_flow_cache_is_active (af, sw_if_index)))
+	{
+	  slots[ii] = ~0;
+	  n_errors[IP_FLOW_CACHE_ERROR_INACTIVE]++;
+	}
+      else if (PREDICT_FALSE (!ip_flow_cache_mk_key (
+		 af, bufs[ii], ip_flow_cache_fib_index (af, bufs[ii]),
+		 keys[ii])))
+	{
+	  slots[ii] = ~0;
+	  n_errors[IP_FLOW_CACHE_ERROR_NOT_CACHEABLE]++;
+	}
+      else
+	{
+	  slots[ii] =
+	    ip_flow_cache_hash (keys[ii], IP_FLOW_CACHE_KEY_N_U64 (af)) &
+	    mask;
+	  CLIB_PREFETCH (ip_flow_cache_slot_key (af, ptd, slots[ii]),
+			 CLIB_CACHE_LINE_BYTES, LOAD);
+	}
+    }
+
+  b = bufs;
+  next = nexts;
+  slot = slots;
+
+  for (ii = 0; ii < n_left; ii++)
+    {
+      const ip_flow_cache_result_t *res;
+
+      if (PREDICT_TRUE ((u32) ~0 != slot[0]))
+	{
+	  res = ip_flow_cache_slot (af, ptd, slot[0]);
+
+	  if (PREDICT_TRUE (res->generation == generation &&
+			    ip_flow_cache_key_equal (
+			      af, keys[ii],
+			      ip_flow_cache_slot_key (af, ptd, slot[0]))))
+	    {
+	      /* do what the lookup would */
+	      vnet_buffer (b[0])->ip.fib_index =
+		ip_flow_cache_fib_index (af, b[0]);
+	      vnet_buffer (b[0])->ip.flow_hash = res->flow_hash;
+	      vnet_buffer (b[0])->ip.adj_index[VLIB_TX] = res->dpo_index;
+	      next[0] = res->dpo_next_node;
+
+	      vlib_increment_combined_counter (
+		cm, thread_index, res->lb_index, 1,
+		vlib_buffer_length_in_chain (vm, b[0]));
+	      n_errors[IP_FLOW_CACHE_ERROR_HIT]++;
+	    }
+	  else
+	    {
+	      vnet_feature_next_u16 (next, b[0]);
+	      n_errors[IP_FLOW_CACHE_ERROR_MISS]++;
+	      res = NULL;
+	    }
+	}
+      else
+	{
+	  vnet_feature_next_u16 (next, b[0]);
+	  res = NULL;
+	}
+
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  ip_flow_cache_trace_t *t;
+
+	  t = vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->slot = slot[0];
+	  if (NULL != res)
+	    {
+	      t->result = IP_FLOW_CACHE_TRACE_HIT;
+	      t->lb_index = res->lb_index;
+	      t->dpo_index = res->dpo_index;
+	    }
+	  else
+	    t->result = ((u32) ~0 == slot[0] ? IP_FLOW_CACHE_TRACE_SKIP :
+					       IP_FLOW_CACHE_TRACE_MISS);
+	}
+
+      b += 1;
+      next += 1;
+      slot += 1;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
+  for (ii = 0; ii < IP_FLOW_CACHE_N_ERROR; ii++)
+    if (n_errors[ii])
+      vlib_node_increment_counter (vm, node->node_index, ii, n_errors[ii]);
+
+  return frame->n_vectors;
+}
+
+/*
+ * The end of the feature arc on the interfaces with the cache; the FIB
+ * lookup, as ip[46]-lookup does it, that caches what it finds.
+ */
+static_always_inline uword
+ip_flow_cache_learn_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
+			    vlib_frame_t *frame, ip_address_family_t af)
+{
+  vlib_combined_counter_main_t *cm = &load_balance_main.lbm_to_counters;
+  ip_flow_cache_main_t *fcm = &ip_flow_cache_main;
+  u32 n_left, *from, thread_index, generation, n_learned;
+  u64 key[IP_FLOW_CACHE_KEY_N_U64 (AF_IP6)];
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u16 nexts[VLIB_FRAME_SIZE], *next;
+  ip_flow_cache_per_thread_t *ptd;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  thread_index = vm->thread_index;
+  ptd = vec_elt_at_index (fcm->per_thread, thread_index);
+  n_learned = 0;
+
+  /*
+   * read before the lookups, so a result from before a FIB change is not
+   * saved with the generation after it
+   */
+  generation = clib_atomic_load_acq_n (&fcm->generation);
+
+  vlib_get_buffers (vm, from, bufs, n_left);
+  b = bufs;
+  next = nexts;
+
+  while (n_left > 0)
+    {
+      const load_balance_t *lb0;
+      const dpo_id_t *dpo0;
+      u32 lbi0, hash_c0, fib_index0, slot0;
+
+      if (n_left > 2)
+	{
+	  vlib_prefetch_buffer_header (b[2], LOAD);
+	  vlib_prefetch_buffer_data (b[2], LOAD);
+	}
+
+      fib_index0 = ip_flow_cache_fib_index (af, b[0]);
+      vnet_buffer (b[0])->ip.fib_index = fib_index0;
+
+      if (AF_IP4 == af)
+	{
+	  ip4_header_t *ip0 = vlib_buffer_get_current (b[0]);
+
+	  lbi0 = ip4_fib_forwarding_lookup (fib_index0, &ip0->dst_address);
+	  lb0 = load_balance_get (lbi0);
+	  hash_c0 = 0;
+	  if (PREDICT_FALSE (lb0->lb_n_buckets > 1))
+	    hash_c0 = ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
+	}
+      else
+	{
+	  ip6_header_t *ip0 = vlib_buffer_get_current (b[0]);
+
+	  lbi0 = ip6_fib_table_fwding_lookup (fib_index0, &ip0->dst_address);
+	  lb0 = load_balance_get (lbi0);
+	  hash_c0 = 0;
+	  if (PREDICT_FALSE (lb0->lb_n_buckets > 1))
+	    hash_c0 = ip6_compute_flow_hash (ip0, lb0->lb_hash_config);
+	}
+
+      vnet_buffer (b[0])->ip.flow_hash = hash_c0;
+      dpo0 = load_balance_get_fwd_bucket (lb0,
+					  hash_c0 & lb0->lb_n_buckets_minus_1);
+
+      next[0] = dpo0->dpoi_next_node;
+      vnet_buffer (b[0])->ip.adj_index[VLIB_TX] = dpo0->dpoi_index;
+
+      if (AF_IP6 == af)
+	{
+	  ip6_header_t *ip0 = vlib_buffer_get_current (b[0]);
+
+	  /* Only process the HBH Option Header if explicitly configured */
+	  if (PREDICT_FALSE (ip0->protocol ==
+			     IP_PROTOCOL_IP6_HOP_BY_HOP_OPTIONS) &&
+	      dpo_is_adj (dpo0) && ip6_main.hbh_enabled)
+	    next[0] = IP6_LOOKUP_NEXT_HOP_BY_HOP;
+	}
+
+      vlib_increment_combined_counter (
+	cm, thread_index, lbi0, 1, vlib_buffer_length_in_chain (vm, b[0]));
+
+      slot0 = ~0;
+      if (ip_flow_cache_is_active (af,
+				   vnet_buffer (b[0])->sw_if_index[VLIB_RX]) &&
+	  ip_flow_cache_mk_key (af, b[0], fib_index0, key))
+	{
+	  ip_flow_cache_result_t *res;
+
+	  slot0 = ip_flow_cache_hash (key, IP_FLOW_CACHE_KEY_N_U64 (af)) &
+		  fcm->n_entries_mask;
+	  clib_memcpy_fast (ip_flow_cache_slot_key (af, ptd, slot0), key,
+			    IP_FLOW_CACHE_KEY_N_U64 (af) * sizeof (u64));
+	  res = ip_flow_cache_slot (af, ptd, slot0);
+	  res->generation = generation;
+	  res->lb_index = lbi0;
+	  res->dpo_index = dpo0->dpoi_index;
+	  res->flow_hash = hash_c0;
+	  res->dpo_next_node = next[0];
+	  n_learned++;
+	}
+
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  ip_flow_cache_trace_t *t;
+
+	  t = vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->result = IP_FLOW_CACHE_TRACE_LEARN;
+	  t->slot = slot0;
+	  t->lb_index = lbi0;
+	  t->dpo_index = dpo0->dpoi_index;
+	}
+
+      b += 1;
+      next += 1;
+      n_left -= 1;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
+  vlib_node_increment_counter (vm, node->node_index,
+			       IP_FLOW_CACHE_LEARN_ERROR_LEARNED, n_learned);
+
+  return frame->n_vectors;
+}
+
+VLIB_NODE_FN (ip4_flow_cache_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  return (ip_flow_cache_inline (vm, node, frame, AF_IP4));
+}
+
+VLIB_NODE_FN (ip6_flow_cache_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  return (ip_flow_cache_inline (vm, node, frame, AF_IP6));
+}
+
+VLIB_NODE_FN (ip4_flow_cache_learn_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  return (ip_flow_cache_learn_inline (vm, node, frame, AF_IP4));
+}
+
+VLIB_NODE_FN (ip6_flow_cache_learn_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  return (ip_flow_cache_learn_inline (vm, node, frame, AF_IP6));
+}
+
+/*
+ * The nodes are siblings of the lookup, so they have its edges to the
+ * DPOs, and hence the next node of a DPO is valid for them.
+ */
+VLIB_REGISTER_NODE (ip4_flow_cache_node) = {
+  .name = "ip4-flow-cache",
+  .vector_size = sizeof (u32),
+  .format_trace = format_ip_flow_cache_trace,
+  .n_errors = IP_FLOW_CACHE_N_ERROR,
+  .error_strings = ip_flow_cache_error_strings,
+  .sibling_of = "ip4-lookup",
+};
+
+VLIB_REGISTER_NODE (ip6_flow_cache_node) = {
+  .name = "ip6-flow-cache",
+  .vector_size = sizeof (u32),
+  .format_trace = format_ip_flow_cache_trace,
+  .n_errors = IP_FLOW_CACHE_N_ERROR,
+  .error_strings = ip_flow_cache_error_strings,
+  .sibling_of = "ip6-lookup",
+};
+
+VLIB_REGISTER_NODE (ip4_flow_cache_learn_node) = {
+  .name = "ip4-flow-cache-learn",
+  .vector_size = sizeof (u32),
+  .format_trace = format_ip_flow_cache_trace,
+  .n_errors = IP_FLOW_CACHE_LEARN_N_ERROR,
+  .error_strings = ip_flow_cache_learn_error_strings,
+  .sibling_of = "ip4-lookup",
+};
+
+VLIB_REGISTER_NODE (ip6_flow_cache_learn_node) = {
+  .name = "ip6-flow-cache-learn",
+  .vector_size = sizeof (u32),
+  .format_trace = format_ip_flow_cache_trace,
+  .n_errors = IP_FLOW_CACHE_LEARN_N_ERROR,
+  .error_strings = ip_flow_cache_learn_error_strings,
+  .sibling_of = "ip6-lookup",
+};
+
+/*
+ * Before the input features that may be bypassed
+ */
+VNET_FEATURE_INIT (ip4_flow_cache_feature, static) = {
+  .arc_name = "ip4-unicast",
+  .node_name = "ip4-flow-cache",
+  .runs_before = VNET_FEATURES ("acl-plugin-in-ip4-fa"),
+};
+
+VNET_FEATURE_INIT (ip6_flow_cache_feature, static) = {
+  .arc_name = "ip6-unicast",
+  .node_name = "ip6-flow-cache",
+  .runs_before = VNET_FEATURES ("acl-plugin-in-ip6-fa"),
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
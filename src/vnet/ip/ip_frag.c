@@ -44,6 +44,8 @@ format_ip_frag_trace (u8 * s, va_list * args)
 
 static u32 running_fragment_id;
 
+ip_frag_main_t ip_frag_main;
+
 static void
 frag_set_sw_if_index (vlib_buffer_t * to, vlib_buffer_t * from)
 {
@@ -235,6 +237,295 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
   return IP_FRAG_ERROR_NONE;
 }
 
+/*
+ * Zero-copy fragmentation.
+ * Each fragment is a small buffer, with the headers and the first few
+ * bytes of the payload, chained to the packet's own buffers. A buffer's
+ * metadata can describe only one window onto its data, so the first
+ * piece of each of the packet's buffers is used in place, and the later
+ * pieces of a buffer that is split between fragments are copied to the
+ * next fragment's header buffer. When the packet's buffers are no larger
+ * than the fragments, the copy is small and of fixed size.
+ */
+typedef struct frag_chain_walk_t_
+{
+  /* the packet's buffer from which the payload is taken */
+  vlib_buffer_t *b;
+  u32 bi;
+  /* the next byte to take and the bytes left in the buffer */
+  u8 *data;
+  u16 left;
+  /* the buffer is already in a fragment */
+  u8 used;
+  /* the buffer's next in the packet; its own link is reused */
+  u8 has_next;
+  u32 next_bi;
+} frag_chain_walk_t;
+
+static void
+frag_chain_walk_load (vlib_main_t * vm, frag_chain_walk_t * w, u32 bi,
+		      u16 offset)
+{
+  w->bi = bi;
+  w->b = vlib_get_buffer (vm, bi);
+  w->data = vlib_buffer_get_current (w->b) + offset;
+  w->left = w->b->current_length - offset;
+  w->used = 0;
+  w->has_next = ! !(w->b->flags & VLIB_BUFFER_NEXT_PRESENT);
+  w->next_bi = w->b->next_buffer;
+}
+
+static void
+frag_chain_walk_next (vlib_main_t * vm, frag_chain_walk_t * w)
+{
+  ASSERT (w->has_next);
+
+  /* a buffer with none of the payload, i.e. only headers */
+  if (!w->used)
+    {
+      w->b->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+      vlib_buffer_free_one (vm, w->bi);
+    }
+  frag_chain_walk_load (vm, w, w->next_bi, 0);
+}
+
+/*
+ * Free the packet's buffers that are in no fragment.
+ */
+static void
+frag_chain_walk_end (vlib_main_t * vm, frag_chain_walk_t * w)
+{
+  if (!w->used)
+    /* its links are those of the packet */
+    vlib_buffer_free_one (vm, w->bi);
+  else if (w->has_next)
+    vlib_buffer_free_one (vm, w->next_bi);
+}
+
+/*
+ * Chain the next len bytes of the packet to the fragment's header buffer
+ */
+static void
+frag_chain_payload (vlib_main_t * vm, frag_chain_walk_t * w,
+		    vlib_buffer_t * to_b, u16 len)
+{
+  vlib_buffer_t *last = to_b;
+  u16 n, min_copy = 0;
+
+  to_b->total_length_not_including_first_buffer = 0;
+
+  /*
+   * the first buffer of a chain must be big enough that headers can be
+   * pushed onto it, so copy the first few bytes. Also copy the rest of a
+   * buffer that is in the previous fragment.
+   */
+  if (to_b->current_length < VLIB_BUFFER_MIN_CHAIN_SEG_SIZE)
+    min_copy = VLIB_BUFFER_MIN_CHAIN_SEG_SIZE - to_b->current_length;
+
+  while (len && (min_copy || (w->used && w->left)))
+    {
+      if (0 == w->left)
+	{
+	  frag_chain_walk_next (vm, w);
+	  continue;
+	}
+
+      n = clib_min (len, w->left);
+      if (!w->used)
+	n = clib_min (n, min_copy);
+
+      clib_memcpy_fast (vlib_buffer_get_tail (to_b), w->data, n);
+      to_b->current_length += n;
+      w->data += n;
+      w->left -= n;
+      len -= n;
+      min_copy -= clib_min (min_copy, n);
+    }
+
+  while (len)
+    {
+      if (0 == w->left)
+	{
+	  frag_chain_walk_next (vm, w);
+	  continue;
+	}
+
+      n = clib_min (len, w->left);
+
+      w->b->current_data = w->data - w->b->data;
+      w->b->current_length = n;
+      last->next_buffer = w->bi;
+      last->flags |= VLIB_BUFFER_NEXT_PRESENT;
+      last = w->b;
+      to_b->total_length_not_including_first_buffer += n;
+
+      w->used = 1;
+      w->data += n;
+      w->left -= n;
+      len -= n;
+    }
+
+  last->flags &= ~VLIB_BUFFER_NEXT_PRESENT;
+  to_b->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+}
+
+/*
+ * Allocate the header buffers of all the fragments, before the packet's
+ * buffers are taken, so a failure leaves the packet as it was.
+ */
+static ip_frag_error_t
+frag_chain_alloc (vlib_buffer_t * org_b, u32 n_frags, u32 ** buffer)
+{
+  u32 n_start = vec_len (*buffer), bi, ii;
+
+  for (ii = 0; ii < n_frags; ii++)
+    {
+      if (frag_buffer_alloc (org_b, &bi) == 0)
+	{
+	  vlib_buffer_free (vlib_get_main (), *buffer + n_start, ii);
+	  _vec_len (*buffer) = n_start;
+	  return IP_FRAG_ERROR_MEMORY;
+	}
+      vec_add1 (*buffer, bi);
+    }
+
+  return IP_FRAG_ERROR_NONE;
+}
+
+/*
+ * Like ip4_frag_do_fragment, but without copying the payload. On success
+ * the packet's buffers are in the fragments, the caller must not free it.
+ */
+ip_frag_error_t
+ip4_frag_do_fragment_chain (vlib_main_t * vm, u32 from_bi, u16 mtu,
+			    u16 l2unfragmentablesize, u32 ** buffer)
+{
+  u16 len, max, rem, hdr_len, ip_frag_id, ip_frag_offset, fo;
+  u32 n_start, n_frags, ii;
+  frag_chain_walk_t w;
+  vlib_buffer_t *from_b;
+  ip_frag_error_t rv;
+  ip4_header_t *ip4;
+  u8 *org_from_packet, more;
+
+  from_b = vlib_get_buffer (vm, from_bi);
+  org_from_packet = vlib_buffer_get_current (from_b);
+  ip4 = vlib_buffer_get_current (from_b) + l2unfragmentablesize;
+  hdr_len = l2unfragmentablesize + sizeof (ip4_header_t);
+
+  rem = clib_net_to_host_u16 (ip4->length) - sizeof (ip4_header_t);
+
+  if (rem >
+      (vlib_buffer_length_in_chain (vm, from_b) - sizeof (ip4_header_t)) ||
+      from_b->current_length < hdr_len)
+    {
+      return IP_FRAG_ERROR_MALFORMED;
+    }
+
+  /*
+   * a fragment's payload may start with a piece copied to its header
+   * buffer, so it's no bigger than the buffer.
+   */
+  max = clib_min (mtu - sizeof (ip4_header_t),
+		  vlib_buffer_get_default_data_size (vm) - hdr_len) & ~0x7;
+
+  if (mtu < sizeof (ip4_header_t) || 0 == max)
+    {
+      return IP_FRAG_ERROR_CANT_FRAGMENT_HEADER;
+    }
+
+  if (ip4->flags_and_fragment_offset &
+      clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT))
+    {
+      return IP_FRAG_ERROR_DONT_FRAGMENT_SET;
+    }
+
+  n_start = vec_len (*buffer);
+  n_frags = (rem + max - 1) / max;
+  rv = frag_chain_alloc (from_b, n_frags, buffer);
+
+  if (IP_FRAG_ERROR_NONE != rv)
+    return (rv);
+
+  if (ip4_is_fragment (ip4))
+    {
+      ip_frag_id = ip4->fragment_id;
+      ip_frag_offset = ip4_get_fragment_offset (ip4);
+      more =
+	!(!(ip4->flags_and_fragment_offset &
+	    clib_host_to_net_u16 (IP4_HEADER_FLAG_MORE_FRAGMENTS)));
+    }
+  else
+    {
+      ip_frag_id = (++running_fragment_id);
+      ip_frag_offset = 0;
+      more = 0;
+    }
+
+  /*
+   * the packet's first buffer may be freed, or moved, by the walk,
+   * so set up all the header buffers first
+   */
+  for (ii = 0; ii < n_frags; ii++)
+    {
+      vlib_buffer_t *to_b;
+      u8 *to_data;
+
+      to_b = vlib_get_buffer (vm, (*buffer)[n_start + ii]);
+      frag_set_sw_if_index (to_b, from_b);
+
+      /* Copy ip4 header */
+      to_data = vlib_buffer_get_current (to_b);
+      clib_memcpy_fast (to_data, org_from_packet, hdr_len);
+      to_b->current_length = hdr_len;
+      vnet_buffer (to_b)->l3_hdr_offset = to_b->current_data;
+      to_b->flags |= VNET_BUFFER_F_L3_HDR_OFFSET_VALID;
+
+      if (from_b->flags & VNET_BUFFER_F_L4_HDR_OFFSET_VALID)
+	{
+	  vnet_buffer (to_b)->l4_hdr_offset =
+	    (vnet_buffer (to_b)->l3_hdr_offset +
+	     (vnet_buffer (from_b)->l4_hdr_offset -
+	      vnet_buffer (from_b)->l3_hdr_offset));
+	  to_b->flags |= VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
+	}
+      to_b->flags |= VNET_BUFFER_F_IS_IP4;
+    }
+
+  frag_chain_walk_load (vm, &w, from_bi, hdr_len);
+  fo = 0;
+
+  for (ii = 0; ii < n_frags; ii++)
+    {
+      vlib_buffer_t *to_b;
+      ip4_header_t *to_ip4;
+
+      len = (rem > max ? max : rem);
+      to_b = vlib_get_buffer (vm, (*buffer)[n_start + ii]);
+      to_ip4 = vlib_buffer_get_current (to_b) + l2unfragmentablesize;
+
+      frag_chain_payload (vm, &w, to_b, len);
+
+      to_ip4->fragment_id = ip_frag_id;
+      to_ip4->flags_and_fragment_offset =
+	clib_host_to_net_u16 ((fo >> 3) + ip_frag_offset);
+      to_ip4->flags_and_fragment_offset |=
+	clib_host_to_net_u16 (((len != rem) || more) << 13);
+      to_ip4->length = clib_host_to_net_u16 (len + sizeof (ip4_header_t));
+      to_ip4->checksum = ip4_header_checksum (to_ip4);
+
+      /* we've just done the IP checksum .. */
+      vnet_buffer_offload_flags_clear (to_b, VNET_BUFFER_OFFLOAD_F_IP_CKSUM);
+
+      rem -= len;
+      fo += len;
+    }
+
+  frag_chain_walk_end (vm, &w);
+
+  return IP_FRAG_ERROR_NONE;
+}
+
 void
 ip_frag_set_vnet_buffer (vlib_buffer_t * b, u16 mtu, u8 next_index, u8 flags)
 {
@@ -255,6 +546,7 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   next_index = node->cached_next_index;
   u32 frag_sent = 0, small_packets = 0;
   u32 *buffer = 0;
+  u8 zero_copy = ip_frag_main.zero_copy;
 
   while (n_left_from > 0)
     {
@@ -265,7 +557,8 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  u32 pi0, *frag_from, frag_left;
 	  vlib_buffer_t *p0;
 	  ip_frag_error_t error0;
-	  int next0;
+	  int next0, is_traced0;
+	  u8 frag_next0;
 
 	  /*
 	   * Note: The packet is not enqueued now. It is instead put
@@ -277,19 +570,31 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  p0 = vlib_get_buffer (vm, pi0);
 	  u16 mtu = vnet_buffer (p0)->ip_frag.mtu;
-	  if (is_ip6)
+	  /* in zero-copy mode p0 may be reused, or freed, by the fragments */
+	  frag_next0 = vnet_buffer (p0)->ip_frag.next_index;
+	  is_traced0 = p0->flags & VLIB_BUFFER_IS_TRACED;
+	  if (zero_copy)
+	    error0 = (is_ip6 ?
+		      ip6_frag_do_fragment_chain (vm, pi0, mtu, 0, &buffer) :
+		      ip4_frag_do_fragment_chain (vm, pi0, mtu, 0, &buffer));
+	  else if (is_ip6)
 	    error0 = ip6_frag_do_fragment (vm, pi0, mtu, 0, &buffer);
 	  else
 	    error0 = ip4_frag_do_fragment (vm, pi0, mtu, 0, &buffer);
 
-	  if (PREDICT_FALSE (p0->flags & VLIB_BUFFER_IS_TRACED))
+	  if (PREDICT_FALSE (is_traced0 &&
+			     (!zero_copy || error0 != IP_FRAG_ERROR_NONE ||
+			      vec_len (buffer))))
 	    {
+	      /* the fragments share the packet's trace */
+	      vlib_buffer_t *tb0 = ((zero_copy && error0 == IP_FRAG_ERROR_NONE) ?
+				    vlib_get_buffer (vm, buffer[0]) : p0);
 	      ip_frag_trace_t *tr =
-		vlib_add_trace (vm, node, p0, sizeof (*tr));
+		vlib_add_trace (vm, node, tb0, sizeof (*tr));
 	      tr->mtu = mtu;
 	      tr->ipv6 = is_ip6 ? 1 : 0;
 	      tr->n_fragments = vec_len (buffer);
-	      tr->next = vnet_buffer (p0)->ip_frag.next_index;
+	      tr->next = frag_next0;
 	    }
 
 	  if (!is_ip6 && error0 == IP_FRAG_ERROR_DONT_FRAGMENT_SET)
@@ -302,8 +607,7 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  else
 	    {
 	      next0 = (error0 == IP_FRAG_ERROR_NONE ?
-		       vnet_buffer (p0)->ip_frag.next_index :
-		       IP_FRAG_NEXT_DROP);
+		       frag_next0 : IP_FRAG_NEXT_DROP);
 	    }
 
 	  if (error0 == IP_FRAG_ERROR_NONE)
@@ -311,7 +615,8 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      /* Free original buffer chain */
 	      frag_sent += vec_len (buffer);
 	      small_packets += (vec_len (buffer) == 1);
-	      vlib_buffer_free_one (vm, pi0);	/* Free original packet */
+	      if (!zero_copy)
+		vlib_buffer_free_one (vm, pi0);	/* Free original packet */
 	    }
 	  else
 	    {
@@ -503,6 +808,127 @@ ip6_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
   return IP_FRAG_ERROR_NONE;
 }
 
+/*
+ * Like ip6_frag_do_fragment, but without copying the payload. On success
+ * the packet's buffers are in the fragments, the caller must not free it.
+ */
+ip_frag_error_t
+ip6_frag_do_fragment_chain (vlib_main_t * vm, u32 from_bi, u16 mtu,
+			    u16 l2unfragmentablesize, u32 ** buffer)
+{
+  u16 len, max, rem, hdr_len, fo;
+  u32 n_start, n_frags, ii, ip_frag_id;
+  frag_chain_walk_t w;
+  vlib_buffer_t *from_b;
+  ip_frag_error_t rv;
+  ip6_header_t *ip6;
+  u8 *org_from_packet, next_hdr;
+
+  from_b = vlib_get_buffer (vm, from_bi);
+  org_from_packet = vlib_buffer_get_current (from_b);
+  ip6 = vlib_buffer_get_current (from_b) + l2unfragmentablesize;
+  hdr_len = l2unfragmentablesize + sizeof (ip6_header_t);
+
+  rem = clib_net_to_host_u16 (ip6->payload_length);
+
+  if (rem >
+      (vlib_buffer_length_in_chain (vm, from_b) - sizeof (ip6_header_t)) ||
+      from_b->current_length < hdr_len)
+    {
+      return IP_FRAG_ERROR_MALFORMED;
+    }
+
+  /* TODO: Look through header chain for fragmentation header */
+  if (ip6->protocol == IP_PROTOCOL_IPV6_FRAGMENTATION)
+    {
+      return IP_FRAG_ERROR_MALFORMED;
+    }
+
+  /* as for ip4, a fragment's payload is no bigger than a buffer */
+  max = clib_min (mtu - sizeof (ip6_header_t) - sizeof (ip6_frag_hdr_t),
+		  vlib_buffer_get_default_data_size (vm) - hdr_len -
+		  sizeof (ip6_frag_hdr_t)) & ~0x7;
+
+  if (mtu < sizeof (ip6_header_t) + sizeof (ip6_frag_hdr_t) || 0 == max)
+    {
+      return IP_FRAG_ERROR_CANT_FRAGMENT_HEADER;
+    }
+
+  n_start = vec_len (*buffer);
+  n_frags = (rem + max - 1) / max;
+  rv = frag_chain_alloc (from_b, n_frags, buffer);
+
+  if (IP_FRAG_ERROR_NONE != rv)
+    return (rv);
+
+  ip_frag_id = ++running_fragment_id;
+  next_hdr = ip6->protocol;
+
+  for (ii = 0; ii < n_frags; ii++)
+    {
+      vlib_buffer_t *to_b;
+      ip6_header_t *to_ip6;
+      ip6_frag_hdr_t *to_frag_hdr;
+      u8 *to_data;
+
+      to_b = vlib_get_buffer (vm, (*buffer)[n_start + ii]);
+      frag_set_sw_if_index (to_b, from_b);
+
+      /* Copy ip6 header, and add the fragment header */
+      to_data = vlib_buffer_get_current (to_b);
+      clib_memcpy_fast (to_data, org_from_packet, hdr_len);
+      to_b->current_length = hdr_len + sizeof (ip6_frag_hdr_t);
+      to_ip6 = (ip6_header_t *) (to_data + l2unfragmentablesize);
+      to_ip6->protocol = IP_PROTOCOL_IPV6_FRAGMENTATION;
+      to_frag_hdr = (ip6_frag_hdr_t *) (to_ip6 + 1);
+      to_frag_hdr->identification = ip_frag_id;
+      to_frag_hdr->next_hdr = next_hdr;
+      to_frag_hdr->rsv = 0;
+
+      vnet_buffer (to_b)->l3_hdr_offset = to_b->current_data;
+      to_b->flags |= VNET_BUFFER_F_L3_HDR_OFFSET_VALID;
+
+      if (from_b->flags & VNET_BUFFER_F_L4_HDR_OFFSET_VALID)
+	{
+	  vnet_buffer (to_b)->l4_hdr_offset =
+	    (vnet_buffer (to_b)->l3_hdr_offset +
+	     (vnet_buffer (from_b)->l4_hdr_offset -
+	      vnet_buffer (from_b)->l3_hdr_offset));
+	  to_b->flags |= VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
+	}
+      to_b->flags |= VNET_BUFFER_F_IS_IP6;
+    }
+
+  frag_chain_walk_load (vm, &w, from_bi, hdr_len);
+  fo = 0;
+
+  for (ii = 0; ii < n_frags; ii++)
+    {
+      vlib_buffer_t *to_b;
+      ip6_header_t *to_ip6;
+      ip6_frag_hdr_t *to_frag_hdr;
+
+      len = (rem > max ? max : rem);
+      to_b = vlib_get_buffer (vm, (*buffer)[n_start + ii]);
+      to_ip6 = vlib_buffer_get_current (to_b) + l2unfragmentablesize;
+      to_frag_hdr = (ip6_frag_hdr_t *) (to_ip6 + 1);
+
+      frag_chain_payload (vm, &w, to_b, len);
+
+      to_ip6->payload_length =
+	clib_host_to_net_u16 (len + sizeof (ip6_frag_hdr_t));
+      to_frag_hdr->fragment_offset_and_more =
+	ip6_frag_hdr_offset_and_more ((fo >> 3), len != rem);
+
+      rem -= len;
+      fo += len;
+    }
+
+  frag_chain_walk_end (vm, &w);
+
+  return IP_FRAG_ERROR_NONE;
+}
+
 static char *ip4_frag_error_strings[] = {
 #define _(sym,string) string,
   foreach_ip_frag_error
@@ -555,6 +981,59 @@ VLIB_REGISTER_NODE (ip6_frag_node) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_ip_frag_command_fn (vlib_main_t * vm,
+			unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  ip_frag_main_t *ifm = &ip_frag_main;
+
+  if (unformat (input, "zero-copy"))
+    ifm->zero_copy = 1;
+  else if (unformat (input, "copy"))
+    ifm->zero_copy = 0;
+  else
+    return clib_error_return (0, "unknown input '%U'",
+			      format_unformat_error, input);
+
+  return NULL;
+}
+
+/*?
+ * Set how the ip4-frag and ip6-frag nodes build fragments. In
+ * zero-copy mode the fragments are buffer chains that reuse the
+ * packet's buffers for the payload, so the cost of fragmenting does
+ * not depend on the size of the packet. In copy mode, the default,
+ * each fragment is a single buffer to which the payload is copied.
+ * Use zero-copy only when the output interfaces accept chained buffers.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip fragmentation zero-copy}
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_ip_frag_command, static) = {
+  .path = "set ip fragmentation",
+  .short_help = "set ip fragmentation [zero-copy|copy]",
+  .function = set_ip_frag_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+show_ip_frag_command_fn (vlib_main_t * vm,
+			 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_cli_output (vm, "ip fragmentation: %s",
+		   ip_frag_main.zero_copy ? "zero-copy" : "copy");
+  return NULL;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_ip_frag_command, static) = {
+  .path = "show ip fragmentation",
+  .short_help = "show ip fragmentation",
+  .function = show_ip_frag_command_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -88,6 +88,30 @@ extern ip_frag_error_t ip6_frag_do_fragment (vlib_main_t * vm,
 					     u16 mtu,
 					     u16 encapsize, u32 ** buffer);
 
+/*
+ * Zero-copy variants; the fragments are buffer chains that reuse the
+ * packet's buffers for the payload. On success the packet is consumed,
+ * so, unlike the above, the caller must not free it.
+ */
+extern ip_frag_error_t ip4_frag_do_fragment_chain (vlib_main_t * vm,
+						   u32 from_bi,
+						   u16 mtu,
+						   u16 encapsize,
+						   u32 ** buffer);
+extern ip_frag_error_t ip6_frag_do_fragment_chain (vlib_main_t * vm,
+						   u32 from_bi,
+						   u16 mtu,
+						   u16 encapsize,
+						   u32 ** buffer);
+
+typedef struct ip_frag_main_t_
+{
+  /* ip[46]-frag produce buffer chains rather than copy the payload */
+  u8 zero_copy;
+} ip_frag_main_t;
+
+extern ip_frag_main_t ip_frag_main;
+
 #endif /* ifndef IP_FRAG_H */
 
 /*
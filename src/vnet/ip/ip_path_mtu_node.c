@@ -56,6 +56,7 @@ ip_pmtu_dpo_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   next_index = node->cached_next_index;
 
   u32 *buffer = 0;
+  u8 zero_copy = ip_frag_main.zero_copy;
 
   while (n_left_from > 0)
     {
@@ -90,7 +91,13 @@ ip_pmtu_dpo_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      t->packet_size = vlib_buffer_length_in_chain (vm, p0);
 	    }
 
-	  if (AF_IP6 == af)
+	  if (zero_copy)
+	    error0 = (AF_IP6 == af ?
+			ip6_frag_do_fragment_chain (vm, pi0, ipm0->ipm_pmtu, 0,
+						    &buffer) :
+			ip4_frag_do_fragment_chain (vm, pi0, ipm0->ipm_pmtu, 0,
+						    &buffer));
+	  else if (AF_IP6 == af)
 	    error0 =
 	      ip6_frag_do_fragment (vm, pi0, ipm0->ipm_pmtu, 0, &buffer);
 	  else
@@ -116,7 +123,8 @@ ip_pmtu_dpo_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      /* Free original buffer chain */
 	      frag_sent += vec_len (buffer);
 	      small_packets += (vec_len (buffer) == 1);
-	      vlib_buffer_free_one (vm, pi0); /* Free original packet */
+	      if (!zero_copy)
+		vlib_buffer_free_one (vm, pi0); /* Free original packet */
 	    }
 	  else
 	    {
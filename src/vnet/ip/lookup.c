@@ -194,12 +194,14 @@ vnet_ip_route_cmd (vlib_main_t * vm,
   fib_route_path_t *rpaths = NULL, rpath;
   fib_prefix_t *prefixs = NULL, pfx;
   clib_error_t *error = NULL;
+  fib_entry_flag_t flags;
   f64 count;
   int i;
 
   is_del = 0;
   table_id = 0;
   count = 1;
+  flags = FIB_ENTRY_FLAG_NONE;
   clib_memset (&pfx, 0, sizeof (pfx));
 
   /* Get a line of input. */
@@ -242,6 +244,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	is_del = 1;
       else if (unformat (line_input, "add"))
 	is_del = 0;
+      else if (unformat (line_input, "resilient"))
+	flags |= FIB_ENTRY_FLAG_RESILIENT;
       else
 	{
 	  error = unformat_parse_error (line_input);
@@ -312,6 +316,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	  incr = 1 << ((FIB_PROTOCOL_IP4 == prefixs[0].fp_proto ? 32 : 128) -
 		       prefixs[i].fp_len);
 
+	  fib_table_batch_begin (fib_index, prefixs[0].fp_proto);
+
 	  for (k = 0; k < n; k++)
 	    {
 	      fib_prefix_t rpfx = {
@@ -326,8 +332,7 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	      else
 		fib_table_entry_path_add2 (fib_index,
 					   &rpfx,
-					   FIB_SOURCE_CLI,
-					   FIB_ENTRY_FLAG_NONE, rpaths);
+					   FIB_SOURCE_CLI, flags, rpaths);
 
 	      if (FIB_PROTOCOL_IP4 == prefixs[0].fp_proto)
 		{
@@ -346,6 +351,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 		}
 	    }
 
+	  fib_table_batch_end (fib_index, prefixs[0].fp_proto);
+
 	  t[1] = vlib_time_now (vm);
 	  if (count > 1)
 	    vlib_cli_output (vm, "%.6e routes/sec", count / (t[1] - t[0]));
@@ -498,7 +505,7 @@ VLIB_CLI_COMMAND (vlib_cli_show_ip6_command, static) = {
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip_route_command, static) = {
   .path = "ip route",
-  .short_help = "ip route [add|del] [count <n>] <dst-ip-addr>/<width> [table <table-id>] via [next-hop-address] [next-hop-interface] [next-hop-table <value>] [weight <value>] [preference <value>] [udp-encap-id <value>] [ip4-lookup-in-table <value>] [ip6-lookup-in-table <value>] [mpls-lookup-in-table <value>] [resolve-via-host] [resolve-via-connected] [rx-ip4 <interface>] [out-labels <value value value>]",
+  .short_help = "ip route [add|del] [count <n>] <dst-ip-addr>/<width> [table <table-id>] via [next-hop-address] [next-hop-interface] [next-hop-table <value>] [weight <value>] [preference <value>] [udp-encap-id <value>] [ip4-lookup-in-table <value>] [ip6-lookup-in-table <value>] [mpls-lookup-in-table <value>] [resolve-via-host] [resolve-via-connected] [rx-ip4 <interface>] [out-labels <value value value>] [resilient]",
   .function = vnet_ip_route_cmd,
   .is_mp_safe = 1,
 };
@@ -31,6 +31,7 @@
 #define IP6_FULL_REASS_EXPIRE_WALK_INTERVAL_DEFAULT_MS 10000	// 10 seconds default
 #define IP6_FULL_REASS_MAX_REASSEMBLIES_DEFAULT 1024
 #define IP6_FULL_REASS_MAX_REASSEMBLY_LENGTH_DEFAULT 3
+#define IP6_FULL_REASS_MAX_MEMORY_DEFAULT (16 << 20)	// 16MB per thread
 #define IP6_FULL_REASS_HT_LOAD_FACTOR (0.75)
 
 typedef enum
@@ -125,6 +126,11 @@ typedef struct
   // thread which received fragment with offset 0 and which sends out the
   // completed reassembly
   u32 sendout_thread_index;
+  // buffer memory held by this reassembly
+  u32 mem;
+  // lru indexes
+  u32 lru_prev;
+  u32 lru_next;
 } ip6_full_reass_t;
 
 typedef struct
@@ -133,6 +139,11 @@ typedef struct
   u32 reass_n;
   u32 id_counter;
   clib_spinlock_t lock;
+  // buffer memory held by all reassemblies
+  uword mem_used;
+  // lru indexes, least recently heard first
+  u32 lru_first;
+  u32 lru_last;
 } ip6_full_reass_per_thread_t;
 
 typedef struct
@@ -145,6 +156,8 @@ typedef struct
   u32 max_reass_len;
   // maximum number of reassemblies
   u32 max_reass_n;
+  // maximum buffer memory held by reassemblies, per thread, 0 is no limit
+  uword max_reass_mem;
 
   // IPv6 runtime
   clib_bihash_48_8_t hash;
@@ -373,10 +386,73 @@ ip6_full_reass_add_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
 #endif
 }
 
+/*
+ * The buffer memory that a fragment holds while it waits for the rest
+ */
+always_inline u32
+ip6_full_reass_buffer_mem (vlib_main_t * vm, vlib_buffer_t * b)
+{
+  u32 n_buffers = 1;
+
+  while (b->flags & VLIB_BUFFER_NEXT_PRESENT)
+    {
+      b = vlib_get_buffer (vm, b->next_buffer);
+      ++n_buffers;
+    }
+  return n_buffers * vlib_buffer_get_default_data_size (vm);
+}
+
+always_inline void
+ip6_full_reass_lru_remove (ip6_full_reass_per_thread_t * rt,
+			   ip6_full_reass_t * reass)
+{
+  if (~0 != reass->lru_prev)
+    {
+      ip6_full_reass_t *lru_prev =
+	pool_elt_at_index (rt->pool, reass->lru_prev);
+      lru_prev->lru_next = reass->lru_next;
+    }
+  if (~0 != reass->lru_next)
+    {
+      ip6_full_reass_t *lru_next =
+	pool_elt_at_index (rt->pool, reass->lru_next);
+      lru_next->lru_prev = reass->lru_prev;
+    }
+  if (rt->lru_first == reass - rt->pool)
+    {
+      rt->lru_first = reass->lru_next;
+    }
+  if (rt->lru_last == reass - rt->pool)
+    {
+      rt->lru_last = reass->lru_prev;
+    }
+}
+
+always_inline void
+ip6_full_reass_lru_add (ip6_full_reass_per_thread_t * rt,
+			ip6_full_reass_t * reass)
+{
+  reass->lru_prev = rt->lru_last;
+  reass->lru_next = ~0;
+
+  if (~0 != rt->lru_last)
+    {
+      ip6_full_reass_t *lru_last = pool_elt_at_index (rt->pool, rt->lru_last);
+      lru_last->lru_next = reass - rt->pool;
+    }
+  else
+    {
+      rt->lru_first = reass - rt->pool;
+    }
+  rt->lru_last = reass - rt->pool;
+}
+
 always_inline void
 ip6_full_reass_free_ctx (ip6_full_reass_per_thread_t * rt,
 			 ip6_full_reass_t * reass)
 {
+  ip6_full_reass_lru_remove (rt, reass);
+  rt->mem_used -= reass->mem;
   pool_put (rt->pool, reass);
   --rt->reass_n;
 }
@@ -397,7 +473,11 @@ ip6_full_reass_free (ip6_full_reass_main_t * rm,
   ip6_full_reass_free_ctx (rt, reass);
 }
 
-always_inline void
+/*
+ * Drop all the fragments of a reassembly. Returns the number of buffers
+ * dropped.
+ */
+always_inline u32
 ip6_full_reass_drop_all (vlib_main_t * vm, vlib_node_runtime_t * node,
 			 ip6_full_reass_main_t * rm, ip6_full_reass_t * reass)
 {
@@ -405,6 +485,7 @@ ip6_full_reass_drop_all (vlib_main_t * vm, vlib_node_runtime_t * node,
   vlib_buffer_t *range_b;
   vnet_buffer_opaque_t *range_vnb;
   u32 *to_free = NULL;
+  u32 n_dropped;
   while (~0 != range_bi)
     {
       range_b = vlib_get_buffer (vm, range_bi);
@@ -426,6 +507,7 @@ ip6_full_reass_drop_all (vlib_main_t * vm, vlib_node_runtime_t * node,
 	}
       range_bi = range_vnb->ip.reass.next_range_bi;
     }
+  n_dropped = vec_len (to_free);
   /* send to next_error_index */
   if (~0 != reass->error_next_index)
     {
@@ -457,16 +539,21 @@ ip6_full_reass_drop_all (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_buffer_free (vm, to_free, vec_len (to_free));
     }
   vec_free (to_free);
+  return n_dropped;
 }
 
-always_inline void
+/*
+ * Returns the number of buffers dropped, not including that sent in the
+ * icmp error.
+ */
+always_inline u32
 ip6_full_reass_on_timeout (vlib_main_t * vm, vlib_node_runtime_t * node,
 			   ip6_full_reass_main_t * rm,
 			   ip6_full_reass_t * reass, u32 * icmp_bi)
 {
   if (~0 == reass->first_bi)
     {
-      return;
+      return 0;
     }
   if (~0 == reass->next_index)	// custom apps don't want icmp
     {
@@ -495,7 +582,7 @@ ip6_full_reass_on_timeout (vlib_main_t * vm, vlib_node_runtime_t * node,
 				       0);
 	}
     }
-  ip6_full_reass_drop_all (vm, node, rm, reass);
+  return ip6_full_reass_drop_all (vm, node, rm, reass);
 }
 
 always_inline ip6_full_reass_t *
@@ -528,7 +615,11 @@ again:
 
       if (now > reass->last_heard + rm->timeout)
 	{
-	  ip6_full_reass_on_timeout (vm, node, rm, reass, icmp_bi);
+	  vlib_node_increment_counter (vm, node->node_index,
+				       IP6_ERROR_REASS_TIMEOUT,
+				       ip6_full_reass_on_timeout (vm, node,
+								  rm, reass,
+								  icmp_bi));
 	  ip6_full_reass_free (rm, rt, reass);
 	  reass = NULL;
 	}
@@ -537,6 +628,8 @@ again:
   if (reass)
     {
       reass->last_heard = now;
+      ip6_full_reass_lru_remove (rt, reass);
+      ip6_full_reass_lru_add (rt, reass);
       return reass;
     }
 
@@ -556,6 +649,7 @@ again:
       reass->data_len = 0;
       reass->next_index = ~0;
       reass->error_next_index = ~0;
+      ip6_full_reass_lru_add (rt, reass);
       ++rt->reass_n;
     }
 
@@ -835,6 +929,9 @@ ip6_full_reass_insert_range_in_chain (vlib_main_t * vm,
       reass->first_bi = new_next_bi;
     }
   reass->data_len += ip6_full_reass_buffer_get_data_len (new_next_b);
+  u32 mem = ip6_full_reass_buffer_mem (vm, new_next_b);
+  reass->mem += mem;
+  rt->mem_used += mem;
 }
 
 always_inline ip6_full_reass_rc_t
@@ -894,6 +991,27 @@ ip6_full_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
   reass->min_fragment_length =
     clib_min (clib_net_to_host_u16 (fip->payload_length),
 	      fvnb->ip.reass.estimated_mtu);
+  if (!more_fragments && 1 == reass->fragments_n)
+    {
+      /*
+       * fast path: the last fragment directly follows the first, so
+       * there's no overlap to look for.
+       */
+      vlib_buffer_t *first_b = vlib_get_buffer (vm, reass->first_bi);
+      vnet_buffer_opaque_t *first_vnb = vnet_buffer (first_b);
+      if (0 == first_vnb->ip.reass.range_first &&
+	  ~0 == first_vnb->ip.reass.next_range_bi &&
+	  fragment_first == first_vnb->ip.reass.range_last + 1)
+	{
+	  ip6_full_reass_insert_range_in_chain (vm, rm, rt, reass,
+						reass->first_bi, *bi0);
+	  vlib_node_increment_counter (vm, node->node_index,
+				       IP6_ERROR_REASS_IN_ORDER, 1);
+	  consumed = 1;
+	  ++reass->fragments_n;
+	  goto check_if_done_maybe;
+	}
+    }
   while (~0 != candidate_range_bi)
     {
       vlib_buffer_t *candidate_b = vlib_get_buffer (vm, candidate_range_bi);
@@ -986,6 +1104,32 @@ check_if_done_maybe:
   return IP6_FULL_REASS_RC_OK;
 }
 
+/*
+ * Make room for a fragment holding mem bytes, by dropping the least
+ * recently heard reassemblies other than the fragment's own.
+ * Returns 0 if there is still no room.
+ */
+always_inline int
+ip6_full_reass_evict (vlib_main_t * vm, vlib_node_runtime_t * node,
+		      ip6_full_reass_main_t * rm,
+		      ip6_full_reass_per_thread_t * rt,
+		      ip6_full_reass_t * reass, u32 mem)
+{
+  u32 n_dropped = 0;
+
+  while (rt->mem_used + mem > rm->max_reass_mem &&
+	 ~0 != rt->lru_first && rt->lru_first != reass - rt->pool)
+    {
+      ip6_full_reass_t *lru = pool_elt_at_index (rt->pool, rt->lru_first);
+      n_dropped += ip6_full_reass_drop_all (vm, node, rm, lru);
+      ip6_full_reass_free (rm, rt, lru);
+    }
+  vlib_node_increment_counter (vm, node->node_index,
+			       IP6_ERROR_REASS_EVICTED, n_dropped);
+
+  return (rt->mem_used + mem <= rm->max_reass_mem);
+}
+
 always_inline bool
 ip6_full_reass_verify_upper_layer_present (vlib_node_runtime_t * node,
 					   vlib_buffer_t * b,
@@ -1153,6 +1297,25 @@ ip6_full_reassembly_inline (vlib_main_t * vm,
 	  else if (reass)
 	    {
 	      u32 handoff_thread_idx;
+	      if (PREDICT_FALSE
+		  (rm->max_reass_mem &&
+		   rt->mem_used + ip6_full_reass_buffer_mem (vm, b0) >
+		   rm->max_reass_mem) &&
+		  !ip6_full_reass_evict (vm, node, rm, rt, reass,
+					 ip6_full_reass_buffer_mem (vm, b0)))
+		{
+		  /* this reassembly alone is over the limit */
+		  vlib_node_increment_counter (vm, node->node_index,
+					       IP6_ERROR_REASS_EVICTED,
+					       ip6_full_reass_drop_all (vm,
+									node,
+									rm,
+									reass));
+		  ip6_full_reass_free (rm, rt, reass);
+		  next0 = IP6_FULL_REASSEMBLY_NEXT_DROP;
+		  error0 = IP6_ERROR_REASS_EVICTED;
+		  goto skip_reass;
+		}
 	      switch (ip6_full_reass_update
 		      (vm, node, rm, rt, reass, &bi0, &next0, &error0,
 		       frag_hdr, is_custom_app, &handoff_thread_idx))
@@ -1447,6 +1610,7 @@ ip6_full_reass_init_function (vlib_main_t * vm)
   {
     clib_spinlock_init (&rt->lock);
     pool_alloc (rt->pool, rm->max_reass_n);
+    rt->lru_first = rt->lru_last = ~0;
   }
 
   node = vlib_get_node_by_name (vm, (u8 *) "ip6-full-reassembly-expire-walk");
@@ -1457,6 +1621,7 @@ ip6_full_reass_init_function (vlib_main_t * vm)
 			     IP6_FULL_REASS_MAX_REASSEMBLIES_DEFAULT,
 			     IP6_FULL_REASS_MAX_REASSEMBLY_LENGTH_DEFAULT,
 			     IP6_FULL_REASS_EXPIRE_WALK_INTERVAL_DEFAULT_MS);
+  rm->max_reass_mem = IP6_FULL_REASS_MAX_MEMORY_DEFAULT;
 
   nbuckets = ip6_full_reass_get_nbuckets ();
   clib_bihash_init_48_8 (&rm->hash, "ip6-full-reass", nbuckets,
@@ -1516,7 +1681,7 @@ ip6_full_reass_walk_expired (vlib_main_t * vm,
       int *pool_indexes_to_free = NULL;
 
       uword thread_index = 0;
-      int index;
+      u32 index;
       const uword nthreads = vlib_num_workers () + 1;
       u32 *vec_icmp_bi = NULL;
       for (thread_index = 0; thread_index < nthreads; ++thread_index)
@@ -1526,28 +1691,33 @@ ip6_full_reass_walk_expired (vlib_main_t * vm,
 	  clib_spinlock_lock (&rt->lock);
 
 	  vec_reset_length (pool_indexes_to_free);
-          /* *INDENT-OFF* */
-          pool_foreach_index (index, rt->pool)  {
-                                reass = pool_elt_at_index (rt->pool, index);
-                                if (now > reass->last_heard + rm->timeout)
-                                  {
-                                    vec_add1 (pool_indexes_to_free, index);
-                                  }
-                              }
-          /* *INDENT-ON* */
+	  /* the lru is in the order heard, so stop at the first unexpired */
+	  index = rt->lru_first;
+	  while (~0 != index)
+	    {
+	      reass = pool_elt_at_index (rt->pool, index);
+	      if (now <= reass->last_heard + rm->timeout)
+		break;
+	      vec_add1 (pool_indexes_to_free, index);
+	      index = reass->lru_next;
+	    }
 	  int *i;
+	  u32 n_dropped = 0;
           /* *INDENT-OFF* */
           vec_foreach (i, pool_indexes_to_free)
           {
             ip6_full_reass_t *reass = pool_elt_at_index (rt->pool, i[0]);
             u32 icmp_bi = ~0;
-            ip6_full_reass_on_timeout (vm, node, rm, reass, &icmp_bi);
+            n_dropped +=
+              ip6_full_reass_on_timeout (vm, node, rm, reass, &icmp_bi);
             if (~0 != icmp_bi)
               vec_add1 (vec_icmp_bi, icmp_bi);
 
             ip6_full_reass_free (rm, rt, reass);
           }
           /* *INDENT-ON* */
+	  vlib_node_increment_counter (vm, node->node_index,
+				       IP6_ERROR_REASS_TIMEOUT, n_dropped);
 
 	  clib_spinlock_unlock (&rt->lock);
 	}
@@ -1662,6 +1832,7 @@ show_ip6_full_reass (vlib_main_t * vm, unformat_input_t * input,
 
   u32 sum_reass_n = 0;
   u64 sum_buffers_n = 0;
+  uword sum_mem_used = 0;
   ip6_full_reass_t *reass;
   uword thread_index;
   const uword nthreads = vlib_num_workers () + 1;
@@ -1678,6 +1849,7 @@ show_ip6_full_reass (vlib_main_t * vm, unformat_input_t * input,
           /* *INDENT-ON* */
 	}
       sum_reass_n += rt->reass_n;
+      sum_mem_used += rt->mem_used;
       clib_spinlock_unlock (&rt->lock);
     }
   vlib_cli_output (vm, "---------------------");
@@ -1686,6 +1858,11 @@ show_ip6_full_reass (vlib_main_t * vm, unformat_input_t * input,
   vlib_cli_output (vm,
 		   "Maximum configured concurrent full IP6 reassemblies per worker-thread: %lu\n",
 		   (long unsigned) rm->max_reass_n);
+  vlib_cli_output (vm, "Current full IP6 reassembly memory: %U\n",
+		   format_memory_size, sum_mem_used);
+  vlib_cli_output (vm,
+		   "Maximum configured full IP6 reassembly memory per worker-thread: %U\n",
+		   format_memory_size, rm->max_reass_mem);
   vlib_cli_output (vm,
 		   "Maximum configured full IP6 reassembly timeout: %lums\n",
 		   (long unsigned) rm->timeout_ms);
@@ -1705,6 +1882,46 @@ VLIB_CLI_COMMAND (show_ip6_full_reassembly_cmd, static) = {
 };
 /* *INDENT-ON* */
 
+#ifndef CLIB_MARCH_VARIANT
+vnet_api_error_t
+ip6_full_reass_set_max_memory (uword max_memory)
+{
+  ip6_full_reass_main.max_reass_mem = max_memory;
+  return 0;
+}
+#endif /* CLIB_MARCH_VARIANT */
+
+static clib_error_t *
+set_ip6_full_reass (vlib_main_t * vm,
+		    unformat_input_t * input,
+		    CLIB_UNUSED (vlib_cli_command_t * lmd))
+{
+  uword max_memory;
+
+  if (!unformat (input, "max-memory %U", unformat_memory_size, &max_memory))
+    return clib_error_return (0, "unknown input '%U'",
+			      format_unformat_error, input);
+
+  ip6_full_reass_set_max_memory (max_memory);
+  return 0;
+}
+
+/*?
+ * Set the limit on the buffer memory that each thread's full IP6
+ * reassemblies hold. When a fragment would exceed it, the least recently
+ * heard reassemblies are dropped. 0 is no limit.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip6-full-reassembly max-memory 16m}
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_ip6_full_reassembly_cmd, static) = {
+    .path = "set ip6-full-reassembly",
+    .short_help = "set ip6-full-reassembly max-memory <n>[k|m|g]",
+    .function = set_ip6_full_reass,
+};
+/* *INDENT-ON* */
+
 #ifndef CLIB_MARCH_VARIANT
 vnet_api_error_t
 ip6_full_reass_enable_disable (u32 sw_if_index, u8 enable_disable)
@@ -40,6 +40,12 @@ vnet_api_error_t ip6_full_reass_get (u32 * timeout_ms, u32 * max_reassemblies,
 				     u32 * max_reassembly_length,
 				     u32 * expire_walk_interval_ms);
 
+/**
+ * @brief set the limit on the buffer memory held by each thread's
+ * reassemblies, 0 is no limit
+ */
+vnet_api_error_t ip6_full_reass_set_max_memory (uword max_memory);
+
 vnet_api_error_t ip6_full_reass_enable_disable (u32 sw_if_index,
 						u8 enable_disable);
 
@@ -43,6 +43,11 @@
 
 bd_main_t bd_main;
 
+vlib_combined_counter_main_t bd_flood_counters = {
+  .name = "bd-flood",
+  .stat_segment_name = "/l2/bd/flood",
+};
+
 /**
   Init bridge domain if not done already.
   For feature bitmap, set all bits except ARP termination
@@ -57,6 +62,8 @@ bd_validate (l2_bridge_domain_t * bd_config)
   bd_config->bvi_sw_if_index = ~0;
   bd_config->uu_fwd_sw_if_index = ~0;
   bd_config->members = 0;
+  bd_config->flood_members_by_shg = 0;
+  bd_config->flood_sw_if_bitmap = 0;
   bd_config->flood_count = 0;
   bd_config->tun_master_count = 0;
   bd_config->tun_normal_count = 0;
@@ -92,6 +99,9 @@ bd_add_bd_index (bd_main_t * bdm, u32 bd_id)
     l2learn_main.bd_default_learn_limit;
   l2input_main.bd_configs[rv].learn_count = 0;
 
+  vlib_validate_combined_counter (&bd_flood_counters, rv);
+  vlib_zero_combined_counter (&bd_flood_counters, rv);
+
   return rv;
 }
 
@@ -116,6 +126,7 @@ bd_delete (bd_main_t * bdm, u32 bd_index)
 {
   l2_bridge_domain_t *bd = &l2input_main.bd_configs[bd_index];
   u32 bd_id = bd->bd_id;
+  u32 i;
 
   /* flush non-static MACs in BD and removed bd_id from hash table */
   l2fib_flush_bd_mac (vlib_get_main (), bd_index);
@@ -129,12 +140,17 @@ bd_delete (bd_main_t * bdm, u32 bd_index)
   bd->feature_bitmap = 0;
   bd->learn_limit = 0;
   bd->learn_count = ~0;
+  bd->learn_rate = 0;
 
   /* free BD tag */
   vec_free (bd->bd_tag);
 
   /* free memory used by BD */
   vec_free (bd->members);
+  vec_foreach_index (i, bd->flood_members_by_shg)
+    vec_free (bd->flood_members_by_shg[i]);
+  vec_free (bd->flood_members_by_shg);
+  clib_bitmap_free (bd->flood_sw_if_bitmap);
   bd_free_ip_mac_tables (bd);
 
   return 0;
@@ -149,6 +165,44 @@ update_flood_count (l2_bridge_domain_t * bd_config)
   bd_config->flood_count -= bd_config->no_flood_count;
 }
 
+/**
+ * Precompute the flood members for each split horizon group, so the
+ * data-path need not check every member of the bridge domain for every
+ * flooded packet. The members are flooded in reverse, so a BVI, the first
+ * member, is always processed last.
+ */
+static void
+update_flood_members (l2_bridge_domain_t * bd_config)
+{
+  l2_flood_member_t *member;
+  u32 shg, max_shg;
+  i32 mi;
+
+  vec_foreach_index (shg, bd_config->flood_members_by_shg)
+    vec_reset_length (bd_config->flood_members_by_shg[shg]);
+  clib_bitmap_zero (bd_config->flood_sw_if_bitmap);
+
+  max_shg = 0;
+  for (mi = 0; mi < bd_config->flood_count; mi++)
+    {
+      member = vec_elt_at_index (bd_config->members, mi);
+      max_shg = clib_max (max_shg, member->shg);
+      bd_config->flood_sw_if_bitmap =
+	clib_bitmap_set (bd_config->flood_sw_if_bitmap, member->sw_if_index,
+			 1);
+    }
+
+  vec_validate (bd_config->flood_members_by_shg, max_shg);
+
+  for (shg = 0; shg <= max_shg; shg++)
+    for (mi = bd_config->flood_count - 1; mi >= 0; mi--)
+      {
+	member = vec_elt_at_index (bd_config->members, mi);
+	if (!shg || member->shg != shg)
+	  vec_add1 (bd_config->flood_members_by_shg[shg], *member);
+      }
+}
+
 void
 bd_add_member (l2_bridge_domain_t * bd_config, l2_flood_member_t * member)
 {
@@ -189,6 +243,7 @@ bd_add_member (l2_bridge_domain_t * bd_config, l2_flood_member_t * member)
 
   vec_insert_elts (bd_config->members, member, 1, ix);
   update_flood_count (bd_config);
+  update_flood_members (bd_config);
 }
 
 #define BD_REMOVE_ERROR_OK        0
@@ -219,6 +274,7 @@ bd_remove_member (l2_bridge_domain_t * bd_config, u32 sw_if_index)
 	  }
 	vec_delete (bd_config->members, 1, ix);
 	update_flood_count (bd_config);
+	update_flood_members (bd_config);
 
 	return BD_REMOVE_ERROR_OK;
       }
@@ -372,6 +428,18 @@ bd_set_learn_limit (vlib_main_t *vm, u32 bd_index, u32 learn_limit)
   bd_config->learn_limit = learn_limit;
 }
 
+/**
+    Set the learn rate limit for the bridge domain.
+*/
+void
+bd_set_learn_rate (vlib_main_t *vm, u32 bd_index, u32 learn_rate)
+{
+  l2_bridge_domain_t *bd_config;
+  vec_validate (l2input_main.bd_configs, bd_index);
+  bd_config = vec_elt_at_index (l2input_main.bd_configs, bd_index);
+  bd_config->learn_rate = learn_rate;
+}
+
 /**
     Set the tag for the bridge domain.
 */
@@ -911,6 +979,68 @@ VLIB_CLI_COMMAND (bd_learn_limit_cli, static) = {
   .function = bd_learn_limit,
 };
 
+static clib_error_t *
+bd_learn_rate (vlib_main_t *vm, unformat_input_t *input,
+	       vlib_cli_command_t *cmd)
+{
+  bd_main_t *bdm = &bd_main;
+  clib_error_t *error = 0;
+  u32 bd_index, bd_id;
+  u32 learn_rate;
+  uword *p;
+
+  if (!unformat (input, "%d", &bd_id))
+    {
+      error = clib_error_return (0, "expecting bridge-domain id but got `%U'",
+				 format_unformat_error, input);
+      goto done;
+    }
+
+  if (bd_id == 0)
+    return clib_error_return (
+      0, "No operations on the default bridge domain are supported");
+
+  p = hash_get (bdm->bd_index_by_bd_id, bd_id);
+
+  if (p == 0)
+    return clib_error_return (0, "No such bridge domain %d", bd_id);
+
+  bd_index = p[0];
+
+  if (unformat (input, "off"))
+    learn_rate = 0;
+  else if (!unformat (input, "%u", &learn_rate))
+    {
+      error = clib_error_return (
+	0, "expecting learns per second but got `%U'", format_unformat_error,
+	input);
+      goto done;
+    }
+
+  bd_set_learn_rate (vm, bd_index, learn_rate);
+
+done:
+  return error;
+}
+
+/*?
+ * Limit the rate at which new MACs are learned and learned MACs are
+ * moved between interfaces in a bridge-domain. The rate is shared
+ * evenly between the worker threads; learns above it are not applied
+ * and the packets are forwarded as for an unknown source. Use 'off'
+ * to remove the limit.
+ *
+ * @cliexpar
+ * Example of how to allow 1000 learns per second on bridge-domain 200:
+ * @cliexcmd{set bridge-domain learn-rate 200 1000}
+?*/
+VLIB_CLI_COMMAND (bd_learn_rate_cli, static) = {
+  .path = "set bridge-domain learn-rate",
+  .short_help =
+    "set bridge-domain learn-rate <bridge-domain-id> <learns-per-sec>|off",
+  .function = bd_learn_rate,
+};
+
 /*?
  * Modify whether or not an existing bridge-domain should terminate and respond
  * to ARP Requests. ARP Termination is disabled by default.
@@ -1241,8 +1371,18 @@ bd_show (vlib_main_t * vm, unformat_input_t * input, vlib_cli_command_t * cmd)
 	    format_vnet_sw_if_index_name_with_NA, vnm,
 	    bd_config->bvi_sw_if_index);
 	  if (detail)
-	    vlib_cli_output (vm, "%U", format_l2_input_feature_bitmap,
-			     bd_config->feature_bitmap);
+	    {
+	      vlib_counter_t fc;
+
+	      vlib_cli_output (vm, "%U", format_l2_input_feature_bitmap,
+			       bd_config->feature_bitmap);
+	      if (bd_config->learn_rate)
+		vlib_cli_output (vm, "  learn rate limit: %u/sec",
+				 bd_config->learn_rate);
+	      vlib_get_combined_counter (&bd_flood_counters, bd_index, &fc);
+	      vlib_cli_output (vm, "  flooded copies: %Ld bytes: %Ld",
+			       fc.packets, fc.bytes);
+	    }
 	  vec_reset_length (as);
 
 	  if (detail || intf)
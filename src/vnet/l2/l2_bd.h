@@ -45,6 +45,9 @@ typedef struct
 
 extern bd_main_t bd_main;
 
+/* Per-bridge domain count and bytes of the copies made when flooding */
+extern vlib_combined_counter_main_t bd_flood_counters;
+
 /* Bridge domain member  */
 
 #define L2_FLOOD_MEMBER_NORMAL 0
@@ -88,6 +91,16 @@ typedef struct
   /* First flood_count member ports are flooded */
   u32 flood_count;
 
+  /*
+   * The flooded members, in flooding order, for packets received in each
+   * split horizon group; that is, the members not in that group. Index 0
+   * holds all of them. Groups above the highest in use flood to all too.
+   */
+  l2_flood_member_t **flood_members_by_shg;
+
+  /* the sw_if_index of each flooded member */
+  uword *flood_sw_if_bitmap;
+
   /* Tunnel Master (Multicast vxlan) are always flooded */
   u32 tun_master_count;
 
@@ -116,6 +129,9 @@ typedef struct
   /* Current number of learned entries */
   u32 learn_count;
 
+  /* Maximum rate of new learns and mac moves per second, 0 for no limit */
+  u32 learn_rate;
+
 } l2_bridge_domain_t;
 
 /* Limit Bridge Domain ID to 24 bits to match 24-bit VNI range */
@@ -165,6 +181,7 @@ u32 bd_set_flags (vlib_main_t * vm, u32 bd_index, bd_flags_t flags,
 		  u32 enable);
 void bd_set_mac_age (vlib_main_t * vm, u32 bd_index, u8 age);
 void bd_set_learn_limit (vlib_main_t *vm, u32 bd_index, u32 learn_limit);
+void bd_set_learn_rate (vlib_main_t *vm, u32 bd_index, u32 learn_rate);
 int bd_add_del (l2_bridge_domain_add_del_args_t * args);
 
 /**
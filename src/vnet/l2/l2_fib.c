@@ -384,6 +384,7 @@ l2fib_clear_table (void)
 {
   l2fib_main_t *mp = &l2fib_main;
   l2_bridge_domain_t *bd_config;
+  int i;
 
   if (mp->mac_table_initialized == 0)
     return;
@@ -396,6 +397,9 @@ l2fib_clear_table (void)
   l2learn_main.global_learn_count = 0;
   vec_foreach (bd_config, l2input_main.bd_configs)
     bd_config->learn_count = 0;
+
+  for (i = 0; i < ARRAY_LEN (mp->age_wheel); i++)
+    vec_reset_length (mp->age_wheel[i]);
 }
 
 /** Clear all entries in L2FIB.
@@ -469,11 +473,8 @@ l2fib_add_entry (const u8 * mac, u32 bd_index,
 	  l2_bridge_domain_t *bd_config =
 	    vec_elt_at_index (l2input_main.bd_configs, bd_index);
 
-	  /* check if learn_count == 0 in case of race condition between 2
-	   * workers adding an entry simultaneously */
-	  /* learn_count variable may have little inaccuracy because they are
-	   * not incremented/decremented with atomic operations */
-	  /* l2fib_scan is call every 2sec fixing potential inaccuracy */
+	  /* learns are counted by the main thread as it applies them, but
+	   * check in case a scan has not yet recounted a reused bd */
 	  if (lm->global_learn_count)
 	    lm->global_learn_count--;
 	  if (bd_config->learn_count)
@@ -1084,6 +1085,125 @@ allocate_mac_evt_buf (u32 client, u32 client_index)
   return mp;
 }
 
+/**
+ * Queue a learned mac to be checked for age when it is next due, that is
+ * mac_age minutes after its timestamp.
+ */
+void
+l2fib_age_wheel_add (u64 key, u8 timestamp, u8 mac_age)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  u8 slot = timestamp + mac_age;
+
+  /* never behind the ager, else it would wait for the wheel to wrap */
+  if (slot == fm->age_wheel_minute)
+    slot++;
+
+  vec_add1 (fm->age_wheel[slot], key);
+}
+
+static_always_inline void
+l2fib_age_wheel_add_entry (l2fib_entry_key_t * key,
+			   l2fib_entry_result_t * result)
+{
+  l2_bridge_domain_t *bd_config =
+    vec_elt_at_index (l2input_main.bd_configs, key->fields.bd_index);
+
+  if (bd_config->mac_age)
+    l2fib_age_wheel_add (key->raw, result->fields.timestamp,
+			 bd_config->mac_age);
+}
+
+/**
+ * Age out the learned macs in the wheel's buckets up to the current
+ * minute. Macs refreshed since they were queued are queued again for
+ * when they are next due, so each run touches only the macs that may
+ * have expired rather than the whole table.
+ */
+static_always_inline f64
+l2fib_age_wheel_run (vlib_main_t * vm, f64 start_time)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  BVT (clib_bihash) * h = &fm->mac_table;
+  u8 minute = (u8) (start_time / 60);
+  f64 last_start = start_time;
+  f64 accum_t = 0;
+  f64 delta_t = 0;
+  u64 *keys, *k;
+
+  if (alloc_arena (h) == 0)
+    return 0.0;
+
+  while (fm->age_wheel_minute != minute)
+    {
+      fm->age_wheel_minute++;
+      keys = fm->age_wheel[fm->age_wheel_minute];
+      fm->age_wheel[fm->age_wheel_minute] = 0;
+
+      vec_foreach (k, keys)
+      {
+	l2_bridge_domain_t *bd_config;
+	l2fib_entry_result_t result;
+	l2fib_entry_key_t key;
+	BVT (clib_bihash_kv) kv;
+	u8 delta;
+
+	/* allow no more than 20us without a pause */
+	delta_t = vlib_time_now (vm) - last_start;
+	if (delta_t > 20e-6)
+	  {
+	    vlib_process_suspend (vm, 100e-6);	/* suspend for 100 us */
+	    last_start = vlib_time_now (vm);
+	    accum_t += delta_t;
+	  }
+
+	kv.key = *k;
+	if (BV (clib_bihash_search) (h, &kv, &kv))
+	  continue;		/* already removed */
+
+	key.raw = kv.key;
+	result.raw = kv.value;
+
+	if (l2fib_entry_result_is_set_AGE_NOT (&result))
+	  continue;		/* provisioned since it was learned */
+
+	if (result.fields.sn !=
+	    l2fib_cur_seq_num (key.fields.bd_index,
+			       result.fields.sw_if_index))
+	  goto age_out;		/* stale mac */
+
+	bd_config = vec_elt_at_index (l2input_main.bd_configs,
+				      key.fields.bd_index);
+
+	/* re-queued by the scan when aging is enabled again */
+	if (bd_config->mac_age == 0)
+	  continue;
+
+	delta = minute - result.fields.timestamp;
+
+	if (delta < bd_config->mac_age)
+	  {
+	    /* refreshed since it was queued */
+	    l2fib_age_wheel_add (kv.key, result.fields.timestamp,
+				 bd_config->mac_age);
+	    continue;
+	  }
+
+      age_out:
+	BV (clib_bihash_add_del) (h, &kv, 0);
+	if (l2learn_main.global_learn_count)
+	  l2learn_main.global_learn_count--;
+	bd_config = vec_elt_at_index (l2input_main.bd_configs,
+				      key.fields.bd_index);
+	if (bd_config->learn_count)
+	  bd_config->learn_count--;
+      }
+      vec_free (keys);
+    }
+
+  return delta_t + accum_t;
+}
+
 static_always_inline f64
 l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 {
@@ -1117,6 +1237,20 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
       reg = vl_api_client_index_to_registration (lm->client_index);
     }
 
+  if (!event_only)
+    {
+      /*
+       * Hold the learns queued while this scan is suspended, so the
+       * learned macs it counts are all there are.
+       */
+      lm->drain_held = 1;
+
+      /* rebuild the age wheel from the entries that survive this scan */
+      for (i = 0; i < ARRAY_LEN (fm->age_wheel); i++)
+	vec_reset_length (fm->age_wheel[i]);
+      fm->age_wheel_minute = (u8) (start_time / 60);
+    }
+
   for (i = 0; i < h->nbuckets; i++)
     {
       /* allow no more than 20us without a pause */
@@ -1207,6 +1341,9 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 		      kv.value = result.raw;
 		      BV (clib_bihash_add_del) (&fm->mac_table, &kv, 1);
 		      evt_idx++;
+		      if (!event_only &&
+			  !l2fib_entry_result_is_set_AGE_NOT (&result))
+			l2fib_age_wheel_add_entry (&key, &result);
 		      continue;	/* skip aging */
 		    }
 		}
@@ -1231,7 +1368,12 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 	      delta += delta < 0 ? 256 : 0;
 
 	      if (delta < bd_config->mac_age)
-		continue;	/* still valid */
+		{
+		  /* still valid */
+		  l2fib_age_wheel_add (key.raw, result.fields.timestamp,
+				       bd_config->mac_age);
+		  continue;
+		}
 
 	    age_out:
 	      if (client)
@@ -1265,12 +1407,18 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
       ;
     }
 
-  /* keep learn count consistent */
-  l2learn_main.global_learn_count = learn_count;
-  vec_foreach_index (bd_index, l2input_main.bd_configs)
+  if (!event_only)
     {
-      vec_elt (l2input_main.bd_configs, bd_index).learn_count =
-	vec_elt (bd_learn_counts, bd_index);
+      /* keep learn count consistent */
+      l2learn_main.global_learn_count = learn_count;
+      vec_foreach_index (bd_index, l2input_main.bd_configs)
+	{
+	  vec_elt (l2input_main.bd_configs, bd_index).learn_count =
+	    vec_elt (bd_learn_counts, bd_index);
+	}
+
+      lm->drain_held = 0;
+      vlib_node_set_interrupt_pending (vm, l2learn_drain_node.index);
     }
 
   if (mp)
@@ -1324,13 +1472,21 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 
       start_time = vlib_time_now (vm);
       enum
-      { SCAN_MAC_AGE, SCAN_MAC_EVENT, SCAN_DISABLE } scan = SCAN_MAC_AGE;
+      {
+	SCAN_MAC_AGE,
+	SCAN_MAC_AGE_WHEEL,
+	SCAN_MAC_EVENT,
+	SCAN_DISABLE,
+      } scan = SCAN_MAC_AGE;
 
       switch (event_type)
 	{
 	case ~0:		/* timer expired */
 	  if (lm->client_pid != 0 && start_time < next_age_scan_time)
 	    scan = SCAN_MAC_EVENT;
+	  else if (lm->client_pid == 0)
+	    /* a full scan is needed only to report events or on a change */
+	    scan = SCAN_MAC_AGE_WHEEL;
 	  break;
 
 	case L2_MAC_AGE_PROCESS_EVENT_START:
@@ -1355,6 +1511,9 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	{
 	  if (scan == SCAN_MAC_AGE)
 	    l2fib_main.age_scan_duration = l2fib_scan (vm, start_time, 0);
+	  if (scan == SCAN_MAC_AGE_WHEEL)
+	    l2fib_main.age_scan_duration =
+	      l2fib_age_wheel_run (vm, start_time);
 	  if (scan == SCAN_DISABLE)
 	    {
 	      l2fib_main.age_scan_duration = 0;
@@ -64,6 +64,16 @@ typedef struct
   /* max macs in event message, default to 100 entries */
   u32 max_macs_in_event;
 
+  /*
+   * Learned mac keys, bucketed by the minute in which they are next due
+   * to be checked for age. Entries are not removed when a mac is
+   * refreshed; it is re-bucketed from its timestamp when it comes due.
+   */
+  u64 *age_wheel[256];
+
+  /* the last minute whose bucket has been processed */
+  u8 age_wheel_minute;
+
   /* convenience variables */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
@@ -461,6 +471,8 @@ u32 l2fib_del_entry (const u8 * mac, u32 bd_index, u32 sw_if_index);
 
 void l2fib_start_ager_scan (vlib_main_t * vm);
 
+void l2fib_age_wheel_add (u64 key, u8 timestamp, u8 mac_age);
+
 void l2fib_flush_int_mac (vlib_main_t * vm, u32 sw_if_index);
 
 void l2fib_flush_bd_mac (vlib_main_t * vm, u32 bd_index);
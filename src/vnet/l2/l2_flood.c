@@ -32,15 +32,13 @@
  * @file
  * @brief Ethernet Flooding.
  *
- * Flooding uses the packet replication infrastructure to send a copy of the
- * packet to each member interface. Logically the replication infrastructure
- * expects two graph nodes: a prep node that initiates replication and sends the
- * packet to the first destination, and a recycle node that is passed the packet
- * after it has been transmitted.
+ * Flooding sends a copy of the packet to each member interface. The copies
+ * are clones: each has its own copy of the packet's headers but shares the
+ * payload with the others, so the cost does not grow with the packet size.
  *
- * To decrease the amount of code, l2 flooding implements both functions in
- * the same graph node. This node can tell if is it being called as the "prep"
- * or "recycle" using replication_is_recycled().
+ * The members to flood to, less those in the packet's split horizon group,
+ * are precomputed by the bridge domain. The copies are enqueued in one
+ * batch at the end of the frame.
  */
 
 
@@ -59,7 +57,13 @@ typedef struct
 
   /* per-cpu vector of cloned packets */
   u32 **clones;
-  l2_flood_member_t ***members;
+
+  /* per-cpu number of clones made of each packet */
+  u16 **n_cloned;
+
+  /* per-cpu vectors of the buffers to enqueue and their next nodes */
+  u32 **to;
+  u16 **nexts;
 } l2flood_main_t;
 
 typedef struct
@@ -121,12 +125,26 @@ typedef enum
 } l2flood_next_t;
 
 /*
- * Perform flooding on one packet
+ * The members a packet received in split horizon group shg floods to
+ */
+static_always_inline const l2_flood_member_t *
+l2flood_members (const l2_bridge_domain_t * bd_config, u8 shg)
+{
+  if (PREDICT_TRUE (shg < vec_len (bd_config->flood_members_by_shg)))
+    return (bd_config->flood_members_by_shg[shg]);
+  if (vec_len (bd_config->flood_members_by_shg))
+    return (bd_config->flood_members_by_shg[0]);
+  return (NULL);
+}
+
+/*
+ * Perform flooding on a run of packets received on the same interface in
+ * the same bridge domain, which all flood to the same members
  *
  * Due to the way BVI processing can modify the packet, the BVI interface
  * (if present) must be processed last in the replication. The member vector
- * is arranged so that the BVI interface is always the first element.
- * Flooding walks the vector in reverse.
+ * is arranged so that the BVI interface is always the first element and the
+ * flood lists are built from it in reverse, so the BVI is always the last.
  *
  * BVI processing causes the packet to go to L3 processing. This strips the
  * L2 header, which is fine because the replication infrastructure restores
@@ -134,174 +152,120 @@ typedef enum
  * example, an ARP request could be turned into an ARP reply, an ICMP request
  * could be turned into an ICMP reply. If BVI processing is not performed
  * last, the modified packet would be replicated to the remaining members.
+ *
+ * The copies are queued member by member, rather than packet by packet, so
+ * that those for each output interface are enqueued together.
  */
-VLIB_NODE_FN (l2flood_node) (vlib_main_t * vm,
-			     vlib_node_runtime_t * node, vlib_frame_t * frame)
+static_always_inline void
+l2flood_run (vlib_main_t * vm, vlib_node_runtime_t * node,
+	     l2flood_main_t * msm, u32 * bis, vlib_buffer_t ** bufs,
+	     u32 n_run, u32 ** to, u16 ** nexts)
 {
-  u32 n_left_from, *from, *to_next;
-  l2flood_next_t next_index;
-  l2flood_main_t *msm = &l2flood_main;
   u32 thread_index = vm->thread_index;
+  const l2_flood_member_t *members, *member;
+  u32 sw_if_index0, bd_index0, n_members, n_clones;
+  l2_bridge_domain_t *bd_config;
+  u64 n_copies, n_bytes;
+  u16 *n_cloned;
+  u32 *clones;
+  u32 i, mi, ci;
+  int skip_rx;
+  u8 in_shg;
+
+  /* Get config for the bridge domain interface */
+  bd_index0 = vnet_buffer (bufs[0])->l2.bd_index;
+  bd_config = vec_elt_at_index (l2input_main.bd_configs, bd_index0);
+  in_shg = vnet_buffer (bufs[0])->l2.shg;
+  sw_if_index0 = vnet_buffer (bufs[0])->sw_if_index[VLIB_RX];
+
+  members = l2flood_members (bd_config, in_shg);
+  n_members = vec_len (members);
+
+  /*
+   * Do not reflect the packet back to the interface it came from. If that
+   * is in a split horizon group it is already excluded with the group.
+   */
+  skip_rx = (0 == in_shg &&
+	     clib_bitmap_get (bd_config->flood_sw_if_bitmap, sw_if_index0));
+  n_clones = n_members - skip_rx;
+
+  if (0 == n_clones)
+    {
+      /* No members to flood to */
+      for (i = 0; i < n_run; i++)
+	{
+	  bufs[i]->error = node->errors[L2FLOOD_ERROR_NO_MEMBERS];
+	  vec_add1 (*to, bis[i]);
+	  vec_add1 (*nexts, L2FLOOD_NEXT_DROP);
+	}
+      return;
+    }
 
-  from = vlib_frame_vector_args (frame);
-  n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+  vec_validate (msm->clones[thread_index], n_run * n_clones - 1);
+  vec_validate (msm->n_cloned[thread_index], n_run - 1);
+  clones = msm->clones[thread_index];
+  n_cloned = msm->n_cloned[thread_index];
+  n_copies = n_bytes = 0;
 
-  while (n_left_from > 0)
+  for (i = 0; i < n_run; i++)
     {
-      u32 n_left_to_next;
+      u32 *c0 = clones + (i * n_clones);
+      u32 len0 = vlib_buffer_length_in_chain (vm, bufs[i]);
 
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      if (1 == n_clones)
 	{
-	  u16 n_clones, n_cloned, clone0;
-	  l2_bridge_domain_t *bd_config;
-	  u32 sw_if_index0, bi0, ci0;
-	  l2_flood_member_t *member;
-	  vlib_buffer_t *b0, *c0;
-	  u16 next0;
-	  u8 in_shg;
-	  i32 mi;
-
-	  /* speculatively enqueue b0 to the current next frame */
-	  bi0 = from[0];
-	  from += 1;
-	  n_left_from -= 1;
-	  next0 = L2FLOOD_NEXT_L2_OUTPUT;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-
-	  /* Get config for the bridge domain interface */
-	  bd_config = vec_elt_at_index (l2input_main.bd_configs,
-					vnet_buffer (b0)->l2.bd_index);
-	  in_shg = vnet_buffer (b0)->l2.shg;
-	  sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-
-	  vec_validate (msm->members[thread_index],
-			vec_len (bd_config->members));
-
-	  vec_reset_length (msm->members[thread_index]);
-
-	  /* Find first members that passes the reflection and SHG checks */
-	  for (mi = bd_config->flood_count - 1; mi >= 0; mi--)
-	    {
-	      member = &bd_config->members[mi];
-	      if ((member->sw_if_index != sw_if_index0) &&
-		  (!in_shg || (member->shg != in_shg)))
-		{
-		  vec_add1 (msm->members[thread_index], member);
-		}
-	    }
-
-	  n_clones = vec_len (msm->members[thread_index]);
+	  c0[0] = bis[i];
+	  n_cloned[i] = 1;
+	}
+      else
+	{
+	  /*
+	   * the header offset needs to be large enough to incorporate
+	   * all the L3 headers that could be touched when doing BVI
+	   * processing. So take the current l2 length plus 2 * IPv6
+	   * headers (for tunnel encap)
+	   */
+	  n_cloned[i] = vlib_buffer_clone (vm, bis[i], c0, n_clones,
+					   VLIB_BUFFER_CLONE_HEAD_SIZE);
 
-	  if (0 == n_clones)
-	    {
-	      /* No members to flood to */
-	      to_next[0] = bi0;
-	      to_next += 1;
-	      n_left_to_next -= 1;
-
-	      b0->error = node->errors[L2FLOOD_ERROR_NO_MEMBERS];
-	      vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					       to_next, n_left_to_next,
-					       bi0, L2FLOOD_NEXT_DROP);
-	      continue;
-	    }
-	  else if (n_clones > 1)
+	  if (PREDICT_FALSE (n_cloned[i] != n_clones))
 	    {
-	      vec_validate (msm->clones[thread_index], n_clones);
-
-	      /*
-	       * the header offset needs to be large enough to incorporate
-	       * all the L3 headers that could be touched when doing BVI
-	       * processing. So take the current l2 length plus 2 * IPv6
-	       * headers (for tunnel encap)
-	       */
-	      n_cloned = vlib_buffer_clone (vm, bi0,
-					    msm->clones[thread_index],
-					    n_clones,
-					    VLIB_BUFFER_CLONE_HEAD_SIZE);
-
-	      vec_set_len (msm->clones[thread_index], n_cloned);
-
-	      if (PREDICT_FALSE (n_cloned != n_clones))
+	      bufs[i]->error = node->errors[L2FLOOD_ERROR_REPL_FAIL];
+	      /* Worst-case, no clones, consume the original buf */
+	      if (n_cloned[i] == 0)
 		{
-		  b0->error = node->errors[L2FLOOD_ERROR_REPL_FAIL];
-		  /* Worst-case, no clones, consume the original buf */
-		  if (n_cloned == 0)
-		    {
-		      ci0 = bi0;
-		      member = msm->members[thread_index][0];
-		      goto use_original_buffer;
-		    }
+		  c0[0] = bis[i];
+		  n_cloned[i] = 1;
 		}
+	    }
+	}
 
-	      /*
-	       * for all but the last clone, these are not BVI bound
-	       */
-	      for (clone0 = 0; clone0 < n_cloned - 1; clone0++)
-		{
-		  member = msm->members[thread_index][clone0];
-		  ci0 = msm->clones[thread_index][clone0];
-		  c0 = vlib_get_buffer (vm, ci0);
+      n_copies += n_cloned[i];
+      n_bytes += n_cloned[i] * len0;
+    }
 
-		  to_next[0] = ci0;
-		  to_next += 1;
-		  n_left_to_next -= 1;
+  for (mi = 0, ci = 0; mi < n_members; mi++)
+    {
+      member = &members[mi];
 
-		  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
-				     (b0->flags & VLIB_BUFFER_IS_TRACED)))
-		    {
-		      ethernet_header_t *h0;
-		      l2flood_trace_t *t;
-
-		      t = vlib_add_trace (vm, node, c0, sizeof (*t));
-		      h0 = vlib_buffer_get_current (c0);
-		      t->sw_if_index = sw_if_index0;
-		      t->bd_index = vnet_buffer (c0)->l2.bd_index;
-		      clib_memcpy_fast (t->src, h0->src_address, 6);
-		      clib_memcpy_fast (t->dst, h0->dst_address, 6);
-		    }
+      if (skip_rx && member->sw_if_index == sw_if_index0)
+	continue;
 
-		  /* Do normal L2 forwarding */
-		  vnet_buffer (c0)->sw_if_index[VLIB_TX] =
-		    member->sw_if_index;
+      for (i = 0; i < n_run; i++)
+	{
+	  u16 next0 = L2FLOOD_NEXT_L2_OUTPUT;
+	  vlib_buffer_t *c0;
+	  u32 ci0;
 
-		  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-						   to_next, n_left_to_next,
-						   ci0, next0);
-		  if (PREDICT_FALSE (0 == n_left_to_next))
-		    {
-		      vlib_put_next_frame (vm, node, next_index,
-					   n_left_to_next);
-		      vlib_get_next_frame (vm, node, next_index, to_next,
-					   n_left_to_next);
-		    }
-		}
-	      member = msm->members[thread_index][clone0];
-	      ci0 = msm->clones[thread_index][clone0];
-	    }
-	  else
-	    {
-	      /* one clone */
-	      ci0 = bi0;
-	      member = msm->members[thread_index][0];
-	    }
+	  /* the replication came up short */
+	  if (PREDICT_FALSE (ci >= n_cloned[i]))
+	    continue;
 
-	use_original_buffer:
-	  /*
-	   * the last clone that might go to a BVI
-	   */
+	  ci0 = clones[(i * n_clones) + ci];
 	  c0 = vlib_get_buffer (vm, ci0);
 
-	  to_next[0] = ci0;
-	  to_next += 1;
-	  n_left_to_next -= 1;
-
 	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
-			     (b0->flags & VLIB_BUFFER_IS_TRACED)))
+			     (bufs[i]->flags & VLIB_BUFFER_IS_TRACED)))
 	    {
 	      ethernet_header_t *h0;
 	      l2flood_trace_t *t;
@@ -313,6 +277,7 @@ VLIB_NODE_FN (l2flood_node) (vlib_main_t * vm,
 	      clib_memcpy_fast (t->src, h0->src_address, 6);
 	      clib_memcpy_fast (t->dst, h0->dst_address, 6);
 	    }
+
 	  /* Forward packet to the current member */
 	  if (PREDICT_FALSE (member->flags & L2_FLOOD_MEMBER_BVI))
 	    {
@@ -341,20 +306,57 @@ VLIB_NODE_FN (l2flood_node) (vlib_main_t * vm,
 	      vnet_buffer (c0)->sw_if_index[VLIB_TX] = member->sw_if_index;
 	    }
 
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   ci0, next0);
-	  if (PREDICT_FALSE (0 == n_left_to_next))
-	    {
-	      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-	      vlib_get_next_frame (vm, node, next_index,
-				   to_next, n_left_to_next);
-	    }
+	  vec_add1 (*to, ci0);
+	  vec_add1 (*nexts, next0);
 	}
+      ci++;
+    }
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+  vlib_increment_combined_counter (&bd_flood_counters, thread_index,
+				   bd_index0, n_copies, n_bytes);
+}
+
+VLIB_NODE_FN (l2flood_node) (vlib_main_t * vm,
+			     vlib_node_runtime_t * node, vlib_frame_t * frame)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  l2flood_main_t *msm = &l2flood_main;
+  u32 thread_index = vm->thread_index;
+  u32 n_left_from, *from, **to;
+  u16 **nexts;
+
+  from = vlib_frame_vector_args (frame);
+  n_left_from = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+  b = bufs;
+
+  to = &msm->to[thread_index];
+  nexts = &msm->nexts[thread_index];
+  vec_reset_length (*to);
+  vec_reset_length (*nexts);
+
+  while (n_left_from > 0)
+    {
+      u32 n_run = 1;
+
+      /* find the packets that flood to the same members as this one */
+      while (n_run < n_left_from &&
+	     vnet_buffer (b[n_run])->l2.bd_index ==
+	     vnet_buffer (b[0])->l2.bd_index &&
+	     vnet_buffer (b[n_run])->l2.shg == vnet_buffer (b[0])->l2.shg &&
+	     vnet_buffer (b[n_run])->sw_if_index[VLIB_RX] ==
+	     vnet_buffer (b[0])->sw_if_index[VLIB_RX])
+	n_run++;
+
+      l2flood_run (vm, node, msm, from, b, n_run, to, nexts);
+
+      from += n_run;
+      b += n_run;
+      n_left_from -= n_run;
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, *to, *nexts, vec_len (*to));
+
   vlib_node_increment_counter (vm, node->node_index,
 			       L2FLOOD_ERROR_L2FLOOD, frame->n_vectors);
 
@@ -392,7 +394,9 @@ l2flood_init (vlib_main_t * vm)
   mp->vnet_main = vnet_get_main ();
 
   vec_validate (mp->clones, vlib_num_workers ());
-  vec_validate (mp->members, vlib_num_workers ());
+  vec_validate (mp->n_cloned, vlib_num_workers ());
+  vec_validate (mp->to, vlib_num_workers ());
+  vec_validate (mp->nexts, vlib_num_workers ());
 
   /* Initialize the feature next-node indexes */
   feat_bitmap_init_next_nodes (vm,
@@ -27,6 +27,7 @@
 
 #include <vppinfra/error.h>
 #include <vppinfra/hash.h>
+#include <vppinfra/xxhash.h>
 
 #ifndef CLIB_MARCH_VARIANT
 l2learn_main_t l2learn_main;
@@ -46,6 +47,12 @@ l2learn_main_t l2learn_main;
  * differ in certain cases (mac move tests), but this not expected to cause
  * problems in real-world networks. It is much simpler to separate learning
  * and forwarding into separate nodes.
+ *
+ * The mac table has a single writer, the main thread. Each thread queues
+ * the learns, moves and refreshes it sees and, at the end of the frame,
+ * hands them to the main thread, which applies them in batches from the
+ * l2-learn-drain node. A thread's own learns are not visible to it until
+ * then, so forwarding may flood a little longer after a learn.
  */
 
 
@@ -82,7 +89,9 @@ _(MAC_MOVE,          "L2 mac moves")			\
 _(MAC_MOVE_VIOLATE,  "L2 mac move violations")		\
 _(LIMIT,             "L2 not learned due to limit")	\
 _(HIT_UPDATE,        "L2 learn hit updates")		\
-_(FILTER_DROP,       "L2 filter mac drops")
+_(FILTER_DROP,       "L2 filter mac drops")		\
+_(RATE_LIMIT,        "L2 not learned due to rate limit")	\
+_(QUEUE_FULL,        "L2 not learned due to full queue")
 
 typedef enum
 {
@@ -106,6 +115,81 @@ typedef enum
 } l2learn_next_t;
 
 
+/* State of the thread's learn queue while a frame is processed */
+typedef struct
+{
+  l2learn_per_thread_t *ptd;
+
+  /* next free slot; published to the main thread at the end of the frame */
+  u32 head;
+
+  /* the main thread's position when the frame started */
+  u32 tail;
+
+  f64 now;
+} l2learn_frame_ctx_t;
+
+/**
+ * Check the bridge domain's learn rate limit. Each thread gets an even
+ * share of the rate, with a burst of up to a second's worth.
+ */
+static_always_inline int
+l2learn_rate_check (l2learn_frame_ctx_t * ctx, u32 bd_index,
+		    const l2_bridge_domain_t * bd_config)
+{
+  l2learn_rate_t *r;
+  f64 rate;
+
+  if (PREDICT_TRUE (bd_config->learn_rate == 0))
+    return 1;
+
+  vec_validate (ctx->ptd->rates, bd_index);
+  r = vec_elt_at_index (ctx->ptd->rates, bd_index);
+
+  rate = (f64) bd_config->learn_rate / clib_max (1, vlib_num_workers ());
+  r->tokens = clib_min (rate, r->tokens + (ctx->now - r->last_time) * rate);
+  r->last_time = ctx->now;
+
+  if (r->tokens < 1)
+    return 0;
+
+  r->tokens -= 1;
+  return 1;
+}
+
+/**
+ * Queue a mac table update for the main thread, unless the same update
+ * is already queued and waiting.
+ */
+static_always_inline void
+l2learn_enqueue (l2learn_frame_ctx_t * ctx, u64 * counter_base,
+		 l2fib_entry_key_t * key0, l2fib_entry_result_t * result0)
+{
+  l2learn_per_thread_t *ptd = ctx->ptd;
+  l2learn_filter_t *f;
+  BVT (clib_bihash_kv) * kv;
+
+  f = &ptd->filter[clib_xxhash (key0->raw) & (L2LEARN_FILTER_SIZE - 1)];
+
+  if (f->key == key0->raw && f->value == result0->raw &&
+      (f->pos - ctx->tail) < (ctx->head - ctx->tail))
+    return;
+
+  if (PREDICT_FALSE (ctx->head - ctx->tail >= L2LEARN_QUEUE_SIZE))
+    {
+      counter_base[L2LEARN_ERROR_QUEUE_FULL] += 1;
+      return;
+    }
+
+  kv = &ptd->queue[ctx->head & (L2LEARN_QUEUE_SIZE - 1)];
+  kv->key = key0->raw;
+  kv->value = result0->raw;
+
+  f->key = key0->raw;
+  f->value = result0->raw;
+  f->pos = ctx->head++;
+}
+
 /** Perform learning on one packet based on the mac table lookup result. */
 
 static_always_inline void
@@ -116,8 +200,10 @@ l2learn_process (vlib_node_runtime_t * node,
 		 u32 sw_if_index0,
 		 l2fib_entry_key_t * key0,
 		 l2fib_entry_key_t * cached_key,
+		 l2fib_entry_result_t * cached_result,
 		 u32 * count,
-		 l2fib_entry_result_t * result0, u16 * next0, u8 timestamp)
+		 l2fib_entry_result_t * result0, u16 * next0, u8 timestamp,
+		 l2learn_frame_ctx_t * ctx)
 {
   l2_bridge_domain_t *bd_config =
     vec_elt_at_index (l2input_main.bd_configs, vnet_buffer (b0)->l2.bd_index);
@@ -173,12 +259,16 @@ l2learn_process (vlib_node_runtime_t * node,
       if (key.raw == 0)
 	return;
 
+      if (!l2learn_rate_check (ctx, vnet_buffer (b0)->l2.bd_index,
+			       bd_config))
+	{
+	  counter_base[L2LEARN_ERROR_RATE_LIMIT] += 1;
+	  return;
+	}
+
       /* It is ok to learn */
-      /* learn_count variable may have little inaccuracy because they are not
-       * incremented/decremented with atomic operations */
-      /* l2fib_scan is call every 2sec fixing potential inaccuracy */
-      msm->global_learn_count++;
-      bd_config->learn_count++;
+      /* the learn counts are updated by the main thread when it applies
+       * the learn, which also enforces the limits exactly */
       result0->raw = 0;		/* clear all fields */
       result0->fields.sw_if_index = sw_if_index0;
       if (msm->client_pid != 0)
@@ -210,21 +300,20 @@ l2learn_process (vlib_node_runtime_t * node,
 	}
 
       /*
-       * TODO: may want to rate limit mac moves
+       * Rate limit mac moves along with new learns, so a storm of moves
+       * cannot monopolise the mac table updates.
        * TODO: check global/bridge domain/interface learn limits
        */
-      result0->fields.sw_if_index = sw_if_index0;
-      if (l2fib_entry_result_is_set_AGE_NOT (result0))
+      if (!l2learn_rate_check (ctx, vnet_buffer (b0)->l2.bd_index,
+			       bd_config))
 	{
-	  /* The mac was provisioned */
-	  /* learn_count variable may have little inaccuracy because they are
-	   * not incremented/decremented with atomic operations */
-	  /* l2fib_scan is call every 2sec fixing potential inaccuracy */
-	  msm->global_learn_count++;
-	  bd_config->learn_count++;
-
-	  l2fib_entry_result_clear_AGE_NOT (result0);
+	  counter_base[L2LEARN_ERROR_RATE_LIMIT] += 1;
+	  return;
 	}
+
+      result0->fields.sw_if_index = sw_if_index0;
+      /* A provisioned mac becomes a learned one; the main thread counts it */
+      l2fib_entry_result_clear_AGE_NOT (result0);
       if (msm->client_pid != 0)
 	l2fib_entry_result_set_bits (result0,
 				     (L2FIB_ENTRY_RESULT_FLAG_LRN_EVT |
@@ -240,13 +329,14 @@ l2learn_process (vlib_node_runtime_t * node,
   result0->fields.timestamp = timestamp;
   result0->fields.sn = vnet_buffer (b0)->l2.l2fib_sn;
 
-  BVT (clib_bihash_kv) kv;
-  kv.key = key0->raw;
-  kv.value = result0->raw;
-  BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
+  l2learn_enqueue (ctx, counter_base, key0, result0);
 
-  /* Invalidate the cache */
-  cached_key->raw = ~0;
+  /*
+   * Cache what the entry will be, so the rest of the frame's packets
+   * from this mac do not queue it again
+   */
+  cached_key->raw = key0->raw;
+  cached_result->raw = result0->raw;
 }
 
 
@@ -261,11 +351,18 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   vlib_error_main_t *em = &vm->error_main;
   l2fib_entry_key_t cached_key;
   l2fib_entry_result_t cached_result;
-  u8 timestamp = (u8) (vlib_time_now (vm) / 60);
+  l2learn_frame_ctx_t ctx;
+  u8 timestamp;
   u32 count = 0;
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
   u16 nexts[VLIB_FRAME_SIZE], *next;
 
+  ctx.ptd = vec_elt_at_index (msm->per_thread_data, vm->thread_index);
+  ctx.head = ctx.ptd->head;
+  ctx.tail = clib_atomic_load_acq_n (&ctx.ptd->tail);
+  ctx.now = vlib_time_now (vm);
+  timestamp = (u8) (ctx.now / 60);
+
   from = vlib_frame_vector_args (frame);
   n_left = frame->n_vectors;	/* number of packets to process */
   vlib_get_buffers (vm, from, bufs, n_left);
@@ -369,19 +466,23 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[0], sw_if_index0, &key0, &cached_key,
-		       &count, &result0, next, timestamp);
+		       &cached_result, &count, &result0, next, timestamp,
+		       &ctx);
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[1], sw_if_index1, &key1, &cached_key,
-		       &count, &result1, next + 1, timestamp);
+		       &cached_result, &count, &result1, next + 1, timestamp,
+		       &ctx);
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[2], sw_if_index2, &key2, &cached_key,
-		       &count, &result2, next + 2, timestamp);
+		       &cached_result, &count, &result2, next + 2, timestamp,
+		       &ctx);
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[3], sw_if_index3, &key3, &cached_key,
-		       &count, &result3, next + 3, timestamp);
+		       &cached_result, &count, &result3, next + 3, timestamp,
+		       &ctx);
 
       next += 4;
       b += 4;
@@ -419,13 +520,26 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       l2learn_process (node, msm, &em->counters[node_counter_base_index],
 		       b[0], sw_if_index0, &key0, &cached_key,
-		       &count, &result0, next, timestamp);
+		       &cached_result, &count, &result0, next, timestamp,
+		       &ctx);
 
       next += 1;
       b += 1;
       n_left -= 1;
     }
 
+  if (ctx.head != ctx.ptd->head)
+    {
+      /* publish this frame's updates to the main thread */
+      clib_atomic_store_rel_n (&ctx.ptd->head, ctx.head);
+
+      if (vm->thread_index == 0)
+	l2learn_drain (vm, ctx.ptd, ~0);
+      else
+	vlib_node_set_interrupt_pending (vlib_mains[0],
+					 l2learn_drain_node.index);
+    }
+
   vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
 
   return frame->n_vectors;
@@ -460,10 +574,127 @@ VLIB_REGISTER_NODE (l2learn_node) = {
 /* *INDENT-ON* */
 
 #ifndef CLIB_MARCH_VARIANT
+/**
+ * Apply a learn, move or refresh queued by a thread to the mac table.
+ * The entry may have changed since it was queued, so the checks that
+ * matter are made again against the current one.
+ */
+static void
+l2learn_apply (vlib_main_t * vm, l2learn_main_t * msm,
+	       BVT (clib_bihash_kv) * kv)
+{
+  l2fib_entry_result_t result, old;
+  l2_bridge_domain_t *bd_config;
+  BVT (clib_bihash_kv) okv;
+  l2fib_entry_key_t key;
+  int is_learn;
+
+  key.raw = kv->key;
+  result.raw = kv->value;
+  bd_config = l2input_bd_config (key.fields.bd_index);
+
+  if (!bd_is_valid (bd_config))
+    return;			/* deleted since */
+
+  okv.key = kv->key;
+  if (BV (clib_bihash_search) (msm->mac_table, &okv, &okv))
+    old.raw = ~0;
+  else
+    old.raw = okv.value;
+
+  if (old.raw != ~0 && (l2fib_entry_result_is_set_STATIC (&old) ||
+			l2fib_entry_result_is_set_FILTER (&old)))
+    return;			/* provisioned since */
+
+  /* a new learn, or a provisioned mac that is now learned */
+  is_learn = (old.raw == ~0 || l2fib_entry_result_is_set_AGE_NOT (&old));
+
+  if (is_learn)
+    {
+      if ((msm->global_learn_count >= msm->global_learn_limit) ||
+	  (bd_config->learn_count >= bd_config->learn_limit))
+	{
+	  vlib_node_increment_counter (vm, l2learn_node.index,
+				       L2LEARN_ERROR_LIMIT, 1);
+	  return;
+	}
+      msm->global_learn_count++;
+      bd_config->learn_count++;
+    }
+
+  BV (clib_bihash_add_del) (msm->mac_table, kv, 1 /* is_add */ );
+
+  if (is_learn && bd_config->mac_age)
+    l2fib_age_wheel_add (kv->key, result.fields.timestamp,
+			 bd_config->mac_age);
+}
+
+/**
+ * Apply up to max of the updates a thread has queued. Returns the number
+ * still queued.
+ */
+u32
+l2learn_drain (vlib_main_t * vm, l2learn_per_thread_t * ptd, u32 max)
+{
+  l2learn_main_t *msm = &l2learn_main;
+  u32 head, tail, n;
+
+  head = clib_atomic_load_acq_n (&ptd->head);
+  tail = ptd->tail;
+
+  /* the scan drains the queues when it is done */
+  if (msm->drain_held)
+    return (head - tail);
+
+  n = clib_min (head - tail, max);
+
+  while (n--)
+    {
+      l2learn_apply (vm, msm,
+		     &ptd->queue[tail & (L2LEARN_QUEUE_SIZE - 1)]);
+      tail++;
+    }
+
+  clib_atomic_store_rel_n (&ptd->tail, tail);
+
+  return (head - tail);
+}
+
+/**
+ * Runs on the main thread when the workers have queued updates.
+ */
+static uword
+l2learn_drain_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+		       vlib_frame_t * frame)
+{
+  l2learn_main_t *msm = &l2learn_main;
+  l2learn_per_thread_t *ptd;
+  u32 n_left = 0;
+
+  vec_foreach (ptd, msm->per_thread_data)
+    n_left += l2learn_drain (vm, ptd, L2LEARN_DRAIN_BATCH);
+
+  /* come back for the rest, so forwarding on this thread is not held up */
+  if (n_left && !msm->drain_held)
+    vlib_node_set_interrupt_pending (vm, node->node_index);
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (l2learn_drain_node) = {
+  .function = l2learn_drain_node_fn,
+  .name = "l2-learn-drain",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+};
+/* *INDENT-ON* */
+
 clib_error_t *
 l2learn_init (vlib_main_t * vm)
 {
   l2learn_main_t *mp = &l2learn_main;
+  l2learn_per_thread_t *ptd;
 
   mp->vlib_main = vm;
   mp->vnet_main = vnet_get_main ();
@@ -489,6 +720,16 @@ l2learn_init (vlib_main_t * vm)
    * of buckets.
    */
   mp->bd_default_learn_limit = L2LEARN_DEFAULT_LIMIT;
+
+  vec_validate_aligned (mp->per_thread_data,
+			vlib_get_thread_main ()->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (ptd, mp->per_thread_data)
+  {
+    vec_validate (ptd->queue, L2LEARN_QUEUE_SIZE - 1);
+    vec_validate (ptd->filter, L2LEARN_FILTER_SIZE - 1);
+  }
+
   return 0;
 }
 
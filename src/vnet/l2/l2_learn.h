@@ -22,6 +22,59 @@
 #include <vppinfra/bihash_8_8.h>
 #include <vnet/ethernet/ethernet.h>
 
+/*
+ * Size of each thread's learn queue, must be a power of 2
+ */
+#define L2LEARN_QUEUE_SIZE (4096)
+
+/*
+ * Number of queued entries each thread remembers, so the same learn
+ * is not queued again before the main thread has applied it
+ */
+#define L2LEARN_FILTER_SIZE (1024)
+
+/*
+ * Max queued entries per thread the main thread applies per drain
+ */
+#define L2LEARN_DRAIN_BATCH (1024)
+
+typedef struct
+{
+  u64 key;
+  u64 value;
+  u32 pos;
+} l2learn_filter_t;
+
+typedef struct
+{
+  f64 tokens;
+  f64 last_time;
+} l2learn_rate_t;
+
+/*
+ * Learns and hit updates are not written to the mac table from the
+ * data-path. Each thread queues them on a single producer, single
+ * consumer ring which the main thread drains in batches.
+ */
+typedef struct
+{
+  /* written by the owning thread */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u32 head;
+
+  /* written by the main thread */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  u32 tail;
+
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  BVT (clib_bihash_kv) * queue;
+
+  /* recently queued entries, owning thread only */
+  l2learn_filter_t *filter;
+
+  /* learn rate token buckets, per bridge domain index, owning thread only */
+  l2learn_rate_t *rates;
+} l2learn_per_thread_t;
 
 typedef struct
 {
@@ -45,6 +98,12 @@ typedef struct
   /* Next nodes for each feature */
   u32 feat_next_node_index[32];
 
+  /* per-thread learn queues */
+  l2learn_per_thread_t *per_thread_data;
+
+  /* queued updates are held while a full scan recounts the learned macs */
+  u8 drain_held;
+
   /* convenience variables */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
@@ -55,6 +114,11 @@ typedef struct
 extern l2learn_main_t l2learn_main;
 
 extern vlib_node_registration_t l2fib_mac_age_scanner_process_node;
+extern vlib_node_registration_t l2learn_node;
+extern vlib_node_registration_t l2learn_drain_node;
+
+extern u32 l2learn_drain (vlib_main_t * vm, l2learn_per_thread_t * ptd,
+			  u32 max);
 
 typedef enum
 {
@@ -810,6 +810,25 @@ static void *vl_api_ip_route_add_del_t_print
   FINISH;
 }
 
+static void *vl_api_ip_route_add_del_bulk_t_print
+  (vl_api_ip_route_add_del_bulk_t * mp, void *handle)
+{
+  u8 *s;
+  u32 i;
+
+  s = format (0, "SCRIPT: ip_route_add_del_bulk ");
+  if (mp->is_add == 0)
+    s = format (s, "del ");
+
+  s = format (s, "table %d", ntohl (mp->table_id));
+
+  for (i = 0; i < ntohl (mp->n_routes); i++)
+    s = format (s, " %U [%U]", format_vl_api_prefix, &mp->routes[i].prefix,
+		format_vl_api_fib_path, &mp->routes[i].path);
+
+  FINISH;
+}
+
 static void *vl_api_mpls_route_add_del_t_print
   (vl_api_mpls_route_add_del_t * mp, void *handle)
 {
@@ -2971,6 +2990,7 @@ _(IP_TABLE_ADD_DEL, ip_table_add_del)                                   \
 _(MPLS_ROUTE_ADD_DEL, mpls_route_add_del)                               \
 _(MPLS_TABLE_ADD_DEL, mpls_table_add_del)                               \
 _(IP_ROUTE_ADD_DEL, ip_route_add_del)                                   \
+_(IP_ROUTE_ADD_DEL_BULK, ip_route_add_del_bulk)                         \
 _(MPLS_TUNNEL_ADD_DEL, mpls_tunnel_add_del)		                \
 _(SR_MPLS_POLICY_ADD, sr_mpls_policy_add)		                \
 _(SR_MPLS_POLICY_DEL, sr_mpls_policy_del)		                \
@@ -589,6 +589,65 @@ update_node_counters (stat_segment_main_t * sm)
   vec_free (stat_vms);
 }
 
+/*
+ * Node dispatch histograms:
+ * clocks_histogram [threads][node-index * clock bins + bin]
+ * vectors_histogram [threads][node-index * vector bins + bin]
+ */
+
+static void
+update_node_histograms (stat_segment_main_t * sm)
+{
+  vlib_main_t *vm = vlib_mains[0];
+  stat_segment_directory_entry_t *cep, *vep;
+  u32 n_nodes = vec_len (vm->node_main.nodes);
+  static u32 no_max_nodes = 0;
+  counter_t **c;
+  u32 n;
+  int i;
+
+  /* Pick up nodes created since the histograms were enabled */
+  if (n_nodes * VLIB_NODE_N_CLOCKS_HISTOGRAM_BINS >
+      vec_len (vm->node_main.clocks_histogram))
+    vlib_node_histograms_enable_disable (vm, 1 /* enable */ );
+
+  cep = &sm->directory_vector[STAT_COUNTER_NODE_CLOCKS_HISTOGRAM];
+  vep = &sm->directory_vector[STAT_COUNTER_NODE_VECTORS_HISTOGRAM];
+
+  if (n_nodes > no_max_nodes)
+    {
+      void *oldheap = clib_mem_set_heap (sm->heap);
+      vlib_stat_segment_lock ();
+
+      stat_validate_counter_vector (cep, n_nodes *
+				    VLIB_NODE_N_CLOCKS_HISTOGRAM_BINS - 1);
+      stat_validate_counter_vector (vep, n_nodes *
+				    VLIB_NODE_N_VECTORS_HISTOGRAM_BINS - 1);
+
+      vlib_stat_segment_unlock ();
+      clib_mem_set_heap (oldheap);
+      no_max_nodes = n_nodes;
+    }
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      vlib_node_main_t *nm;
+
+      if (vlib_mains[i] == 0)
+	continue;
+
+      nm = &vlib_mains[i]->node_main;
+
+      c = cep->data;
+      n = clib_min (vec_len (nm->clocks_histogram), vec_len (c[i]));
+      clib_memcpy_fast (c[i], nm->clocks_histogram, n * sizeof (c[i][0]));
+
+      c = vep->data;
+      n = clib_min (vec_len (nm->vectors_histogram), vec_len (c[i]));
+      clib_memcpy_fast (c[i], nm->vectors_histogram, n * sizeof (c[i][0]));
+    }
+}
+
 static void
 do_stat_segment_updates (stat_segment_main_t * sm)
 {
@@ -668,6 +727,9 @@ do_stat_segment_updates (stat_segment_main_t * sm)
   if (sm->node_counters_enabled)
     update_node_counters (sm);
 
+  if (vm->node_main.clocks_histogram)
+    update_node_histograms (sm);
+
   /* *INDENT-OFF* */
   stat_segment_gauges_pool_t *g;
   pool_foreach (g, sm->gauges)
@@ -759,6 +821,9 @@ stat_segment_collector_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 {
   stat_segment_main_t *sm = &stat_segment_main;
 
+  if (sm->node_histograms_enabled)
+    vlib_node_histograms_enable_disable (vm, 1 /* enable */ );
+
   while (1)
     {
       do_stat_segment_updates (sm);
@@ -919,6 +984,10 @@ statseg_config (vlib_main_t * vm, unformat_input_t * input)
 	sm->node_counters_enabled = 1;
       else if (unformat (input, "per-node-counters off"))
 	sm->node_counters_enabled = 0;
+      else if (unformat (input, "per-node-histograms on"))
+	sm->node_histograms_enabled = 1;
+      else if (unformat (input, "per-node-histograms off"))
+	sm->node_histograms_enabled = 0;
       else if (unformat (input, "update-interval %f", &sm->update_interval))
 	;
       else
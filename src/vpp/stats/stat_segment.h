@@ -33,6 +33,8 @@ typedef enum
  STAT_COUNTER_NODE_VECTORS,
  STAT_COUNTER_NODE_CALLS,
  STAT_COUNTER_NODE_SUSPENDS,
+ STAT_COUNTER_NODE_CLOCKS_HISTOGRAM,
+ STAT_COUNTER_NODE_VECTORS_HISTOGRAM,
  STAT_COUNTER_INTERFACE_NAMES,
  STAT_COUNTER_NODE_NAMES,
  STAT_COUNTER_MEM_STATSEG_TOTAL,
@@ -53,6 +55,10 @@ typedef enum
   _(NODE_VECTORS, COUNTER_VECTOR_SIMPLE, vectors, /sys/node)    \
   _(NODE_CALLS, COUNTER_VECTOR_SIMPLE, calls, /sys/node)        \
   _(NODE_SUSPENDS, COUNTER_VECTOR_SIMPLE, suspends, /sys/node)  \
+  _(NODE_CLOCKS_HISTOGRAM, COUNTER_VECTOR_SIMPLE,               \
+    clocks_histogram, /sys/node)                                \
+  _(NODE_VECTORS_HISTOGRAM, COUNTER_VECTOR_SIMPLE,              \
+    vectors_histogram, /sys/node)                               \
   _(INTERFACE_NAMES, NAME_VECTOR, names, /if)                   \
   _(NODE_NAMES, NAME_VECTOR, names, /sys/node)                  \
   _(MEM_STATSEG_TOTAL, SCALAR_INDEX, total, /mem/statseg)       \
@@ -95,6 +101,7 @@ typedef struct
   ssize_t memory_size;
   clib_mem_page_sz_t log2_page_sz;
   u8 node_counters_enabled;
+  u8 node_histograms_enabled;
   void *last;
   void *heap;
   stat_segment_shared_header_t *shared_header;	/* pointer to shared memory segment */
@@ -19,6 +19,7 @@
 #undef BIHASH_KVP_AT_BUCKET_LEVEL
 #undef BIHASH_LAZY_INSTANTIATE
 #undef BIHASH_BUCKET_PREFETCH_CACHE_LINES
+#undef BIHASH_PAGE_SCAN
 #undef BIHASH_USE_HEAP
 
 #define BIHASH_TYPE _16_8
@@ -26,6 +27,7 @@
 #define BIHASH_KVP_AT_BUCKET_LEVEL 1
 #define BIHASH_LAZY_INSTANTIATE 0
 #define BIHASH_BUCKET_PREFETCH_CACHE_LINES 2
+#define BIHASH_PAGE_SCAN 1
 #define BIHASH_USE_HEAP 1
 
 #ifndef __included_bihash_16_8_h__
@@ -19,6 +19,7 @@
 #undef BIHASH_KVP_AT_BUCKET_LEVEL
 #undef BIHASH_LAZY_INSTANTIATE
 #undef BIHASH_BUCKET_PREFETCH_CACHE_LINES
+#undef BIHASH_PAGE_SCAN
 #undef BIHASH_USE_HEAP
 
 #define BIHASH_TYPE _24_16
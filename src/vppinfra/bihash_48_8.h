@@ -20,12 +20,14 @@
 #undef BIHASH_KVP_AT_BUCKET_LEVEL
 #undef BIHASH_LAZY_INSTANTIATE
 #undef BIHASH_BUCKET_PREFETCH_CACHE_LINES
+#undef BIHASH_PAGE_SCAN
 
 #define BIHASH_TYPE _48_8
 #define BIHASH_KVP_PER_PAGE 4
 #define BIHASH_KVP_AT_BUCKET_LEVEL 0
 #define BIHASH_LAZY_INSTANTIATE 1
 #define BIHASH_BUCKET_PREFETCH_CACHE_LINES 1
+#define BIHASH_PAGE_SCAN 1
 
 #ifndef __included_bihash_48_8_h__
 #define __included_bihash_48_8_h__
@@ -166,6 +166,58 @@ void clib_bihash_prefetch_data (clib_bihash * h, u64 hash);
 int clib_bihash_search_inline_2
   (clib_bihash * h, clib_bihash_kv * search_key, clib_bihash_kv * valuep);
 
+/** Search a bi-hash table for a batch of keys
+
+    @param h - the bi-hash table to search
+    @param keys - n (key,value) pairs containing the search keys
+    @param hashes - set to the n hash codes of the keys
+    @param results - (key,value) pairs set to the search results, may
+    be the same array as keys
+    @param hits - bitmap of (n + 63) / 64 words, bit i set if keys[i]
+    was found
+    @param n - number of keys
+    @returns number of keys found
+    @note bucket and data prefetches are pipelined across the batch,
+    see BIHASH_SEARCH_BATCH_PREFETCH_STRIDE
+*/
+u32 clib_bihash_search_batch
+  (clib_bihash * h, clib_bihash_kv * keys, u64 * hashes,
+   clib_bihash_kv * results, u64 * hits, u32 n);
+
+/** Give each thread a lookup cache in front of a bi-hash table
+
+    @param h - the bi-hash table
+    @param n_threads - number of threads which will search the table
+    @param n_sets - number of 2-way cache sets per thread, rounded up
+    to a power of two
+    @note call before searching the table, see clib_bihash_search_cached
+*/
+void clib_bihash_lookup_cache_enable (clib_bihash * h, u32 n_threads,
+				      u32 n_sets);
+
+/** Search a bi-hash table through the calling thread's lookup cache
+
+    @param h - the bi-hash table to search
+    @param thread_index - index of the calling thread
+    @param search_key - (key,value) pair containing the search key
+    @param valuep - (key,value) set to search result
+    @returns 0 on success (with valuep set), < 0 on error
+    @note same as clib_bihash_search_inline_2 if the table has no lookup
+    caches. Cached (key,value) pairs are invalidated by add_del.
+*/
+int clib_bihash_search_cached
+  (clib_bihash * h, u32 thread_index, clib_bihash_kv * search_key,
+   clib_bihash_kv * valuep);
+
+/** Sum the lookup cache hit and miss counters of all threads
+
+    @param h - the bi-hash table
+    @param hits - set to the number of cache hits
+    @param misses - set to the number of cache misses
+*/
+void clib_bihash_lookup_cache_counters (clib_bihash * h, u64 * hits,
+					u64 * misses);
+
 /* Calback function for walking a bihash table
  *
  * @param kv - KV pair visited
@@ -186,6 +238,35 @@ void clib_bihash_foreach_key_value_pair (clib_bihash * h,
 					 clib_bihash_foreach_key_value_pair_cb
 					 * callback, void *arg);
 
+/** Start resizing a bi-hash table online
+
+    @param h - the bi-hash table to resize
+    @param nbuckets - the new number of buckets, will be rounded up to
+    a power of two
+    @returns 0 if the resize was started, < 0 if another resize is
+    in progress or the table lives in shared memory
+    @note Readers and writers keep running while old buckets are migrated
+    into the new table, see clib_bihash_resize_step
+*/
+int clib_bihash_resize_start (clib_bihash * h, u32 nbuckets);
+
+/** Migrate some buckets of an in-progress resize
+
+    @param h - the bi-hash table being resized
+    @param n_buckets - maximum number of old buckets to migrate
+    @returns 1 once the resize is complete, 0 otherwise
+    @note Writers also call this, a few buckets at a time, whenever a
+    resize is in progress
+*/
+int clib_bihash_resize_step (clib_bihash * h, u32 n_buckets);
+
+/** Resize a bi-hash table, migrating all buckets before returning
+
+    @param h - the bi-hash table to resize
+    @param nbuckets - the new number of buckets
+*/
+void clib_bihash_resize (clib_bihash * h, u32 nbuckets);
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -23,6 +23,21 @@
 #define BIIHASH_MIN_ALLOC_LOG2_PAGES 10
 #endif
 
+/* A split this deep counts towards growing the table */
+#ifndef BIHASH_RESIZE_LOG2_PAGES
+#define BIHASH_RESIZE_LOG2_PAGES 2
+#endif
+
+/* Grow once deep splits exceed nbuckets >> BIHASH_RESIZE_SPLIT_SHIFT */
+#ifndef BIHASH_RESIZE_SPLIT_SHIFT
+#define BIHASH_RESIZE_SPLIT_SHIFT 6
+#endif
+
+/* Old buckets migrated by each writer while a resize is in progress */
+#ifndef BIHASH_RESIZE_BUCKETS_PER_STEP
+#define BIHASH_RESIZE_BUCKETS_PER_STEP 16
+#endif
+
 static inline void *BV (alloc_aligned) (BVT (clib_bihash) * h, uword nbytes)
 {
   uword rv;
@@ -129,44 +144,56 @@ static inline void *BV (alloc_aligned) (BVT (clib_bihash) * h, uword nbytes)
   return (void *) (uword) (rv + alloc_arena (h));
 }
 
-static void BV (clib_bihash_instantiate) (BVT (clib_bihash) * h)
+static void BV (alloc_chunk_free) (BVT (clib_bihash) * h, void *v)
 {
-  uword bucket_size;
+  /* allocations bigger or equal to chunk size always contain single
+   * alloc and they can be given back to heap */
+  void *oldheap;
+  BVT (clib_bihash_alloc_chunk) * c;
+  c = (BVT (clib_bihash_alloc_chunk) *) v - 1;
 
-  if (BIHASH_USE_HEAP)
-    {
-      h->heap = clib_mem_get_heap ();
-      h->chunks = 0;
-      alloc_arena (h) = (uword) clib_mem_get_heap_base (h->heap);
-    }
+  if (c->prev)
+    c->prev->next = c->next;
   else
-    {
-      alloc_arena (h) = clib_mem_vm_reserve (0, h->memory_size,
-					     BIHASH_LOG2_HUGEPAGE_SIZE);
-      if (alloc_arena (h) == ~0)
-	os_out_of_memory ();
-      alloc_arena_next (h) = 0;
-      alloc_arena_size (h) = h->memory_size;
-      alloc_arena_mapped (h) = 0;
-    }
+    h->chunks = c->next;
 
-  bucket_size = h->nbuckets * sizeof (h->buckets[0]);
+  if (c->next)
+    c->next->prev = c->prev;
+
+  oldheap = clib_mem_set_heap (h->heap);
+  clib_mem_free (c);
+  clib_mem_set_heap (oldheap);
+}
+
+static uword BV (buckets_size) (u32 log2_nbuckets)
+{
+  uword bucket_size;
+
+  bucket_size = sizeof (BVT (clib_bihash_bucket));
 
   if (BIHASH_KVP_AT_BUCKET_LEVEL)
-    bucket_size +=
-      h->nbuckets * BIHASH_KVP_PER_PAGE * sizeof (BVT (clib_bihash_kv));
+    bucket_size += BIHASH_KVP_PER_PAGE * sizeof (BVT (clib_bihash_kv));
 
-  h->buckets = BV (alloc_aligned) (h, bucket_size);
-  clib_memset_u8 (h->buckets, 0, bucket_size);
+  return bucket_size << log2_nbuckets;
+}
+
+static BVT (clib_bihash_bucket) *
+BV (buckets_alloc) (BVT (clib_bihash) * h, u32 log2_nbuckets)
+{
+  BVT (clib_bihash_bucket) * buckets;
+  uword bucket_size = BV (buckets_size) (log2_nbuckets);
+
+  buckets = BV (alloc_aligned) (h, bucket_size);
+  clib_memset_u8 (buckets, 0, bucket_size);
 
   if (BIHASH_KVP_AT_BUCKET_LEVEL)
     {
       int i;
       BVT (clib_bihash_bucket) * b;
 
-      b = h->buckets;
+      b = buckets;
 
-      for (i = 0; i < h->nbuckets; i++)
+      for (i = 0; i < (1 << log2_nbuckets); i++)
 	{
 	  b->offset = BV (clib_bihash_get_offset) (h, (void *) (b + 1));
 	  b->refcnt = 1;
@@ -180,6 +207,49 @@ static void BV (clib_bihash_instantiate) (BVT (clib_bihash) * h)
 			 sizeof (BVT (clib_bihash_kv))));
 	}
     }
+  return buckets;
+}
+
+static void
+BV (buckets_free) (BVT (clib_bihash) * h,
+		   BVT (clib_bihash_bucket) * buckets, u32 log2_nbuckets)
+{
+  uword page_sz = sizeof (BVT (clib_bihash_value));
+  uword chunk_sz = round_pow2 (page_sz << BIIHASH_MIN_ALLOC_LOG2_PAGES,
+			       CLIB_CACHE_LINE_BYTES);
+  uword nbytes = round_pow2 (BV (buckets_size) (log2_nbuckets),
+			     CLIB_CACHE_LINE_BYTES);
+
+  ASSERT (h->alloc_lock[0]);
+
+  /*
+   * Only bucket arrays which got a heap chunk of their own can be given
+   * back, smaller ones (and anything in the arena) stay allocated.
+   */
+  if (BIHASH_USE_HEAP && nbytes >= chunk_sz)
+    BV (alloc_chunk_free) (h, buckets);
+}
+
+static void BV (clib_bihash_instantiate) (BVT (clib_bihash) * h)
+{
+  if (BIHASH_USE_HEAP)
+    {
+      h->heap = clib_mem_get_heap ();
+      h->chunks = 0;
+      alloc_arena (h) = (uword) clib_mem_get_heap_base (h->heap);
+    }
+  else
+    {
+      alloc_arena (h) = clib_mem_vm_reserve (0, h->memory_size,
+					     BIHASH_LOG2_HUGEPAGE_SIZE);
+      if (alloc_arena (h) == ~0)
+	os_out_of_memory ();
+      alloc_arena_next (h) = 0;
+      alloc_arena_size (h) = h->memory_size;
+      alloc_arena_mapped (h) = 0;
+    }
+
+  h->buckets = BV (buckets_alloc) (h, h->log2_nbuckets);
   CLIB_MEMORY_STORE_BARRIER ();
   h->instantiated = 1;
 }
@@ -199,6 +269,7 @@ void BV (clib_bihash_init2) (BVT (clib_bihash_init2_args) * a)
   h->instantiated = 0;
   h->fmt_fn = BV (format_bihash);
   h->kvp_fmt_fn = a->kvp_fmt_fn;
+  h->resize_max_nbuckets = a->max_nbuckets;
 
   alloc_arena (h) = 0;
 
@@ -431,6 +502,10 @@ void BV (clib_bihash_free) (BVT (clib_bihash) * h)
     clib_mem_vm_free ((void *) (uword) (alloc_arena (h)),
 		      alloc_arena_size (h));
 never_initialized:
+  for (i = 0; i < vec_len (h->lookup_caches); i++)
+    vec_free (h->lookup_caches[i].entries);
+  vec_free (h->lookup_caches);
+  vec_free (h->lookup_cache_gens);
   clib_memset_u8 (h, 0, sizeof (*h));
   for (i = 0; i < vec_len (clib_all_bihashes); i++)
     {
@@ -486,23 +561,7 @@ BV (value_free) (BVT (clib_bihash) * h, BVT (clib_bihash_value) * v,
 
   if (BIHASH_USE_HEAP && log2_pages >= BIIHASH_MIN_ALLOC_LOG2_PAGES)
     {
-      /* allocations bigger or equal to chunk size always contain single
-       * alloc and they can be given back to heap */
-      void *oldheap;
-      BVT (clib_bihash_alloc_chunk) * c;
-      c = (BVT (clib_bihash_alloc_chunk) *) v - 1;
-
-      if (c->prev)
-	c->prev->next = c->next;
-      else
-	h->chunks = c->next;
-
-      if (c->next)
-	c->next->prev = c->prev;
-
-      oldheap = clib_mem_set_heap (h->heap);
-      clib_mem_free (c);
-      clib_mem_set_heap (oldheap);
+      BV (alloc_chunk_free) (h, v);
       return;
     }
 
@@ -569,7 +628,7 @@ BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
 static
 BVT (clib_bihash_value) *
 BV (split_and_rehash)
-  (BVT (clib_bihash) * h,
+  (BVT (clib_bihash) * h, u32 log2_nbuckets,
    BVT (clib_bihash_value) * old_values, u32 old_log2_pages,
    u32 new_log2_pages)
 {
@@ -591,7 +650,7 @@ BV (split_and_rehash)
 
       /* rehash the item onto its new home-page */
       new_hash = BV (clib_bihash_hash) (&(old_values->kvp[i]));
-      new_hash = extract_bits (new_hash, h->log2_nbuckets, new_log2_pages);
+      new_hash = extract_bits (new_hash, log2_nbuckets, new_log2_pages);
       new_v = &new_values[new_hash];
 
       /* Across the new home-page */
@@ -661,11 +720,17 @@ BV (split_and_rehash_linear)
   return new_values;
 }
 
-static_always_inline int BV (clib_bihash_add_del_inline_with_hash)
-  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, u64 hash, int is_add,
+/*
+ * Add / delete in bucket b, which the caller has locked. The bucket
+ * belongs to a table of (1 << log2_nbuckets) buckets, normally h->buckets
+ * but the old or new table while a resize is in progress.
+ */
+static_always_inline int BV (clib_bihash_add_del_in_bucket)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b, u32 log2_nbuckets,
+   BVT (clib_bihash_kv) * add_v, u64 hash, int is_add,
    int (*is_stale_cb) (BVT (clib_bihash_kv) *, void *), void *arg)
 {
-  BVT (clib_bihash_bucket) * b, tmp_b;
+  BVT (clib_bihash_bucket) tmp_b;
   BVT (clib_bihash_value) * v, *new_v, *save_new_v, *working_copy;
   int i, limit;
   u64 new_hash;
@@ -681,29 +746,7 @@ static_always_inline int BV (clib_bihash_add_del_inline_with_hash)
   };
   /* *INDENT-ON* */
 
-#if BIHASH_LAZY_INSTANTIATE
-  /*
-   * Create the table (is_add=1,2), or flunk the request now (is_add=0)
-   * Use the alloc_lock to protect the instantiate operation.
-   */
-  if (PREDICT_FALSE (h->instantiated == 0))
-    {
-      if (is_add == 0)
-	return (-1);
-
-      BV (clib_bihash_alloc_lock) (h);
-      if (h->instantiated == 0)
-	BV (clib_bihash_instantiate) (h);
-      BV (clib_bihash_alloc_unlock) (h);
-    }
-#else
-  /* Debug image: make sure the table has been instantiated */
-  ASSERT (h->instantiated != 0);
-#endif
-
-  b = BV (clib_bihash_get_bucket) (h, hash);
-
-  BV (clib_bihash_lock_bucket) (b);
+  ASSERT (b->lock && b->migrated == 0);
 
   /* First elt in the bucket? */
   if (BIHASH_KVP_AT_BUCKET_LEVEL == 0 && BV (clib_bihash_bucket_is_empty) (b))
@@ -739,7 +782,7 @@ static_always_inline int BV (clib_bihash_add_del_inline_with_hash)
       if (PREDICT_FALSE (b->linear_search))
 	limit <<= b->log2_pages;
       else
-	v += extract_bits (hash, h->log2_nbuckets, b->log2_pages);
+	v += extract_bits (hash, log2_nbuckets, b->log2_pages);
     }
 
   if (is_add)
@@ -803,9 +846,11 @@ static_always_inline int BV (clib_bihash_add_del_inline_with_hash)
 	    {
 	      if (is_stale_cb (&(v->kvp[i]), arg))
 		{
+		  u64 stale_hash = BV (clib_bihash_hash) (&(v->kvp[i]));
 		  clib_memcpy_fast (&(v->kvp[i]), add_v, sizeof (*add_v));
 		  CLIB_MEMORY_STORE_BARRIER ();
 		  BV (clib_bihash_unlock_bucket) (b);
+		  BV (clib_bihash_lookup_cache_invalidate) (h, stale_hash);
 		  BV (clib_bihash_increment_stat) (h, BIHASH_STAT_replace, 1);
 		  return (0);
 		}
@@ -890,16 +935,16 @@ static_always_inline int BV (clib_bihash_add_del_inline_with_hash)
   resplit_once = 0;
   BV (clib_bihash_increment_stat) (h, BIHASH_STAT_splits, 1);
 
-  new_v = BV (split_and_rehash) (h, working_copy, old_log2_pages,
-				 new_log2_pages);
+  new_v = BV (split_and_rehash) (h, log2_nbuckets, working_copy,
+				 old_log2_pages, new_log2_pages);
   if (new_v == 0)
     {
     try_resplit:
       resplit_once = 1;
       new_log2_pages++;
       /* Try re-splitting. If that fails, fall back to linear search */
-      new_v = BV (split_and_rehash) (h, working_copy, old_log2_pages,
-				     new_log2_pages);
+      new_v = BV (split_and_rehash) (h, log2_nbuckets, working_copy,
+				     old_log2_pages, new_log2_pages);
       if (new_v == 0)
 	{
 	mark_linear:
@@ -923,7 +968,7 @@ static_always_inline int BV (clib_bihash_add_del_inline_with_hash)
   if (mark_bucket_linear)
     limit <<= new_log2_pages;
   else
-    new_v += extract_bits (new_hash, h->log2_nbuckets, new_log2_pages);
+    new_v += extract_bits (new_hash, log2_nbuckets, new_log2_pages);
 
   for (i = 0; i < limit; i++)
     {
@@ -946,6 +991,10 @@ static_always_inline int BV (clib_bihash_add_del_inline_with_hash)
     goto try_resplit;
 
 expand_ok:
+  /* Deep splits mean the table is too small, see clib_bihash_resize_auto */
+  if (new_log2_pages >= BIHASH_RESIZE_LOG2_PAGES || mark_bucket_linear)
+    h->resize_deep_splits++;
+
   tmp_b.log2_pages = new_log2_pages;
   tmp_b.offset = BV (clib_bihash_get_offset) (h, save_new_v);
   tmp_b.linear_search = mark_bucket_linear;
@@ -977,6 +1026,89 @@ expand_ok:
   return (0);
 }
 
+static void BV (clib_bihash_resize_auto) (BVT (clib_bihash) * h);
+
+static_always_inline int BV (clib_bihash_add_del_inline_with_hash)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, u64 hash, int is_add,
+   int (*is_stale_cb) (BVT (clib_bihash_kv) *, void *), void *arg)
+{
+  BVT (clib_bihash_bucket) * b;
+  u32 resize_seq, log2_nbuckets;
+  int rv;
+
+#if BIHASH_LAZY_INSTANTIATE
+  /*
+   * Create the table (is_add=1,2), or flunk the request now (is_add=0)
+   * Use the alloc_lock to protect the instantiate operation.
+   */
+  if (PREDICT_FALSE (h->instantiated == 0))
+    {
+      if (is_add == 0)
+	return (-1);
+
+      BV (clib_bihash_alloc_lock) (h);
+      if (h->instantiated == 0)
+	BV (clib_bihash_instantiate) (h);
+      BV (clib_bihash_alloc_unlock) (h);
+    }
+#else
+  /* Debug image: make sure the table has been instantiated */
+  ASSERT (h->instantiated != 0);
+#endif
+
+again:
+  resize_seq = clib_atomic_load_acq_n (&h->resize_seq);
+
+  if (PREDICT_FALSE (resize_seq & 1))
+    {
+      log2_nbuckets = h->resize_old_log2_nbuckets;
+      b = BV (clib_bihash_get_bucket_in) (h->resize_old_buckets,
+					  log2_nbuckets, hash);
+    }
+  else
+    {
+      log2_nbuckets = h->log2_nbuckets;
+      b = BV (clib_bihash_get_bucket) (h, hash);
+    }
+
+  BV (clib_bihash_lock_bucket) (b);
+
+  /* Raced with the start or the end of a resize? Try again */
+  if (PREDICT_FALSE (h->resize_seq != resize_seq))
+    {
+      BV (clib_bihash_unlock_bucket) (b);
+      goto again;
+    }
+
+  /* Bucket already moved to the new table? Follow it */
+  if (PREDICT_FALSE (b->migrated))
+    {
+      ASSERT (resize_seq & 1);
+      BV (clib_bihash_unlock_bucket) (b);
+      log2_nbuckets = h->resize_new_log2_nbuckets;
+      b = BV (clib_bihash_get_bucket_in) (h->resize_new_buckets,
+					  log2_nbuckets, hash);
+      BV (clib_bihash_lock_bucket) (b);
+
+      if (PREDICT_FALSE (b->migrated))
+	{
+	  BV (clib_bihash_unlock_bucket) (b);
+	  goto again;
+	}
+    }
+
+  rv = BV (clib_bihash_add_del_in_bucket) (h, b, log2_nbuckets, add_v, hash,
+					   is_add, is_stale_cb, arg);
+
+  if (rv == 0)
+    BV (clib_bihash_lookup_cache_invalidate) (h, hash);
+
+  if (PREDICT_FALSE (h->resize_max_nbuckets || (h->resize_seq & 1)))
+    BV (clib_bihash_resize_auto) (h);
+
+  return rv;
+}
+
 static_always_inline int BV (clib_bihash_add_del_inline)
   (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, int is_add,
    int (*is_stale_cb) (BVT (clib_bihash_kv) *, void *), void *arg)
@@ -1006,6 +1138,367 @@ int BV (clib_bihash_search)
   return BV (clib_bihash_search_inline_2) (h, search_key, valuep);
 }
 
+static_always_inline int BV (clib_bihash_search_in_bucket)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b, u32 log2_nbuckets,
+   u64 hash, BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
+{
+  BVT (clib_bihash_value) * v;
+  BVT (clib_bihash_kv) * kvp;
+  u32 n_pages = 1;
+
+  if (BV (clib_bihash_bucket_is_empty) (b))
+    return -1;
+
+  if (PREDICT_FALSE (b->lock))
+    {
+      volatile BVT (clib_bihash_bucket) * bv = b;
+      while (bv->lock)
+	CLIB_PAUSE ();
+    }
+
+  v = BV (clib_bihash_get_value) (h, b->offset);
+
+  if (b->linear_search)
+    n_pages <<= b->log2_pages;
+  else
+    v += extract_bits (hash, log2_nbuckets, b->log2_pages);
+
+  kvp = BV (clib_bihash_search_pages) (v, n_pages, search_key);
+  if (kvp == 0)
+    return -1;
+
+  *valuep = *kvp;
+  return 0;
+}
+
+/*
+ * Search slow path, used while a resize is in progress or when a
+ * fast-path search missed and noticed that one started or ended.
+ */
+int BV (clib_bihash_search_resizing)
+  (BVT (clib_bihash) * h, u64 hash,
+   BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
+{
+  BVT (clib_bihash_bucket) * b;
+  u32 resize_seq;
+
+again:
+  resize_seq = clib_atomic_load_acq_n (&h->resize_seq);
+
+  if (resize_seq & 1)
+    {
+      b = BV (clib_bihash_get_bucket_in) (h->resize_old_buckets,
+					  h->resize_old_log2_nbuckets, hash);
+      if (b->migrated == 0
+	  && BV (clib_bihash_search_in_bucket) (h, b,
+						h->resize_old_log2_nbuckets,
+						hash, search_key, valuep) == 0)
+	return 0;
+
+      /*
+       * The migrated bit is set before the old copy is torn down,
+       * so a miss on a bucket which has since moved is retried there.
+       */
+      __atomic_thread_fence (__ATOMIC_ACQUIRE);
+      if (b->migrated)
+	{
+	  b = BV (clib_bihash_get_bucket_in) (h->resize_new_buckets,
+					      h->resize_new_log2_nbuckets,
+					      hash);
+	  if (BV (clib_bihash_search_in_bucket)
+	      (h, b, h->resize_new_log2_nbuckets, hash, search_key,
+	       valuep) == 0)
+	    return 0;
+	}
+    }
+  else if (BV (clib_bihash_search_in_bucket)
+	   (h, BV (clib_bihash_get_bucket) (h, hash), h->log2_nbuckets, hash,
+	    search_key, valuep) == 0)
+    return 0;
+
+  if (BV (clib_bihash_resize_seq_changed) (h, resize_seq))
+    goto again;
+
+  return -1;
+}
+
+/*
+ * Move every kvp of old bucket b into the new table, then mark b as
+ * migrated. Called with the resize lock held.
+ */
+static void BV (clib_bihash_migrate_bucket)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
+{
+  BVT (clib_bihash_bucket) * nb, tmp_b;
+  BVT (clib_bihash_value) * v;
+  BVT (clib_bihash_kv) * kv;
+  u32 new_log2_nbuckets = h->resize_new_log2_nbuckets;
+  u64 hash;
+  int i, j;
+
+  BV (clib_bihash_lock_bucket) (b);
+  tmp_b.as_u64 = b->as_u64;
+
+  if (!BV (clib_bihash_bucket_is_empty) (b))
+    {
+      v = BV (clib_bihash_get_value) (h, b->offset);
+
+      for (j = 0; j < (1 << b->log2_pages); j++)
+	{
+	  for (i = 0; i < BIHASH_KVP_PER_PAGE; i++)
+	    {
+	      if (BV (clib_bihash_is_free) (&v->kvp[i]))
+		continue;
+
+	      /* The old page stays intact while we hold its bucket lock */
+	      kv = &v->kvp[i];
+	      hash = BV (clib_bihash_hash) (kv);
+	      nb = BV (clib_bihash_get_bucket_in) (h->resize_new_buckets,
+						   new_log2_nbuckets, hash);
+	      BV (clib_bihash_lock_bucket) (nb);
+	      BV (clib_bihash_add_del_in_bucket) (h, nb, new_log2_nbuckets,
+						  kv, hash, 1 /* is_add */ ,
+						  0, 0);
+	    }
+	  v++;
+	}
+    }
+
+  /* Publish the move while the old copy is still intact */
+  b->migrated = 1;
+  CLIB_MEMORY_STORE_BARRIER ();
+
+  if (BIHASH_KVP_AT_BUCKET_LEVEL)
+    {
+      clib_memset_u8 ((b + 1), 0xff, BIHASH_KVP_PER_PAGE *
+		      sizeof (BVT (clib_bihash_kv)));
+      CLIB_MEMORY_STORE_BARRIER ();
+      b->offset = BV (clib_bihash_get_offset) (h, (void *) (b + 1));
+      b->linear_search = 0;
+      b->log2_pages = 0;
+      b->refcnt = 1;
+    }
+  else
+    b->offset = 0;
+
+  CLIB_MEMORY_STORE_BARRIER ();
+  BV (clib_bihash_unlock_bucket) (b);
+
+  /* Give back the old pages, except the bucket-level kvp array */
+  if (BIHASH_KVP_AT_BUCKET_LEVEL ? tmp_b.log2_pages > 0 : tmp_b.offset != 0)
+    {
+      BV (clib_bihash_alloc_lock) (h);
+      v = BV (clib_bihash_get_value) (h, tmp_b.offset);
+      BV (value_free) (h, v, tmp_b.log2_pages);
+      BV (clib_bihash_alloc_unlock) (h);
+    }
+}
+
+/**
+ * Start resizing the table to nbuckets (rounded up to a power of 2).
+ * Buckets are migrated by clib_bihash_resize_step, which writers
+ * also call a few buckets at a time until the resize is complete.
+ * Returns 0 if a resize was started, -1 if a resize is already
+ * running or the table is shared memory.
+ */
+int BV (clib_bihash_resize_start) (BVT (clib_bihash) * h, u32 nbuckets)
+{
+  BVT (clib_bihash_bucket) * new_buckets;
+  u32 log2_nbuckets;
+
+  nbuckets = 1 << max_log2 (nbuckets);
+  log2_nbuckets = max_log2 (nbuckets);
+
+#if BIHASH_32_64_SVM
+  /* The bucket array location is part of the shared segment header */
+  return -1;
+#endif
+
+  if (clib_atomic_test_and_set (&h->resize_lock))
+    return -1;
+
+  if ((h->resize_seq & 1) || nbuckets == h->nbuckets)
+    {
+      clib_atomic_release (&h->resize_lock);
+      return -1;
+    }
+
+  BV (clib_bihash_alloc_lock) (h);
+
+  /* Nothing to migrate yet, simply change the geometry */
+  if (h->instantiated == 0)
+    {
+      h->nbuckets = nbuckets;
+      h->log2_nbuckets = log2_nbuckets;
+      BV (clib_bihash_alloc_unlock) (h);
+      clib_atomic_release (&h->resize_lock);
+      return 0;
+    }
+
+  new_buckets = BV (buckets_alloc) (h, log2_nbuckets);
+  BV (clib_bihash_alloc_unlock) (h);
+
+  h->resize_old_buckets = h->buckets;
+  h->resize_old_log2_nbuckets = h->log2_nbuckets;
+  h->resize_new_buckets = new_buckets;
+  h->resize_new_log2_nbuckets = log2_nbuckets;
+  h->resize_cursor = 0;
+  h->resize_deep_splits = 0;
+  CLIB_MEMORY_STORE_BARRIER ();
+  clib_atomic_store_rel_n (&h->resize_seq, h->resize_seq + 1);
+
+  BV (clib_bihash_increment_stat) (h, BIHASH_STAT_resize, 1);
+  clib_atomic_release (&h->resize_lock);
+  return 0;
+}
+
+static void BV (clib_bihash_resize_finish) (BVT (clib_bihash) * h)
+{
+  h->buckets = h->resize_new_buckets;
+  h->nbuckets = 1 << h->resize_new_log2_nbuckets;
+  h->log2_nbuckets = h->resize_new_log2_nbuckets;
+
+  /*
+   * Readers and writers may still be holding pointers into the old
+   * bucket array, keep it around until the next resize completes.
+   */
+  BV (clib_bihash_alloc_lock) (h);
+  if (h->resize_retired_buckets)
+    BV (buckets_free) (h, h->resize_retired_buckets,
+		       h->resize_retired_log2_nbuckets);
+  BV (clib_bihash_alloc_unlock) (h);
+  h->resize_retired_buckets = h->resize_old_buckets;
+  h->resize_retired_log2_nbuckets = h->resize_old_log2_nbuckets;
+
+  CLIB_MEMORY_STORE_BARRIER ();
+  clib_atomic_store_rel_n (&h->resize_seq, h->resize_seq + 1);
+
+  BV (clib_bihash_increment_stat) (h, BIHASH_STAT_resize_done, 1);
+}
+
+/**
+ * Migrate up to n_buckets old buckets of an in-progress resize.
+ * Returns 1 once no resize is in progress, 0 if there is more to do
+ * or another thread holds the resize lock.
+ */
+int BV (clib_bihash_resize_step) (BVT (clib_bihash) * h, u32 n_buckets)
+{
+  BVT (clib_bihash_bucket) * b;
+  u32 old_nbuckets, n_migrated = 0;
+  int done = 0;
+
+  if ((h->resize_seq & 1) == 0)
+    return 1;
+
+  if (clib_atomic_test_and_set (&h->resize_lock))
+    return 0;
+
+  if ((h->resize_seq & 1) == 0)
+    {
+      clib_atomic_release (&h->resize_lock);
+      return 1;
+    }
+
+  old_nbuckets = 1 << h->resize_old_log2_nbuckets;
+
+  while (n_migrated < n_buckets && h->resize_cursor < old_nbuckets)
+    {
+      b = BV (clib_bihash_get_bucket_in) (h->resize_old_buckets,
+					  h->resize_old_log2_nbuckets,
+					  h->resize_cursor);
+      BV (clib_bihash_migrate_bucket) (h, b);
+      h->resize_cursor++;
+      n_migrated++;
+    }
+
+  BV (clib_bihash_increment_stat) (h, BIHASH_STAT_resize_migrate,
+				   n_migrated);
+
+  if (h->resize_cursor == old_nbuckets)
+    {
+      BV (clib_bihash_resize_finish) (h);
+      done = 1;
+    }
+
+  clib_atomic_release (&h->resize_lock);
+  return done;
+}
+
+/**
+ * Resize the table to nbuckets, migrating all buckets before returning.
+ * Concurrent readers and writers keep working while this runs.
+ */
+void BV (clib_bihash_resize) (BVT (clib_bihash) * h, u32 nbuckets)
+{
+  if (BV (clib_bihash_resize_start) (h, nbuckets) < 0
+      && (h->resize_seq & 1) == 0)
+    return;
+
+  while (BV (clib_bihash_resize_step) (h, 1024) == 0)
+    CLIB_PAUSE ();
+}
+
+/*
+ * Called by writers when auto-grow is enabled or a resize is running:
+ * double the table once deep splits become common, and move a few
+ * buckets along so that resizes complete without a dedicated thread.
+ */
+static void BV (clib_bihash_resize_auto) (BVT (clib_bihash) * h)
+{
+  if ((h->resize_seq & 1) == 0)
+    {
+      if (h->resize_max_nbuckets > h->nbuckets
+	  && h->resize_deep_splits >
+	  (h->nbuckets >> BIHASH_RESIZE_SPLIT_SHIFT))
+	BV (clib_bihash_resize_start) (h, h->nbuckets << 1);
+      return;
+    }
+
+  BV (clib_bihash_resize_step) (h, BIHASH_RESIZE_BUCKETS_PER_STEP);
+}
+
+/*
+ * Give each of n_threads threads a 2-way lookup cache of n_sets sets
+ * (rounded up to a power of two), used by clib_bihash_search_cached.
+ * Call before any thread searches the table.
+ */
+void BV (clib_bihash_lookup_cache_enable) (BVT (clib_bihash) * h,
+					   u32 n_threads, u32 n_sets)
+{
+  BVT (clib_bihash_lookup_cache) * caches = 0, *c;
+  u32 *gens = 0;
+
+  ASSERT (h->lookup_caches == 0);
+  ASSERT (n_threads > 0 && n_sets > 0);
+
+  n_sets = 1 << max_log2 (n_sets);
+
+  vec_validate_init_empty (gens, n_sets - 1, 1);
+  vec_validate_aligned (caches, n_threads - 1, CLIB_CACHE_LINE_BYTES);
+
+  /* One spare set: wide key compares may read past an entry */
+  vec_foreach (c, caches)
+    vec_validate (c->entries, 2 * n_sets + 1);
+
+  h->lookup_cache_mask = n_sets - 1;
+  h->lookup_cache_gens = gens;
+  CLIB_MEMORY_STORE_BARRIER ();
+  h->lookup_caches = caches;
+}
+
+void BV (clib_bihash_lookup_cache_counters) (BVT (clib_bihash) * h,
+					     u64 * hits, u64 * misses)
+{
+  BVT (clib_bihash_lookup_cache) * c;
+
+  *hits = *misses = 0;
+  vec_foreach (c, h->lookup_caches)
+  {
+    *hits += c->hits;
+    *misses += c->misses;
+  }
+}
+
 u8 *BV (format_bihash) (u8 * s, va_list * args)
 {
   BVT (clib_bihash) * h = va_arg (*args, BVT (clib_bihash) *);
@@ -1101,6 +1594,17 @@ u8 *BV (format_bihash) (u8 * s, va_list * args)
     }
 
   s = format (s, "    %lld linear search buckets\n", linear_buckets);
+  if (h->resize_seq & 1)
+    s = format (s, "    resizing to %u buckets: %u of %u migrated\n",
+		1 << h->resize_new_log2_nbuckets, h->resize_cursor,
+		1 << h->resize_old_log2_nbuckets);
+  if (h->lookup_caches)
+    {
+      u64 hits, misses;
+      BV (clib_bihash_lookup_cache_counters) (h, &hits, &misses);
+      s = format (s, "    lookup cache: %u sets x 2, %llu hits, "
+		  "%llu misses\n", h->lookup_cache_mask + 1, hits, misses);
+    }
   if (BIHASH_USE_HEAP)
     {
       BVT (clib_bihash_alloc_chunk) * c = h->chunks;
@@ -1132,23 +1636,18 @@ u8 *BV (format_bihash) (u8 * s, va_list * args)
   return s;
 }
 
-void BV (clib_bihash_foreach_key_value_pair)
-  (BVT (clib_bihash) * h,
-   BV (clib_bihash_foreach_key_value_pair_cb) cb, void *arg)
+static int BV (clib_bihash_foreach_in_table)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * buckets,
+   u32 log2_nbuckets, BV (clib_bihash_foreach_key_value_pair_cb) cb,
+   void *arg)
 {
   int i, j, k;
   BVT (clib_bihash_bucket) * b;
   BVT (clib_bihash_value) * v;
 
-
-#if BIHASH_LAZY_INSTANTIATE
-  if (PREDICT_FALSE (h->instantiated == 0))
-    return;
-#endif
-
-  for (i = 0; i < h->nbuckets; i++)
+  for (i = 0; i < (1 << log2_nbuckets); i++)
     {
-      b = BV (clib_bihash_get_bucket) (h, i);
+      b = BV (clib_bihash_get_bucket_in) (buckets, log2_nbuckets, i);
       if (BV (clib_bihash_bucket_is_empty) (b))
 	continue;
 
@@ -1161,7 +1660,7 @@ void BV (clib_bihash_foreach_key_value_pair)
 		continue;
 
 	      if (BIHASH_WALK_STOP == cb (&v->kvp[k], arg))
-		return;
+		return BIHASH_WALK_STOP;
 	      /*
 	       * In case the callback deletes the last entry in the bucket...
 	       */
@@ -1173,6 +1672,36 @@ void BV (clib_bihash_foreach_key_value_pair)
     doublebreak:
       ;
     }
+  return BIHASH_WALK_CONTINUE;
+}
+
+void BV (clib_bihash_foreach_key_value_pair)
+  (BVT (clib_bihash) * h,
+   BV (clib_bihash_foreach_key_value_pair_cb) cb, void *arg)
+{
+  u32 resize_seq;
+
+#if BIHASH_LAZY_INSTANTIATE
+  if (PREDICT_FALSE (h->instantiated == 0))
+    return;
+#endif
+
+  resize_seq = clib_atomic_load_acq_n (&h->resize_seq);
+
+  /* While resizing, walk the unmigrated old buckets, then the new table */
+  if (resize_seq & 1)
+    {
+      if (BIHASH_WALK_STOP ==
+	  BV (clib_bihash_foreach_in_table) (h, h->resize_old_buckets,
+					     h->resize_old_log2_nbuckets, cb,
+					     arg))
+	return;
+      BV (clib_bihash_foreach_in_table) (h, h->resize_new_buckets,
+					 h->resize_new_log2_nbuckets, cb, arg);
+    }
+  else
+    BV (clib_bihash_foreach_in_table) (h, h->buckets, h->log2_nbuckets, cb,
+				       arg);
 }
 
 /** @endcond */
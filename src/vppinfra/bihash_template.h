@@ -93,6 +93,7 @@ typedef struct
       u64 linear_search:1;
       u64 log2_pages:8;
       u64 refcnt:16;
+      u64 migrated:1;
     };
     u64 as_u64;
   };
@@ -142,6 +143,23 @@ BVS (clib_bihash_alloc_chunk)
 
 } BVT (clib_bihash_alloc_chunk);
 
+typedef struct
+{
+  BVT (clib_bihash_kv) kv;
+  u32 gen;
+} BVT (clib_bihash_lookup_cache_entry);
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* 2 ways per set, most recently used way first */
+  BVT (clib_bihash_lookup_cache_entry) * entries;
+
+  u64 hits;
+  u64 misses;
+} BVT (clib_bihash_lookup_cache);
+
 typedef
 BVS (clib_bihash)
 {
@@ -154,6 +172,11 @@ BVS (clib_bihash)
 
   u32 nbuckets;
   u32 log2_nbuckets;
+
+  /* Odd while an online resize is in progress, bumped at start and end */
+  volatile u32 resize_seq;
+  u32 resize_cursor;
+
   u64 memory_size;
   u8 *name;
   format_function_t *fmt_fn;
@@ -177,6 +200,31 @@ BVS (clib_bihash)
     */
   format_function_t *kvp_fmt_fn;
 
+  /**
+    * Online resize state. Buckets of the old table are migrated
+    * resize_cursor at a time into the new table; readers consult
+    * the old bucket and follow its migrated bit to the new one.
+    */
+  BVT (clib_bihash_bucket) * resize_old_buckets;
+  BVT (clib_bihash_bucket) * resize_new_buckets;
+  u32 resize_old_log2_nbuckets;
+  u32 resize_new_log2_nbuckets;
+  volatile u32 resize_lock;
+  u32 resize_max_nbuckets;	/* auto-grow limit, 0 disables auto-grow */
+  u32 resize_deep_splits;	/* splits past BIHASH_RESIZE_LOG2_PAGES */
+
+  /* Bucket array retired by the last resize, freed by the next one */
+  BVT (clib_bihash_bucket) * resize_retired_buckets;
+  u32 resize_retired_log2_nbuckets;
+
+  /**
+    * Optional per-thread lookup caches. A cached kvp is valid while
+    * its generation matches the one of its set, which add_del bumps.
+    */
+  BVT (clib_bihash_lookup_cache) * lookup_caches;
+  u32 *lookup_cache_gens;
+  u32 lookup_cache_mask;
+
   /** Optional statistics-gathering callback */
 #if BIHASH_ENABLE_STATS
   void (*inc_stats_callback) (BVS (clib_bihash) *, int stat_id, u64 count);
@@ -196,6 +244,8 @@ typedef struct
   format_function_t *kvp_fmt_fn;
   u8 instantiate_immediately;
   u8 dont_add_to_all_bihash_list;
+  /* if non-zero, double nbuckets online up to this limit */
+  u32 max_nbuckets;
 } BVT (clib_bihash_init2_args);
 
 extern void **clib_all_bihashes;
@@ -238,6 +288,9 @@ _(del_free)                                     \
 _(linear)                                       \
 _(resplit)                                      \
 _(working_copy_lost)                            \
+_(resize)                                       \
+_(resize_migrate)                               \
+_(resize_done)                                  \
 _(splits)			/* must be last */
 
 typedef enum
@@ -365,6 +418,18 @@ int BV (clib_bihash_add_or_overwrite_stale) (BVT (clib_bihash) * h,
 int BV (clib_bihash_search) (BVT (clib_bihash) * h,
 			     BVT (clib_bihash_kv) * search_v,
 			     BVT (clib_bihash_kv) * return_v);
+int BV (clib_bihash_search_resizing) (BVT (clib_bihash) * h, u64 hash,
+				      BVT (clib_bihash_kv) * search_v,
+				      BVT (clib_bihash_kv) * return_v);
+
+int BV (clib_bihash_resize_start) (BVT (clib_bihash) * h, u32 nbuckets);
+int BV (clib_bihash_resize_step) (BVT (clib_bihash) * h, u32 n_buckets);
+void BV (clib_bihash_resize) (BVT (clib_bihash) * h, u32 nbuckets);
+
+void BV (clib_bihash_lookup_cache_enable) (BVT (clib_bihash) * h,
+					   u32 n_threads, u32 n_sets);
+void BV (clib_bihash_lookup_cache_counters) (BVT (clib_bihash) * h,
+					     u64 * hits, u64 * misses);
 
 int BV (clib_bihash_is_initialised) (const BVT (clib_bihash) * h);
 
@@ -400,12 +465,184 @@ BV (clib_bihash_get_bucket) (BVT (clib_bihash) * h, u64 hash)
 #endif
 }
 
+static inline
+BVT (clib_bihash_bucket) *
+BV (clib_bihash_get_bucket_in) (BVT (clib_bihash_bucket) * buckets,
+				u32 log2_nbuckets, u64 hash)
+{
+  uword offset = hash & pow2_mask (log2_nbuckets);
+#if BIHASH_KVP_AT_BUCKET_LEVEL
+  offset = offset * (sizeof (BVT (clib_bihash_bucket))
+		     + (BIHASH_KVP_PER_PAGE * sizeof (BVT (clib_bihash_kv))));
+  return ((BVT (clib_bihash_bucket) *) (((u8 *) buckets) + offset));
+#else
+  return buckets + offset;
+#endif
+}
+
+/*
+ * Page scan: types whose kvp is an array of u64 key words followed by a
+ * single u64 value can define BIHASH_PAGE_SCAN to compare the search key
+ * against every kvp of a page at once. The page is loaded as consecutive
+ * u64 vectors and compared with the key repeated at kvp stride; a kvp
+ * matches when all its key lanes compare equal.
+ */
+#undef BIHASH_HAVE_PAGE_SCAN
+#if BIHASH_PAGE_SCAN
+#if defined (CLIB_HAVE_VEC512) || defined (CLIB_HAVE_VEC256) || \
+  (defined (CLIB_HAVE_VEC128) && defined (CLIB_HAVE_VEC128_UNALIGNED_LOAD_STORE))
+#define BIHASH_HAVE_PAGE_SCAN 1
+#endif
+#endif
+
+#ifdef BIHASH_HAVE_PAGE_SCAN
+/* search key word compared against page word w */
+#define BIHASH_PAGE_SCAN_KEY(w)						\
+  key[((w) % (sizeof (BVT (clib_bihash_kv)) / sizeof (u64)))		\
+      % ARRAY_LEN (((BVT (clib_bihash_kv) *) 0)->key)]
+
+/* bitmap of page words [w, w + n) equal to the key word they line up with */
+static_always_inline u64
+BV (clib_bihash_page_scan_words) (u64 * p, u64 * key, const uword w,
+				  const uword n)
+{
+#define _(i) BIHASH_PAGE_SCAN_KEY (w + i)
+#if defined (CLIB_HAVE_VEC512)
+  if (n == 8)
+    {
+      u64x8 k = { _(0), _(1), _(2), _(3), _(4), _(5), _(6), _(7) };
+      /* is_zero_mask has a bit set for each non-zero lane */
+      u8 ne = u64x8_is_zero_mask (u64x8_load_unaligned (p + w) ^ k);
+      return (u64) (u8) ~ne << w;
+    }
+#endif
+#if defined (CLIB_HAVE_VEC256)
+  if (n == 4)
+    {
+      u64x4 k = { _(0), _(1), _(2), _(3) };
+      u64x4 eq = (u64x4) ((u64x4_load_unaligned (p + w) ^ k)
+			  == u64x4_splat (0));
+      return (u64) u64x4_msb_mask (eq) << w;
+    }
+#else
+  if (n == 2)
+    {
+      u64x2 k = { _(0), _(1) };
+      u32 m = u8x16_msb_mask ((u8x16) ((u64x2_load_unaligned (p + w) ^ k)
+				       == u64x2_splat (0)));
+      return (u64) (((m >> 7) & 1) | ((m >> 14) & 2)) << w;
+    }
+#endif
+#undef _
+  ASSERT (0);
+  return 0;
+}
+
+/* index of the kvp in page v whose key matches, or -1 */
+static_always_inline int
+BV (clib_bihash_page_scan) (BVT (clib_bihash_value) * v, u64 * key)
+{
+  const uword kvp_u64s = sizeof (BVT (clib_bihash_kv)) / sizeof (u64);
+  const uword key_u64s = ARRAY_LEN (((BVT (clib_bihash_kv) *) 0)->key);
+  const uword page_u64s = kvp_u64s * BIHASH_KVP_PER_PAGE;
+  u64 *p = (u64 *) v->kvp;
+  u64 eq = 0, match, kvp_starts = 0;
+  uword w = 0, i;
+
+  STATIC_ASSERT (sizeof (((BVT (clib_bihash_kv) *) 0)->value) == sizeof (u64),
+		 "page scan needs u64 value");
+  STATIC_ASSERT (sizeof (BVT (clib_bihash_kv)) * BIHASH_KVP_PER_PAGE
+		 <= 64 * sizeof (u64), "page too big for page scan");
+
+  /* Constant trip counts, the compiler unrolls these */
+#if defined (CLIB_HAVE_VEC512)
+  for (; w + 8 <= page_u64s; w += 8)
+    eq |= BV (clib_bihash_page_scan_words) (p, key, w, 8);
+#endif
+#if defined (CLIB_HAVE_VEC256)
+  for (; w + 4 <= page_u64s; w += 4)
+    eq |= BV (clib_bihash_page_scan_words) (p, key, w, 4);
+#else
+  for (; w + 2 <= page_u64s; w += 2)
+    eq |= BV (clib_bihash_page_scan_words) (p, key, w, 2);
+#endif
+  ASSERT (w == page_u64s);
+
+  /* A kvp matches if all of its key words, starting at its first, match */
+  match = eq;
+  for (i = 1; i < key_u64s; i++)
+    match &= eq >> i;
+
+  for (i = 0; i < BIHASH_KVP_PER_PAGE; i++)
+    kvp_starts |= 1ULL << (i * kvp_u64s);
+
+  match &= kvp_starts;
+
+  if (match == 0)
+    return -1;
+
+  return count_trailing_zeros (match) / kvp_u64s;
+}
+#undef BIHASH_PAGE_SCAN_KEY
+#endif /* BIHASH_HAVE_PAGE_SCAN */
+
+/*
+ * Search n_pages consecutive pages starting at v for the key of
+ * search_key, return the matching kvp or 0.
+ */
+static_always_inline BVT (clib_bihash_kv) *
+BV (clib_bihash_search_pages) (BVT (clib_bihash_value) * v, u32 n_pages,
+			       BVT (clib_bihash_kv) * search_key)
+{
+#ifdef BIHASH_HAVE_PAGE_SCAN
+  int i;
+
+  for (; n_pages > 0; n_pages--, v++)
+    {
+      i = BV (clib_bihash_page_scan) (v, search_key->key);
+      if (i >= 0)
+	return &v->kvp[i];
+    }
+#else
+  int i, limit = BIHASH_KVP_PER_PAGE * n_pages;
+
+  for (i = 0; i < limit; i++)
+    {
+      if (BV (clib_bihash_key_compare) (v->kvp[i].key, search_key->key))
+	return &v->kvp[i];
+    }
+#endif
+  return 0;
+}
+
+/* Drop cached kvps of the lookup cache set of hash, see add_del */
+static inline void BV (clib_bihash_lookup_cache_invalidate)
+  (BVT (clib_bihash) * h, u64 hash)
+{
+  if (PREDICT_TRUE (h->lookup_cache_gens == 0))
+    return;
+
+  /* Generations stay odd, zeroed cache entries never match */
+  clib_atomic_fetch_add_rel (h->lookup_cache_gens +
+			     (hash & h->lookup_cache_mask), 2);
+}
+
+static inline int BV (clib_bihash_resize_seq_changed)
+  (BVT (clib_bihash) * h, u32 resize_seq)
+{
+  /* Order the bucket reads before re-reading the sequence number */
+  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+  return (h->resize_seq != resize_seq);
+}
+
 static inline int BV (clib_bihash_search_inline_with_hash)
   (BVT (clib_bihash) * h, u64 hash, BVT (clib_bihash_kv) * key_result)
 {
   BVT (clib_bihash_value) * v;
   BVT (clib_bihash_bucket) * b;
-  int i, limit;
+  BVT (clib_bihash_kv) * kvp;
+  u32 n_pages = 1;
+  u32 resize_seq;
 
   /* *INDENT-OFF* */
   static const BVT (clib_bihash_bucket) mask = {
@@ -419,10 +656,16 @@ static inline int BV (clib_bihash_search_inline_with_hash)
     return -1;
 #endif
 
+  /* Table being resized? Take the slow path */
+  resize_seq = clib_atomic_load_acq_n (&h->resize_seq);
+  if (PREDICT_FALSE (resize_seq & 1))
+    return BV (clib_bihash_search_resizing) (h, hash, key_result,
+					     key_result);
+
   b = BV (clib_bihash_get_bucket) (h, hash);
 
   if (PREDICT_FALSE (BV (clib_bihash_bucket_is_empty) (b)))
-    return -1;
+    goto not_found;
 
   if (PREDICT_FALSE (b->lock))
     {
@@ -434,24 +677,26 @@ static inline int BV (clib_bihash_search_inline_with_hash)
   v = BV (clib_bihash_get_value) (h, b->offset);
 
   /* If the bucket has unresolvable collisions, use linear search */
-  limit = BIHASH_KVP_PER_PAGE;
-
   if (PREDICT_FALSE (b->as_u64 & mask.as_u64))
     {
       if (PREDICT_FALSE (b->linear_search))
-	limit <<= b->log2_pages;
+	n_pages <<= b->log2_pages;
       else
 	v += extract_bits (hash, h->log2_nbuckets, b->log2_pages);
     }
 
-  for (i = 0; i < limit; i++)
+  kvp = BV (clib_bihash_search_pages) (v, n_pages, key_result);
+  if (kvp)
     {
-      if (BV (clib_bihash_key_compare) (v->kvp[i].key, key_result->key))
-	{
-	  *key_result = v->kvp[i];
-	  return 0;
-	}
+      *key_result = *kvp;
+      return 0;
     }
+
+not_found:
+  /* A resize may have moved the key while we were looking */
+  if (PREDICT_FALSE (BV (clib_bihash_resize_seq_changed) (h, resize_seq)))
+    return BV (clib_bihash_search_resizing) (h, hash, key_result,
+					     key_result);
   return -1;
 }
 
@@ -504,7 +749,9 @@ static inline int BV (clib_bihash_search_inline_2_with_hash)
 {
   BVT (clib_bihash_value) * v;
   BVT (clib_bihash_bucket) * b;
-  int i, limit;
+  BVT (clib_bihash_kv) * kvp;
+  u32 n_pages = 1;
+  u32 resize_seq;
 
 /* *INDENT-OFF* */
   static const BVT (clib_bihash_bucket) mask = {
@@ -520,10 +767,15 @@ static inline int BV (clib_bihash_search_inline_2_with_hash)
     return -1;
 #endif
 
+  /* Table being resized? Take the slow path */
+  resize_seq = clib_atomic_load_acq_n (&h->resize_seq);
+  if (PREDICT_FALSE (resize_seq & 1))
+    return BV (clib_bihash_search_resizing) (h, hash, search_key, valuep);
+
   b = BV (clib_bihash_get_bucket) (h, hash);
 
   if (PREDICT_FALSE (BV (clib_bihash_bucket_is_empty) (b)))
-    return -1;
+    goto not_found;
 
   if (PREDICT_FALSE (b->lock))
     {
@@ -535,24 +787,25 @@ static inline int BV (clib_bihash_search_inline_2_with_hash)
   v = BV (clib_bihash_get_value) (h, b->offset);
 
   /* If the bucket has unresolvable collisions, use linear search */
-  limit = BIHASH_KVP_PER_PAGE;
-
   if (PREDICT_FALSE (b->as_u64 & mask.as_u64))
     {
       if (PREDICT_FALSE (b->linear_search))
-	limit <<= b->log2_pages;
+	n_pages <<= b->log2_pages;
       else
 	v += extract_bits (hash, h->log2_nbuckets, b->log2_pages);
     }
 
-  for (i = 0; i < limit; i++)
+  kvp = BV (clib_bihash_search_pages) (v, n_pages, search_key);
+  if (kvp)
     {
-      if (BV (clib_bihash_key_compare) (v->kvp[i].key, search_key->key))
-	{
-	  *valuep = v->kvp[i];
-	  return 0;
-	}
+      *valuep = *kvp;
+      return 0;
     }
+
+not_found:
+  /* A resize may have moved the key while we were looking */
+  if (PREDICT_FALSE (BV (clib_bihash_resize_seq_changed) (h, resize_seq)))
+    return BV (clib_bihash_search_resizing) (h, hash, search_key, valuep);
   return -1;
 }
 
@@ -568,6 +821,126 @@ static inline int BV (clib_bihash_search_inline_2)
 						     valuep);
 }
 
+/*
+ * Search through the calling thread's lookup cache, if the table has
+ * them enabled. Hits are served from a 2-way set associative cache of
+ * recently found kvps; misses search the table and cache the result.
+ * Cached kvps of a set are dropped when an add_del hashing to the set
+ * bumps its generation.
+ */
+static inline int BV (clib_bihash_search_cached_with_hash)
+  (BVT (clib_bihash) * h, u32 thread_index, u64 hash,
+   BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
+{
+  BVT (clib_bihash_lookup_cache) * c;
+  BVT (clib_bihash_lookup_cache_entry) * e, tmp;
+  u32 set, gen;
+  int rv;
+
+  if (PREDICT_TRUE (h->lookup_caches == 0))
+    return BV (clib_bihash_search_inline_2_with_hash) (h, hash, search_key,
+						       valuep);
+
+  c = vec_elt_at_index (h->lookup_caches, thread_index);
+  set = hash & h->lookup_cache_mask;
+  e = c->entries + 2 * set;
+
+  /* Load the generation before searching, so that a racing add_del
+     leaves us with a stale generation rather than a stale kvp */
+  gen = clib_atomic_load_acq_n (h->lookup_cache_gens + set);
+
+  if (e[0].gen == gen
+      && BV (clib_bihash_key_compare) (e[0].kv.key, search_key->key))
+    {
+      *valuep = e[0].kv;
+      c->hits++;
+      return 0;
+    }
+
+  if (e[1].gen == gen
+      && BV (clib_bihash_key_compare) (e[1].kv.key, search_key->key))
+    {
+      *valuep = e[1].kv;
+      tmp = e[0];
+      e[0] = e[1];
+      e[1] = tmp;
+      c->hits++;
+      return 0;
+    }
+
+  c->misses++;
+  rv = BV (clib_bihash_search_inline_2_with_hash) (h, hash, search_key,
+						   valuep);
+  if (rv == 0)
+    {
+      e[1] = e[0];
+      e[0].kv = *valuep;
+      e[0].gen = gen;
+    }
+
+  return rv;
+}
+
+static inline int BV (clib_bihash_search_cached)
+  (BVT (clib_bihash) * h, u32 thread_index,
+   BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
+{
+  u64 hash;
+
+  hash = BV (clib_bihash_hash) (search_key);
+
+  return BV (clib_bihash_search_cached_with_hash) (h, thread_index, hash,
+						   search_key, valuep);
+}
+
+#ifndef BIHASH_SEARCH_BATCH_PREFETCH_STRIDE
+/* keys between bucket prefetch, data prefetch and search of a key */
+#define BIHASH_SEARCH_BATCH_PREFETCH_STRIDE 4
+#endif
+
+/*
+ * Search n keys. All hashes are computed up front into hashes[], then
+ * the batch is walked as a software pipeline: while key i is searched,
+ * the data of key i + stride and the bucket of key i + 2 * stride are
+ * prefetched. Found kvps are copied to results[i] and bit i of hits[]
+ * is set, hits[] must hold (n + 63) / 64 words. results may be keys.
+ */
+static inline u32 BV (clib_bihash_search_batch)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * keys, u64 * hashes,
+   BVT (clib_bihash_kv) * results, u64 * hits, u32 n)
+{
+  const u32 stride = BIHASH_SEARCH_BATCH_PREFETCH_STRIDE;
+  u32 i, n_hits = 0;
+
+  for (i = 0; i < n; i++)
+    hashes[i] = BV (clib_bihash_hash) (keys + i);
+
+  clib_memset_u64 (hits, 0, (n + 63) / 64);
+
+  /* Fill the pipeline */
+  for (i = 0; i < clib_min (n, 2 * stride); i++)
+    BV (clib_bihash_prefetch_bucket) (h, hashes[i]);
+  for (i = 0; i < clib_min (n, stride); i++)
+    BV (clib_bihash_prefetch_data) (h, hashes[i]);
+
+  for (i = 0; i < n; i++)
+    {
+      if (i + 2 * stride < n)
+	BV (clib_bihash_prefetch_bucket) (h, hashes[i + 2 * stride]);
+      if (i + stride < n)
+	BV (clib_bihash_prefetch_data) (h, hashes[i + stride]);
+
+      if (BV (clib_bihash_search_inline_2_with_hash)
+	  (h, hashes[i], keys + i, results + i) == 0)
+	{
+	  hits[i / 64] |= 1ULL << (i % 64);
+	  n_hits++;
+	}
+    }
+
+  return n_hits;
+}
+
 
 #endif /* __included_bihash_template_h__ */
 
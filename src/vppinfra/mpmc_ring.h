@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef included_clib_mpmc_ring_h
+#define included_clib_mpmc_ring_h
+
+#include <vppinfra/clib.h>
+#include <vppinfra/mem.h>
+#include <vppinfra/string.h>
+#include <vppinfra/lock.h>
+#include <vppinfra/atomics.h>
+
+/*
+ * Multi-producer, multi-consumer ring of u32s (typically buffer
+ * indices), without locks.
+ *
+ * Each side has a head and a tail. An enqueue claims the slots between
+ * the producer head and head + n with a compare-and-swap on the head,
+ * copies its elements in, then waits for earlier producers to publish
+ * and moves the producer tail past its slots. Consumers mirror this
+ * with the consumer head and tail. Producers only ever look at the
+ * consumer tail and vice versa, so a claimed but not yet published
+ * slot is never seen by the other side.
+ *
+ * Indices are free running u32s, masked on access; the ring size is a
+ * power of two.
+ */
+
+typedef struct
+{
+  /* producer side */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u32 prod_head;
+  volatile u32 prod_tail;
+
+  /* consumer side */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u32 cons_head;
+  volatile u32 cons_tail;
+
+  /* read-only, constant, shared */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  u32 size;
+  u32 mask;
+} clib_mpmc_ring_t;
+
+/* Elements follow the header, which is a whole number of cache lines */
+always_inline u32 *
+clib_mpmc_ring_elts (clib_mpmc_ring_t * r)
+{
+  return (u32 *) (r + 1);
+}
+
+/* Allocate a ring of at least size elements */
+always_inline clib_mpmc_ring_t *
+clib_mpmc_ring_alloc (u32 size)
+{
+  clib_mpmc_ring_t *r;
+
+  size = 1 << max_log2 (size);
+  r = clib_mem_alloc_aligned (sizeof (*r) + size * sizeof (u32),
+			      CLIB_CACHE_LINE_BYTES);
+  clib_memset (r, 0, sizeof (*r));
+  r->size = size;
+  r->mask = size - 1;
+  return r;
+}
+
+always_inline void
+clib_mpmc_ring_free (clib_mpmc_ring_t * r)
+{
+  clib_mem_free (r);
+}
+
+/* Number of elements in the ring, a snapshot if others are running */
+always_inline u32
+clib_mpmc_ring_n_used (clib_mpmc_ring_t * r)
+{
+  return clib_atomic_load_acq_n (&r->prod_tail) -
+    clib_atomic_load_acq_n (&r->cons_tail);
+}
+
+always_inline u32
+clib_mpmc_ring_n_free (clib_mpmc_ring_t * r)
+{
+  return r->size - clib_mpmc_ring_n_used (r);
+}
+
+always_inline void
+clib_mpmc_ring_copy_in (clib_mpmc_ring_t * r, u32 slot, u32 * elts, u32 n)
+{
+  u32 *ring = clib_mpmc_ring_elts (r);
+  u32 n_to_end;
+
+  slot &= r->mask;
+  n_to_end = r->size - slot;
+
+  if (PREDICT_TRUE (n <= n_to_end))
+    clib_memcpy_fast (ring + slot, elts, n * sizeof (u32));
+  else
+    {
+      clib_memcpy_fast (ring + slot, elts, n_to_end * sizeof (u32));
+      clib_memcpy_fast (ring, elts + n_to_end, (n - n_to_end) * sizeof (u32));
+    }
+}
+
+always_inline void
+clib_mpmc_ring_copy_out (clib_mpmc_ring_t * r, u32 slot, u32 * elts, u32 n)
+{
+  u32 *ring = clib_mpmc_ring_elts (r);
+  u32 n_to_end;
+
+  slot &= r->mask;
+  n_to_end = r->size - slot;
+
+  if (PREDICT_TRUE (n <= n_to_end))
+    clib_memcpy_fast (elts, ring + slot, n * sizeof (u32));
+  else
+    {
+      clib_memcpy_fast (elts, ring + slot, n_to_end * sizeof (u32));
+      clib_memcpy_fast (elts + n_to_end, ring, (n - n_to_end) * sizeof (u32));
+    }
+}
+
+/*
+ * Claim up to n slots starting at *head, seen from a side whose own
+ * head is at *own_head and whose peer has published up to *peer_tail.
+ * peer_offset is the ring size for producers, 0 for consumers.
+ * If all_or_none, claim n slots or none. Returns the number claimed.
+ */
+always_inline u32
+clib_mpmc_ring_claim (volatile u32 * own_head, volatile u32 * peer_tail,
+		      u32 peer_offset, u32 n, int all_or_none, u32 * head)
+{
+  u32 n_avail;
+
+  *head = clib_atomic_load_relax_n (own_head);
+
+  do
+    {
+      n_avail = peer_offset + clib_atomic_load_acq_n (peer_tail) - *head;
+      if (n > n_avail)
+	{
+	  if (all_or_none)
+	    return 0;
+	  n = n_avail;
+	}
+      if (n == 0)
+	return 0;
+    }
+  while (!clib_atomic_cmp_and_swap_acq_relax_n (own_head, head, *head + n,
+						1 /* weak */ ));
+
+  return n;
+}
+
+/* Publish claimed slots [head, head + n) once earlier claims are done */
+always_inline void
+clib_mpmc_ring_publish (volatile u32 * own_tail, u32 head, u32 n)
+{
+  while (clib_atomic_load_relax_n (own_tail) != head)
+    CLIB_PAUSE ();
+
+  clib_atomic_store_rel_n (own_tail, head + n);
+}
+
+always_inline u32
+clib_mpmc_ring_enqueue_inline (clib_mpmc_ring_t * r, u32 * elts, u32 n,
+			       int all_or_none)
+{
+  u32 head;
+
+  n = clib_mpmc_ring_claim (&r->prod_head, &r->cons_tail, r->size, n,
+			    all_or_none, &head);
+  if (n == 0)
+    return 0;
+
+  clib_mpmc_ring_copy_in (r, head, elts, n);
+  clib_mpmc_ring_publish (&r->prod_tail, head, n);
+  return n;
+}
+
+always_inline u32
+clib_mpmc_ring_dequeue_inline (clib_mpmc_ring_t * r, u32 * elts, u32 n,
+			       int all_or_none)
+{
+  u32 head;
+
+  n = clib_mpmc_ring_claim (&r->cons_head, &r->prod_tail, 0, n,
+			    all_or_none, &head);
+  if (n == 0)
+    return 0;
+
+  clib_mpmc_ring_copy_out (r, head, elts, n);
+  clib_mpmc_ring_publish (&r->cons_tail, head, n);
+  return n;
+}
+
+/* Enqueue as many of n elements as fit, return the number enqueued */
+always_inline u32
+clib_mpmc_ring_enqueue_burst (clib_mpmc_ring_t * r, u32 * elts, u32 n)
+{
+  return clib_mpmc_ring_enqueue_inline (r, elts, n, 0);
+}
+
+/* Enqueue all n elements or none, return n or 0 */
+always_inline u32
+clib_mpmc_ring_enqueue_bulk (clib_mpmc_ring_t * r, u32 * elts, u32 n)
+{
+  return clib_mpmc_ring_enqueue_inline (r, elts, n, 1);
+}
+
+/* Dequeue up to n elements, return the number dequeued */
+always_inline u32
+clib_mpmc_ring_dequeue_burst (clib_mpmc_ring_t * r, u32 * elts, u32 n)
+{
+  return clib_mpmc_ring_dequeue_inline (r, elts, n, 0);
+}
+
+/* Dequeue exactly n elements or none, return n or 0 */
+always_inline u32
+clib_mpmc_ring_dequeue_bulk (clib_mpmc_ring_t * r, u32 * elts, u32 n)
+{
+  return clib_mpmc_ring_dequeue_inline (r, elts, n, 1);
+}
+
+#endif /* included_clib_mpmc_ring_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
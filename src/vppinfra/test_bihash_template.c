@@ -36,6 +36,8 @@ typedef struct
   u32 report_every_n;
   u32 search_iter;
   u32 noverwritten;
+  u32 max_nbuckets;
+  u32 resize_step;
   int careful_delete_tests;
   int verbose;
   int non_random_keys;
@@ -146,6 +148,219 @@ test_bihash_stale_overwrite (test_main_t * tm)
   return 0;
 }
 
+static int
+test_bihash_resize_check (test_main_t * tm, BVT (clib_bihash) * h)
+{
+  BVT (clib_bihash_kv) kv;
+  int i, nerrors = 0;
+
+  for (i = 0; i < vec_len (tm->keys); i++)
+    {
+      kv.key = tm->keys[i];
+      if (BV (clib_bihash_search) (h, &kv, &kv) < 0
+	  || kv.value != (u64) (i + 1))
+	{
+	  clib_warning ("search for key %lld failed during resize",
+			tm->keys[i]);
+	  nerrors++;
+	}
+    }
+  return nerrors;
+}
+
+static clib_error_t *
+test_bihash_resize (test_main_t * tm)
+{
+  BVT (clib_bihash_init2_args) _a, *a = &_a;
+  BVT (clib_bihash) * h;
+  BVT (clib_bihash_kv) kv;
+  int i, nsteps, nerrors = 0;
+  u32 nbuckets;
+  f64 before;
+
+  h = &tm->hash;
+
+  clib_memset (a, 0, sizeof (*a));
+  a->h = h;
+  a->name = "test";
+  a->nbuckets = tm->nbuckets;
+  a->memory_size = tm->hash_memory_size;
+  a->max_nbuckets = tm->max_nbuckets;
+  BV (clib_bihash_init2) (a);
+
+  fformat (stdout, "Add %d items to %d buckets%s\n", tm->nitems,
+	   tm->nbuckets, tm->max_nbuckets ? ", auto-grow enabled" : "");
+
+  for (i = 0; i < tm->nitems; i++)
+    {
+      kv.key = (u64) (i + 1) << 16;
+      kv.value = i + 1;
+      vec_add1 (tm->keys, kv.key);
+      BV (clib_bihash_add_del) (h, &kv, 1 /* is_add */ );
+    }
+
+  /* Complete any auto-grow still in progress */
+  while (BV (clib_bihash_resize_step) (h, 1024) == 0)
+    ;
+  fformat (stdout, "Table now has %d buckets\n", h->nbuckets);
+  nerrors += test_bihash_resize_check (tm, h);
+
+  if (tm->verbose)
+    fformat (stdout, "%U", BV (format_bihash), h, 0 /* verbose */ );
+
+  /*
+   * Grow then shrink the table, searching and updating between steps.
+   * Don't shrink so far that a bucket could overflow its refcnt.
+   */
+  for (nbuckets = h->nbuckets << 2;
+       nbuckets >= 2 && nbuckets >= (tm->nitems >> 12); nbuckets >>= 3)
+    {
+      fformat (stdout, "Resize from %d to %d buckets...\n", h->nbuckets,
+	       nbuckets);
+
+      if (BV (clib_bihash_resize_start) (h, nbuckets) < 0)
+	return clib_error_return (0, "resize to %d buckets failed",
+				  nbuckets);
+
+      before = clib_time_now (&tm->clib_time);
+      nsteps = 0;
+
+      do
+	{
+	  /* Delete and re-add a key while buckets are in flight */
+	  kv.key = tm->keys[nsteps % vec_len (tm->keys)];
+	  kv.value = (nsteps % vec_len (tm->keys)) + 1;
+	  if (BV (clib_bihash_add_del) (h, &kv, 0 /* is_add */ ) < 0)
+	    nerrors++;
+	  BV (clib_bihash_add_del) (h, &kv, 1 /* is_add */ );
+
+	  nerrors += test_bihash_resize_check (tm, h);
+	  nsteps++;
+	}
+      while (BV (clib_bihash_resize_step) (h, tm->resize_step) == 0);
+
+      fformat (stdout, "%d steps, %.2f us, now %d buckets\n", nsteps,
+	       (clib_time_now (&tm->clib_time) - before) * 1e6, h->nbuckets);
+
+      nerrors += test_bihash_resize_check (tm, h);
+      if (tm->verbose)
+	fformat (stdout, "%U", BV (format_bihash), h, 0 /* verbose */ );
+    }
+
+  BV (clib_bihash_free) (h);
+
+  if (nerrors)
+    return clib_error_return (0, "%d errors during resize", nerrors);
+
+  fformat (stdout, "Resize test OK\n");
+  return 0;
+}
+
+static int
+test_bihash_lookup_cache_check (test_main_t * tm, BVT (clib_bihash) * h,
+				u64 value_offset)
+{
+  BVT (clib_bihash_kv) kv;
+  int i, j, nerrors = 0;
+
+  /* Twice, so that the second pass hits the cache */
+  for (j = 0; j < 2; j++)
+    for (i = 0; i < vec_len (tm->keys); i++)
+      {
+	kv.key = tm->keys[i];
+	if (BV (clib_bihash_search_cached) (h, 0, &kv, &kv) < 0)
+	  {
+	    if (i & 1)
+	      continue;
+	    clib_warning ("search for key %lld failed", tm->keys[i]);
+	    nerrors++;
+	  }
+	else if (i & 1)
+	  {
+	    clib_warning ("deleted key %lld found", tm->keys[i]);
+	    nerrors++;
+	  }
+	else if (kv.value != i + value_offset)
+	  {
+	    clib_warning ("search for key %lld returned %lld, not %lld",
+			  tm->keys[i], kv.value, i + value_offset);
+	    nerrors++;
+	  }
+      }
+  return nerrors;
+}
+
+static clib_error_t *
+test_bihash_lookup_cache (test_main_t * tm)
+{
+  BVT (clib_bihash) * h;
+  BVT (clib_bihash_kv) kv;
+  u64 hits, misses;
+  int i, nerrors = 0;
+
+  h = &tm->hash;
+  BV (clib_bihash_init) (h, "test", tm->nbuckets, tm->hash_memory_size);
+  BV (clib_bihash_lookup_cache_enable) (h, 1 /* n_threads */ ,
+					tm->nitems >> 2);
+
+  fformat (stdout, "Add %d items, search through a %d set lookup cache\n",
+	   tm->nitems, h->lookup_cache_mask + 1);
+
+  for (i = 0; i < tm->nitems; i++)
+    {
+      kv.key = random_u64 (&tm->seed);
+      kv.value = i;
+      vec_add1 (tm->keys, kv.key);
+      BV (clib_bihash_add_del) (h, &kv, 1 /* is_add */ );
+    }
+
+  /* Odd keys are not in the table, see test_bihash_lookup_cache_check */
+  for (i = 1; i < tm->nitems; i += 2)
+    {
+      kv.key = tm->keys[i];
+      BV (clib_bihash_add_del) (h, &kv, 0 /* is_add */ );
+    }
+  nerrors += test_bihash_lookup_cache_check (tm, h, 0);
+
+  /* Cached kvps must not survive an overwrite... */
+  for (i = 0; i < tm->nitems; i += 2)
+    {
+      kv.key = tm->keys[i];
+      kv.value = i + 1;
+      BV (clib_bihash_add_del) (h, &kv, 1 /* is_add */ );
+    }
+  nerrors += test_bihash_lookup_cache_check (tm, h, 1);
+
+  /* ... nor a delete */
+  for (i = 0; i < tm->nitems; i++)
+    {
+      kv.key = tm->keys[i];
+      BV (clib_bihash_add_del) (h, &kv, 0 /* is_add */ );
+      if (BV (clib_bihash_search_cached) (h, 0, &kv, &kv) == 0)
+	{
+	  clib_warning ("deleted key %lld found", tm->keys[i]);
+	  nerrors++;
+	}
+    }
+
+  BV (clib_bihash_lookup_cache_counters) (h, &hits, &misses);
+  fformat (stdout, "%lld cache hits, %lld misses\n", hits, misses);
+  if (tm->verbose)
+    fformat (stdout, "%U", BV (format_bihash), h, 0 /* verbose */ );
+
+  if (hits == 0)
+    nerrors++;
+
+  BV (clib_bihash_free) (h);
+
+  if (nerrors)
+    return clib_error_return (0, "%d errors during lookup cache test",
+			      nerrors);
+
+  fformat (stdout, "Lookup cache test OK\n");
+  return 0;
+}
+
 void *
 test_bihash_thread_fn (void *arg)
 {
@@ -472,6 +687,177 @@ test_bihash (test_main_t * tm)
   return 0;
 }
 
+/*
+ * Lookup benchmark for the wide key types, which use the vector page
+ * scan when built for a target with 128, 256 or 512 bit vectors.
+ * Measures hits and misses, one at a time and in batches of
+ * BENCH_BATCH keys, with one page worth of kvps per bucket, and with
+ * buckets overflowed into several pages.
+ */
+#include <vppinfra/bihash_16_8.h>
+#include <vppinfra/bihash_template.c>
+#include <vppinfra/bihash_24_8.h>
+#include <vppinfra/bihash_template.c>
+#include <vppinfra/bihash_32_8.h>
+#include <vppinfra/bihash_template.c>
+#include <vppinfra/bihash_40_8.h>
+#include <vppinfra/bihash_template.c>
+#include <vppinfra/bihash_48_8.h>
+#include <vppinfra/bihash_template.c>
+
+#define foreach_bench_bihash_type _(16_8) _(24_8) _(32_8) _(40_8) _(48_8)
+#define BENCH_BATCH 256
+
+/* *INDENT-OFF* */
+#define _(t)								\
+static f64								\
+test_bihash_bench_search_##t (test_main_t * tm,				\
+			      clib_bihash_##t##_t * h,			\
+			      clib_bihash_kv_##t##_t * keys, int batch)	\
+{									\
+  clib_bihash_kv_##t##_t kv, results[BENCH_BATCH];			\
+  u64 hashes[BENCH_BATCH], hit_bmp[BENCH_BATCH / 64];			\
+  f64 before;								\
+  int i, j;								\
+									\
+  before = clib_time_now (&tm->clib_time);				\
+  for (j = 0; j < tm->search_iter; j++)					\
+    if (batch)								\
+      for (i = 0; i < vec_len (keys); i += BENCH_BATCH)			\
+	clib_bihash_search_batch_##t (h, keys + i, hashes, results,	\
+				      hit_bmp, clib_min (BENCH_BATCH,	\
+							 vec_len (keys) - i)); \
+    else								\
+      for (i = 0; i < vec_len (keys); i++)				\
+	clib_bihash_search_inline_2_##t (h, keys + i, &kv);		\
+									\
+  return (f64) tm->search_iter * vec_len (keys) /			\
+    (clib_time_now (&tm->clib_time) - before);				\
+}									\
+									\
+static clib_error_t *							\
+test_bihash_bench_##t (test_main_t * tm, u32 kvps_per_bucket)		\
+{									\
+  clib_bihash_##t##_t _h, *h = &_h;					\
+  clib_bihash_kv_##t##_t kv, *hits = 0, *misses = 0;			\
+  clib_bihash_kv_##t##_t results[BENCH_BATCH];				\
+  u64 hashes[BENCH_BATCH], hit_bmp[BENCH_BATCH / 64];			\
+  clib_error_t *error = 0;						\
+  u32 nitems = tm->nbuckets * kvps_per_bucket, n;			\
+  f64 hit_rate, miss_rate, batch_hit_rate, batch_miss_rate;		\
+  int i, j;								\
+									\
+  clib_memset (h, 0, sizeof (*h));					\
+  clib_bihash_init_##t (h, "bench", tm->nbuckets,			\
+			tm->hash_memory_size);				\
+									\
+  vec_validate (hits, nitems - 1);					\
+  vec_validate (misses, nitems - 1);					\
+  for (i = 0; i < nitems; i++)						\
+    {									\
+      for (j = 0; j < ARRAY_LEN (hits[i].key); j++)			\
+	{								\
+	  hits[i].key[j] = random_u64 (&tm->seed);			\
+	  misses[i].key[j] = random_u64 (&tm->seed);			\
+	}								\
+      hits[i].value = i;						\
+      clib_bihash_add_del_##t (h, hits + i, 1 /* is_add */);		\
+    }									\
+									\
+  for (i = 0; i < nitems; i++)						\
+    {									\
+      if (clib_bihash_search_##t (h, hits + i, &kv) < 0			\
+	  || kv.value != i)						\
+	{								\
+	  error = clib_error_return (0, "%s: key %d not found", #t, i);	\
+	  goto done;							\
+	}								\
+      if (clib_bihash_search_##t (h, misses + i, &kv) == 0)		\
+	{								\
+	  error = clib_error_return (0, "%s: bogus key %d found", #t, i); \
+	  goto done;							\
+	}								\
+    }									\
+									\
+  for (i = 0; i < nitems; i += BENCH_BATCH)				\
+    {									\
+      n = clib_min (BENCH_BATCH, nitems - i);				\
+      if (clib_bihash_search_batch_##t (h, hits + i, hashes, results,	\
+					hit_bmp, n) != n)		\
+	{								\
+	  error = clib_error_return (0, "%s: batch %d: keys missing",	\
+				     #t, i);				\
+	  goto done;							\
+	}								\
+      for (j = 0; j < n; j++)						\
+	if (results[j].value != i + j					\
+	    || hashes[j] != clib_bihash_hash_##t (hits + i + j))	\
+	  {								\
+	    error = clib_error_return (0, "%s: batch key %d: bad result", \
+				       #t, i + j);			\
+	    goto done;							\
+	  }								\
+      if (clib_bihash_search_batch_##t (h, misses + i, hashes, results,	\
+					hit_bmp, n)			\
+	  || hit_bmp[0] || hit_bmp[(n - 1) / 64])			\
+	{								\
+	  error = clib_error_return (0, "%s: batch %d: bogus keys found", \
+				     #t, i);				\
+	  goto done;							\
+	}								\
+    }									\
+									\
+  hit_rate = test_bihash_bench_search_##t (tm, h, hits, 0);		\
+  batch_hit_rate = test_bihash_bench_search_##t (tm, h, hits, 1);	\
+  miss_rate = test_bihash_bench_search_##t (tm, h, misses, 0);		\
+  batch_miss_rate = test_bihash_bench_search_##t (tm, h, misses, 1);	\
+									\
+  fformat (stdout, "%-5s %2d kvps/bucket: Mlookups/s hit %6.2f "	\
+	   "batched %6.2f, miss %6.2f batched %6.2f\n", #t,		\
+	   kvps_per_bucket, hit_rate * 1e-6, batch_hit_rate * 1e-6,	\
+	   miss_rate * 1e-6, batch_miss_rate * 1e-6);			\
+  if (tm->verbose > 1)							\
+    fformat (stdout, "%U", format_bihash_##t, h, 0 /* verbose */);	\
+									\
+done:									\
+  vec_free (hits);							\
+  vec_free (misses);							\
+  clib_bihash_free_##t (h);						\
+  return error;								\
+}
+foreach_bench_bihash_type
+#undef _
+/* *INDENT-ON* */
+
+static clib_error_t *
+test_bihash_bench (test_main_t * tm)
+{
+  clib_error_t *error;
+
+  fformat (stdout, "%d buckets, %d search iterations, page scan: %s\n",
+	   tm->nbuckets, tm->search_iter,
+#if defined (CLIB_HAVE_VEC512)
+	   "512-bit"
+#elif defined (CLIB_HAVE_VEC256)
+	   "256-bit"
+#elif defined (CLIB_HAVE_VEC128)
+	   "128-bit"
+#else
+	   "none"
+#endif
+    );
+
+  /* Full single-page buckets, then buckets overflowed into 4+ pages */
+#define _(t)								\
+  if ((error = test_bihash_bench_##t (tm, BIHASH_KVP_PER_PAGE)))	\
+    return error;							\
+  if ((error = test_bihash_bench_##t (tm, 4 * BIHASH_KVP_PER_PAGE)))	\
+    return error;
+  foreach_bench_bihash_type
+#undef _
+  return 0;
+}
+
 clib_error_t *
 test_bihash_main (test_main_t * tm)
 {
@@ -514,6 +900,16 @@ test_bihash_main (test_main_t * tm)
 	tm->verbose = 1;
       else if (unformat (i, "stale-overwrite"))
 	which = 3;
+      else if (unformat (i, "max-nbuckets %d", &tm->max_nbuckets))
+	;
+      else if (unformat (i, "resize-step %d", &tm->resize_step))
+	;
+      else if (unformat (i, "resize"))
+	which = 4;
+      else if (unformat (i, "bench"))
+	which = 5;
+      else if (unformat (i, "lookup-cache"))
+	which = 6;
       else
 	return clib_error_return (0, "unknown input '%U'",
 				  format_unformat_error, i);
@@ -543,6 +939,18 @@ test_bihash_main (test_main_t * tm)
       error = test_bihash_stale_overwrite (tm);
       break;
 
+    case 4:
+      error = test_bihash_resize (tm);
+      break;
+
+    case 5:
+      error = test_bihash_bench (tm);
+      break;
+
+    case 6:
+      error = test_bihash_lookup_cache (tm);
+      break;
+
     default:
       return clib_error_return (0, "no such test?");
     }
@@ -571,6 +979,7 @@ main (int argc, char *argv[])
   tm->verbose = 1;
   tm->search_iter = 1;
   tm->careful_delete_tests = 0;
+  tm->resize_step = 1;
   clib_time_init (&tm->clib_time);
 
   unformat_init_command_line (&i, argv);
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2021 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vppinfra/mpmc_ring.h>
+#include <vppinfra/format.h>
+#include <vppinfra/error.h>
+#include <vppinfra/time.h>
+#include <vppinfra/random.h>
+#include <pthread.h>
+#include <sched.h>
+
+/*
+ * Producers enqueue (producer index << 24 | sequence) in random sized
+ * bursts, consumers dequeue in random sized bursts and count what they
+ * see. Every element must be seen exactly once, and each consumer must
+ * see each producer's elements in order.
+ */
+
+typedef struct
+{
+  clib_mpmc_ring_t *ring;
+  u32 n_producers;
+  u32 n_consumers;
+  u32 n_per_producer;
+  u32 ring_size;
+  u32 max_burst;
+  u32 seed;
+
+  volatile u32 go;
+  volatile u32 producers_running;
+
+  /* per element: number of times dequeued */
+  u8 *seen;
+  u32 n_errors;
+} mpmc_ring_test_main_t;
+
+static mpmc_ring_test_main_t mpmc_ring_test_main;
+
+static void *
+producer_fn (void *arg)
+{
+  mpmc_ring_test_main_t *tm = &mpmc_ring_test_main;
+  u32 index = pointer_to_uword (arg);
+  u32 seed = tm->seed + index;
+  u32 elts[tm->max_burst];
+  u32 seq = 0, n, i;
+
+  while (!clib_atomic_load_acq_n (&tm->go))
+    ;
+
+  while (seq < tm->n_per_producer)
+    {
+      n = 1 + random_u32 (&seed) % tm->max_burst;
+      n = clib_min (n, tm->n_per_producer - seq);
+      for (i = 0; i < n; i++)
+	elts[i] = (index << 24) | (seq + i);
+
+      if (random_u32 (&seed) & 1)
+	n = clib_mpmc_ring_enqueue_burst (tm->ring, elts, n);
+      else
+	n = clib_mpmc_ring_enqueue_bulk (tm->ring, elts, n);
+
+      /* Yield rather than spin, test machines may be oversubscribed */
+      if (n == 0)
+	sched_yield ();
+      seq += n;
+    }
+
+  clib_atomic_fetch_sub (&tm->producers_running, 1);
+  return 0;
+}
+
+static void *
+consumer_fn (void *arg)
+{
+  mpmc_ring_test_main_t *tm = &mpmc_ring_test_main;
+  u32 index = pointer_to_uword (arg);
+  u32 seed = tm->seed + 1000 + index;
+  u32 elts[tm->max_burst];
+  u32 *last_seq = 0;
+  u32 n, i, producer, seq;
+  int done = 0;
+
+  vec_validate_init_empty (last_seq, tm->n_producers - 1, ~0);
+
+  while (!clib_atomic_load_acq_n (&tm->go))
+    ;
+
+  while (1)
+    {
+      /* Check before dequeueing, so that the last elements are drained */
+      done = clib_atomic_load_acq_n (&tm->producers_running) == 0;
+
+      n = 1 + random_u32 (&seed) % tm->max_burst;
+      if (random_u32 (&seed) & 1)
+	n = clib_mpmc_ring_dequeue_burst (tm->ring, elts, n);
+      else
+	n = clib_mpmc_ring_dequeue_bulk (tm->ring, elts, n);
+
+      for (i = 0; i < n; i++)
+	{
+	  producer = elts[i] >> 24;
+	  seq = elts[i] & pow2_mask (24);
+	  if (producer >= tm->n_producers || seq >= tm->n_per_producer)
+	    {
+	      clib_atomic_fetch_add (&tm->n_errors, 1);
+	      continue;
+	    }
+	  if (last_seq[producer] != ~0 && seq <= last_seq[producer])
+	    clib_atomic_fetch_add (&tm->n_errors, 1);
+	  last_seq[producer] = seq;
+	  clib_atomic_fetch_add (&tm->seen[producer * tm->n_per_producer +
+					   seq], 1);
+	}
+
+      if (n == 0)
+	{
+	  if (done && clib_mpmc_ring_n_used (tm->ring) == 0)
+	    break;
+	  sched_yield ();
+	}
+    }
+
+  vec_free (last_seq);
+  return 0;
+}
+
+static clib_error_t *
+test_mpmc_ring (mpmc_ring_test_main_t * tm)
+{
+  pthread_t *threads = 0, *t;
+  clib_time_t clib_time;
+  u32 i, n_lost = 0, n_dups = 0, n_total;
+  f64 before, delta;
+  int rv;
+
+  n_total = tm->n_producers * tm->n_per_producer;
+  tm->ring = clib_mpmc_ring_alloc (tm->ring_size);
+  vec_validate (tm->seen, n_total - 1);
+  tm->producers_running = tm->n_producers;
+
+  fformat (stdout, "%u producers x %u elements, %u consumers, ring size %u, "
+	   "bursts up to %u\n", tm->n_producers, tm->n_per_producer,
+	   tm->n_consumers, tm->ring->size, tm->max_burst);
+
+  for (i = 0; i < tm->n_producers + tm->n_consumers; i++)
+    {
+      vec_add2 (threads, t, 1);
+      rv = pthread_create (t, NULL,
+			   i < tm->n_producers ? producer_fn : consumer_fn,
+			   uword_to_pointer (i < tm->n_producers ? i :
+					     i - tm->n_producers, void *));
+      if (rv)
+	return clib_error_return_unix (0, "pthread_create");
+    }
+
+  clib_time_init (&clib_time);
+  before = clib_time_now (&clib_time);
+  clib_atomic_store_rel_n (&tm->go, 1);
+
+  vec_foreach (t, threads)
+    pthread_join (t[0], NULL);
+
+  delta = clib_time_now (&clib_time) - before;
+
+  for (i = 0; i < n_total; i++)
+    {
+      n_lost += tm->seen[i] == 0;
+      n_dups += tm->seen[i] > 1;
+    }
+
+  fformat (stdout, "%.2f M elements/s, %u lost, %u duplicated, "
+	   "%u out of order or bogus\n", n_total / delta * 1e-6, n_lost,
+	   n_dups, tm->n_errors);
+
+  vec_free (threads);
+  vec_free (tm->seen);
+  clib_mpmc_ring_free (tm->ring);
+
+  if (n_lost || n_dups || tm->n_errors)
+    return clib_error_return (0, "mpmc ring test FAILED");
+
+  fformat (stdout, "mpmc ring test OK\n");
+  return 0;
+}
+
+static clib_error_t *
+test_mpmc_ring_main (unformat_input_t * input)
+{
+  mpmc_ring_test_main_t *tm = &mpmc_ring_test_main;
+
+  tm->n_producers = 4;
+  tm->n_consumers = 2;
+  tm->n_per_producer = 1 << 18;
+  tm->ring_size = 1024;
+  tm->max_burst = 64;
+  tm->seed = 0xdeaddabe;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "producers %u", &tm->n_producers))
+	;
+      else if (unformat (input, "consumers %u", &tm->n_consumers))
+	;
+      else if (unformat (input, "elements %u", &tm->n_per_producer))
+	;
+      else if (unformat (input, "ring-size %u", &tm->ring_size))
+	;
+      else if (unformat (input, "burst %u", &tm->max_burst))
+	;
+      else if (unformat (input, "seed %u", &tm->seed))
+	;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (tm->n_producers == 0 || tm->n_producers > 255 || tm->n_consumers == 0
+      || tm->n_per_producer == 0 || tm->n_per_producer > (1 << 24)
+      || tm->max_burst == 0)
+    return clib_error_return (0, "bad parameters");
+
+  return test_mpmc_ring (tm);
+}
+
+#ifdef CLIB_UNIX
+int
+main (int argc, char *argv[])
+{
+  unformat_input_t i;
+  clib_error_t *error;
+
+  clib_mem_init (0, 1ULL << 30);
+
+  unformat_init_command_line (&i, argv);
+  error = test_mpmc_ring_main (&i);
+  unformat_free (&i);
+
+  if (error)
+    {
+      clib_error_report (error);
+      return 1;
+    }
+  return 0;
+}
+#endif /* CLIB_UNIX */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -110,6 +110,12 @@ u8x32_msb_mask (u8x32 v)
   return _mm256_movemask_epi8 ((__m256i) v);
 }
 
+static_always_inline u32
+u64x4_msb_mask (u64x4 v)
+{
+  return _mm256_movemask_pd ((__m256d) v);
+}
+
 /* _from_ */
 /* *INDENT-OFF* */
 #define _(f,t,i) \
@@ -260,6 +266,26 @@ u32x8_gather (void *p0, void *p1, void *p2, void *p3, void *p4, void *p5,
 }
 
 
+/* gather base[indices[i]] */
+static_always_inline u32x8
+u32x8_gather_u32 (const u32 * base, u32x8 indices)
+{
+  return (u32x8) _mm256_i32gather_epi32 ((const int *) base,
+					 (__m256i) indices, 4);
+}
+
+/* gather base[indices[i]] for the lanes with the mask's top bit set,
+   the others are taken from src */
+static_always_inline u32x8
+u32x8_mask_gather_u32 (u32x8 src, const u32 * base, u32x8 indices,
+		       u32x8 mask)
+{
+  return (u32x8) _mm256_mask_i32gather_epi32 ((__m256i) src,
+					      (const int *) base,
+					      (__m256i) indices,
+					      (__m256i) mask, 4);
+}
+
 static_always_inline void
 u64x4_scatter (u64x4 r, void *p0, void *p1, void *p2, void *p3)
 {
@@ -2005,6 +2005,43 @@ class TestIPInput(VppTestCase):
                 Raw(load=b'\x0a' * 18))
         rx = self.send_and_assert_no_replies(self.pg0, p_s0 * 17)
 
+    def test_ip_input_mixed(self):
+        """ IP Input Exceptions mixed with good packets """
+
+        #
+        # the headers are validated many at a time, so mix the
+        # exceptions with good packets in the same frames
+        #
+        def mk(**kwargs):
+            return (Ether(src=self.pg0.remote_mac,
+                          dst=self.pg0.local_mac) /
+                    IP(src=self.pg0.remote_ip4,
+                       dst=self.pg1.remote_ip4, **kwargs) /
+                    UDP(sport=1234, dport=1234) /
+                    Raw(b'\xa5' * 100))
+
+        bad = [mk(chksum=400), mk(ttl=0), mk(version=3),
+               mk(frag=1), mk(len=400)]
+        pkts = []
+        for i in range(200):
+            pkts.append(mk())
+            if i % 7 == 0:
+                pkts.append(bad[i % len(bad)])
+        n_bad = len(pkts) - 200
+
+        errors = ["/err/ip4-input/%s" % c
+                  for c in ["bad ip4 checksum",
+                            "ip4 ttl <= 1",
+                            "ip4 version != 4",
+                            "ip4 fragment offset == 1",
+                            "ip4 length > l2 length"]]
+        before = sum(self.statistics.get_err_counter(e) for e in errors)
+
+        self.send_and_expect(self.pg0, pkts, self.pg1, n_rx=200)
+
+        after = sum(self.statistics.get_err_counter(e) for e in errors)
+        self.assertEqual(after - before, n_bad)
+
 
 class TestIPDirectedBroadcast(VppTestCase):
     """ IPv4 Directed Broadcast """
@@ -2138,6 +2175,135 @@ class TestIPLPM(VppTestCase):
         rx = self.send_and_expect(self.pg0, p_8 * NUM_PKTS, self.pg2)
         rx = self.send_and_expect(self.pg0, p_24 * NUM_PKTS, self.pg1)
 
+        #
+        # the same with the table's routes moved to a poptrie, then
+        # with a /25 that needs a poptrie subtree, then back again
+        #
+        self.vapi.cli("set ip fib lookup table 0 poptrie")
+        self.logger.info(self.vapi.cli("sh ip fib mtrie"))
+        rx = self.send_and_expect(self.pg0, p_8 * NUM_PKTS, self.pg2)
+        rx = self.send_and_expect(self.pg0, p_24 * NUM_PKTS, self.pg1)
+
+        s_25 = VppIpRoute(self, "10.1.2.0", 25,
+                          [VppRoutePath(self.pg3.remote_ip4,
+                                        self.pg3.sw_if_index)])
+        s_25.add_vpp_config()
+        rx = self.send_and_expect(self.pg0, p_24 * NUM_PKTS, self.pg3)
+        s_25.remove_vpp_config()
+        rx = self.send_and_expect(self.pg0, p_24 * NUM_PKTS, self.pg1)
+
+        self.vapi.cli("set ip fib lookup table 0 mtrie")
+        rx = self.send_and_expect(self.pg0, p_8 * NUM_PKTS, self.pg2)
+        rx = self.send_and_expect(self.pg0, p_24 * NUM_PKTS, self.pg1)
+
+    def test_ip_lpm_batch(self):
+        """ IP longest Prefix Match, mixed frame """
+
+        #
+        # packets that match routes of different lengths, and so end
+        # their lookup at different plys, interleaved in the same frame
+        #
+        routes = [VppIpRoute(self, "10.0.0.0", 8,
+                             [VppRoutePath(self.pg1.remote_ip4,
+                                           self.pg1.sw_if_index)]),
+                  VppIpRoute(self, "10.1.0.0", 16,
+                             [VppRoutePath(self.pg2.remote_ip4,
+                                           self.pg2.sw_if_index)]),
+                  VppIpRoute(self, "10.1.1.0", 24,
+                             [VppRoutePath(self.pg3.remote_ip4,
+                                           self.pg3.sw_if_index)])]
+        for r in routes:
+            r.add_vpp_config()
+
+        dsts = ["10.2.0.1", "10.1.2.1", "10.1.1.1"]
+        pkts = []
+        for i in range(NUM_PKTS * 3):
+            pkts.append(Ether(src=self.pg0.remote_mac,
+                              dst=self.pg0.local_mac) /
+                        IP(src="1.1.1.1", dst=dsts[i % 3]) /
+                        UDP(sport=1234, dport=1234 + i) /
+                        Raw(b'\xa5' * 100))
+
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        for i, itf in enumerate([self.pg1, self.pg2, self.pg3]):
+            rx = itf.get_capture(NUM_PKTS)
+            for p in rx:
+                self.assertEqual(p[IP].dst, dsts[i])
+
+    def test_ip_route_bulk(self):
+        """ IP bulk route add/del """
+
+        path_1 = VppRoutePath(self.pg1.remote_ip4,
+                              self.pg1.sw_if_index).encode()
+        path_2 = VppRoutePath(self.pg2.remote_ip4,
+                              self.pg2.sw_if_index).encode()
+
+        #
+        # a /16 and some /24s beneath it, and a route with two paths
+        #
+        routes = [{'prefix': "10.2.0.0/16", 'path': path_2}]
+        for i in range(32):
+            routes.append({'prefix': "10.2.%d.0/24" % i, 'path': path_1})
+        routes.append({'prefix': "10.3.0.0/16", 'path': path_1})
+        routes.append({'prefix': "10.3.0.0/16", 'path': path_2})
+
+        self.vapi.ip_route_add_del_bulk(is_add=1, table_id=0,
+                                        n_routes=len(routes),
+                                        routes=routes)
+
+        self.assertTrue(find_route(self, "10.2.0.0", 16,
+                                   sw_if_index=self.pg2.sw_if_index))
+        self.assertTrue(find_route(self, "10.2.31.0", 24,
+                                   sw_if_index=self.pg1.sw_if_index))
+        self.assertTrue(find_route(self, "10.3.0.0", 16))
+        self.assertFalse(find_route(self, "10.3.0.0", 16,
+                                    sw_if_index=self.pg1.sw_if_index))
+
+        p_24 = (Ether(src=self.pg0.remote_mac,
+                      dst=self.pg0.local_mac) /
+                IP(src="1.1.1.1", dst="10.2.7.1") /
+                UDP(sport=1234, dport=1234) /
+                Raw(b'\xa5' * 100))
+        p_16 = (Ether(src=self.pg0.remote_mac,
+                      dst=self.pg0.local_mac) /
+                IP(src="1.1.1.1", dst="10.2.200.1") /
+                UDP(sport=1234, dport=1234) /
+                Raw(b'\xa5' * 100))
+        self.send_and_expect(self.pg0, p_24 * NUM_PKTS, self.pg1)
+        self.send_and_expect(self.pg0, p_16 * NUM_PKTS, self.pg2)
+
+        #
+        # an invalid route in the batch, none are programmed
+        #
+        bad = [{'prefix': "10.4.0.0/16", 'path': path_1},
+               {'prefix': "2001::/64", 'path': path_1}]
+        with self.vapi.assert_negative_api_retval():
+            self.vapi.ip_route_add_del_bulk(is_add=1, table_id=0,
+                                            n_routes=len(bad),
+                                            routes=bad)
+        self.assertFalse(find_route(self, "10.4.0.0", 16))
+
+        #
+        # delete them all
+        #
+        self.vapi.ip_route_add_del_bulk(is_add=0, table_id=0,
+                                        n_routes=len(routes),
+                                        routes=routes)
+        self.assertFalse(find_route(self, "10.2.0.0", 16))
+        self.assertFalse(find_route(self, "10.2.7.0", 24))
+        self.assertFalse(find_route(self, "10.3.0.0", 16))
+
+    def test_ip_poptrie_unittest(self):
+        """ IP poptrie against mtrie """
+
+        error = self.vapi.cli("test ip4 poptrie routes 20000 "
+                              "lookups 100000 deletes 2000")
+        self.logger.info(error)
+        self.assertNotIn("FAIL", error)
+
 
 @tag_fixme_vpp_workers
 class TestIPv4Frag(VppTestCase):
@@ -2203,6 +2369,57 @@ class TestIPv4Frag(VppTestCase):
             payload += p[Raw].load
         self.assert_equal(payload, saved_payload, "payload")
 
+    def test_frag_zero_copy(self):
+        """ Zero-copy fragmentation """
+
+        self.vapi.cli("set ip fragmentation zero-copy")
+        self.assertIn("zero-copy",
+                      self.vapi.cli("show ip fragmentation"))
+
+        nbr = VppNeighbor(self,
+                          self.dst_if.sw_if_index,
+                          self.dst_if.remote_mac,
+                          self.dst_if.remote_ip4).add_vpp_config()
+
+        #
+        # packets in chains of 2048 byte buffers, fragmented at MTUs
+        # that do, and do not, align with the buffers
+        #
+        for (size, mtu) in [(6000, 5000), (6000, 1500),
+                            (9000, 576), (1600, 1500)]:
+            p = (Ether(dst=self.src_if.local_mac,
+                       src=self.src_if.remote_mac) /
+                 IP(src=self.src_if.remote_ip4,
+                    dst=self.dst_if.remote_ip4) /
+                 UDP(sport=1234, dport=5678) / Raw())
+            self.extend_packet(p, size, "abcde")
+            saved_payload = p[Raw].load
+
+            self.vapi.sw_interface_set_mtu(self.dst_if.sw_if_index,
+                                           [mtu, 0, 0, 0])
+
+            # the payload is split into the most 8 byte multiples that
+            # fit both the MTU and a buffer
+            n_frags = -(-(len(p[IP]) - 20) //
+                        (min(mtu - 20, 2048 - 20) & ~7))
+
+            self.pg_enable_capture()
+            self.src_if.add_stream(p)
+            self.pg_start()
+            packets = self.dst_if.get_capture(n_frags)
+
+            payload = b''
+            for f in packets:
+                self.assertLessEqual(len(f[IP]), mtu)
+                payload_offset = f.frag * 8
+                if payload_offset > 0:
+                    payload_offset -= 8  # UDP header is not in payload
+                self.assert_equal(payload_offset, len(payload))
+                payload += f[Raw].load
+            self.assert_equal(payload, saved_payload, "payload")
+
+        self.vapi.cli("set ip fragmentation copy")
+
 
 class TestIPReplace(VppTestCase):
     """ IPv4 Table Replace """
@@ -2733,5 +2950,97 @@ class TestIPv4PathMTU(VppTestCase):
             self.send_and_expect(self.pg0, [p_1k], self.pg1, n_rx=2)
 
 
+class TestIPFlowCache(VppTestCase):
+    """ IPv4 Flow Cache """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestIPFlowCache, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestIPFlowCache, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestIPFlowCache, self).setUp()
+
+        self.create_pg_interfaces(range(3))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    def tearDown(self):
+        super(TestIPFlowCache, self).tearDown()
+        self.vapi.cli("set interface ip flow-cache pg0 disable")
+        for i in self.pg_interfaces:
+            i.admin_down()
+            i.unconfig_ip4()
+
+    def test_ip_flow_cache(self):
+        """ IP Flow Cache """
+
+        r_8 = VppIpRoute(self, "10.0.0.0", 8,
+                         [VppRoutePath(self.pg1.remote_ip4,
+                                       self.pg1.sw_if_index)])
+        r_8.add_vpp_config()
+
+        self.vapi.cli("set interface ip flow-cache pg0 ip4")
+
+        p = (Ether(src=self.pg0.remote_mac,
+                   dst=self.pg0.local_mac) /
+             IP(src=self.pg0.remote_ip4, dst="10.1.1.1") /
+             UDP(sport=1234, dport=1234) /
+             Raw(b'\xa5' * 100))
+
+        #
+        # the first packets learn the flow, the rest hit it
+        #
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+
+        self.assertEqual(
+            self.statistics.get_err_counter(
+                "/err/ip4-flow-cache-learn/flows learned"), NUM_PKTS)
+        self.assertEqual(
+            self.statistics.get_err_counter(
+                "/err/ip4-flow-cache/flows found"), NUM_PKTS)
+
+        #
+        # a more specific route makes the cached flow stale
+        #
+        r_24 = VppIpRoute(self, "10.1.1.0", 24,
+                          [VppRoutePath(self.pg2.remote_ip4,
+                                        self.pg2.sw_if_index)])
+        r_24.add_vpp_config()
+
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg2)
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg2)
+        self.assertEqual(
+            self.statistics.get_err_counter(
+                "/err/ip4-flow-cache/flows found"), 2 * NUM_PKTS)
+
+        r_24.remove_vpp_config()
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+
+        #
+        # packets that are not TCP or UDP are not cached
+        #
+        p_icmp = (Ether(src=self.pg0.remote_mac,
+                        dst=self.pg0.local_mac) /
+                  IP(src=self.pg0.remote_ip4, dst="10.1.1.1") /
+                  ICMP())
+        self.send_and_expect(self.pg0, p_icmp * NUM_PKTS, self.pg1)
+        self.assertEqual(
+            self.statistics.get_err_counter(
+                "/err/ip4-flow-cache/packets not cacheable"), NUM_PKTS)
+
+        self.assertIn("ip4 pg0: active",
+                      self.vapi.cli("show ip flow-cache"))
+
+        r_8.remove_vpp_config()
+
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -380,6 +380,44 @@ class TestIPv6(TestIPv6ND):
             pkts = i.parent.get_capture()
             self.verify_capture(i, pkts)
 
+    def test_fib_tree_bitmap(self):
+        """ IPv6 FIB test with a tree bitmap lookup
+
+        Test scenario:
+            - Move table 0's forwarding lookups to a tree bitmap
+            - Run the FIB test
+            - Add and remove a route more specific than the interface's
+            - Move table 0 back to the hash
+        """
+
+        self.vapi.cli("set ip6 fib lookup table 0 tree-bitmap")
+        self.logger.info(self.vapi.cli("show ip6 fib mem"))
+        self.test_fib()
+
+        p = (Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+             IPv6(src=self.pg0.remote_ip6, dst="2001:db8::1:2") /
+             UDP(sport=1234, dport=1234) /
+             Raw(b'\xa5' * 100))
+
+        r = VppIpRoute(self, "2001:db8::", 64,
+                       [VppRoutePath(self.pg1.sub_if.remote_ip6,
+                                     self.pg1.sub_if.sw_if_index)])
+        r.add_vpp_config()
+        self.send_and_expect(self.pg0, p * NUM_PKTS, self.pg1)
+        r.remove_vpp_config()
+        self.send_and_assert_no_replies(self.pg0, p * NUM_PKTS)
+
+        self.vapi.cli("set ip6 fib lookup table 0 hash")
+        self.test_fib()
+
+    def test_tree_bitmap_unittest(self):
+        """ IPv6 tree bitmap against hash lookup """
+
+        error = self.vapi.cli("test ip6 tree-bitmap routes 20000 "
+                              "lookups 100000 deletes 2000")
+        self.logger.info(error)
+        self.assertNotIn("FAIL", error)
+
     def test_ns(self):
         """ IPv6 Neighbour Solicitation Exceptions
 
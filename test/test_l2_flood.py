@@ -187,6 +187,14 @@ class TestL2Flood(VppTestCase):
         #
         self.send_and_expect(self.pg0, p*NUM_PKTS, self.pg1)
 
+        #
+        # the BD's flood counter counts one copy of each
+        #
+        stats = self.statistics.get_counter("/l2/bd/flood")
+        self.assertEqual(sum(s[1]['packets'] for s in stats), NUM_PKTS)
+        self.assertEqual(sum(s[1]['bytes'] for s in stats),
+                         NUM_PKTS * len(p))
+
         #
         # cleanup
         #
@@ -96,6 +96,29 @@ class TestL2LearnLimit(VppTestCase):
             bd_id=3, enable=0)
         self.vapi.bridge_domain_add_del(is_add=0, bd_id=3)
 
+    def test_l2bd_learnrate(self):
+        """ L2BD test with bridge domain learn rate limit
+        """
+        self.vapi.bridge_domain_set_learn_limit(2, 1000)
+        self.vapi.cli("set bridge-domain learn-rate 2 10")
+
+        hosts = self.create_hosts(self.pg_interfaces[1], 100, 4)
+
+        # inject 100 mac addresses on bd2 in one burst
+        self.learn_hosts(self.pg_interfaces[1], 2, hosts)
+
+        lfs = self.vapi.l2_fib_table_dump(2)
+
+        # check that the burst was cut short by the rate limit
+        self.assertGreater(len(lfs), 0)
+        self.assertLess(len(lfs), 20)
+        self.assertEqual(
+            self.statistics.get_err_counter(
+                "/err/l2-learn/L2 not learned due to rate limit"),
+            100 - len(lfs))
+
+        self.vapi.cli("set bridge-domain learn-rate 2 off")
+
     def setUp(self):
         super(TestL2LearnLimit, self).setUp()
 
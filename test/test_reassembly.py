@@ -239,6 +239,60 @@ class TestIPv4Reassembly(VppTestCase):
         self.dst_if.get_capture(1)
         self.assert_error_counter_equal(error_cnt_str, error_cnt + 1)
 
+    def test_memory_limit(self):
+        """ reassembly memory limit """
+
+        error_cnt_str = \
+            "/err/ip4-full-reassembly-feature/" \
+            "fragments dropped due to reassembly memory limit"
+
+        error_cnt = self.statistics.get_err_counter(error_cnt_str)
+
+        # first fragments only, so none of them completes
+        frags = []
+        for i in range(100):
+            p = (Ether(dst=self.src_if.local_mac, src=self.src_if.remote_mac) /
+                 IP(id=2000 + i, src=self.src_if.remote_ip4,
+                    dst=self.dst_if.remote_ip4) /
+                 UDP(sport=1234, dport=5678) /
+                 Raw(b"X" * 1000))
+            frags.append(fragment_rfc791(p, 400)[0])
+
+        self.vapi.cli("set ip4-full-reassembly max-memory 20k")
+        try:
+            self.pg_enable_capture()
+            self.src_if.add_stream(frags)
+            self.pg_start()
+            self.dst_if.assert_nothing_captured()
+        finally:
+            self.vapi.cli("set ip4-full-reassembly max-memory 16m")
+
+        self.assertGreater(self.statistics.get_err_counter(error_cnt_str),
+                           error_cnt)
+
+    def test_in_order_pair(self):
+        """ in-order two fragment reassembly """
+
+        error_cnt_str = \
+            "/err/ip4-full-reassembly-feature/in-order fragment pairs"
+
+        error_cnt = self.statistics.get_err_counter(error_cnt_str)
+
+        p = (Ether(dst=self.src_if.local_mac, src=self.src_if.remote_mac) /
+             IP(id=3000, src=self.src_if.remote_ip4,
+                dst=self.dst_if.remote_ip4) /
+             UDP(sport=1234, dport=5678) /
+             Raw(b"X" * 600))
+        frags = fragment_rfc791(p, 400)
+        self.assertEqual(len(frags), 2)
+
+        self.pg_enable_capture()
+        self.src_if.add_stream(frags)
+        self.pg_start()
+
+        self.dst_if.get_capture(1)
+        self.assert_error_counter_equal(error_cnt_str, error_cnt + 1)
+
     def test_5737(self):
         """ fragment length + ip header size > 65535 """
         self.vapi.cli("clear errors")
@@ -1228,6 +1282,59 @@ class TestIPv6Reassembly(VppTestCase):
         self.dst_if.get_capture(1)
         self.assert_error_counter_equal(error_cnt_str, error_cnt + 1)
 
+    def test_memory_limit(self):
+        """ reassembly memory limit """
+
+        error_cnt_str = \
+            "/err/ip6-full-reassembly-feature/" \
+            "fragments dropped due to reassembly memory limit"
+
+        error_cnt = self.statistics.get_err_counter(error_cnt_str)
+
+        p = (Ether(dst=self.src_if.local_mac, src=self.src_if.remote_mac) /
+             IPv6(src=self.src_if.remote_ip6,
+                  dst=self.dst_if.remote_ip6) /
+             UDP(sport=1234, dport=5678) /
+             Raw(b"X" * 1000))
+
+        # first fragments only, so none of them completes
+        frags = [fragment_rfc8200(p, 2000 + i, 400)[0] for i in range(100)]
+
+        self.vapi.cli("set ip6-full-reassembly max-memory 20k")
+        try:
+            self.pg_enable_capture()
+            self.src_if.add_stream(frags)
+            self.pg_start()
+            self.dst_if.assert_nothing_captured()
+        finally:
+            self.vapi.cli("set ip6-full-reassembly max-memory 16m")
+
+        self.assertGreater(self.statistics.get_err_counter(error_cnt_str),
+                           error_cnt)
+
+    def test_in_order_pair(self):
+        """ in-order two fragment reassembly """
+
+        error_cnt_str = \
+            "/err/ip6-full-reassembly-feature/in-order fragment pairs"
+
+        error_cnt = self.statistics.get_err_counter(error_cnt_str)
+
+        p = (Ether(dst=self.src_if.local_mac, src=self.src_if.remote_mac) /
+             IPv6(src=self.src_if.remote_ip6,
+                  dst=self.dst_if.remote_ip6) /
+             UDP(sport=1234, dport=5678) /
+             Raw(b"X" * 600))
+        frags = fragment_rfc8200(p, 3000, 400)
+        self.assertEqual(len(frags), 2)
+
+        self.pg_enable_capture()
+        self.src_if.add_stream(frags)
+        self.pg_start()
+
+        self.dst_if.get_capture(1)
+        self.assert_error_counter_equal(error_cnt_str, error_cnt + 1)
+
     def test_overlap1(self):
         """ overlapping fragments case #1 """
 